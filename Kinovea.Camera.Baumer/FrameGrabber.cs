@@ -312,10 +312,10 @@ namespace Kinovea.Camera.Baumer
                 bool flush = finishline.Consolidate(frameBuffer);
                 if (flush)
                 {
-                    ComputeDataRate(finishline.BufferOutput.Length);
+                    ComputeDataRate(finishline.OutputLength);
 
                     if (FrameProduced != null)
-                        FrameProduced(this, new FrameProducedEventArgs(finishline.BufferOutput, finishline.BufferOutput.Length));
+                        FrameProduced(this, new FrameProducedEventArgs(finishline.Buffer, finishline.OutputOffset, finishline.OutputLength));
                 }
             }
             else
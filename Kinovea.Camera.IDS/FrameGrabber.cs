@@ -317,10 +317,10 @@ namespace Kinovea.Camera.IDS
                 bool flush = finishline.Consolidate(incomingBuffer);
                 if (flush)
                 {
-                    ComputeDataRate(finishline.BufferOutput.Length);
+                    ComputeDataRate(finishline.OutputLength);
 
                     if (FrameProduced != null)
-                        FrameProduced(this, new FrameProducedEventArgs(finishline.BufferOutput, finishline.BufferOutput.Length));
+                        FrameProduced(this, new FrameProducedEventArgs(finishline.Buffer, finishline.OutputOffset, finishline.OutputLength));
                 }
             }
             else
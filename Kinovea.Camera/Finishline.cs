@@ -9,7 +9,12 @@ namespace Kinovea.Camera
 {
     /// <summary>
     /// Helper class to manage finishline mode.
-    /// This class host the buffer and builds the current frame.
+    /// This class hosts the strip buffer and builds the current frame.
+    /// 
+    /// The strip is a mirrored ring of rows: each consolidated row is written twice, at its ring position
+    /// and at the same position + outputHeight. This way the most recent outputHeight rows are always
+    /// contiguous in memory and the output frame is just a window into the strip, no matter where the
+    /// write cursor is. The waterfall view is served from this window without rebuilding a separate frame.
     /// </summary>
     public class Finishline
     {
@@ -29,9 +34,22 @@ namespace Kinovea.Camera
             get { return resultingFramerate; }
         }
 
-        public byte[] BufferOutput
+        /// <summary>
+        /// The strip buffer. The finished frame starts at OutputOffset and spans OutputLength bytes.
+        /// </summary>
+        public byte[] Buffer
+        {
+            get { return strip; }
+        }
+
+        public int OutputOffset
         {
-            get { return bufferOutput; }
+            get { return outputOffset; }
+        }
+
+        public int OutputLength
+        {
+            get { return outputLength; }
         }
         #endregion
 
@@ -41,13 +59,13 @@ namespace Kinovea.Camera
         private int thresholdHeight;              // If the user configures the camera with an height below this, we automatically switch to finishline mode.
         private int consolidationHeight;          // Number of rows we grab from the incoming frames, independently of the user configured height. (Some camera have a min height).
         private int outputHeight;                 // Size of the frames we will output. aka, how many consolidated rows make a frame.
-        private int waterfallFlushHeight;         // Size of waterfall sections before we output that section into the frame and flush.
-        private bool waterfallEnabled;            // If false, each frame will have unique rows. If true we overlap the rows and flush more often.
-        private byte[] bufferCurrent;             // Current frame being consolidated.
-        private byte[] bufferOld;                 // Last completely consolidated frame. Used during waterfall for overlap.
-        private byte[] bufferOutput;              // The finished frame. May contain rows from both current and previous.
-        private int row;                          // The rows we have consolidated so far in the current frame.
-        private int section;                      // The section of rows we are in, for waterfall overlap.
+        private int flushHeight;                  // Number of new rows between two output frames. Smaller than outputHeight in waterfall mode.
+        private int stride;                       // Size of one row in bytes.
+        private byte[] strip;                     // Mirrored ring of 2 × outputHeight rows.
+        private int writeRow;                     // Ring position of the next row to write, this is also the oldest row of the window.
+        private int rowsSinceFlush;               // Number of rows consolidated since the last output frame.
+        private int outputOffset;                 // Byte offset of the finished frame inside the strip.
+        private int outputLength;                 // Byte length of the finished frame.
 
         /// <summary>
         /// Compute the new image size/framerate and prepare the buffers.
@@ -58,7 +76,10 @@ namespace Kinovea.Camera
             enabled = height <= thresholdHeight;
 
             if (!enabled)
+            {
+                strip = null;
                 return;
+            }
 
             // Constraints:
             // -The number of consolidated rows has to be lower than the height threshold, otherwise we won't have enough source material to copy.
@@ -69,10 +90,11 @@ namespace Kinovea.Camera
             outputHeight = PreferencesManager.CapturePreferences.PhotofinishConfiguration.OutputHeight;
             outputHeight = outputHeight - (outputHeight % consolidationHeight);
 
-            waterfallEnabled = PreferencesManager.CapturePreferences.PhotofinishConfiguration.Waterfall;
+            flushHeight = outputHeight;
+            bool waterfallEnabled = PreferencesManager.CapturePreferences.PhotofinishConfiguration.Waterfall;
             if (waterfallEnabled)
             {
-                waterfallFlushHeight = PreferencesManager.CapturePreferences.PhotofinishConfiguration.WaterfallFlushHeight;
+                int waterfallFlushHeight = PreferencesManager.CapturePreferences.PhotofinishConfiguration.WaterfallFlushHeight;
 
                 bool isWaterfallFlushHeightValid =
                     waterfallFlushHeight >= consolidationHeight &&
@@ -80,83 +102,49 @@ namespace Kinovea.Camera
                     (outputHeight % waterfallFlushHeight == 0) &&
                     (waterfallFlushHeight % consolidationHeight == 0);
 
-                if (!isWaterfallFlushHeightValid)
-                    waterfallFlushHeight = outputHeight;
+                if (isWaterfallFlushHeightValid)
+                    flushHeight = waterfallFlushHeight;
             }
 
-            // Prepare buffer for output images.
             float rowsPerSecond = inputFramerate * consolidationHeight;
-            if (waterfallEnabled)
-                this.resultingFramerate = rowsPerSecond / waterfallFlushHeight;
-            else
-                this.resultingFramerate = rowsPerSecond / outputHeight;
+            this.resultingFramerate = rowsPerSecond / flushHeight;
 
             int pfBufferSize = ImageFormatHelper.ComputeBufferSize(width, outputHeight, format);
             imageDescriptor = new ImageDescriptor(format, width, outputHeight, true, pfBufferSize);
 
-            bufferCurrent = new byte[pfBufferSize];
-            bufferOld = new byte[pfBufferSize];
-            bufferOutput = new byte[pfBufferSize];
-            row = 0;
+            stride = width * ImageFormatHelper.BytesPerPixel(format);
+            strip = new byte[stride * outputHeight * 2];
+            outputLength = stride * outputHeight;
+            outputOffset = 0;
+            writeRow = 0;
+            rowsSinceFlush = 0;
         }
 
         /// <summary>
         /// Consolidate the incoming rows.
-        /// Returns true if the buffer has to be flushed, in which case the properties BufferOutput will be valid
-        /// and can be used by the caller to raise the FrameProducedEvent.
+        /// Returns true if the frame has to be flushed, in which case the properties Buffer, OutputOffset and OutputLength 
+        /// will be valid and can be used by the caller to raise the FrameProducedEvent.
         /// </summary>
         public bool Consolidate(byte[] buffer)
         {
             if (!enabled)
                 throw new InvalidOperationException();
 
-            bool flush = false;
-            int bytesPerPixel = ImageFormatHelper.BytesPerPixel(imageDescriptor.Format);
-            int stride = imageDescriptor.Width * bytesPerPixel;
-
-            // Consolidate the current sub-frame.
-            Buffer.BlockCopy(buffer, 0, bufferCurrent, row * imageDescriptor.Width * bytesPerPixel, imageDescriptor.Width * bytesPerPixel * consolidationHeight);
-            row += consolidationHeight;
+            // Append the sub-frame at the write cursor and at its mirror position.
+            int length = stride * consolidationHeight;
+            System.Buffer.BlockCopy(buffer, 0, strip, writeRow * stride, length);
+            System.Buffer.BlockCopy(buffer, 0, strip, (writeRow + outputHeight) * stride, length);
 
-            if (waterfallEnabled && (row % waterfallFlushHeight == 0))
-            {
-                // Flush the current and old image to output in sliding window mode.
-                // "section" is at 0 after we grabbed the first section of rows.
-                int totalSections = outputHeight / waterfallFlushHeight;
-
-                // Rows are always added to the bottom, so here we continue this pattern.
-                // The current image is copied at the bottom, and the old image is copied at the top.
-                // We just need to figure out which portion of each image to copy.
-                int bufferCurrentSource = 0;
-                int bufferCurrentLength = (section + 1) * waterfallFlushHeight * stride;
-                int bufferCurrentDestination = (totalSections - (section + 1)) * waterfallFlushHeight * stride;
-                int bufferOldSource = bufferCurrentLength;
-                int bufferOldLength = bufferCurrentDestination;
-                int bufferOldDestination = 0;
-
-                Buffer.BlockCopy(bufferCurrent, bufferCurrentSource, bufferOutput, bufferCurrentDestination, bufferCurrentLength);
-                Buffer.BlockCopy(bufferOld, bufferOldSource, bufferOutput, bufferOldDestination, bufferOldLength);
-
-                section = (section + 1) % totalSections;
-
-                flush = true;
-            }
+            writeRow = (writeRow + consolidationHeight) % outputHeight;
+            rowsSinceFlush += consolidationHeight;
 
-            if (row >= outputHeight)
-            {
-                row = 0;
-                section = 0;
-
-                if (!waterfallEnabled)
-                    flush = true;
-
-                // Swap buffers.
-                byte[] pfBufferTemp = bufferOld;
-                bufferOld = bufferCurrent;
-                bufferCurrent = bufferOld;
-            }
+            if (rowsSinceFlush < flushHeight)
+                return false;
 
-            return flush;
+            // The window starts at the oldest row and ends with the newest row at the bottom.
+            rowsSinceFlush = 0;
+            outputOffset = writeRow * stride;
+            return true;
         }
     }
 }
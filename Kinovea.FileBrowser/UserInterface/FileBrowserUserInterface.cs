@@ -60,6 +60,10 @@ namespace Kinovea.FileBrowser
         private string lastOpenedDirectory;
         private ActiveFileBrowserTab activeTab;
         private FileSystemWatcher fileWatcher = new FileSystemWatcher();
+        private System.Windows.Forms.Timer fileWatcherTimer = new System.Windows.Forms.Timer();
+        private FileList explorerFiles;
+        private FileList shortcutsFiles;
+        private FileList capturedFiles;
 
         #region Menu
         private ContextMenuStrip popMenuFolders = new ContextMenuStrip();
@@ -86,6 +90,10 @@ namespace Kinovea.FileBrowser
         public FileBrowserUserInterface()
         {
             InitializeComponent();
+
+            explorerFiles = new FileList(lvExplorer);
+            shortcutsFiles = new FileList(lvShortcuts);
+            capturedFiles = new FileList(lvCaptured);
             
             lvCameras.SmallImageList = cameraIcons;
             cameraIcons.Images.Add("historyEntryDay", Properties.Resources.calendar_view_day);
@@ -241,21 +249,17 @@ namespace Kinovea.FileBrowser
 
             // Find the file and select it here.
             ListView lv = GetFileListview();
-            lv.SelectedItems.Clear();
+            FileList fileList = GetFileList(lv);
+            lv.SelectedIndices.Clear();
+            fileList.Select(null);
 
-            if (string.IsNullOrEmpty(e.File))
+            int index = fileList.IndexOf(e.File);
+            if (index < 0)
                 return;
 
-            foreach (ListViewItem item in lv.Items)
-            {
-                if ((string)item.Tag != e.File)
-                    continue;
-                
-                externalSelection = true;
-                item.Selected = true;
-                item.EnsureVisible();
-                break;
-            }
+            externalSelection = true;
+            lv.SelectedIndices.Add(index);
+            lv.EnsureVisible(index);
         }
         private ListView GetFileListview()
         {
@@ -270,6 +274,15 @@ namespace Kinovea.FileBrowser
                     return lvExplorer;
             }
         }
+        private FileList GetFileList(ListView lv)
+        {
+            if (lv == lvShortcuts)
+                return shortcutsFiles;
+            else if (lv == lvCaptured)
+                return capturedFiles;
+            else
+                return explorerFiles;
+        }
         private void NotificationCenter_FileOpened(object sender, FileActionEventArgs e)
         {
             // Create a virtual shortcut for the current video directory.
@@ -393,7 +406,8 @@ namespace Kinovea.FileBrowser
 
         public void ResetShortcutList()
         {
-            lvShortcuts.Clear();
+            shortcutsFiles.SetFiles(null, new List<string>());
+            lvShortcuts.Columns.Clear();
         }
         public void CamerasDiscovered(List<CameraSummary> summaries)
         {
@@ -713,18 +727,54 @@ namespace Kinovea.FileBrowser
             // Triggers an update of the thumbnails pane if requested.
             if(folder == null)
                 return;
-            
+
+            PrepareListView(listView);
+            UpdateFileWatcher(folder);
+
+            // Even if we don't want to reload the thumbnails, we must ensure that 
+            // the screen manager backup list is in sync with the actual file list.
+            // desync can happen in case of renaming and deleting files.
+            // the screenmanager backup list is used at BringBackThumbnail,
+            // (i.e. when we close a screen)
+            FileList fileList = GetFileList(listView);
+            if (IsFileSystemFolder(folder.Path))
+            {
+                // Enumerate in the background, the thumbnails are updated once the list is complete.
+                fileList.Load(folder.Path, files => NotificationCenter.RaiseCurrentDirectoryChanged(this, shortcuts, files, refreshThumbnails));
+            }
+            else
+            {
+                List<string> filenames = GetShellFiles(folder);
+                fileList.SetFiles(folder.Path, filenames);
+                NotificationCenter.RaiseCurrentDirectoryChanged(this, shortcuts, filenames, refreshThumbnails);
+            }
+        }
+
+        /// <summary>
+        /// Whether the folder can be enumerated directly from the file system rather than through the shell.
+        /// </summary>
+        private static bool IsFileSystemFolder(string path)
+        {
+            if (string.IsNullOrEmpty(path) || path.StartsWith("::"))
+                return false;
+
+            try
+            {
+                return Directory.Exists(path);
+            }
+            catch
+            {
+                return false;
+            }
+        }
+
+        /// <summary>
+        /// Lists the supported files of a virtual folder through the shell.
+        /// </summary>
+        private List<string> GetShellFiles(CShItem folder)
+        {
             this.Cursor = Cursors.WaitCursor;
-            
-            listView.BeginUpdate();
-            listView.View = View.Details;
-            listView.Items.Clear();
-            listView.Columns.Clear();
-            listView.Columns.Add("", listView.Width);
-            listView.GridLines = true;
-            listView.HeaderStyle = ColumnHeaderStyle.None;
-            
-            // Each list element will store the CShItem it's referring to in its Tag property.
+
             ArrayList fileList = folder.GetFiles();
             
             List<string> filenames = new List<string>();
@@ -751,26 +801,9 @@ namespace Kinovea.FileBrowser
             }
             
             filenames.Sort(new AlphanumComparator());
-            
-            foreach(string filename in filenames)
-            {
-                ListViewItem lvi = new ListViewItem(Path.GetFileName(filename));
-                lvi.Tag = filename;
-                lvi.ImageIndex = 0;
-                listView.Items.Add(lvi);
-            }
-            
-            listView.EndUpdate();
 
-            UpdateFileWatcher(folder);
-                            
-            // Even if we don't want to reload the thumbnails, we must ensure that 
-            // the screen manager backup list is in sync with the actual file list.
-            // desync can happen in case of renaming and deleting files.
-            // the screenmanager backup list is used at BringBackThumbnail,
-            // (i.e. when we close a screen)
-            NotificationCenter.RaiseCurrentDirectoryChanged(this, shortcuts, filenames, refreshThumbnails);
             this.Cursor = Cursors.Default;
+            return filenames;
         }
 
         /// <summary>
@@ -778,24 +811,17 @@ namespace Kinovea.FileBrowser
         /// </summary>
         private void UpdateFileList(List<string> filenames, ListView listView, bool refreshThumbnails, bool shortcuts)
         {
-            listView.BeginUpdate();
+            PrepareListView(listView);
+            GetFileList(listView).SetFiles(null, filenames);
+        }
+
+        private void PrepareListView(ListView listView)
+        {
             listView.View = View.Details;
-            listView.Items.Clear();
             listView.Columns.Clear();
             listView.Columns.Add("", listView.Width);
             listView.GridLines = true;
             listView.HeaderStyle = ColumnHeaderStyle.None;
-
-            foreach (string filename in filenames)
-            {
-                ListViewItem lvi = new ListViewItem(Path.GetFileName(filename));
-                lvi.Tag = filename;
-                lvi.ImageIndex = 0;
-                listView.Items.Add(lvi);
-            }
-
-            listView.Invalidate();
-            listView.EndUpdate();
         }
 
         private void lv_ItemDrag(object sender, ItemDragEventArgs e)
@@ -839,7 +865,7 @@ namespace Kinovea.FileBrowser
         {
             ListViewItem lvi = listView.GetItemAt(e.X, e.Y);
             
-            if(lvi == null || listView.SelectedItems == null || listView.SelectedItems.Count != 1)
+            if(lvi == null || listView.SelectedIndices.Count != 1)
                 return;
             
             string path = lvi.Tag as string;
@@ -901,21 +927,18 @@ namespace Kinovea.FileBrowser
         private void listViews_SelectedIndexChanged(object sender, EventArgs e)
         {
             ListView lv = sender as ListView;
-            if (lv == null || lv.SelectedItems.Count != 1)
+            if (lv == null)
                 return;
 
-            string file = lv.SelectedItems[0].Tag as string;
-            if (string.IsNullOrEmpty(file))
+            FileList fileList = GetFileList(lv);
+            if (fileList.Updating)
                 return;
 
-            foreach (ListViewItem item in lv.Items)
-            {
-                item.BackColor = Color.White;
-                item.ForeColor = Color.Black;
-            }
+            string file = fileList.GetSelectedPath();
+            if (string.IsNullOrEmpty(file))
+                return;
 
-            lv.SelectedItems[0].BackColor = SystemColors.Highlight;
-            lv.SelectedItems[0].ForeColor = SystemColors.HighlightText;
+            fileList.Select(file);
 
             if (!externalSelection)
                 NotificationCenter.RaiseFileSelected(this, file);
@@ -934,6 +957,10 @@ namespace Kinovea.FileBrowser
             fileWatcher.Created += fileWatcher_Created;
             fileWatcher.Deleted += fileWatcher_Deleted;
             fileWatcher.Renamed += fileWatcher_Renamed;
+
+            // Bursts of changes, like a file being written, are coalesced into a single update of the thumbnails.
+            fileWatcherTimer.Interval = 250;
+            fileWatcherTimer.Tick += fileWatcherTimer_Tick;
         }
 
         private void UpdateFileWatcher(CShItem folder)
@@ -957,22 +984,87 @@ namespace Kinovea.FileBrowser
         
         private void fileWatcher_Renamed(object sender, RenamedEventArgs e)
         {
-            this.BeginInvoke((MethodInvoker)delegate { DoRefreshFileList(true); });
+            this.BeginInvoke((MethodInvoker)delegate {
+                RemoveWatchedFile(e.OldFullPath);
+                AddWatchedFile(e.FullPath);
+                fileWatcherTimer.Stop();
+                fileWatcherTimer.Start();
+            });
         }
 
         private void fileWatcher_Deleted(object sender, FileSystemEventArgs e)
         {
-            this.BeginInvoke((MethodInvoker)delegate { DoRefreshFileList(true); });
+            this.BeginInvoke((MethodInvoker)delegate {
+                RemoveWatchedFile(e.FullPath);
+                fileWatcherTimer.Stop();
+                fileWatcherTimer.Start();
+            });
         }
 
         private void fileWatcher_Created(object sender, FileSystemEventArgs e)
         {
-            this.BeginInvoke((MethodInvoker)delegate { DoRefreshFileList(true); });
+            this.BeginInvoke((MethodInvoker)delegate {
+                AddWatchedFile(e.FullPath);
+                fileWatcherTimer.Stop();
+                fileWatcherTimer.Start();
+            });
         }
 
         private void fileWatcher_Changed(object sender, FileSystemEventArgs e)
         {
-            this.BeginInvoke((MethodInvoker)delegate { DoRefreshFileList(true); });
+            // The list itself doesn't change, but the thumbnail of the file may.
+            this.BeginInvoke((MethodInvoker)delegate {
+                fileWatcherTimer.Stop();
+                fileWatcherTimer.Start();
+            });
+        }
+
+        /// <summary>
+        /// Adds the file to the lists showing its folder.
+        /// </summary>
+        private void AddWatchedFile(string path)
+        {
+            string directory = Path.GetDirectoryName(path);
+            foreach (FileList fileList in new FileList[] { explorerFiles, shortcutsFiles })
+            {
+                if (string.Equals(fileList.Folder, directory, StringComparison.OrdinalIgnoreCase))
+                    fileList.Add(path);
+            }
+        }
+
+        /// <summary>
+        /// Removes the file from the lists showing its folder.
+        /// </summary>
+        private void RemoveWatchedFile(string path)
+        {
+            string directory = Path.GetDirectoryName(path);
+            foreach (FileList fileList in new FileList[] { explorerFiles, shortcutsFiles })
+            {
+                if (string.Equals(fileList.Folder, directory, StringComparison.OrdinalIgnoreCase))
+                    fileList.Remove(path);
+            }
+        }
+
+        private void fileWatcherTimer_Tick(object sender, EventArgs e)
+        {
+            fileWatcherTimer.Stop();
+
+            if (initializing)
+                return;
+
+            if (activeTab == ActiveFileBrowserTab.Cameras)
+            {
+                DoRefreshFileList(true);
+                return;
+            }
+
+            // Push the updated list to the thumbnails pane, unless a listing in progress will do it.
+            bool shortcuts = activeTab == ActiveFileBrowserTab.Shortcuts && currentShortcutItem != null;
+            FileList fileList = shortcuts ? shortcutsFiles : explorerFiles;
+            if (fileList.Loading || fileList.Folder == null)
+                return;
+
+            NotificationCenter.RaiseCurrentDirectoryChanged(this, shortcuts, fileList.GetFiles(), true);
         }
         #endregion
 
@@ -1027,10 +1119,10 @@ namespace Kinovea.FileBrowser
 
         private string GetSelectedVideoPath(ListView lv)
         {
-            if (lv == null || lv.SelectedItems == null || lv.SelectedItems.Count != 1)
+            if (lv == null)
                 return null;
 
-            return lv.SelectedItems[0].Tag as string;
+            return GetFileList(lv).GetSelectedPath();
         }
 
         private void LaunchSelectedVideo(ListView lv)
@@ -0,0 +1,346 @@
+#region License
+/*
+Copyright  Joan Charmant 2008.
+jcharmant@gmail.com 
+ 
+This file is part of Kinovea.
+
+Kinovea is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2 
+as published by the Free Software Foundation.
+
+Kinovea is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Kinovea. If not, see http://www.gnu.org/licenses/.
+
+*/
+#endregion
+
+using System;
+using System.Collections.Generic;
+using System.ComponentModel;
+using System.Drawing;
+using System.IO;
+using System.Windows.Forms;
+using Kinovea.Services;
+using Kinovea.Video;
+
+namespace Kinovea.FileBrowser
+{
+    /// <summary>
+    /// The content of a file list view.
+    /// The list view is used in virtual mode, the items are only created for the rows being displayed.
+    /// Folders are enumerated on a background thread and the files are streamed into the list by batches,
+    /// the list is kept sorted. Files can then be added or removed individually, to follow the file watcher.
+    /// </summary>
+    public class FileList
+    {
+        #region Properties
+        /// <summary>
+        /// The folder being listed, or null for an explicit list of files.
+        /// </summary>
+        public string Folder
+        {
+            get { return folder; }
+        }
+
+        /// <summary>
+        /// True while the folder is being enumerated.
+        /// </summary>
+        public bool Loading
+        {
+            get { return worker != null; }
+        }
+
+        /// <summary>
+        /// True while the list changes the selection of the list view by itself, to follow a file whose index changed.
+        /// </summary>
+        public bool Updating
+        {
+            get { return updating; }
+        }
+        #endregion
+
+        #region Members
+        private ListView listView;
+        private string folder;
+        private List<string> files = new List<string>();
+        private HashSet<string> known = new HashSet<string>(StringComparer.OrdinalIgnoreCase);
+        private AlphanumComparator comparator = new AlphanumComparator();
+        private string selected;
+        private bool updating;
+        private BackgroundWorker worker;
+        private Action<List<string>> loaded;
+        private const int batchSize = 256;
+        private static readonly log4net.ILog log = log4net.LogManager.GetLogger(System.Reflection.MethodBase.GetCurrentMethod().DeclaringType);
+        #endregion
+
+        public FileList(ListView listView)
+        {
+            this.listView = listView;
+            listView.VirtualMode = true;
+            listView.VirtualListSize = 0;
+            listView.RetrieveVirtualItem += ListView_RetrieveVirtualItem;
+        }
+
+        #region Public methods
+        /// <summary>
+        /// Starts listing the supported files of the folder.
+        /// The callback is invoked on the UI thread with the complete list, unless the loading is superseded.
+        /// </summary>
+        public void Load(string folder, Action<List<string>> loaded)
+        {
+            Cancel();
+            Reset(folder);
+
+            this.loaded = loaded;
+            worker = new BackgroundWorker();
+            worker.WorkerReportsProgress = true;
+            worker.WorkerSupportsCancellation = true;
+            worker.DoWork += Worker_DoWork;
+            worker.ProgressChanged += Worker_ProgressChanged;
+            worker.RunWorkerCompleted += Worker_RunWorkerCompleted;
+            worker.RunWorkerAsync(folder);
+        }
+
+        /// <summary>
+        /// Replaces the content with an explicit list of files, kept in the passed order.
+        /// </summary>
+        public void SetFiles(string folder, List<string> filenames)
+        {
+            Cancel();
+            Reset(folder);
+
+            foreach (string filename in filenames)
+            {
+                if (known.Add(filename))
+                    files.Add(filename);
+            }
+
+            UpdateListView();
+        }
+
+        /// <summary>
+        /// Returns a copy of the current list of files.
+        /// </summary>
+        public List<string> GetFiles()
+        {
+            return new List<string>(files);
+        }
+
+        public string GetPath(int index)
+        {
+            if (index < 0 || index >= files.Count)
+                return null;
+
+            return files[index];
+        }
+
+        public int IndexOf(string path)
+        {
+            if (string.IsNullOrEmpty(path) || !known.Contains(path))
+                return -1;
+
+            return files.FindIndex(f => string.Equals(f, path, StringComparison.OrdinalIgnoreCase));
+        }
+
+        /// <summary>
+        /// Returns the path of the selected file, or null.
+        /// </summary>
+        public string GetSelectedPath()
+        {
+            if (listView.SelectedIndices.Count != 1)
+                return null;
+
+            return GetPath(listView.SelectedIndices[0]);
+        }
+
+        /// <summary>
+        /// Records the selected file so it is highlighted and followed when the content changes.
+        /// </summary>
+        public void Select(string path)
+        {
+            selected = path;
+            listView.Invalidate();
+        }
+
+        /// <summary>
+        /// Adds a file at its sorted position, if it is a supported file not already in the list.
+        /// Returns true if the file was added.
+        /// </summary>
+        public bool Add(string path)
+        {
+            if (!IsSupported(path) || known.Contains(path))
+                return false;
+
+            known.Add(path);
+            int index = files.BinarySearch(path, comparator);
+            files.Insert(index < 0 ? ~index : index, path);
+            UpdateListView();
+            return true;
+        }
+
+        /// <summary>
+        /// Removes a file from the list.
+        /// Returns true if the file was in the list.
+        /// </summary>
+        public bool Remove(string path)
+        {
+            int index = IndexOf(path);
+            if (index < 0)
+                return false;
+
+            known.Remove(path);
+            files.RemoveAt(index);
+            UpdateListView();
+            return true;
+        }
+
+        /// <summary>
+        /// Stops the enumeration in progress, if any. The files already listed are kept.
+        /// </summary>
+        public void Cancel()
+        {
+            if (worker == null)
+                return;
+
+            worker.CancelAsync();
+            worker = null;
+            loaded = null;
+        }
+        #endregion
+
+        #region Private methods
+        private void Reset(string folder)
+        {
+            this.folder = folder;
+            files.Clear();
+            known.Clear();
+            selected = null;
+            UpdateListView();
+        }
+
+        private static bool IsSupported(string path)
+        {
+            string extension = Path.GetExtension(path);
+            return !string.IsNullOrEmpty(extension) && VideoTypeManager.IsSupported(extension);
+        }
+
+        private void Worker_DoWork(object sender, DoWorkEventArgs e)
+        {
+            BackgroundWorker bgWorker = sender as BackgroundWorker;
+            string path = e.Argument as string;
+            List<string> batch = new List<string>(batchSize);
+
+            try
+            {
+                // EnumerateFiles streams the entries instead of building the whole array first.
+                foreach (string file in Directory.EnumerateFiles(path))
+                {
+                    if (bgWorker.CancellationPending)
+                    {
+                        e.Cancel = true;
+                        return;
+                    }
+
+                    if (!IsSupported(file))
+                        continue;
+
+                    batch.Add(file);
+                    if (batch.Count < batchSize)
+                        continue;
+
+                    bgWorker.ReportProgress(0, batch);
+                    batch = new List<string>(batchSize);
+                }
+            }
+            catch (Exception ex)
+            {
+                log.ErrorFormat("An error happened while listing the files of {0}: {1}", path, ex.Message);
+            }
+
+            if (batch.Count > 0)
+                bgWorker.ReportProgress(0, batch);
+        }
+
+        private void Worker_ProgressChanged(object sender, ProgressChangedEventArgs e)
+        {
+            // Batch from a superseded enumeration.
+            if (sender != worker)
+                return;
+
+            List<string> batch = e.UserState as List<string>;
+            foreach (string file in batch)
+            {
+                // The file may have been added by the file watcher in the meantime.
+                if (known.Add(file))
+                    files.Add(file);
+            }
+
+            files.Sort(comparator);
+            UpdateListView();
+        }
+
+        private void Worker_RunWorkerCompleted(object sender, RunWorkerCompletedEventArgs e)
+        {
+            if (sender != worker)
+                return;
+
+            Action<List<string>> callback = loaded;
+            worker = null;
+            loaded = null;
+
+            log.DebugFormat("Listed {0} files in {1}.", files.Count, folder);
+
+            if (callback != null)
+                callback(GetFiles());
+        }
+
+        /// <summary>
+        /// Pushes the new content to the list view, keeping the selected file selected.
+        /// </summary>
+        private void UpdateListView()
+        {
+            updating = true;
+
+            listView.BeginUpdate();
+            listView.SelectedIndices.Clear();
+            listView.VirtualListSize = files.Count;
+
+            int index = IndexOf(selected);
+            if (index >= 0)
+                listView.SelectedIndices.Add(index);
+
+            listView.EndUpdate();
+            listView.Invalidate();
+
+            updating = false;
+        }
+
+        private void ListView_RetrieveVirtualItem(object sender, RetrieveVirtualItemEventArgs e)
+        {
+            string path = files[e.ItemIndex];
+            ListViewItem lvi = new ListViewItem(Path.GetFileName(path));
+            lvi.Tag = path;
+            lvi.ImageIndex = 0;
+
+            if (string.Equals(path, selected, StringComparison.OrdinalIgnoreCase))
+            {
+                lvi.BackColor = SystemColors.Highlight;
+                lvi.ForeColor = SystemColors.HighlightText;
+            }
+            else
+            {
+                lvi.BackColor = Color.White;
+                lvi.ForeColor = Color.Black;
+            }
+
+            e.Item = lvi;
+        }
+        #endregion
+    }
+}
@@ -28,10 +28,20 @@ namespace Kinovea.Pipeline
     public class FrameProducedEventArgs : EventArgs
     {
         public readonly byte[] Buffer;
+        public readonly int Offset;
         public readonly int PayloadLength;
         public FrameProducedEventArgs(byte[] buffer, int payloadLength)
+            : this(buffer, 0, payloadLength)
+        {
+        }
+
+        /// <summary>
+        /// Frame whose payload starts somewhere inside a larger buffer owned by the producer.
+        /// </summary>
+        public FrameProducedEventArgs(byte[] buffer, int offset, int payloadLength)
         {
             this.Buffer = buffer;
+            this.Offset = offset;
             this.PayloadLength = payloadLength;
         }
     }
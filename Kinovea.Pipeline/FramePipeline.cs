@@ -162,11 +162,11 @@ namespace Kinovea.Pipeline
             }
             else
             {
-                WriteSlot(e.Buffer, e.PayloadLength, entry);
+                WriteSlot(e.Buffer, e.Offset, e.PayloadLength, entry);
             }
         }
 
-        private void WriteSlot(byte[] bytes, int payloadLength, Frame entry)
+        private void WriteSlot(byte[] bytes, int offset, int payloadLength, Frame entry)
         {
             //-------------------------
             // Runs in producer thread.
@@ -175,7 +175,7 @@ namespace Kinovea.Pipeline
             // The slot is writeable, let's stuff it with camera bytes.
             if (payloadLength <= entry.Buffer.Length)
             {
-                Buffer.BlockCopy(bytes, 0, entry.Buffer, 0, payloadLength);
+                Buffer.BlockCopy(bytes, offset, entry.Buffer, 0, payloadLength);
                 entry.PayloadLength = payloadLength;
             }
             else
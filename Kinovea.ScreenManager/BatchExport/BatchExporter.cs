@@ -0,0 +1,373 @@
+﻿#region License
+/*
+Copyright © Joan Charmant 2021.
+jcharmant@gmail.com
+
+This file is part of Kinovea.
+
+Kinovea is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2
+as published by the Free Software Foundation.
+
+Kinovea is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Kinovea. If not, see http://www.gnu.org/licenses/.
+*/
+#endregion
+using System;
+using System.Collections.Generic;
+using System.ComponentModel;
+using System.Drawing;
+using System.IO;
+using System.Linq;
+using System.Threading;
+using Kinovea.Services;
+using Kinovea.Video;
+using Kinovea.Video.FFMpeg;
+
+namespace Kinovea.ScreenManager
+{
+    /// <summary>
+    /// Exports a list of videos with their side-car KVA to annotated videos and CSV files, without the user interface.
+    ///
+    /// Each file is loaded in its own frame server and metadata, the drawings are painted by a PlayerMetadataRenderer
+    /// and the video is encoded by the same writer as the interactive export.
+    /// Several files are exported at the same time, within a number of jobs and a memory budget for the frames in flight.
+    /// Video decoding and encoding are already multithreaded, so the default number of jobs is half the processors.
+    /// </summary>
+    public class BatchExporter
+    {
+        /// <summary>
+        /// Value returned by Run when the input doesn't designate any supported video.
+        /// </summary>
+        public const int NoInput = -1;
+
+        #region Members
+        // Frames alive at the same time for one export: the decoded frame, the painted output and the encoder copy.
+        private const int framesInFlight = 3;
+        private const long megabytes = 1024 * 1024;
+
+        private BatchExportSettings settings;
+        private Queue<string> pending = new Queue<string>();
+        private int succeeded;
+        private int failed;
+        private long budget;
+        private long used;
+        private object locker = new object();
+        private static readonly log4net.ILog log = log4net.LogManager.GetLogger(System.Reflection.MethodBase.GetCurrentMethod().DeclaringType);
+        #endregion
+
+        public BatchExporter(BatchExportSettings settings)
+        {
+            this.settings = settings;
+        }
+
+        #region Public methods
+        /// <summary>
+        /// Exports all the input files and returns when they are done.
+        /// Returns the number of files that could not be exported, or NoInput if there was nothing to export.
+        /// </summary>
+        public int Run()
+        {
+            List<string> files = ListInputs(settings.Input);
+            if (files.Count == 0)
+            {
+                log.ErrorFormat("Batch export: no supported video found for {0}.", settings.Input);
+                return NoInput;
+            }
+
+            if (!string.IsNullOrEmpty(settings.OutputFolder) && !Directory.Exists(settings.OutputFolder))
+                Directory.CreateDirectory(settings.OutputFolder);
+
+            foreach (string file in files)
+                pending.Enqueue(file);
+
+            int jobs = settings.MaxJobs > 0 ? settings.MaxJobs : Math.Max(1, Environment.ProcessorCount / 2);
+            jobs = Math.Min(jobs, files.Count);
+            int memory = settings.MemoryBudget > 0 ? settings.MemoryBudget : MemoryHelper.MaxMemoryBuffer();
+            budget = memory * megabytes;
+
+            log.DebugFormat("Batch export of {0} files, {1} jobs, memory budget: {2} MB.", files.Count, jobs, memory);
+
+            List<Thread> threads = new List<Thread>();
+            for (int i = 0; i < jobs; i++)
+            {
+                Thread thread = new Thread(Work) { IsBackground = true, Name = string.Format("Batch export {0}", i) };
+                threads.Add(thread);
+                thread.Start();
+            }
+
+            foreach (Thread thread in threads)
+                thread.Join();
+
+            log.DebugFormat("Batch export done. Exported: {0}, failed: {1}.", succeeded, failed);
+            return failed;
+        }
+
+        /// <summary>
+        /// Returns the supported videos designated by the input: a file, a folder or a file pattern.
+        /// </summary>
+        public static List<string> ListInputs(string input)
+        {
+            if (File.Exists(input))
+                return new List<string>() { input };
+
+            string folder = input;
+            string pattern = "*";
+            if (!Directory.Exists(input))
+            {
+                folder = Path.GetDirectoryName(input);
+                pattern = Path.GetFileName(input);
+                if (string.IsNullOrEmpty(folder))
+                    folder = Directory.GetCurrentDirectory();
+
+                if (!Directory.Exists(folder))
+                    return new List<string>();
+            }
+
+            return Directory.GetFiles(folder, pattern)
+                .Where(f => VideoTypeManager.IsSupported(Path.GetExtension(f)) && !MetadataSerializer.IsMetadataFile(f))
+                .OrderBy(f => f)
+                .ToList();
+        }
+        #endregion
+
+        #region Private methods
+        private void Work()
+        {
+            while (true)
+            {
+                string file;
+                lock (locker)
+                {
+                    if (pending.Count == 0)
+                        return;
+
+                    file = pending.Dequeue();
+                }
+
+                bool success = false;
+                try
+                {
+                    success = Export(file);
+                }
+                catch (Exception e)
+                {
+                    log.Error(string.Format("Batch export: error while exporting {0}.", file), e);
+                }
+
+                lock (locker)
+                {
+                    if (success)
+                        succeeded++;
+                    else
+                        failed++;
+                }
+            }
+        }
+
+        private bool Export(string file)
+        {
+            FrameServerPlayer frameServer = new FrameServerPlayer(null);
+            OpenVideoResult result = frameServer.Load(file);
+            if (result != OpenVideoResult.Success)
+            {
+                log.ErrorFormat("Batch export: {0} could not be opened: {1}.", file, result);
+                return false;
+            }
+
+            Metadata metadata = new Metadata(null, frameServer.TimeStampsToTimecode);
+            frameServer.Metadata = metadata;
+            long memory = 0;
+            try
+            {
+                if (!LoadMetadata(frameServer, file))
+                    return false;
+
+                string output = string.IsNullOrEmpty(settings.OutputFolder) ? Path.GetDirectoryName(file) : settings.OutputFolder;
+                string name = Path.GetFileNameWithoutExtension(file);
+                bool success = true;
+
+                if (settings.ExportVideo)
+                {
+                    Size size = frameServer.VideoReader.Info.ReferenceSize;
+                    memory = (long)size.Width * size.Height * 4 * framesInFlight;
+                    AcquireMemory(memory);
+
+                    success = ExportVideo(frameServer, Path.Combine(output, name + " - annotated.mp4"));
+                }
+
+                if (success && settings.ExportCSV)
+                    MetadataExporter.Export(metadata, Path.Combine(output, name + ".csv"), MetadataExportFormat.CSV);
+
+                if (success)
+                    log.DebugFormat("Batch export: {0} exported.", Path.GetFileName(file));
+
+                return success;
+            }
+            finally
+            {
+                if (memory > 0)
+                    ReleaseMemory(memory);
+
+                frameServer.Unload();
+                metadata.Close();
+            }
+        }
+
+        /// <summary>
+        /// Loads the side-car annotations and restores the working zone and image options they contain.
+        /// </summary>
+        private bool LoadMetadata(FrameServerPlayer frameServer, string file)
+        {
+            VideoReader reader = frameServer.VideoReader;
+            Metadata metadata = frameServer.Metadata;
+
+            frameServer.SetupMetadata(true);
+            metadata.VideoPath = reader.FilePath;
+            metadata.SelectionStart = reader.WorkingZone.Start;
+            metadata.SelectionEnd = reader.WorkingZone.End;
+            metadata.TimeOrigin = reader.WorkingZone.Start;
+
+            bool loaded = false;
+            foreach (string extension in MetadataSerializer.SupportedFileFormats())
+            {
+                string candidate = Path.Combine(Path.GetDirectoryName(file), Path.GetFileNameWithoutExtension(file) + extension);
+                if (!File.Exists(candidate))
+                    continue;
+
+                MetadataSerializer s = new MetadataSerializer();
+                s.Load(metadata, candidate, true);
+                loaded = true;
+            }
+
+            if (!loaded)
+            {
+                log.ErrorFormat("Batch export: no annotation file found for {0}.", file);
+                return false;
+            }
+
+            frameServer.RestoreImageOptions();
+            if (reader.CanChangeWorkingZone)
+            {
+                // The memory is passed as zero so the reader doesn't try to cache the working zone.
+                VideoSection section = new VideoSection(metadata.SelectionStart, metadata.SelectionEnd);
+                reader.UpdateWorkingZone(section, true, 0, RunWorker);
+            }
+
+            frameServer.SetupMetadata(false);
+            return true;
+        }
+
+        private bool ExportVideo(FrameServerPlayer frameServer, string file)
+        {
+            VideoReader reader = frameServer.VideoReader;
+            Metadata metadata = frameServer.Metadata;
+
+            // Same settings as the interactive export at the original speed.
+            SavingSettings s = new SavingSettings();
+            s.Section = reader.WorkingZone;
+            s.File = file;
+            s.InputFrameInterval = metadata.UserInterval;
+            s.FlushDrawings = true;
+            s.Duplication = (int)Math.Ceiling(s.InputFrameInterval / 125.0);
+            s.KeyframeDuplication = s.Duplication;
+            s.OutputFrameInterval = s.InputFrameInterval / s.Duplication;
+            s.EstimatedTotal = reader.EstimatedFrames * s.Duplication;
+
+            // The writer reports progress and checks for cancellation on a background worker.
+            // It is never started, progress events are raised synchronously on the export thread.
+            BackgroundWorker worker = new BackgroundWorker();
+            worker.WorkerReportsProgress = true;
+
+            SaveResult result;
+            using (PlayerMetadataRenderer renderer = new PlayerMetadataRenderer(metadata))
+            {
+                reader.BeforeFrameEnumeration();
+                VideoFileWriter w = new VideoFileWriter();
+                result = w.Save(s, reader.Info, FilenameHelper.GetFormatString(file), EnumerateImages(reader, metadata, renderer, s.Duplication), worker);
+                reader.AfterFrameEnumeration();
+            }
+
+            if (result != SaveResult.Success)
+            {
+                log.ErrorFormat("Batch export: {0} could not be saved: {1}.", file, result);
+                return false;
+            }
+
+            return true;
+        }
+
+        /// <summary>
+        /// Lazily enumerate the painted images of the working zone.
+        /// </summary>
+        private static IEnumerable<Bitmap> EnumerateImages(VideoReader reader, Metadata metadata, PlayerMetadataRenderer renderer, int duplication)
+        {
+            Bitmap output = null;
+            try
+            {
+                foreach (VideoFrame vf in reader.FrameEnumerator())
+                {
+                    if (vf == null)
+                    {
+                        log.Error("Working zone enumerator yield null.");
+                        yield break;
+                    }
+
+                    if (output == null)
+                        output = new Bitmap(vf.Image.Width, vf.Image.Height, vf.Image.PixelFormat);
+
+                    // Make sure the trackable drawings are on the right context.
+                    metadata.TrackabilityManager.Track(vf);
+
+                    using (Graphics canvas = Graphics.FromImage(output))
+                        renderer.RenderFrame(vf.Image, canvas, reader.Info.ReferenceSize, vf.Timestamp);
+
+                    for (int i = 0; i < duplication; i++)
+                        yield return output;
+                }
+            }
+            finally
+            {
+                if (output != null)
+                    output.Dispose();
+            }
+        }
+
+        private static void RunWorker(DoWorkEventHandler doWork)
+        {
+            BackgroundWorker worker = new BackgroundWorker();
+            worker.WorkerReportsProgress = true;
+            doWork(worker, new DoWorkEventArgs(null));
+        }
+
+        /// <summary>
+        /// Waits until the memory fits in the budget.
+        /// A single export larger than the budget is still allowed to run alone.
+        /// </summary>
+        private void AcquireMemory(long memory)
+        {
+            lock (locker)
+            {
+                while (used > 0 && used + memory > budget)
+                    Monitor.Wait(locker);
+
+                used += memory;
+            }
+        }
+
+        private void ReleaseMemory(long memory)
+        {
+            lock (locker)
+            {
+                used -= memory;
+                Monitor.PulseAll(locker);
+            }
+        }
+        #endregion
+    }
+}
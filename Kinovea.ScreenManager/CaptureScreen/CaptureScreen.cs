@@ -214,6 +214,7 @@ namespace Kinovea.ScreenManager
             viewportController = new ViewportController();
             viewportController.DisplayRectangleUpdated += ViewportController_DisplayRectangleUpdated;
             viewportController.Poked += viewportController_Poked;
+            viewportController.FullFrameProvider = GetFullResolutionFrame;
 
             view.SetViewport(viewportController.View);
             view.SetCapturedFilesView(capturedFiles.View);
@@ -800,7 +801,7 @@ namespace Kinovea.ScreenManager
             // This timer is used for display and to feed the delay buffer when using recording mode "Camera".
             // No point displaying images faster than what the camera produces, or that the monitor can show, but floor at 1 fps.
             double displayFramerate = PreferencesManager.CapturePreferences.DisplaySynchronizationFramerate;
-            double monitorFramerate = GetMonitorFramerate();
+            double monitorFramerate = UIHelper.GetMonitorFramerate(viewportController.View.Handle);
 
             double slowFramerate = Math.Min(displayFramerate, monitorFramerate);
             if (cameraGrabber.Framerate != 0)
@@ -1184,7 +1185,9 @@ namespace Kinovea.ScreenManager
 
             // Get the displayed frame.
             int target = 0;
-            Bitmap displayFrame = delayedDisplay ? delayer.GetWeak(delay, ImageRotation, Mirrored, out target) : delayer.GetWeak(0, ImageRotation, Mirrored, out target);
+            // The frame is converted at the size it is displayed at, unless zoomed in.
+            Size displaySize = viewportController.DisplayRectangle.Size;
+            Bitmap displayFrame = delayedDisplay ? delayer.GetWeak(delay, ImageRotation, Mirrored, displaySize, out target) : delayer.GetWeak(0, ImageRotation, Mirrored, displaySize, out target);
             
             if (displayFrame == null && target < 0)
                 displayFrame = CreateWaitImage(-target);
@@ -1253,6 +1256,18 @@ namespace Kinovea.ScreenManager
 
             cameraSummary.UpdateDisplayRectangle(viewportController.DisplayRectangle);
             CameraTypeManager.UpdatedCameraSummary(cameraSummary);
+
+            // The displayed frame was converted for the previous display size, get it again in "pause and browse" mode.
+            if (!cameraConnected)
+            {
+                Bitmap delayed = delayer.GetWeak(delay, ImageRotation, Mirrored, viewportController.DisplayRectangle.Size, out _);
+                if (delayed != null)
+                {
+                    viewportController.ForgetBitmap();
+                    viewportController.Bitmap = delayed;
+                    viewportController.Refresh();
+                }
+            }
         }
 
         private void viewportController_Poked(object sender, EventArgs e)
@@ -1316,32 +1331,6 @@ namespace Kinovea.ScreenManager
         
         }
 
-        private double GetMonitorFramerate()
-        {
-            // Based on https://github.com/rickbrew/RefreshRateWpf/blob/master/RefreshRateWpfApp/MainWindow.xaml.cs
-            double defaultFramerate = 60;
-
-            IntPtr hmonitor = NativeMethods.MonitorFromWindow(viewportController.View.Handle, NativeMethods.MONITOR_DEFAULTTONEAREST);
-            if (hmonitor == IntPtr.Zero)
-                return defaultFramerate;
-
-            // Get more info about the monitor.
-            NativeMethods.MONITORINFOEXW monitorInfo = new NativeMethods.MONITORINFOEXW();
-            monitorInfo.cbSize = (uint)Marshal.SizeOf<NativeMethods.MONITORINFOEXW>();
-            bool result = NativeMethods.GetMonitorInfoW(hmonitor, ref monitorInfo);
-            if (!result)
-                return defaultFramerate;
-
-            // Get the current display settings for that monitor.
-            NativeMethods.DEVMODEW devMode = new NativeMethods.DEVMODEW();
-            devMode.dmSize = (ushort)Marshal.SizeOf<NativeMethods.DEVMODEW>();
-            result = NativeMethods.EnumDisplaySettingsW(monitorInfo.szDevice, NativeMethods.ENUM_CURRENT_SETTINGS, out devMode);
-            if (!result)
-                return defaultFramerate;
-
-            return (double)devMode.dmDisplayFrequency;
-        }
-
         /// <summary>
         /// Returns a textual representation of a time or duration in the user-preferred format.
         /// In the capture context this is only used to export user time for some drawings.
@@ -1391,6 +1380,18 @@ namespace Kinovea.ScreenManager
             view.UpdateNextVideoFilename(nextVideo);
         }
         
+        /// <summary>
+        /// Returns the displayed frame at full resolution. The caller owns the bitmap.
+        /// </summary>
+        private Bitmap GetFullResolutionFrame()
+        {
+            if (!cameraLoaded)
+                return null;
+
+            int age = (!cameraConnected || delayedDisplay) ? delay : 0;
+            return delayer.GetWeak(age, ImageRotation, Mirrored, out _);
+        }
+
         private void MakeSnapshot()
         {
             if (!cameraLoaded)
@@ -2034,7 +2035,7 @@ namespace Kinovea.ScreenManager
             // Force a refresh if we are not connected to the camera to enable "pause and browse".
             if (cameraLoaded && !cameraConnected)
             {
-                Bitmap delayed = delayer.GetWeak(delay, ImageRotation, Mirrored, out _);
+                Bitmap delayed = delayer.GetWeak(delay, ImageRotation, Mirrored, viewportController.DisplayRectangle.Size, out _);
                 viewportController.Bitmap = delayed;
                 viewportController.Refresh();
             }
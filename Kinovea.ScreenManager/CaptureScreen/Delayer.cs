@@ -9,6 +9,7 @@ using System.Drawing.Imaging;
 using System.Diagnostics;
 using System.Threading;
 using Kinovea.Services;
+using Kinovea.Video.FFMpeg;
 
 namespace Kinovea.ScreenManager
 {
@@ -43,8 +44,6 @@ namespace Kinovea.ScreenManager
         private bool allocated;
         private long availableMemory;
         private ImageDescriptor imageDescriptor;
-        int pitch;
-        byte[] tempJpeg;
         private Stopwatch stopwatch = new Stopwatch();
         private object lockerFrame = new object();
         private object lockerPosition = new object();
@@ -114,8 +113,6 @@ namespace Kinovea.ScreenManager
             {
                 // The following variables are used during frame -> bitmap conversion.
                 this.rect = new Rectangle(0, 0, imageDescriptor.Width, imageDescriptor.Height);
-                this.pitch = imageDescriptor.Width * 3;
-                this.tempJpeg = new byte[bufferSize];
 
                 this.allocated = true;
                 this.fullCapacity = frames.Count;
@@ -201,6 +198,16 @@ namespace Kinovea.ScreenManager
         /// to implement a waiting image.
         /// </summary>
         public Bitmap GetWeak(int age, ImageRotation rotation, bool mirror, out int target)
+        {
+            return GetWeak(age, rotation, mirror, Size.Empty, out target);
+        }
+
+        /// <summary>
+        /// Get the frame from `age` frames ago as an RGB24 Bitmap, correctly oriented, for display at the passed size.
+        /// The image is converted at a reduced size, still covering the display size, when the full image would be scaled down anyway.
+        /// Pass an empty display size to get the image at full resolution.
+        /// </summary>
+        public Bitmap GetWeak(int age, ImageRotation rotation, bool mirror, Size displaySize, out int target)
         {
             //----------------------------------------------------
             // Runs in the UI thread, to get the image to display.
@@ -221,48 +228,20 @@ namespace Kinovea.ScreenManager
 
                     // Returns a newly allocated RGB24 bitmap.
                     // TODO: maybe get a pre-allocated bitmap from caller.
-                    copy = new Bitmap(imageDescriptor.Width, imageDescriptor.Height, PixelFormat.Format24bppRgb);
+                    int factor;
+                    Size decodingSize = GetDecodingSize(displaySize, rotation, out factor);
+                    copy = new Bitmap(decodingSize.Width, decodingSize.Height, PixelFormat.Format24bppRgb);
 
-                    switch (imageDescriptor.Format)
-                    {
-                        case Kinovea.Services.ImageFormat.RGB24:
-                            BitmapHelper.FillFromRGB24(copy, rect, imageDescriptor.TopDown, frame.Buffer);
-                            break;
-                        case Kinovea.Services.ImageFormat.RGB32:
-                            BitmapHelper.FillFromRGB32(copy, rect, imageDescriptor.TopDown, frame.Buffer);
-                            break;
-                        case Kinovea.Services.ImageFormat.Y800:
-                            BitmapHelper.FillFromY800(copy, rect, imageDescriptor.TopDown, frame.Buffer);
-                            break;
-                        case Kinovea.Services.ImageFormat.JPEG:
-                            BitmapHelper.FillFromJPEG(copy, rect, tempJpeg, frame.Buffer, frame.PayloadLength, pitch);
-                            break;
-                    }
+                    if (factor > 1)
+                        FillScaled(copy, frame, factor);
+                    else
+                        Fill(copy, frame);
 
-                    switch (rotation)
+                    Bitmap rotated = ImageKernels.RotateFlip(copy, rotation, mirror);
+                    if (rotated != copy)
                     {
-                        case ImageRotation.Rotate90:
-                            if (mirror)
-                                copy.RotateFlip(RotateFlipType.Rotate90FlipX);
-                            else
-                                copy.RotateFlip(RotateFlipType.Rotate90FlipNone);
-                            break;
-                        case ImageRotation.Rotate180:
-                            if (mirror)
-                                copy.RotateFlip(RotateFlipType.Rotate180FlipX);
-                            else
-                                copy.RotateFlip(RotateFlipType.Rotate180FlipNone);
-                            break;
-                        case ImageRotation.Rotate270:
-                            if (mirror)
-                                copy.RotateFlip(RotateFlipType.Rotate270FlipX);
-                            else
-                                copy.RotateFlip(RotateFlipType.Rotate270FlipNone);
-                            break;
-                        default:
-                            if (mirror)
-                                copy.RotateFlip(RotateFlipType.RotateNoneFlipX);
-                            break;
+                        copy.Dispose();
+                        copy = rotated;
                     }
                 }
                 catch
@@ -343,6 +322,66 @@ namespace Kinovea.ScreenManager
             log.DebugFormat("Freed delay buffer: {0} ms. Total: {1} frames.", stopwatch.ElapsedMilliseconds, frames.Count);
         }
         
+        private void Fill(Bitmap copy, Frame frame)
+        {
+            switch (imageDescriptor.Format)
+            {
+                case Kinovea.Services.ImageFormat.RGB24:
+                case Kinovea.Services.ImageFormat.RGB32:
+                case Kinovea.Services.ImageFormat.Y800:
+                    ImageKernels.Fill(copy, frame.Buffer, imageDescriptor.Format, imageDescriptor.TopDown);
+                    break;
+                case Kinovea.Services.ImageFormat.JPEG:
+                    // The bitmap may be at a reduced size, the JPEG is then decoded with the scaled IDCT.
+                    BitmapHelper.FillFromJPEG(copy, frame.Buffer, frame.PayloadLength);
+                    break;
+            }
+        }
+
+        private void FillScaled(Bitmap copy, Frame frame, int factor)
+        {
+            Size imageSize = rect.Size;
+            switch (imageDescriptor.Format)
+            {
+                case Kinovea.Services.ImageFormat.RGB24:
+                    BitmapHelper.FillFromRGB24Scaled(copy, imageSize, imageDescriptor.TopDown, frame.Buffer, factor);
+                    break;
+                case Kinovea.Services.ImageFormat.RGB32:
+                    BitmapHelper.FillFromRGB32Scaled(copy, imageSize, imageDescriptor.TopDown, frame.Buffer, factor);
+                    break;
+                case Kinovea.Services.ImageFormat.Y800:
+                    BitmapHelper.FillFromY800Scaled(copy, imageSize, imageDescriptor.TopDown, frame.Buffer, factor);
+                    break;
+            }
+        }
+
+        /// <summary>
+        /// Returns the size at which to convert the frame for display.
+        /// This is the smallest size supported by the conversion that still covers the display size:
+        /// the scaled IDCT sizes for JPEG, and integer reductions for the uncompressed formats.
+        /// The factor is the integer reduction, or 1 if the frame is converted by the regular path.
+        /// </summary>
+        private Size GetDecodingSize(Size displaySize, ImageRotation rotation, out int factor)
+        {
+            factor = 1;
+            Size imageSize = rect.Size;
+            if (displaySize.Width <= 0 || displaySize.Height <= 0)
+                return imageSize;
+
+            // The display size is expressed after rotation.
+            if (rotation == ImageRotation.Rotate90 || rotation == ImageRotation.Rotate270)
+                displaySize = new Size(displaySize.Height, displaySize.Width);
+
+            if (displaySize.Width >= imageSize.Width || displaySize.Height >= imageSize.Height)
+                return imageSize;
+
+            if (imageDescriptor.Format == Kinovea.Services.ImageFormat.JPEG)
+                return BitmapHelper.GetJPEGScaledSize(imageSize, displaySize);
+
+            factor = Math.Max(1, Math.Min(imageSize.Width / displaySize.Width, imageSize.Height / displaySize.Height));
+            return new Size(imageSize.Width / factor, imageSize.Height / factor);
+        }
+
         private void ResetData()
         {
             allocated = false;
@@ -232,6 +232,14 @@ namespace Kinovea.ScreenManager
             metadata.InitializeEnd(cancelLastPoint);
         }
 
+        /// <summary>
+        /// Flags the metadata as modified after a drawing was changed from its context menu.
+        /// </summary>
+        public void SetDirty()
+        {
+            metadata.SetDirty();
+        }
+
         private void CreateNewDrawing(PointF imagePoint, ImageToViewportTransformer transformer)
         {
             int keyframeIndex = 0;
@@ -49,6 +49,16 @@ namespace Kinovea.ScreenManager
             set { bitmap = value; }
         }
 
+        /// <summary>
+        /// Provides the displayed frame at full resolution, the displayed bitmap may have been converted at a reduced size.
+        /// The returned bitmap is owned by the caller.
+        /// </summary>
+        public Func<Bitmap> FullFrameProvider
+        {
+            get { return fullFrameProvider; }
+            set { fullFrameProvider = value; }
+        }
+
         public long Timestamp
         {
             get { return timestamp; }
@@ -88,6 +98,7 @@ namespace Kinovea.ScreenManager
         #region Members
         private Viewport view;
         private Bitmap bitmap;
+        private Func<Bitmap> fullFrameProvider;
         private long timestamp;
         private Rectangle displayRectangle;
         private MetadataRenderer metadataRenderer;
@@ -175,7 +186,16 @@ namespace Kinovea.ScreenManager
             if (metadataManipulator == null)
                 return;
 
-            metadataManipulator.OnMouseUp(bitmap, mouse, modifiers, imageLocation, imageZoom);
+            // The track points are updated from the image at mouse up, their templates must be taken at full resolution.
+            Bitmap fullFrame = null;
+            if (fullFrameProvider != null && metadataManipulator.IsUsingHandTool)
+                fullFrame = fullFrameProvider();
+
+            metadataManipulator.OnMouseUp(fullFrameProvider != null ? fullFrame : bitmap, mouse, modifiers, imageLocation, imageZoom);
+
+            if (fullFrame != null)
+                fullFrame.Dispose();
+
             Refresh();
         }
 
@@ -213,6 +233,9 @@ namespace Kinovea.ScreenManager
         }
         public void InvalidateFromMenu()
         {
+            if (metadataManipulator != null)
+                metadataManipulator.SetDirty();
+
             DoInvalidate();
         }
         public void InitializeEndFromMenu(bool cancelLastPoint)
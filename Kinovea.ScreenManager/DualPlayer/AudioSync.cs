@@ -0,0 +1,158 @@
+﻿using System;
+using System.ComponentModel;
+using Emgu.CV;
+using Emgu.CV.CvEnum;
+using Kinovea.Video;
+
+namespace Kinovea.ScreenManager
+{
+    /// <summary>
+    /// Finds the time offset between two videos by cross-correlating their audio tracks.
+    ///
+    /// Both tracks are decoded to mono at a low sample rate. This keeps the envelope of claps, impacts and speech,
+    /// which is what the alignment relies on, and keeps a 10-minute clip at a few million samples.
+    /// The cross-correlation is computed in the frequency domain and the peak is refined to a fraction of a sample,
+    /// well below the duration of a video frame.
+    /// </summary>
+    public static class AudioSync
+    {
+        /// <summary>
+        /// Sample rate of the decoded tracks. The resolution before peak interpolation is 0.25 ms.
+        /// </summary>
+        public const int SampleRate = 4000;
+
+        private static readonly log4net.ILog log = log4net.LogManager.GetLogger(System.Reflection.MethodBase.GetCurrentMethod().DeclaringType);
+
+        /// <summary>
+        /// Computes the offset in seconds between the audio tracks of the two videos.
+        /// The offset is the time of a sound in the right video minus the time of the same sound in the left video,
+        /// both on the timeline of their file.
+        /// Runs on the worker thread, progress is reported as a percentage.
+        /// Returns false if a file has no usable audio or the worker was cancelled.
+        /// </summary>
+        public static bool ComputeOffset(VideoReader leftReader, VideoReader rightReader, BackgroundWorker worker, out double offset)
+        {
+            offset = 0;
+
+            float[] left = Extract(leftReader, worker, 0, 45);
+            if (left == null)
+                return false;
+
+            float[] right = Extract(rightReader, worker, 45, 45);
+            if (right == null)
+                return false;
+
+            worker.ReportProgress(90, 100);
+
+            double lag;
+            if (!Correlate(left, right, out lag))
+                return false;
+
+            worker.ReportProgress(100, 100);
+
+            offset = lag / SampleRate;
+            log.DebugFormat("Audio offset between the videos: {0:0.0000} s.", offset);
+            return true;
+        }
+
+        private static float[] Extract(VideoReader reader, BackgroundWorker worker, int start, int span)
+        {
+            float[] samples = reader.ExtractAudio(reader.FilePath, SampleRate, (progress) =>
+            {
+                if (worker.CancellationPending)
+                    return false;
+
+                worker.ReportProgress(start + (int)(progress * span), 100);
+                return true;
+            });
+
+            if (samples == null || samples.Length == 0)
+            {
+                log.DebugFormat("No audio extracted from {0}.", reader.FilePath);
+                return null;
+            }
+
+            return samples;
+        }
+
+        /// <summary>
+        /// Finds the lag in samples that best aligns b onto a, that is, maximizes the sum of a[t] * b[t + lag].
+        /// </summary>
+        private static bool Correlate(float[] a, float[] b, out double lag)
+        {
+            lag = 0;
+
+            double energyA = RemoveMean(a);
+            double energyB = RemoveMean(b);
+            if (energyA == 0 || energyB == 0)
+            {
+                log.Debug("Silent audio track, the videos cannot be synchronized on audio.");
+                return false;
+            }
+
+            // Zero-padding to at least the sum of the lengths avoids the circular wrap-around of the correlation.
+            int n = CvInvoke.cvGetOptimalDFTSize(a.Length + b.Length);
+            float[,] bufferA = new float[1, n];
+            float[,] bufferB = new float[1, n];
+            Buffer.BlockCopy(a, 0, bufferA, 0, a.Length * sizeof(float));
+            Buffer.BlockCopy(b, 0, bufferB, 0, b.Length * sizeof(float));
+
+            // The matrices wrap the arrays, the result is read back from bufferB.
+            using (Matrix<float> matA = new Matrix<float>(bufferA))
+            using (Matrix<float> matB = new Matrix<float>(bufferB))
+            {
+                CvInvoke.cvDFT(matA.Ptr, matA.Ptr, CV_DXT.CV_DXT_FORWARD, 0);
+                CvInvoke.cvDFT(matB.Ptr, matB.Ptr, CV_DXT.CV_DXT_FORWARD, 0);
+                CvInvoke.cvMulSpectrums(matB.Ptr, matA.Ptr, matB.Ptr, MUL_SPECTRUMS_TYPE.CV_DXT_MUL_CONJ);
+                CvInvoke.cvDFT(matB.Ptr, matB.Ptr, CV_DXT.CV_DXT_INV_SCALE, 0);
+            }
+
+            // Positive lags are at the start of the buffer, negative lags wrap around at the end.
+            int best = 0;
+            float peak = float.MinValue;
+            for (int i = 0; i < n; i++)
+            {
+                bool valid = i < b.Length || i > n - a.Length;
+                if (valid && bufferB[0, i] > peak)
+                {
+                    peak = bufferB[0, i];
+                    best = i;
+                }
+            }
+
+            // Parabolic interpolation around the peak.
+            double y0 = bufferB[0, (best + n - 1) % n];
+            double y1 = bufferB[0, best];
+            double y2 = bufferB[0, (best + 1) % n];
+            double denominator = y0 - 2 * y1 + y2;
+            double delta = denominator < 0 ? 0.5 * (y0 - y2) / denominator : 0;
+
+            lag = (best < b.Length ? best : best - n) + delta;
+
+            log.DebugFormat("Audio cross-correlation: {0} + {1} samples, peak lag: {2:0.00}, normalized peak: {3:0.000}.",
+                a.Length, b.Length, lag, peak / Math.Sqrt(energyA * energyB));
+
+            return true;
+        }
+
+        /// <summary>
+        /// Removes the DC component in place and returns the energy of the remaining signal.
+        /// </summary>
+        private static double RemoveMean(float[] samples)
+        {
+            double sum = 0;
+            for (int i = 0; i < samples.Length; i++)
+                sum += samples[i];
+
+            float mean = (float)(sum / samples.Length);
+            double energy = 0;
+            for (int i = 0; i < samples.Length; i++)
+            {
+                samples[i] -= mean;
+                energy += samples[i] * samples[i];
+            }
+
+            return energy;
+        }
+    }
+}
@@ -43,6 +43,7 @@ namespace Kinovea.ScreenManager
         public event EventHandler SwapAsked;
         public event EventHandler AddKeyframe;
         public event EventHandler SyncAsked;
+        public event EventHandler AudioSyncAsked;
         public event EventHandler MergeAsked;
         public event EventHandler<TimeEventArgs> PositionChanged;
         public event EventHandler DualSaveAsked;
@@ -202,6 +203,10 @@ namespace Kinovea.ScreenManager
                     if (AddKeyframe != null)
                         AddKeyframe(this, EventArgs.Empty);
                     break;
+                case DualPlayerCommands.SyncOnAudio:
+                    if (AudioSyncAsked != null)
+                        AudioSyncAsked(this, EventArgs.Empty);
+                    break;
                 default:
                     return base.ExecuteCommand(cmd);
             }
@@ -281,6 +286,15 @@ namespace Kinovea.ScreenManager
         }
         private void btnSync_Click(object sender, EventArgs e)
         {
+            // Shift + click: find the sync point from the audio tracks.
+            if ((ModifierKeys & Keys.Shift) == Keys.Shift)
+            {
+                if (AudioSyncAsked != null)
+                    AudioSyncAsked(this, EventArgs.Empty);
+
+                return;
+            }
+
             if (SyncAsked != null)
                 SyncAsked(this, EventArgs.Empty);
         }
@@ -0,0 +1,148 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Drawing;
+using System.Drawing.Imaging;
+using Kinovea.Video;
+
+namespace Kinovea.ScreenManager
+{
+    /// <summary>
+    /// One side of a dual video export.
+    /// Opens its own reader on the player's file so the export doesn't seek the player on screen,
+    /// and walks the video sequentially as the common time advances.
+    /// The current image is painted with the drawings of the player.
+    /// </summary>
+    public class DualExportSource : IDisposable
+    {
+        /// <summary>
+        /// Image of the frame at the last requested common time, with drawings.
+        /// </summary>
+        public Bitmap Image
+        {
+            get { return image; }
+        }
+
+        private PlayerScreen player;
+        private CommonTimeline commonTimeline;
+        private VideoReader reader;
+        private IEnumerator<VideoFrame> frames;
+        private VideoFrame pending;
+        private Bitmap image;
+        private long currentTimestamp;
+        private long endTimestamp;
+        private static readonly log4net.ILog log = log4net.LogManager.GetLogger(System.Reflection.MethodBase.GetCurrentMethod().DeclaringType);
+
+        public DualExportSource(PlayerScreen player, CommonTimeline commonTimeline)
+        {
+            this.player = player;
+            this.commonTimeline = commonTimeline;
+        }
+
+        /// <summary>
+        /// Opens a second reader of the same type, with the same options and frame transform as the player's,
+        /// and positions it at the start of the common timeline.
+        /// </summary>
+        public bool Open()
+        {
+            VideoReader source = player.FrameServer.VideoReader;
+            if (source == null || !source.Loaded)
+                return false;
+
+            try
+            {
+                reader = (VideoReader)Activator.CreateInstance(source.GetType());
+                reader.Options = new VideoOptions(source.Options.ImageAspectRatio, source.Options.ImageRotation, source.Options.Demosaicing, source.Options.Deinterlace);
+                OpenVideoResult result = reader.Open(source.FilePath);
+                if (result != OpenVideoResult.Success)
+                {
+                    log.ErrorFormat("Dual export: could not open a second reader on {0}. {1}", source.FilePath, result);
+                    reader = null;
+                    return false;
+                }
+
+                if (reader.CanChangeFrameTransform)
+                    reader.ChangeFrameTransform(player.FrameServer.GetFrameTransform());
+            }
+            catch (Exception e)
+            {
+                log.ErrorFormat("Dual export: could not open a second reader on {0}.", source.FilePath);
+                log.Error(e);
+                reader = null;
+                return false;
+            }
+
+            endTimestamp = source.WorkingZone.End;
+
+            reader.BeforeFrameEnumeration();
+            frames = reader.FrameEnumerator(GetTimestamp(0), 0).GetEnumerator();
+            pending = frames.MoveNext() ? frames.Current : null;
+            return true;
+        }
+
+        /// <summary>
+        /// Moves forward to the frame the player would show at this common time: the first frame at or after it, or the last frame.
+        /// Frames are only ever decoded in sequence, and only the frame kept is painted with its drawings.
+        /// </summary>
+        public void MoveTo(long commonTime)
+        {
+            long target = GetTimestamp(commonTime);
+
+            while (pending != null && pending.Image != null && (image == null || currentTimestamp < target))
+            {
+                VideoFrame frame = pending;
+                bool flushed = frame.Timestamp >= target;
+                if (flushed)
+                    Flush(frame);
+
+                // The frame enumerator yields the last frame again when it reaches the end.
+                // The reader doesn't move in that case so the skipped frame is still valid and can be kept.
+                pending = frames.MoveNext() ? frames.Current : null;
+                if (pending == null || pending.Timestamp <= frame.Timestamp)
+                {
+                    if (!flushed)
+                        Flush(frame);
+
+                    pending = null;
+                }
+            }
+        }
+
+        public void Dispose()
+        {
+            if (reader != null)
+            {
+                frames.Dispose();
+                reader.AfterFrameEnumeration();
+                reader.Close();
+                reader = null;
+            }
+
+            if (image != null)
+            {
+                image.Dispose();
+                image = null;
+            }
+        }
+
+        private void Flush(VideoFrame frame)
+        {
+            if (image == null || image.Size != frame.Image.Size)
+            {
+                if (image != null)
+                    image.Dispose();
+
+                image = new Bitmap(frame.Image.Width, frame.Image.Height, PixelFormat.Format24bppRgb);
+            }
+
+            player.GetFlushedImage(frame, image);
+            currentTimestamp = frame.Timestamp;
+        }
+
+        private long GetTimestamp(long commonTime)
+        {
+            long localTime = Math.Max(0, commonTimeline.GetLocalTime(player, commonTime));
+            long timestamp = player.RelativeRealTimeToAbsoluteTimestamp(localTime);
+            return Math.Min(timestamp, endTimestamp);
+        }
+    }
+}
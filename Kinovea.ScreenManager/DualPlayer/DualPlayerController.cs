@@ -4,7 +4,9 @@ using System.Linq;
 using System.Text;
 using System.Windows.Forms;
 using System.Drawing;
+using System.ComponentModel;
 using Kinovea.Services;
+using Kinovea.Video;
 
 namespace Kinovea.ScreenManager
 {
@@ -55,6 +57,7 @@ namespace Kinovea.ScreenManager
             view.GotoSync += CCtrl_GotoSync;
             view.AddKeyframe += CCtrl_AddKeyframe;
             view.SyncAsked += CCtrl_SyncAsked;
+            view.AudioSyncAsked += CCtrl_AudioSyncAsked;
             view.MergeAsked += CCtrl_MergeAsked;
             view.PositionChanged += CCtrl_PositionChanged;
             view.DualSaveAsked += CCtrl_DualSaveAsked;
@@ -378,6 +381,32 @@ namespace Kinovea.ScreenManager
             SetSyncPoint(false);
             GotoTime(currentTime, true);
         }
+        private void CCtrl_AudioSyncAsked(object sender, EventArgs e)
+        {
+            if (!synching)
+                return;
+
+            Pause();
+
+            VideoReader leftReader = players[0].FrameServer.VideoReader;
+            VideoReader rightReader = players[1].FrameServer.VideoReader;
+            double offset = 0;
+            bool found = false;
+            
+            formProgressBar2 fpb = new formProgressBar2(true, true, (s, args) =>
+            {
+                found = AudioSync.ComputeOffset(leftReader, rightReader, s as BackgroundWorker, out offset);
+            });
+
+            fpb.ShowDialog();
+            fpb.Dispose();
+
+            if (!found)
+                return;
+
+            SetSyncOffset(offset);
+            GotoTime(currentTime, true);
+        }
         private void CCtrl_MergeAsked(object sender, EventArgs e)
         {
             if (!synching)
@@ -596,6 +625,27 @@ namespace Kinovea.ScreenManager
             players[0].LocalTimeOriginPhysical = players[0].LocalTime;
             players[1].LocalTimeOriginPhysical = players[1].LocalTime;
 
+            UpdateSyncPoint();
+        }
+
+        /// <summary>
+        /// Sets the time origins at the current left frame and at the moment of the right video playing the same sound.
+        /// The offset is in seconds, between the timelines of the files. The right origin is not necessarily on a frame.
+        /// </summary>
+        private void SetSyncOffset(double offset)
+        {
+            log.DebugFormat("Resetting time origins from audio. [0]:{0}, offset:{1:0.0000} s", players[0].LocalTime, offset);
+            players[0].LocalTimeOriginPhysical = players[0].LocalTime;
+
+            double leftSeconds = players[0].AbsoluteTimeOrigin / players[0].FrameServer.VideoReader.Info.AverageTimeStampsPerSeconds;
+            double rightTimestampsPerSecond = players[1].FrameServer.VideoReader.Info.AverageTimeStampsPerSeconds;
+            players[1].AbsoluteTimeOrigin = (long)Math.Round((leftSeconds + offset) * rightTimestampsPerSecond);
+
+            UpdateSyncPoint();
+        }
+
+        private void UpdateSyncPoint()
+        {
             commonTimeline.Initialize(players[0], players[1]);
             currentTime = commonTimeline.GetCommonTime(players[0], players[0].LocalTime);
             
@@ -9,6 +9,8 @@ using Kinovea.Video.FFMpeg;
 using System.ComponentModel;
 using Kinovea.Services;
 using System.Drawing;
+using System.Drawing.Imaging;
+using System.Threading.Tasks;
 using Kinovea.Video;
 
 namespace Kinovea.ScreenManager
@@ -16,6 +18,9 @@ namespace Kinovea.ScreenManager
     /// <summary>
     /// Create and save a composite video with side by side synchronized images.
     /// If merge is active, only saves the left video.
+    /// 
+    /// Side by side export doesn't touch the players on screen: each side is decoded sequentially by its own reader,
+    /// both sides are decoded concurrently, and the encoding of a composite overlaps with the decoding of the next one.
     /// </summary>
     public class DualVideoExporter
     {
@@ -26,6 +31,7 @@ namespace Kinovea.ScreenManager
         private string dualSaveFileName;
         private bool dualSaveCancelled;
         private bool merging;
+        private bool savingContextOpen;
         
         private VideoFileWriter videoFileWriter = new VideoFileWriter();
         private BackgroundWorker bgWorkerDualSave;
@@ -48,6 +54,7 @@ namespace Kinovea.ScreenManager
                 return;
 
             dualSaveCancelled = false;
+            savingContextOpen = false;
             
             // Instanciate and configure the bgWorker.
             bgWorkerDualSave = new BackgroundWorker();
@@ -96,13 +103,168 @@ namespace Kinovea.ScreenManager
         private void bgWorkerDualSave_DoWork(object sender, DoWorkEventArgs e)
         {
             // This is executed in Worker Thread space. (Do not call any UI methods)
+            try
+            {
+                e.Result = merging ? SaveMerged() : SaveSideBySide();
+            }
+            catch (Exception exception)
+            {
+                log.ErrorFormat("Error while saving dual video. {0}", exception);
+                e.Result = 2;
+            }
+        }
+
+        /// <summary>
+        /// Saves the side by side video. Returns 0 on success, 1 if cancelled, 2 on error.
+        /// </summary>
+        private int SaveSideBySide()
+        {
             log.Debug("Saving side by side video.");
 
+            DualExportSource left = new DualExportSource(leftPlayer, commonTimeline);
+            DualExportSource right = new DualExportSource(rightPlayer, commonTimeline);
+            Bitmap[] composites = new Bitmap[2];
+            Task encoding = null;
+            int threadResult = 0;
+
+            try
+            {
+                if (!left.Open() || !right.Open())
+                    return 2;
+
+                long currentTime = 0;
+                MoveTo(left, right, currentTime);
+                if (left.Image == null || right.Image == null)
+                    return 2;
+
+                // The composites are allocated once and used in turn: one is being encoded while the other is being composed.
+                Size compositeSize = GetCompositeSize(left.Image.Size, right.Image.Size);
+                log.DebugFormat("Composite size: {0}.", compositeSize);
+                for (int i = 0; i < composites.Length; i++)
+                    composites[i] = new Bitmap(compositeSize.Width, compositeSize.Height, PixelFormat.Format24bppRgb);
+
+                VideoInfo info = new VideoInfo
+                {
+                    ReferenceSize = compositeSize
+                };
+
+                string formatString = FilenameHelper.GetFormatString(dualSaveFileName);
+                SaveResult result = videoFileWriter.OpenSavingContext(dualSaveFileName, info, formatString, fileFrameInterval);
+                if (result != SaveResult.Success)
+                    return 2;
+
+                savingContextOpen = true;
+
+                int index = 0;
+                while (true)
+                {
+                    Bitmap composite = composites[index % composites.Length];
+                    Compose(left.Image, right.Image, composite);
+
+                    if (encoding != null)
+                        encoding.Wait();
+
+                    encoding = Task.Factory.StartNew(() => videoFileWriter.SaveFrame(composite));
+                    index++;
+
+                    if (currentTime >= commonTimeline.LastTime || dualSaveCancelled)
+                        break;
+
+                    if (bgWorkerDualSave.CancellationPending)
+                    {
+                        threadResult = 1;
+                        dualSaveCancelled = true;
+                        break;
+                    }
+
+                    // Decode the next images while the encoder works on this one.
+                    currentTime += commonTimeline.FrameTime;
+                    MoveTo(left, right, currentTime);
+
+                    int percent = (int)((double)currentTime * 100 / commonTimeline.LastTime);
+                    bgWorkerDualSave.ReportProgress(percent);
+                }
+
+                encoding.Wait();
+                encoding = null;
+            }
+            finally
+            {
+                if (encoding != null)
+                {
+                    try
+                    {
+                        encoding.Wait();
+                    }
+                    catch (AggregateException)
+                    {
+                    }
+                }
+
+                left.Dispose();
+                right.Dispose();
+                foreach (Bitmap composite in composites)
+                {
+                    if (composite != null)
+                        composite.Dispose();
+                }
+            }
+
+            return dualSaveCancelled ? 1 : threadResult;
+        }
+
+        /// <summary>
+        /// Moves both sides to the common time concurrently.
+        /// </summary>
+        private void MoveTo(DualExportSource left, DualExportSource right, long commonTime)
+        {
+            Parallel.Invoke(() => left.MoveTo(commonTime), () => right.MoveTo(commonTime));
+        }
+
+        /// <summary>
+        /// Size of the side by side composite, same layout as ImageHelper.GetSideBySideComposite for video.
+        /// </summary>
+        private Size GetCompositeSize(Size leftSize, Size rightSize)
+        {
+            int height = Math.Max(leftSize.Height, rightSize.Height);
+            int width = leftSize.Width + rightSize.Width;
+
+            if (height % 2 != 0)
+                height++;
+
+            if (width % 4 != 0)
+                width += 4 - (width % 4);
+
+            return new Size(width, height);
+        }
+
+        private void Compose(Bitmap leftImage, Bitmap rightImage, Bitmap composite)
+        {
+            // Vertically center the shortest image.
+            int leftTop = (composite.Height - leftImage.Height) / 2;
+            int rightTop = (composite.Height - rightImage.Height) / 2;
+
+            using (Graphics g = Graphics.FromImage(composite))
+            {
+                g.DrawImage(leftImage, new Rectangle(0, leftTop, leftImage.Width, leftImage.Height));
+                g.DrawImage(rightImage, new Rectangle(leftImage.Width, rightTop, rightImage.Width, rightImage.Height));
+            }
+        }
+
+        /// <summary>
+        /// Saves the left video with the right one merged in. 
+        /// The merge image is pushed by the other player on screen, so this goes through the players themselves.
+        /// Returns 0 on success, 1 if cancelled, 2 on error.
+        /// </summary>
+        private int SaveMerged()
+        {
+            log.Debug("Saving merged video.");
+
             int threadResult = 0;
             
             // Get first frame outside the loop to set up the saving context.
             long currentTime = 0;
-            Bitmap composite = GetCompositeImage(currentTime);
+            Bitmap composite = GetMergedImage(currentTime);
             
             log.DebugFormat("Composite size: {0}.", composite.Size);
 
@@ -117,10 +279,11 @@ namespace Kinovea.ScreenManager
 
             if (result != SaveResult.Success)
             {
-                e.Result = 2;
-                return;
+                composite.Dispose();
+                return 2;
             }
 
+            savingContextOpen = true;
             videoFileWriter.SaveFrame(composite);
             composite.Dispose();
             
@@ -135,7 +298,7 @@ namespace Kinovea.ScreenManager
                     break;
                 }
 
-                composite = GetCompositeImage(currentTime);
+                composite = GetMergedImage(currentTime);
                 videoFileWriter.SaveFrame(composite);
                 composite.Dispose();
 
@@ -146,7 +309,7 @@ namespace Kinovea.ScreenManager
             if (!dualSaveCancelled)
                 threadResult = 0;
             
-            e.Result = threadResult;
+            return threadResult;
         }
         
         private void GotoTime(PlayerScreen player, long commonTime)
@@ -156,36 +319,25 @@ namespace Kinovea.ScreenManager
             player.GotoTime(localTime, false);
         }
 
-        private Bitmap GetCompositeImage(long currentTime)
+        private Bitmap GetMergedImage(long currentTime)
         {
-            Bitmap composite;
-
             GotoTime(leftPlayer, currentTime);
             GotoTime(rightPlayer, currentTime);
 
             Bitmap img1 = leftPlayer.GetFlushedImage();
 
-            if (!merging)
-            {
-                Bitmap img2 = rightPlayer.GetFlushedImage();
-                composite = ImageHelper.GetSideBySideComposite(img1, img2, true, true);
-                img2.Dispose();
-            }
-            else
-            {
-                int height = img1.Height;
-                int width = img1.Width;
+            int height = img1.Height;
+            int width = img1.Width;
 
-                if (img1.Height % 2 != 0)
-                    height++;
+            if (img1.Height % 2 != 0)
+                height++;
 
-                if (width % 4 != 0)
-                    width += 4 - (width % 4);
+            if (width % 4 != 0)
+                width += 4 - (width % 4);
 
-                composite = new Bitmap(width, height, img1.PixelFormat);
-                Graphics g = Graphics.FromImage(composite);
+            Bitmap composite = new Bitmap(width, height, img1.PixelFormat);
+            using (Graphics g = Graphics.FromImage(composite))
                 g.DrawImage(img1, Point.Empty);
-            }
 
             img1.Dispose();
             
@@ -207,8 +359,11 @@ namespace Kinovea.ScreenManager
                 dualSaveProgressBar.Close();
                 dualSaveProgressBar.Dispose();
 
-                if (!dualSaveCancelled && (int)e.Result != 1 && videoFileWriter != null)
-                    videoFileWriter.CloseSavingContext((int)e.Result == 0);
+                // The context is only closed here, once the worker is done with the encoder.
+                if (savingContextOpen)
+                    videoFileWriter.CloseSavingContext(!dualSaveCancelled && (int)e.Result == 0);
+
+                savingContextOpen = false;
             }
             catch (Exception exception)
             {
@@ -221,9 +376,7 @@ namespace Kinovea.ScreenManager
         private void dualSave_CancelAsked(object sender, EventArgs e)
         {
             // This will simply set BgWorker.CancellationPending to true, which we check periodically in the saving loop.
-            // This will also end the bgWorker immediately, maybe before we check for the cancellation in the other thread. 
-            
-            videoFileWriter.CloseSavingContext(false);
+            // The saving context is closed when the worker completes, as the encoder may still be working on a frame.
             dualSaveCancelled = true;
             bgWorkerDualSave.CancelAsync();
         }
@@ -3084,6 +3084,15 @@ namespace Kinovea.ScreenManager.Languages {
             }
         }
         
+        /// <summary>
+        ///   Looks up a localized string similar to Track to end of working zone.
+        /// </summary>
+        public static string mnuTrackToEndOfZone {
+            get {
+                return ResourceManager.GetString("mnuTrackToEndOfZone", resourceCulture);
+            }
+        }
+        
         /// <summary>
         ///   Looks up a localized string similar to Track path.
         /// </summary>
@@ -3120,6 +3129,15 @@ namespace Kinovea.ScreenManager.Languages {
             }
         }
         
+        /// <summary>
+        ///   Looks up a localized string similar to Correct lens distortion.
+        /// </summary>
+        public static string mnuUndistort {
+            get {
+                return ResourceManager.GetString("mnuUndistort", resourceCulture);
+            }
+        }
+        
         /// <summary>
         ///   Looks up a localized string similar to Configure custom fading.
         /// </summary>
@@ -110,6 +110,21 @@ namespace Kinovea.ScreenManager
             get { return distortionHelper; }
         }
 
+        /// <summary>
+        /// Whether the images are undistorted by the reader.
+        /// In this case drawings are in rectified space and no further lens distortion correction is done.
+        /// </summary>
+        public bool ImageRectified
+        {
+            get { return imageRectified; }
+            set
+            {
+                imageRectified = value;
+                distortionHelper.ImageRectified = value;
+                AfterCalibrationChanged();
+            }
+        }
+
         public Size ImageSize
         {
             get { return imageSize; }
@@ -137,6 +152,7 @@ namespace Kinovea.ScreenManager
         private CalibratorType calibratorType = CalibratorType.Line;
         private CalibratorPlane calibrator = new CalibratorPlane();
         private DistortionHelper distortionHelper = new DistortionHelper();
+        private bool imageRectified;
         private Guid calibrationDrawingId;
         private Size imageSize;
         private CoordinateSystemGrid coordinateSystemGrid;
@@ -185,6 +201,7 @@ namespace Kinovea.ScreenManager
             calibrator.Initialize(100, center, new PointF(center.X + 100, center.Y), CalibrationAxis.LineHorizontal);
 
             distortionHelper = new DistortionHelper();
+            distortionHelper.ImageRectified = imageRectified;
 
             lengthUnit = LengthUnit.Pixels;
             
@@ -20,8 +20,10 @@ along with Kinovea. If not, see http://www.gnu.org/licenses/.
 #endregion
 using System;
 using System.Collections.Generic;
+using System.Collections.Concurrent;
 using System.Linq;
 using System.Text;
+using System.Threading.Tasks;
 
 namespace Kinovea.ScreenManager
 {
@@ -39,13 +41,26 @@ namespace Kinovea.ScreenManager
     /// Ref: "A procedure for the automatic determination of filter cutoff frequency for the processing of biomechanical data", John Challis, JAB, 1999, 15, 303-317.
     ///
     /// The autocorrelation of residuals is estimated using the Durbin-Watson statistic.
+    ///
+    /// The cutoff frequencies are tested in parallel. The intermediate passes are done in pooled scratch buffers,
+    /// only the final filtered values are allocated for each cutoff.
     /// </summary>
     public class ButterworthFilter
     {
-        private double a0, a1, a2;
-        private double b1, b2;
-        private double x0, x1, x2, y0, y1, y2; 
-        private double correctionFactor;
+        private class Scratch
+        {
+            public double[] Forward = new double[0];
+            public double[] Backward = new double[0];
+        }
+
+        private struct Coefficients
+        {
+            public double A0, A1, A2;
+            public double B1, B2;
+        }
+
+        private const int padding = 10;
+        private static ConcurrentBag<Scratch> scratchPool = new ConcurrentBag<Scratch>();
 
         /// <summary>
         /// Filter a list of samples and return a list of lists of filtered values at various test cutoff frequencies.
@@ -60,12 +75,9 @@ namespace Kinovea.ScreenManager
             if (samples.Length <= 10)
                 throw new ArgumentException("Number of samples must be superior to 10");
 
-            List<FilteringResult> results = new List<FilteringResult>();
-
             double nyquist = fs / 2;
-            UpdateCorrectionFactor(2);
+            double correctionFactor = GetCorrectionFactor(2);
 
-            int padding = 10;
             double[] padded = AddPadding(samples, padding);
 
             // Compute filtered result for a range of fc.
@@ -74,31 +86,40 @@ namespace Kinovea.ScreenManager
             double min = 0.5;
             double max = nyquist;
             double step = (max - min) / fcTests;
-            double bestScore = 1;
-            int bestIndex = -1;
-            int index = 0;
+            List<double> cutoffs = new List<double>();
             for (double fc = min; fc < max; fc += step)
+                cutoffs.Add(fc);
+
+            FilteringResult[] candidates = new FilteringResult[cutoffs.Count];
+            Parallel.For(0, cutoffs.Count, RentScratch, (i, loopState, scratch) =>
             {
-                double[] filteredPadded = FilterSamples(padded, fs, fc);
-                double[] filtered = RemovePadding(filteredPadded, padding);
+                double fc = cutoffs[i];
+                Coefficients coeffs = GetCoefficients(fs, fc, correctionFactor);
+                double[] filtered = FilterSamples(padded, coeffs, scratch);
 
-                double[] residuals = samples.Subtract(filtered);
-                double dw = StatsHelper.DurbinWatson(residuals);
-                if (double.IsNaN(dw))
-                  continue;
+                double dw = DurbinWatson(samples, filtered);
+                if (!double.IsNaN(dw))
+                    candidates[i] = new FilteringResult(fc, filtered, Math.Abs(2 - dw) / 2);
 
-                double dwNormalized = Math.Abs(2 - dw) / 2;
+                return scratch;
+            }, ReturnScratch);
 
-                FilteringResult result = new FilteringResult(fc, filtered, dwNormalized);
-                results.Add(result);
+            // Collect in order of cutoff frequency, the best score is the first minimum.
+            List<FilteringResult> results = new List<FilteringResult>();
+            double bestScore = 1;
+            int bestIndex = -1;
+            foreach (FilteringResult result in candidates)
+            {
+                if (result == null)
+                    continue;
 
-                if (dwNormalized < bestScore)
+                if (result.DurbinWatson < bestScore)
                 {
-                    bestScore = dwNormalized;
-                    bestIndex = index;
+                    bestScore = result.DurbinWatson;
+                    bestIndex = results.Count;
                 }
 
-                index++;
+                results.Add(result);
             }
 
             bestCutoffIndex = bestIndex;
@@ -124,100 +145,100 @@ namespace Kinovea.ScreenManager
             return padded;
         }
 
-        private double[] RemovePadding(double[] samples, int padding)
+        /// <summary>
+        /// Runs the forward and backward passes on the padded samples and returns the unpadded result.
+        /// </summary>
+        private double[] FilterSamples(double[] padded, Coefficients coeffs, Scratch scratch)
         {
-            double[] result = new double[samples.Length - 2 * padding];
-            for (int i = padding; i < samples.Length - padding; i++)
-                result[i - padding] = samples[i];
-            
-            return result;
-        }
+            int length = padded.Length;
+            if (scratch.Forward.Length < length)
+            {
+                scratch.Forward = new double[length];
+                scratch.Backward = new double[length];
+            }
 
-        private double[] FilterSamples(double[] samples, double fs, double fc)
-        {
-            UpdateCoefficients(fs, fc);
-            double[] forward = ForwardPass(samples);
-            double[] backward = BackwardPass(forward);
-            return backward;
+            ForwardPass(padded, scratch.Forward, length, coeffs);
+            BackwardPass(scratch.Forward, scratch.Backward, length, coeffs);
+
+            double[] result = new double[length - 2 * padding];
+            Array.Copy(scratch.Backward, padding, result, 0, result.Length);
+            return result;
         }
         
-        private void UpdateCorrectionFactor(int passes)
+        private static double GetCorrectionFactor(int passes)
         {
             // Ref: Chapt. 3.4.4.2 of "Biomechanics and motor control of human movement".
-            correctionFactor = Math.Pow((Math.Pow(2, 1.0 / passes) - 1), 0.25);
+            return Math.Pow((Math.Pow(2, 1.0 / passes) - 1), 0.25);
         }
 
-        private void UpdateCoefficients(double fs, double fc)
+        private static Coefficients GetCoefficients(double fs, double fc, double correctionFactor)
         {
             // Ref: Chapt. 2.2.4.4 of "Biomechanics and motor control of human movement".
             double o = Math.Tan(Math.PI * fc / fs) / correctionFactor;
             double k1 = MathHelper.SQRT2 * o;
             double k2 = o * o;
 
-            a0 = k2 / (1 + k1 + k2);
-            a1 = 2 * a0;
-            a2 = a0;
+            Coefficients coeffs;
+            coeffs.A0 = k2 / (1 + k1 + k2);
+            coeffs.A1 = 2 * coeffs.A0;
+            coeffs.A2 = coeffs.A0;
 
-            double k3 = 2 * a0 / k2;
-            b1 = -2 * a0 + k3;
-            b2 = 1 - a0 - a1 - a2 - b1;
+            double k3 = 2 * coeffs.A0 / k2;
+            coeffs.B1 = -2 * coeffs.A0 + k3;
+            coeffs.B2 = 1 - coeffs.A0 - coeffs.A1 - coeffs.A2 - coeffs.B1;
+            return coeffs;
         }
 
-        private void ResetValues()
+        private static void ForwardPass(double[] raw, double[] filtered, int length, Coefficients c)
         {
-            x0 = x1 = x2 = y0 = y1 = y2 = 0;
+            // The first two values are used as is to initialize the filter.
+            filtered[0] = raw[0];
+            filtered[1] = raw[1];
+            for (int i = 2; i < length; i++)
+                filtered[i] = c.A0 * raw[i] + c.A1 * raw[i - 1] + c.A2 * raw[i - 2] + c.B1 * filtered[i - 1] + c.B2 * filtered[i - 2];
         }
 
-        private double[] ForwardPass(double[] raw)
+        private static void BackwardPass(double[] forward, double[] filtered, int length, Coefficients c)
         {
-            ResetValues();
-
-            y1 = x1 = raw[0];
-            y0 = x0 = raw[1];
+            // Same as the forward pass, starting from the end, so the result doesn't need to be reversed.
+            filtered[length - 1] = forward[length - 1];
+            filtered[length - 2] = forward[length - 2];
+            for (int i = length - 3; i >= 0; i--)
+                filtered[i] = c.A0 * forward[i] + c.A1 * forward[i + 1] + c.A2 * forward[i + 2] + c.B1 * filtered[i + 1] + c.B2 * filtered[i + 2];
+        }
 
-            double[] filtered = new double[raw.Length];
-            filtered[0] = y1;
-            filtered[1] = y0;
-            for (int i = 2; i < raw.Length; i++)
+        /// <summary>
+        /// Durbin-Watson statistic of the residuals between the raw and filtered values, without storing the residuals.
+        /// </summary>
+        private static double DurbinWatson(double[] samples, double[] filtered)
+        {
+            double num = 0;
+            double den = 0;
+            double previous = samples[0] - filtered[0];
+            for (int i = 1; i < samples.Length; i++)
             {
-                double f = FilterSample(raw[i]);
-                filtered[i] = f;
+                double e = samples[i] - filtered[i];
+                num += (e - previous) * (e - previous);
+                den += previous * previous;
+                previous = e;
             }
 
-            return filtered;
+            den += previous * previous;
+            return num / den;
         }
 
-        private double[] BackwardPass(double[] forward)
+        private static Scratch RentScratch()
         {
-            ResetValues();
-
-            y1 = x1 = forward[forward.Length - 1];
-            y0 = x0 = forward[forward.Length - 2];
-
-            double[] filtered = new double[forward.Length];
-            filtered[0] = y1;
-            filtered[1] = y0;
-            for (int i = forward.Length - 3; i >= 0; i--)
-            {
-                double f = FilterSample(forward[i]);
-                filtered[forward.Length - 1 - i] = f;
-            }
+            Scratch scratch;
+            if (!scratchPool.TryTake(out scratch))
+                scratch = new Scratch();
 
-            Array.Reverse(filtered);
-            return filtered;
+            return scratch;
         }
 
-        private double FilterSample(double sample)
+        private static void ReturnScratch(Scratch scratch)
         {
-            x2 = x1;
-            x1 = x0;
-            x0 = sample;
-            y2 = y1;
-            y1 = y0;
-            
-            y0 = a0 * x0 + a1 * x1 + a2 * x2 + b1 * y1 + b2 * y2;
-
-            return y0;
+            scratchPool.Add(scratch);
         }
     }
 }
@@ -0,0 +1,89 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Drawing;
+
+namespace Kinovea.ScreenManager
+{
+    /// <summary>
+    /// Keeps the curves computed for distorted segments, in image space, so paints and hit tests
+    /// of the same segment don't redo the undistortion and distortion of the vertices.
+    /// 
+    /// Segments are identified by their end points and kind, which is exactly what the curve depends on
+    /// besides the distortion parameters. The owner clears the cache when the parameters change.
+    /// The cache is flushed when it gets too large, for example while a drawing is being moved around.
+    /// The returned lists are shared and must not be modified.
+    /// </summary>
+    public class DistortedLineCache
+    {
+        private struct Segment : IEquatable<Segment>
+        {
+            public readonly PointF A;
+            public readonly PointF B;
+            public readonly bool Rectified;
+
+            public Segment(PointF a, PointF b, bool rectified)
+            {
+                this.A = a;
+                this.B = b;
+                this.Rectified = rectified;
+            }
+
+            public bool Equals(Segment other)
+            {
+                return A == other.A && B == other.B && Rectified == other.Rectified;
+            }
+
+            public override bool Equals(object obj)
+            {
+                return obj is Segment && Equals((Segment)obj);
+            }
+
+            public override int GetHashCode()
+            {
+                int hash = A.GetHashCode();
+                hash = hash * 31 + B.GetHashCode();
+                hash = hash * 31 + Rectified.GetHashCode();
+                return hash;
+            }
+        }
+
+        private const int maxSegments = 8192;
+        private Dictionary<Segment, List<PointF>> curves = new Dictionary<Segment, List<PointF>>();
+        private object locker = new object();
+
+        /// <summary>
+        /// Returns the curve of the segment, computing it with the passed function if it's not known yet.
+        /// </summary>
+        public List<PointF> Get(PointF a, PointF b, bool rectified, Func<PointF, PointF, List<PointF>> compute)
+        {
+            Segment segment = new Segment(a, b, rectified);
+
+            lock (locker)
+            {
+                List<PointF> curve;
+                if (curves.TryGetValue(segment, out curve))
+                    return curve;
+            }
+
+            List<PointF> computed = compute(a, b);
+
+            lock (locker)
+            {
+                if (curves.Count >= maxSegments)
+                    curves.Clear();
+
+                curves[segment] = computed;
+            }
+
+            return computed;
+        }
+
+        public void Clear()
+        {
+            lock (locker)
+                curves.Clear();
+        }
+    }
+}
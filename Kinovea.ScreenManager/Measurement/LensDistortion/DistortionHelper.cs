@@ -32,15 +32,43 @@ namespace Kinovea.ScreenManager
         {
             get
             {
-                return initialized && parameters != null ? parameters.ContentHash : 0;
+                return initialized && parameters != null ? parameters.ContentHash ^ imageRectified.GetHashCode() : 0;
             }
         }
+
+        /// <summary>
+        /// Whether the images are undistorted before being displayed.
+        /// In this case drawings and measurements are in rectified space and point conversions are the identity.
+        /// </summary>
+        public bool ImageRectified
+        {
+            get { return imageRectified; }
+            set { imageRectified = value; }
+        }
+
+        /// <summary>
+        /// Whether the remap tables are kept in fixed-point form.
+        /// </summary>
+        public bool CompactMaps
+        {
+            get { return compactMaps; }
+            set { compactMaps = value; }
+        }
         #endregion
 
         private bool initialized;
+        private bool imageRectified;
+        private bool compactMaps = true;
         private DistortionParameters parameters;
         private IntrinsicCameraParameters icp;
         private Size imageSize;
+        private UndistortionMap undistortionMap;
+        private DistortedLineCache lineCache = new DistortedLineCache();
+        private int lineCacheHash;
+        private Image<Bgr, Byte> scratchBgr;
+        private Image<Bgra, Byte> scratchBgra;
+        private Image<Gray, Byte> scratchGray;
+        private object mapLocker = new object();
         private static readonly log4net.ILog log = log4net.LogManager.GetLogger(System.Reflection.MethodBase.GetCurrentMethod().DeclaringType);
 
         public void Initialize(DistortionParameters parameters, Size imageSize)
@@ -60,7 +88,7 @@ namespace Kinovea.ScreenManager
         /// </summary>
         public PointF Undistort(PointF point)
         {
-            if (!initialized)
+            if (!initialized || imageRectified)
                 return point;
 
             double x = 0;
@@ -92,7 +120,7 @@ namespace Kinovea.ScreenManager
         {
             PointF result = point;
 
-            if (!initialized)
+            if (!initialized || imageRectified)
                 return result;
 
             try
@@ -132,8 +160,15 @@ namespace Kinovea.ScreenManager
         /// Takes the start and end point of a segment in distorted space and return 
         /// the same segment as a list of points still in distorted space.
         /// The segment is split in several subsegments that can be drawn with drawCurve.
+        /// The result is cached and must not be modified.
         /// </summary>
         public List<PointF> DistortLine(PointF start, PointF end)
+        {
+            ValidateLineCache();
+            return lineCache.Get(start, end, false, ComputeDistortLine);
+        }
+
+        private List<PointF> ComputeDistortLine(PointF start, PointF end)
         {
             int innerPoints = 5;
             float factor = 1.0f / ((float)innerPoints + 1);
@@ -150,8 +185,26 @@ namespace Kinovea.ScreenManager
         /// Takes the start and end point of a segment in rectified space and return 
         /// the same segment as a list of points in distorted space.
         /// The segment is split in several subsegments that can be drawn with drawCurve.
+        /// The result is cached and must not be modified.
         /// </summary>
         public List<PointF> DistortRectifiedLine(PointF start, PointF end)
+        {
+            ValidateLineCache();
+            return lineCache.Get(start, end, true, ComputeDistortRectifiedLine);
+        }
+
+        private void ValidateLineCache()
+        {
+            // The parameters may have been edited in place since the curves were computed.
+            int hash = ContentHash;
+            if (hash == lineCacheHash)
+                return;
+
+            lineCache.Clear();
+            lineCacheHash = hash;
+        }
+
+        private List<PointF> ComputeDistortRectifiedLine(PointF start, PointF end)
         {
             int innerPoints = 5;
             float factor = 1.0f / ((float)innerPoints + 1);
@@ -281,32 +334,86 @@ namespace Kinovea.ScreenManager
             return bmp;
         }
 
+        /// <summary>
+        /// Returns an undistorted copy of the image, at the size of the source image.
+        /// </summary>
         public Bitmap GetUndistortedImage(Bitmap sourceImage)
         {
-            // The source image is possibly at reduced size, we need to upscale it for the map to work, 
-            // as it's based on the coefficients computed for the full size.
+            Bitmap result = new Bitmap(sourceImage.Width, sourceImage.Height, PixelFormat.Format24bppRgb);
+            using (Graphics g = Graphics.FromImage(result))
+                g.DrawImageUnscaled(sourceImage, 0, 0);
+
+            UndistortImage(result);
+            return result;
+        }
+
+        /// <summary>
+        /// Undistorts the image in place.
+        /// The image is possibly at reduced size, the remap tables are computed for its size and kept for the next images.
+        /// </summary>
+        public void UndistortImage(Bitmap image)
+        {
+            if (!initialized)
+                return;
 
-            Matrix<float> mapx;
-            Matrix<float> mapy;
-            icp.InitUndistortMap(imageSize.Width, imageSize.Height, out mapx, out mapy);
+            PixelFormat format = image.PixelFormat;
+            if (format != PixelFormat.Format24bppRgb && format != PixelFormat.Format32bppArgb && 
+                format != PixelFormat.Format32bppPArgb && format != PixelFormat.Format32bppRgb && format != PixelFormat.Format8bppIndexed)
+            {
+                log.ErrorFormat("Unsupported pixel format for undistortion: {0}.", format);
+                return;
+            }
 
-            Bitmap source = new Bitmap(imageSize.Width, imageSize.Height, PixelFormat.Format24bppRgb);
-            Graphics g = Graphics.FromImage(source);
-            g.DrawImage(sourceImage, 0, 0, imageSize.Width, imageSize.Height);
+            lock (mapLocker)
+            {
+                UndistortionMap map = GetUndistortionMap(image.Size);
+                BitmapData data = image.LockBits(new Rectangle(0, 0, image.Width, image.Height), ImageLockMode.ReadWrite, format);
+                try
+                {
+                    if (format == PixelFormat.Format24bppRgb)
+                        Remap(data, map, ref scratchBgr);
+                    else if (format == PixelFormat.Format8bppIndexed)
+                        Remap(data, map, ref scratchGray);
+                    else
+                        Remap(data, map, ref scratchBgra);
+                }
+                finally
+                {
+                    image.UnlockBits(data);
+                }
+            }
+        }
 
-            BitmapData sourceImageData = source.LockBits(new Rectangle(0, 0, source.Width, source.Height), ImageLockMode.ReadOnly, source.PixelFormat);
-            Image<Bgr, Byte> cvSource = new Image<Bgr, Byte>(sourceImageData.Width, sourceImageData.Height, sourceImageData.Stride, sourceImageData.Scan0);
+        private UndistortionMap GetUndistortionMap(Size size)
+        {
+            if (undistortionMap != null && undistortionMap.Matches(parameters.ContentHash, size, compactMaps))
+                return undistortionMap;
+
+            if (undistortionMap != null)
+                undistortionMap.Dispose();
 
-            Bitmap result = new Bitmap(source.Width, source.Height, PixelFormat.Format24bppRgb);
-            BitmapData resultImageData = result.LockBits(new Rectangle(0, 0, result.Width, result.Height), ImageLockMode.ReadOnly, result.PixelFormat);
-            Image<Bgr, Byte> cvResult = new Image<Bgr, Byte>(resultImageData.Width, resultImageData.Height, resultImageData.Stride, resultImageData.Scan0);
+            log.DebugFormat("Building undistortion maps for {0}.", size);
+            undistortionMap = new UndistortionMap(parameters, imageSize, size, compactMaps);
+            return undistortionMap;
+        }
 
-            CvInvoke.cvRemap(cvSource, cvResult, mapx, mapy, 0, new MCvScalar(0));
+        private static void Remap<TColor>(BitmapData data, UndistortionMap map, ref Image<TColor, Byte> scratch)
+            where TColor : struct, IColor
+        {
+            // The remap can't be done in place, the source is copied to a scratch image kept for the next frames.
+            if (scratch == null || scratch.Size != map.Size)
+            {
+                if (scratch != null)
+                    scratch.Dispose();
 
-            source.UnlockBits(sourceImageData);
-            result.UnlockBits(resultImageData);
+                scratch = new Image<TColor, Byte>(map.Size);
+            }
 
-            return result;
+            using (Image<TColor, Byte> image = new Image<TColor, Byte>(data.Width, data.Height, data.Stride, data.Scan0))
+            {
+                CvInvoke.cvCopy(image, scratch, IntPtr.Zero);
+                map.Remap(scratch, image);
+            }
         }
     }
 
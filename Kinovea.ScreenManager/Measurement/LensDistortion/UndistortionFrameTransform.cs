@@ -0,0 +1,29 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Drawing;
+using Kinovea.Video;
+
+namespace Kinovea.ScreenManager
+{
+    /// <summary>
+    /// Reader-side lens distortion correction.
+    /// Frames are undistorted once as they are decoded, so playback, caching and tracking all work on rectified images.
+    /// Uses the current lens calibration of the calibration helper.
+    /// </summary>
+    public class UndistortionFrameTransform : IFrameTransform
+    {
+        private CalibrationHelper calibrationHelper;
+
+        public UndistortionFrameTransform(CalibrationHelper calibrationHelper)
+        {
+            this.calibrationHelper = calibrationHelper;
+        }
+
+        public void Apply(Bitmap image)
+        {
+            calibrationHelper.DistortionHelper.UndistortImage(image);
+        }
+    }
+}
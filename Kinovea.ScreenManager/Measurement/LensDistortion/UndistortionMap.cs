@@ -0,0 +1,109 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Drawing;
+using Emgu.CV;
+using Emgu.CV.CvEnum;
+using Emgu.CV.Structure;
+
+namespace Kinovea.ScreenManager
+{
+    /// <summary>
+    /// Remap tables to undistort images of a given size.
+    /// Building the tables is expensive, they are computed once and reused for every image of the same size
+    /// until the distortion parameters change.
+    /// 
+    /// The compact form stores the tables in fixed-point (16-bit integer coordinates and interpolation index),
+    /// it takes less memory than the floating point form and is faster to apply.
+    /// </summary>
+    public class UndistortionMap : IDisposable
+    {
+        public Size Size
+        {
+            get { return size; }
+        }
+
+        public int ContentHash
+        {
+            get { return contentHash; }
+        }
+
+        public bool Compact
+        {
+            get { return compact; }
+        }
+
+        private Size size;
+        private int contentHash;
+        private bool compact;
+        private Matrix<float> mapx;
+        private Matrix<float> mapy;
+        private Matrix<short> mapxy;
+        private Matrix<ushort> mapInterpolation;
+        private const int flags = (int)INTER.CV_INTER_LINEAR + (int)WARP.CV_WARP_FILL_OUTLIERS;
+
+        /// <summary>
+        /// Builds the tables for images of the passed size.
+        /// The parameters are expressed for the reference size, they are scaled to the target size.
+        /// </summary>
+        public UndistortionMap(DistortionParameters parameters, Size referenceSize, Size size, bool compact)
+        {
+            this.size = size;
+            this.contentHash = parameters.ContentHash;
+            this.compact = compact;
+
+            double sx = (double)size.Width / referenceSize.Width;
+            double sy = (double)size.Height / referenceSize.Height;
+            DistortionParameters scaled = new DistortionParameters(
+                parameters.K1, parameters.K2, parameters.K3, parameters.P1, parameters.P2,
+                parameters.Fx * sx, parameters.Fy * sy, parameters.Cx * sx, parameters.Cy * sy,
+                parameters.PixelsPerMillimeter * sx);
+
+            scaled.IntrinsicCameraParameters.InitUndistortMap(size.Width, size.Height, out mapx, out mapy);
+
+            if (compact)
+            {
+                mapxy = new Matrix<short>(size.Height, size.Width, 2);
+                mapInterpolation = new Matrix<ushort>(size.Height, size.Width);
+                CvInvoke.cvConvertMaps(mapx, mapy, mapxy, mapInterpolation);
+
+                mapx.Dispose();
+                mapy.Dispose();
+                mapx = null;
+                mapy = null;
+            }
+        }
+
+        public bool Matches(int contentHash, Size size, bool compact)
+        {
+            return this.contentHash == contentHash && this.size == size && this.compact == compact;
+        }
+
+        /// <summary>
+        /// Undistorts the source image into the destination image. Both must have the size of the map.
+        /// </summary>
+        public void Remap(IntPtr source, IntPtr destination)
+        {
+            if (compact)
+                CvInvoke.cvRemap(source, destination, mapxy, mapInterpolation, flags, new MCvScalar(0));
+            else
+                CvInvoke.cvRemap(source, destination, mapx, mapy, flags, new MCvScalar(0));
+        }
+
+        public void Dispose()
+        {
+            if (mapx != null)
+                mapx.Dispose();
+            
+            if (mapy != null)
+                mapy.Dispose();
+
+            if (mapxy != null)
+                mapxy.Dispose();
+
+            if (mapInterpolation != null)
+                mapInterpolation.Dispose();
+        }
+    }
+}
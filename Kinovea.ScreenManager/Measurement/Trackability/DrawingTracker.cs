@@ -54,6 +54,14 @@ namespace Kinovea.ScreenManager
             get { return trackablePoints.Count > 0 && trackablePoints.First().Value.Timeline.HasData(); }
         }
 
+        /// <summary>
+        /// Generation number of the tracking data, incremented each time the timelines or the tracking state change.
+        /// </summary>
+        public long ContentVersion
+        {
+            get { return contentVersion; }
+        }
+
         public Guid ID
         {
             get { return drawingId; }
@@ -100,6 +108,7 @@ namespace Kinovea.ScreenManager
         private Guid drawingId;
         private bool isTracking;
         private bool assigned;
+        private long contentVersion;
         private TrackerParameters parameters;
         private Dictionary<string, TrackablePoint> trackablePoints = new Dictionary<string, TrackablePoint>();
         private static readonly log4net.ILog log = log4net.LogManager.GetLogger(System.Reflection.MethodBase.GetCurrentMethod().DeclaringType);
@@ -135,36 +144,55 @@ namespace Kinovea.ScreenManager
         {
             // Some drawings like polyline have a dynamic list of trackable points.
             trackablePoints.Add(key, new TrackablePoint(context, parameters, value));
+            contentVersion++;
         }
 
         public void RemovePoint(string key)
         {
+            if (trackablePoints.ContainsKey(key))
+                trackablePoints[key].Dispose();
+
             trackablePoints.Remove(key);
+            contentVersion++;
         }
   
         public void Track(TrackingContext context)
         {
-            // This is where we would spawn new threads for each tracking.
             Dictionary<string, bool> insertionMap = new Dictionary<string, bool>();
+            foreach(KeyValuePair<string, TrackablePoint> pair in trackablePoints)
+                insertionMap[pair.Key] = pair.Value.Track(context);
+
+            CommitTracking(insertionMap);
+        }
+
+        /// <summary>
+        /// Push the values of the trackable points to the drawing after they have been tracked.
+        /// The insertion map tells which points inserted a new entry in their timeline.
+        /// This must run on the UI thread, points are processed in a deterministic order.
+        /// </summary>
+        public void CommitTracking(Dictionary<string, bool> insertionMap)
+        {
             bool atLeastOneInserted = false;
             foreach(KeyValuePair<string, TrackablePoint> pair in trackablePoints)
             {
-                bool inserted = pair.Value.Track(context);
                 drawing.SetTrackablePointValue(pair.Key, pair.Value.CurrentValue, pair.Value.TimeDifference);
 
-                insertionMap[pair.Key] = inserted;
-                if (inserted)
+                if (insertionMap[pair.Key])
                     atLeastOneInserted = true;
             }
 
             if (atLeastOneInserted)
+            {
                 FixTimelineSync(insertionMap);
+                contentVersion++;
+            }
         }
         
         public void ToggleTracking()
         {
             isTracking = !isTracking;
             AfterToggleTracking();
+            contentVersion++;
         }
 
         /// <summary>
@@ -219,12 +247,14 @@ namespace Kinovea.ScreenManager
         {
             foreach (TrackablePoint trackablePoint in trackablePoints.Values)
                 trackablePoint.Reset();
+
+            contentVersion++;
         }
 
         public void Dispose()
         {
             foreach (TrackablePoint trackablePoint in trackablePoints.Values)
-                trackablePoint.Reset();
+                trackablePoint.Dispose();
                         
             if (drawing != null)
                 drawing.TrackablePointMoved -= drawing_TrackablePointMoved;
@@ -236,6 +266,7 @@ namespace Kinovea.ScreenManager
                 throw new ArgumentException("This point is not bound.");
             
             bool inserted = trackablePoints[e.PointName].SetUserValue(e.Position);
+            contentVersion++;
 
             // This is called when we manually move a point even though the object is not in tracking mode.
             // In this case we may have added a new entry in the timeline. 
@@ -288,18 +319,38 @@ namespace Kinovea.ScreenManager
             return data;
         }
 
-        public void WriteXml(XmlWriter w)
+        /// <summary>
+        /// Returns the first and last times found in the timelines of the points, or false if there is no tracking data.
+        /// </summary>
+        public bool GetTrackedSpan(out long start, out long end)
+        {
+            start = long.MaxValue;
+            end = long.MinValue;
+            foreach (TrackablePoint trackablePoint in trackablePoints.Values)
+            {
+                IList<long> times = trackablePoint.Timeline.Times;
+                if (times.Count == 0)
+                    continue;
+
+                start = Math.Min(start, times[0]);
+                end = Math.Max(end, times[times.Count - 1]);
+            }
+
+            return start <= end;
+        }
+
+        public void WriteXml(XmlWriter w, MetadataSnapshot snapshot)
         {
             foreach (KeyValuePair<string, TrackablePoint> pair in trackablePoints)
             {
                 w.WriteStartElement("TrackablePoint");
                 w.WriteAttributeString("key", pair.Key.ToString());
-                pair.Value.WriteXml(w);
+                pair.Value.WriteXml(w, snapshot, string.Format("{0}/{1}", drawingId, pair.Key));
                 w.WriteEndElement();
             }
         }
 
-        public DrawingTracker(XmlReader r, PointF scale, TimestampMapper timeMapper)
+        public DrawingTracker(XmlReader r, PointF scale, TimestampMapper timeMapper, MetadataSidecar sidecar)
         {
             bool isEmpty = r.IsEmptyElement;
 
@@ -315,7 +366,7 @@ namespace Kinovea.ScreenManager
                 switch (r.Name)
                 {
                     case "TrackablePoint":
-                        ParseTrackablePoint(r, scale, timeMapper);
+                        ParseTrackablePoint(r, scale, timeMapper, sidecar);
                         break;
                     default:
                         string unparsed = r.ReadOuterXml();
@@ -327,7 +378,7 @@ namespace Kinovea.ScreenManager
                 r.ReadEndElement();
         }
 
-        private void ParseTrackablePoint(XmlReader r, PointF scale, TimestampMapper timeMapper)
+        private void ParseTrackablePoint(XmlReader r, PointF scale, TimestampMapper timeMapper, MetadataSidecar sidecar)
         {
             string key = "";
             
@@ -336,7 +387,7 @@ namespace Kinovea.ScreenManager
             if (r.MoveToAttribute("key"))
                 key = r.ReadContentAsString();
 
-            TrackablePoint point = new TrackablePoint(r, scale, timeMapper);
+            TrackablePoint point = new TrackablePoint(r, scale, timeMapper, sidecar);
             trackablePoints.Add(key, point);
         }
     }
@@ -0,0 +1,296 @@
+﻿#region License
+/*
+Copyright © Joan Charmant 2012.
+jcharmant@gmail.com
+
+This file is part of Kinovea.
+
+Kinovea is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2
+as published by the Free Software Foundation.
+
+Kinovea is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Kinovea. If not, see http://www.gnu.org/licenses/.
+*/
+#endregion
+using System;
+using System.Drawing;
+using System.Drawing.Imaging;
+using Emgu.CV;
+using Emgu.CV.CvEnum;
+using Emgu.CV.Structure;
+
+namespace Kinovea.ScreenManager
+{
+    /// <summary>
+    /// Coarse to fine template matching for large search windows.
+    ///
+    /// The search zone and the template are converted to grey levels and downsampled,
+    /// the template is matched over the whole downsampled search zone, and the few best candidates
+    /// are then refined by matching at full resolution in a small neighborhood around each of them.
+    /// The returned similarity is computed in colour at the winning location, like the exhaustive search,
+    /// so the similarity and template update thresholds keep their meaning whichever path is taken.
+    ///
+    /// An instance holds its working images and reuses them from one call to the next,
+    /// so there should be one instance per tracked point. Instances are not thread safe.
+    /// </summary>
+    public class PyramidMatcher : IDisposable
+    {
+        /// <summary>
+        /// Similarity map of the winning refinement, to be used for sub-pixel refinement of the location.
+        /// </summary>
+        public Image<Gray, Single> FineMap
+        {
+            get { return fineMap; }
+        }
+
+        /// <summary>
+        /// Location of the best match in the fine similarity map.
+        /// </summary>
+        public Point FineMapLocation
+        {
+            get { return fineMapLocation; }
+        }
+
+        /// <summary>
+        /// Location of the top-left corner of the fine similarity map relatively to the search zone.
+        /// </summary>
+        public Point FineMapOrigin
+        {
+            get { return fineMapOrigin; }
+        }
+
+        // Below this size at the coarse level the template doesn't carry enough structure to be matched reliably.
+        private const int minCoarseTemplateSize = 8;
+        private const int maxLevels = 2;
+        private const int candidates = 3;
+
+        private Image<Gray, Byte> searchGray;
+        private Image<Gray, Byte> templateGray;
+        private Image<Gray, Byte> searchCoarse;
+        private Image<Gray, Byte> templateCoarse;
+        private Image<Gray, Single> coarseMap;
+        private Image<Gray, Single> candidateMap;
+        private Image<Gray, Single> fineMap;
+        private Image<Gray, Single> scoreMap;
+        private Point fineMapLocation;
+        private Point fineMapOrigin;
+        private Point[] candidateLocations = new Point[candidates];
+
+        /// <summary>
+        /// Returns the number of pyramid levels to use, 0 means the search window is too small
+        /// or the template too small for the coarse to fine approach to pay off.
+        /// </summary>
+        public static int GetLevels(Size searchZone, Size template)
+        {
+            if (searchZone.Width < template.Width * 3 && searchZone.Height < template.Height * 3)
+                return 0;
+
+            int levels = 0;
+            while (levels < maxLevels &&
+                (template.Width >> (levels + 1)) >= minCoarseTemplateSize &&
+                (template.Height >> (levels + 1)) >= minCoarseTemplateSize)
+            {
+                levels++;
+            }
+
+            return levels;
+        }
+
+        /// <summary>
+        /// Finds the template in the search zone of the locked 32bpp image.
+        /// Returns the similarity score of the best match, and its location as the top-left corner of the template relatively to the search zone.
+        /// </summary>
+        public double Match(BitmapData imageData, Rectangle searchZone, Bitmap template, int levels, out Point location)
+        {
+            location = Point.Empty;
+
+            Ensure(ref searchGray, searchZone.Size);
+            Ensure(ref templateGray, template.Size);
+
+            // Grey level conversion of the search zone and the template.
+            using (Image<Bgra, Byte> cvImage = new Image<Bgra, Byte>(imageData.Width, imageData.Height, imageData.Stride, imageData.Scan0))
+            {
+                cvImage.ROI = searchZone;
+                CvInvoke.cvCvtColor(cvImage.Ptr, searchGray.Ptr, COLOR_CONVERSION.CV_BGRA2GRAY);
+            }
+
+            BitmapData templateData = template.LockBits(new Rectangle(0, 0, template.Width, template.Height), ImageLockMode.ReadOnly, template.PixelFormat);
+            using (Image<Bgra, Byte> cvTemplate = new Image<Bgra, Byte>(templateData.Width, templateData.Height, templateData.Stride, templateData.Scan0))
+                CvInvoke.cvCvtColor(cvTemplate.Ptr, templateGray.Ptr, COLOR_CONVERSION.CV_BGRA2GRAY);
+            template.UnlockBits(templateData);
+
+            // Coarse level: exhaustive search over the downsampled search zone.
+            int scale = 1 << levels;
+            Size searchCoarseSize = new Size(searchZone.Width / scale, searchZone.Height / scale);
+            Size templateCoarseSize = new Size(template.Width / scale, template.Height / scale);
+            Ensure(ref searchCoarse, searchCoarseSize);
+            Ensure(ref templateCoarse, templateCoarseSize);
+            CvInvoke.cvResize(searchGray.Ptr, searchCoarse.Ptr, INTER.CV_INTER_AREA);
+            CvInvoke.cvResize(templateGray.Ptr, templateCoarse.Ptr, INTER.CV_INTER_AREA);
+
+            Size coarseMapSize = new Size(searchCoarseSize.Width - templateCoarseSize.Width + 1, searchCoarseSize.Height - templateCoarseSize.Height + 1);
+            if (coarseMapSize.Width <= 0 || coarseMapSize.Height <= 0)
+                return 0;
+
+            Ensure(ref coarseMap, coarseMapSize);
+            CvInvoke.cvMatchTemplate(searchCoarse.Ptr, templateCoarse.Ptr, coarseMap.Ptr, TM_TYPE.CV_TM_CCOEFF_NORMED);
+
+            int found = FindCandidates(coarseMap.Data, templateCoarseSize);
+
+            // Fine level: match at full resolution around each candidate, keep the best.
+            double bestScore = double.MinValue;
+            int margin = scale * 2;
+            for (int i = 0; i < found; i++)
+            {
+                Rectangle fineZone = new Rectangle(
+                    candidateLocations[i].X * scale - margin,
+                    candidateLocations[i].Y * scale - margin,
+                    template.Width + margin * 2,
+                    template.Height + margin * 2);
+
+                fineZone.Intersect(new Rectangle(Point.Empty, searchZone.Size));
+                if (fineZone.Width < template.Width || fineZone.Height < template.Height)
+                    continue;
+
+                searchGray.ROI = fineZone;
+                Size mapSize = new Size(fineZone.Width - template.Width + 1, fineZone.Height - template.Height + 1);
+                Ensure(ref candidateMap, mapSize);
+                CvInvoke.cvMatchTemplate(searchGray.Ptr, templateGray.Ptr, candidateMap.Ptr, TM_TYPE.CV_TM_CCOEFF_NORMED);
+                searchGray.ROI = Rectangle.Empty;
+
+                Point minLoc = Point.Empty;
+                Point maxLoc = Point.Empty;
+                double min = 0;
+                double max = 0;
+                CvInvoke.cvMinMaxLoc(candidateMap.Ptr, ref min, ref max, ref minLoc, ref maxLoc, IntPtr.Zero);
+
+                if (max <= bestScore)
+                    continue;
+
+                bestScore = max;
+                fineMapLocation = maxLoc;
+                fineMapOrigin = fineZone.Location;
+                location = new Point(fineZone.Left + maxLoc.X, fineZone.Top + maxLoc.Y);
+
+                // Keep the winning map around for sub-pixel refinement.
+                Image<Gray, Single> temp = fineMap;
+                fineMap = candidateMap;
+                candidateMap = temp;
+            }
+
+            if (bestScore == double.MinValue)
+                return 0;
+
+            return ColorSimilarity(imageData, searchZone, template, location);
+        }
+
+        public void Dispose()
+        {
+            Release(ref searchGray);
+            Release(ref templateGray);
+            Release(ref searchCoarse);
+            Release(ref templateCoarse);
+            Release(ref coarseMap);
+            Release(ref candidateMap);
+            Release(ref fineMap);
+            Release(ref scoreMap);
+        }
+
+        /// <summary>
+        /// Similarity between the template and the image at the given location, in colour.
+        /// The grey level score is not directly comparable to the score of the exhaustive search.
+        /// </summary>
+        private double ColorSimilarity(BitmapData imageData, Rectangle searchZone, Bitmap template, Point location)
+        {
+            Ensure(ref scoreMap, new Size(1, 1));
+
+            BitmapData templateData = template.LockBits(new Rectangle(0, 0, template.Width, template.Height), ImageLockMode.ReadOnly, template.PixelFormat);
+            using (Image<Bgra, Byte> cvImage = new Image<Bgra, Byte>(imageData.Width, imageData.Height, imageData.Stride, imageData.Scan0))
+            using (Image<Bgra, Byte> cvTemplate = new Image<Bgra, Byte>(templateData.Width, templateData.Height, templateData.Stride, templateData.Scan0))
+            {
+                cvImage.ROI = new Rectangle(searchZone.Left + location.X, searchZone.Top + location.Y, template.Width, template.Height);
+                CvInvoke.cvMatchTemplate(cvImage.Ptr, cvTemplate.Ptr, scoreMap.Ptr, TM_TYPE.CV_TM_CCOEFF_NORMED);
+            }
+            template.UnlockBits(templateData);
+
+            return scoreMap.Data[0, 0, 0];
+        }
+
+        /// <summary>
+        /// Find the local maxima of the coarse similarity map, best first.
+        /// After each pick the neighborhood of the candidate is excluded so candidates are distinct.
+        /// </summary>
+        private int FindCandidates(float[,,] data, Size exclusion)
+        {
+            int rows = data.GetLength(0);
+            int cols = data.GetLength(1);
+            int found = 0;
+
+            for (int c = 0; c < candidates; c++)
+            {
+                float best = float.MinValue;
+                Point bestLoc = new Point(-1, -1);
+                for (int j = 0; j < rows; j++)
+                {
+                    for (int i = 0; i < cols; i++)
+                    {
+                        if (data[j, i, 0] <= best || IsExcluded(i, j, found, exclusion))
+                            continue;
+
+                        best = data[j, i, 0];
+                        bestLoc = new Point(i, j);
+                    }
+                }
+
+                if (bestLoc.X < 0)
+                    break;
+
+                candidateLocations[found] = bestLoc;
+                found++;
+            }
+
+            return found;
+        }
+
+        private bool IsExcluded(int x, int y, int found, Size exclusion)
+        {
+            for (int k = 0; k < found; k++)
+            {
+                if (Math.Abs(x - candidateLocations[k].X) < exclusion.Width / 2 && Math.Abs(y - candidateLocations[k].Y) < exclusion.Height / 2)
+                    return true;
+            }
+
+            return false;
+        }
+
+        private static void Ensure<TColor, TDepth>(ref Image<TColor, TDepth> image, Size size)
+            where TColor : struct, IColor
+            where TDepth : new()
+        {
+            if (image != null && image.Width == size.Width && image.Height == size.Height)
+                return;
+
+            if (image != null)
+                image.Dispose();
+
+            image = new Image<TColor, TDepth>(size.Width, size.Height);
+        }
+
+        private static void Release<TColor, TDepth>(ref Image<TColor, TDepth> image)
+            where TColor : struct, IColor
+            where TDepth : new()
+        {
+            if (image == null)
+                return;
+
+            image.Dispose();
+            image = null;
+        }
+    }
+}
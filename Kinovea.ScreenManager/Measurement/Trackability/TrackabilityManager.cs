@@ -20,8 +20,10 @@ along with Kinovea. If not, see http://www.gnu.org/licenses/.
 #endregion
 using System;
 using System.Collections.Generic;
+using System.Diagnostics;
 using System.Drawing;
 using System.Linq;
+using System.Threading.Tasks;
 
 using Kinovea.Video;
 using System.Xml;
@@ -54,11 +56,50 @@ namespace Kinovea.ScreenManager
                 return hash;
             }
         }
+
+        /// <summary>
+        /// Generation number of the tracking data of all drawings.
+        /// This is cheap to compute and changes each time anything in the trackers changes.
+        /// </summary>
+        public long ContentVersion
+        {
+            get 
+            {
+                long version = contentVersion;
+                foreach (DrawingTracker tracker in trackers.Values)
+                {
+                    if (tracker != null)
+                        version += tracker.ContentVersion;
+                }
+
+                return version;
+            }
+        }
+
+        /// <summary>
+        /// Time spent in the last call to Track, in milliseconds.
+        /// </summary>
+        public double LastTrackingDuration
+        {
+            get { return lastTrackingDuration; }
+        }
+
+        /// <summary>
+        /// Number of trackable points processed in the last call to Track.
+        /// </summary>
+        public int LastTrackingPoints
+        {
+            get { return lastTrackingPoints; }
+        }
         #endregion
 
         #region Members
         private Dictionary<Guid, DrawingTracker> trackers = new Dictionary<Guid, DrawingTracker>();
         private Size imageSize;
+        private long contentVersion;    // Changes of the tracker list, plus the versions of the removed trackers.
+        private Stopwatch stopwatch = new Stopwatch();
+        private double lastTrackingDuration;
+        private int lastTrackingPoints;
         private static readonly log4net.ILog log = log4net.LogManager.GetLogger(System.Reflection.MethodBase.GetCurrentMethod().DeclaringType);
         #endregion
 
@@ -77,6 +118,7 @@ namespace Kinovea.ScreenManager
 
             TrackingContext context = new TrackingContext(videoFrame.Timestamp, videoFrame.Image);
             trackers.Add(drawing.Id, new DrawingTracker(drawing, context, parameters));
+            contentVersion++;
         }
 
         public void Assign(ITrackable drawing)
@@ -92,6 +134,7 @@ namespace Kinovea.ScreenManager
 
             trackers.Add(newId, trackers[oldId]);
             trackers.Remove(oldId);
+            contentVersion++;
         }
 
         public void AddPoint(ITrackable drawing, VideoFrame videoFrame, string key, PointF point)
@@ -128,7 +171,7 @@ namespace Kinovea.ScreenManager
             }
 
             foreach (Guid key in pruneList)
-                trackers.Remove(key);
+                Retire(key);
         }
 
         public void Clear()
@@ -136,7 +179,8 @@ namespace Kinovea.ScreenManager
             foreach(DrawingTracker tracker in trackers.Values)
                 tracker.Dispose();
             
-            trackers.Clear();
+            foreach (Guid key in trackers.Keys.ToList())
+                Retire(key);
         }
         
         public void Remove(ITrackable drawing)
@@ -145,17 +189,85 @@ namespace Kinovea.ScreenManager
                 return;
             
             trackers[drawing.Id].Dispose();
-            trackers.Remove(drawing.Id);
+            Retire(drawing.Id);
         }
 
+        /// <summary>
+        /// Track all the trackable points of all drawings in the passed frame.
+        /// When tracking is active the points are matched concurrently, one task per point, 
+        /// against a single read-only lock of the frame. The results are then pushed to the drawings 
+        /// on the calling thread, in the order of the trackers.
+        /// </summary>
         public void Track(VideoFrame videoFrame)
         {
+            Commit(Match(videoFrame));
+        }
+
+        /// <summary>
+        /// Match all the trackable points of all drawings in the passed frame, without touching the drawings.
+        /// This may run on a background thread. The result must be committed on the UI thread 
+        /// before the next frame is matched, the drawings take the current values of the points.
+        /// </summary>
+        public List<KeyValuePair<DrawingTracker, Dictionary<string, bool>>> Match(VideoFrame videoFrame)
+        {
+            stopwatch.Restart();
+
             TrackingContext context = new TrackingContext(videoFrame.Timestamp, videoFrame.Image);
             
-            foreach(DrawingTracker tracker in trackers.Values)
+            List<DrawingTracker> trackerList = trackers.Values.ToList();
+            List<KeyValuePair<string, TrackablePoint>> points = new List<KeyValuePair<string, TrackablePoint>>();
+            foreach (DrawingTracker tracker in trackerList)
+                points.AddRange(tracker.TrackablePoints);
+
+            bool[] inserted = new bool[points.Count];
+            bool parallel = points.Count > 1 && trackerList.Any(t => t.IsTracking);
+
+            if (parallel)
+            {
+                context.Lock();
+                try
+                {
+                    Parallel.For(0, points.Count, i => inserted[i] = points[i].Value.Track(context));
+                }
+                finally
+                {
+                    context.Unlock();
+                }
+            }
+            else
+            {
+                for (int i = 0; i < points.Count; i++)
+                    inserted[i] = points[i].Value.Track(context);
+            }
+
+            List<KeyValuePair<DrawingTracker, Dictionary<string, bool>>> result = new List<KeyValuePair<DrawingTracker, Dictionary<string, bool>>>();
+            int index = 0;
+            foreach (DrawingTracker tracker in trackerList)
             {
-                tracker.Track(context);
+                Dictionary<string, bool> insertionMap = new Dictionary<string, bool>();
+                for (int i = 0; i < tracker.TrackablePoints.Count; i++, index++)
+                    insertionMap[points[index].Key] = inserted[index];
+
+                result.Add(new KeyValuePair<DrawingTracker, Dictionary<string, bool>>(tracker, insertionMap));
             }
+
+            stopwatch.Stop();
+            lastTrackingDuration = stopwatch.Elapsed.TotalMilliseconds;
+            lastTrackingPoints = points.Count;
+
+            if (parallel)
+                log.DebugFormat("Tracked {0} points in {1:0.000} ms.", lastTrackingPoints, lastTrackingDuration);
+
+            return result;
+        }
+
+        /// <summary>
+        /// Push the result of Match to the drawings. Must run on the UI thread.
+        /// </summary>
+        public void Commit(List<KeyValuePair<DrawingTracker, Dictionary<string, bool>>> result)
+        {
+            foreach (KeyValuePair<DrawingTracker, Dictionary<string, bool>> pair in result)
+                pair.Key.CommitTracking(pair.Value);
         }
         
         /// <summary>
@@ -179,6 +291,30 @@ namespace Kinovea.ScreenManager
 
             return trackers[id].HasData;
         }
+
+        /// <summary>
+        /// Returns the version of the tracking data of the drawing, or -1 if it has no tracker.
+        /// </summary>
+        public long GetContentVersion(Guid id)
+        {
+            if (!trackers.ContainsKey(id))
+                return -1;
+
+            return trackers[id].ContentVersion;
+        }
+
+        /// <summary>
+        /// Returns the first and last tracked times of the drawing, or false if it has no tracking data.
+        /// </summary>
+        public bool GetTrackedSpan(Guid id, out long start, out long end)
+        {
+            start = 0;
+            end = 0;
+            if (!trackers.ContainsKey(id))
+                return false;
+
+            return trackers[id].GetTrackedSpan(out start, out end);
+        }
         
         public void UpdateContext(ITrackable drawing, VideoFrame videoFrame)
         {
@@ -226,6 +362,19 @@ namespace Kinovea.ScreenManager
             return trackers[id].GetLocation(key, time);
         }
 
+        /// <summary>
+        /// Remove a tracker from the list while keeping the aggregated version monotonic.
+        /// </summary>
+        private void Retire(Guid id)
+        {
+            DrawingTracker tracker = trackers[id];
+            if (tracker != null)
+                contentVersion += tracker.ContentVersion;
+
+            contentVersion++;
+            trackers.Remove(id);
+        }
+
         private bool SanityCheck(Guid id)
         {
             bool contains = trackers.ContainsKey(id);
@@ -300,13 +449,21 @@ namespace Kinovea.ScreenManager
             }
         }
 
-        public void WriteXml(XmlWriter w)
+        /// <summary>
+        /// Writes all the trackers. When a snapshot is passed the timelines are stored in it instead of inline.
+        /// </summary>
+        public void WriteXml(XmlWriter w, MetadataSnapshot snapshot)
         {
             foreach (DrawingTracker tracker in trackers.Values)
-                WriteTracker(w, tracker.ID);
+                WriteTracker(w, tracker.ID, snapshot);
         }
 
         public void WriteTracker(XmlWriter w, Guid id)
+        {
+            WriteTracker(w, id, null);
+        }
+
+        public void WriteTracker(XmlWriter w, Guid id, MetadataSnapshot snapshot)
         {
             if (!trackers.ContainsKey(id))
                 return;
@@ -317,11 +474,14 @@ namespace Kinovea.ScreenManager
 
             w.WriteStartElement("TrackableDrawing");
             w.WriteAttributeString("id", tracker.ID.ToString());
-            tracker.WriteXml(w);
+            tracker.WriteXml(w, snapshot);
             w.WriteEndElement();
         }
 
-        public void ReadXml(XmlReader r, PointF scale, TimestampMapper timeMapper)
+        /// <summary>
+        /// Reads all the trackers. The sidecar holds the timelines stored out of the KVA, if any.
+        /// </summary>
+        public void ReadXml(XmlReader r, PointF scale, TimestampMapper timeMapper, MetadataSidecar sidecar)
         {
             bool isEmpty = r.IsEmptyElement;
             r.ReadStartElement();
@@ -331,26 +491,30 @@ namespace Kinovea.ScreenManager
 
             while (r.NodeType == XmlNodeType.Element)
             {
-                ReadTracker(r, scale, timeMapper);
+                ReadTracker(r, scale, timeMapper, sidecar);
             }
 
             r.ReadEndElement();
         }
 
         public void ReadTracker(XmlReader r, PointF scale, TimestampMapper timeMapper)
+        {
+            ReadTracker(r, scale, timeMapper, null);
+        }
+
+        public void ReadTracker(XmlReader r, PointF scale, TimestampMapper timeMapper, MetadataSidecar sidecar)
         {
             if (r.Name == "TrackableDrawing")
             {
-                DrawingTracker tracker = new DrawingTracker(r, scale, timeMapper);
+                DrawingTracker tracker = new DrawingTracker(r, scale, timeMapper, sidecar);
                 if (trackers.ContainsKey(tracker.ID))
                 {
                     trackers[tracker.ID].Dispose();
-                    trackers[tracker.ID] = tracker;
-                }
-                else
-                {
-                    trackers.Add(tracker.ID, tracker);
+                    Retire(tracker.ID);
                 }
+
+                trackers.Add(tracker.ID, tracker);
+                contentVersion++;
             }
             else
             {
@@ -85,6 +85,7 @@ namespace Kinovea.ScreenManager
         private TrackerParameters trackerParameters;
         private Timeline<TrackFrame> trackTimeline = new Timeline<TrackFrame>();
         private PointF nonTrackingValue;
+        private PyramidMatcher pyramidMatcher = new PyramidMatcher();
         
         private static readonly log4net.ILog log = log4net.LogManager.GetLogger(System.Reflection.MethodBase.GetCurrentMethod().DeclaringType);
 
@@ -141,6 +142,7 @@ namespace Kinovea.ScreenManager
         /// This way we ensure the timelines are always of the same length.
         /// </summary>
         /// <param name="context"></param>
+        /// <remarks>Only touches the state of this point, so different points may track the same context concurrently.</remarks>
         public bool Track(TrackingContext context)
         {
             bool inserted = false;
@@ -206,7 +208,11 @@ namespace Kinovea.ScreenManager
             }
 
             // We did not find the exact requested time in the timeline, but tracking is active so let's look for the pattern.
-            TrackResult result = Tracker.Track(trackerParameters.SearchWindow, closestFrame, context.Image);
+            TrackResult result;
+            if (context.ImageData != null)
+                result = Tracker.Track(trackerParameters.SearchWindow, closestFrame, context.ImageData, pyramidMatcher);
+            else
+                result = Tracker.Track(trackerParameters.SearchWindow, closestFrame, context.Image, pyramidMatcher);
 
             if(result.Similarity >= trackerParameters.SimilarityThreshold)
             {
@@ -259,6 +265,12 @@ namespace Kinovea.ScreenManager
         {
             ClearTimeline();
         }
+
+        public void Dispose()
+        {
+            ClearTimeline();
+            pyramidMatcher.Dispose();
+        }
        
         public bool SetTracking(bool isTracking)
         {
@@ -293,7 +305,11 @@ namespace Kinovea.ScreenManager
             return closestFrame.Location;
         }
 
-        public void WriteXml(XmlWriter w)
+        /// <summary>
+        /// Writes the point. When a snapshot is passed the timeline is stored in it under the series id
+        /// and the KVA only references it.
+        /// </summary>
+        public void WriteXml(XmlWriter w, MetadataSnapshot snapshot, string seriesId)
         {
             w.WriteStartElement("TrackerParameters");
             trackerParameters.WriteXml(w);
@@ -303,18 +319,31 @@ namespace Kinovea.ScreenManager
             w.WriteElementString("CurrentValue", XmlHelper.WritePointF(currentValue));
 
             w.WriteStartElement("Timeline");
-            foreach (TrackFrame frame in trackTimeline.Enumerate())
+            if (snapshot != null)
             {
-                w.WriteStartElement("Frame");
-                w.WriteAttributeString("time", frame.Time.ToString());
-                w.WriteAttributeString("location", XmlHelper.WritePointF(frame.Location));
-                w.WriteAttributeString("source", frame.PositionningSource.ToString());
-                w.WriteEndElement();
+                SidecarSample[] samples = new SidecarSample[trackTimeline.Count];
+                int i = 0;
+                foreach (TrackFrame frame in trackTimeline.Enumerate())
+                    samples[i++] = new SidecarSample(frame.Time, frame.Location.X, frame.Location.Y, (byte)frame.PositionningSource);
+
+                w.WriteAttributeString("Count", samples.Length.ToString());
+                w.WriteAttributeString("Sidecar", snapshot.AddSeries(seriesId, samples));
+            }
+            else
+            {
+                foreach (TrackFrame frame in trackTimeline.Enumerate())
+                {
+                    w.WriteStartElement("Frame");
+                    w.WriteAttributeString("time", frame.Time.ToString());
+                    w.WriteAttributeString("location", XmlHelper.WritePointF(frame.Location));
+                    w.WriteAttributeString("source", frame.PositionningSource.ToString());
+                    w.WriteEndElement();
+                }
             }
             w.WriteEndElement();
         }
 
-        public TrackablePoint(XmlReader r, PointF scale, TimestampMapper timeMapper)
+        public TrackablePoint(XmlReader r, PointF scale, TimestampMapper timeMapper, MetadataSidecar sidecar)
         {
             r.ReadStartElement();
 
@@ -334,7 +363,7 @@ namespace Kinovea.ScreenManager
                         currentValue = currentValue.Scale(scale.X, scale.Y);
                         break;
                     case "Timeline":
-                        ParseTimeline(r, scale, timeMapper);
+                        ParseTimeline(r, scale, timeMapper, sidecar);
                         break;
                     default:
                         string unparsed = r.ReadOuterXml();
@@ -345,14 +374,21 @@ namespace Kinovea.ScreenManager
             r.ReadEndElement();
         }
 
-        private void ParseTimeline(XmlReader r, PointF scale, TimestampMapper timeMapper)
+        private void ParseTimeline(XmlReader r, PointF scale, TimestampMapper timeMapper, MetadataSidecar sidecar)
         {
             trackTimeline.Clear();
             
             bool isEmpty = r.IsEmptyElement;
 
+            string seriesId = null;
+            if (r.MoveToAttribute("Sidecar"))
+                seriesId = r.ReadContentAsString();
+
             r.ReadStartElement();
 
+            if (seriesId != null)
+                ParseTimeline(sidecar, seriesId, scale, timeMapper);
+
             while (r.NodeType == XmlNodeType.Element)
             {
                 switch (r.Name)
@@ -371,6 +407,23 @@ namespace Kinovea.ScreenManager
                 r.ReadEndElement();
         }
 
+        private void ParseTimeline(MetadataSidecar sidecar, string seriesId, PointF scale, TimestampMapper timeMapper)
+        {
+            SidecarSample[] samples;
+            if (sidecar == null || !sidecar.TryGetSeries(seriesId, out samples))
+            {
+                log.ErrorFormat("Timeline {0} not found in the sidecar.", seriesId);
+                return;
+            }
+
+            foreach (SidecarSample sample in samples)
+            {
+                PointF location = new PointF(sample.X, sample.Y).Scale(scale.X, scale.Y);
+                TrackFrame frame = new TrackFrame(timeMapper(sample.T), location, null, (PositionningSource)sample.Source);
+                trackTimeline.Insert(frame.Time, frame);
+            }
+        }
+
         /// <summary>
         /// Creates a timeline entry (TrackFrame) from an existing location.
         /// Does not perform any tracking.
@@ -379,7 +432,7 @@ namespace Kinovea.ScreenManager
         private TrackFrame CreateTrackFrame(PointF location, PositionningSource positionningSource)
         {
             Rectangle region = location.Box(trackerParameters.BlockWindow).ToRectangle();
-            Bitmap template = context.Image.ExtractTemplate(region);
+            Bitmap template = context.ImageData != null ? context.ImageData.ExtractTemplate(region) : context.Image.ExtractTemplate(region);
             return new TrackFrame(context.Time, location, template, positionningSource);
         }
 
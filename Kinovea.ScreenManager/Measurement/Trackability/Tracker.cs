@@ -33,12 +33,43 @@ namespace Kinovea.ScreenManager
         /// Tracks a reference template in the given image. Returns similarity score and position of best candidate.
         /// </summary>
         public static TrackResult Track(Size searchWindow, TrackFrame reference, Bitmap image)
+        {
+            return Track(searchWindow, reference, image, null);
+        }
+
+        public static TrackResult Track(Size searchWindow, TrackFrame reference, Bitmap image, PyramidMatcher matcher)
         {
             if(image == null || reference.Template == null)
                 throw new ArgumentException("image");
 
-            Rectangle searchZone = reference.Location.Box(searchWindow).ToRectangle();
             Rectangle imageBounds = new Rectangle(0, 0, image.Width, image.Height);
+            BitmapData imageData = image.LockBits(imageBounds, ImageLockMode.ReadOnly, image.PixelFormat);
+            TrackResult result = Track(searchWindow, reference, imageData, matcher);
+            image.UnlockBits(imageData);
+
+            return result;
+        }
+
+        /// <summary>
+        /// Tracks a reference template in an already locked image. 
+        /// The image is only read, so the same locked image can be used concurrently from several threads.
+        /// </summary>
+        public static TrackResult Track(Size searchWindow, TrackFrame reference, BitmapData imageData)
+        {
+            return Track(searchWindow, reference, imageData, null);
+        }
+
+        /// <summary>
+        /// Tracks a reference template in an already locked image. 
+        /// If a matcher is passed and the search window is large compared to the template, the matching is done coarse to fine.
+        /// </summary>
+        public static TrackResult Track(Size searchWindow, TrackFrame reference, BitmapData imageData, PyramidMatcher matcher)
+        {
+            if(imageData == null || reference.Template == null)
+                throw new ArgumentException("image");
+
+            Rectangle searchZone = reference.Location.Box(searchWindow).ToRectangle();
+            Rectangle imageBounds = new Rectangle(0, 0, imageData.Width, imageData.Height);
             searchZone.Intersect(imageBounds);
             
             if(searchZone == Rectangle.Empty)
@@ -49,8 +80,16 @@ namespace Kinovea.ScreenManager
             
             if(searchZone.Width < template.Width || searchZone.Height < template.Height)
                 return new TrackResult(0, Point.Empty);
+
+            int levels = matcher == null ? 0 : PyramidMatcher.GetLevels(searchZone.Size, template.Size);
+            if (levels > 0)
+            {
+                Point matchLocation;
+                double similarity = matcher.Match(imageData, searchZone, template, levels, out matchLocation);
+                Point center = new Point(searchZone.Left + matchLocation.X + template.Width / 2, searchZone.Top + matchLocation.Y + template.Height / 2);
+                return new TrackResult(similarity, center);
+            }
             
-            BitmapData imageData = image.LockBits(imageBounds, ImageLockMode.ReadOnly, image.PixelFormat );
             BitmapData templateData = template.LockBits(templateBounds, ImageLockMode.ReadOnly, template.PixelFormat );
             
             Image<Bgra, Byte> cvImage = new Image<Bgra, Byte>(imageData.Width, imageData.Height, imageData.Stride, imageData.Scan0);
@@ -64,7 +103,6 @@ namespace Kinovea.ScreenManager
             
             CvInvoke.cvMatchTemplate(cvImage.Ptr, cvTemplate.Ptr, similarityMap.Ptr, TM_TYPE.CV_TM_CCOEFF_NORMED);
                 
-            image.UnlockBits(imageData);
             template.UnlockBits(templateData);
                 
             Point minLoc = new Point(0,0);
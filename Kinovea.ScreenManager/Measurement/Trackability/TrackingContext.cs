@@ -20,6 +20,7 @@ along with Kinovea. If not, see http://www.gnu.org/licenses/.
 #endregion
 using System;
 using System.Drawing;
+using System.Drawing.Imaging;
 
 namespace Kinovea.ScreenManager
 {
@@ -35,14 +36,42 @@ namespace Kinovea.ScreenManager
             get { return image; }
         }
 
+        /// <summary>
+        /// The locked pixels of the image, or null if the image is not currently locked.
+        /// While the image is locked it must be accessed read-only and through this object only.
+        /// This lets several trackable points share the same frame without calling LockBits each.
+        /// </summary>
+        public BitmapData ImageData
+        {
+            get { return imageData; }
+        }
+
         private long time;
         private Bitmap image;
+        private BitmapData imageData;
         
         public TrackingContext(long time, Bitmap image)
         {
             this.time = time;
             this.image = image;
         }
+
+        public void Lock()
+        {
+            if (imageData != null || image == null)
+                return;
+
+            imageData = image.LockBits(new Rectangle(0, 0, image.Width, image.Height), ImageLockMode.ReadOnly, image.PixelFormat);
+        }
+
+        public void Unlock()
+        {
+            if (imageData == null)
+                return;
+
+            image.UnlockBits(imageData);
+            imageData = null;
+        }
         
         public override string ToString()
         {
@@ -29,10 +29,16 @@ namespace Kinovea.ScreenManager
     /// This class is not to be instanciated, use a concrete tracker instead,
     /// like TrackerSURF or TrackerBlock. 
     /// </summary>
-    public abstract class AbstractTracker
+    public abstract class AbstractTracker : IDisposable
     {
         public abstract TrackerParameters Parameters { get; set; }
 
+        /// <summary>
+        /// Releases the working resources of the tracker, if any.
+        /// </summary>
+        public virtual void Dispose()
+        {
+        }
 
         #region Abstract Methods
         
@@ -219,7 +219,11 @@ namespace Kinovea.ScreenManager
         private const int focusFadingFrames = 30;    // Number of frames of the focus section. 
        
         // Internal data.
-        private List<AbstractTrackPoint> positions = new List<AbstractTrackPoint>();
+        private List<AbstractTrackPoint> positions = new List<AbstractTrackPoint>();     // Sorted by time.
+        private Point[] polyline;                    // Trajectory in screen space, consecutive duplicate pixels removed.
+        private int[] polylineIndices;               // Index in positions of each vertex of the polyline.
+        private Point polylineOrigin;                // Transform of the reference points at the time the polyline was built.
+        private Point polylineFar;
         private FilteredTrajectory filteredTrajectory = new FilteredTrajectory();
         private TimeSeriesCollection timeSeriesCollection;
         private LinearKinematics linearKinematics = new LinearKinematics();
@@ -287,7 +291,7 @@ namespace Kinovea.ScreenManager
         public DrawingTrack(XmlReader xmlReader, PointF scale, TimestampMapper timestampMapper, Metadata metadata)
             : this(PointF.Empty, 0, null)
         {
-            ReadXml(xmlReader, scale, timestampMapper);
+            ReadXml(xmlReader, scale, timestampMapper, metadata != null ? metadata.Sidecar : null);
         }
         #endregion
 
@@ -369,6 +373,7 @@ namespace Kinovea.ScreenManager
             {
                 positions[currentPoint].X += dx;
                 positions[currentPoint].Y += dy;
+                polyline = null;
 
                 if (trackStatus == TrackStatus.Configuration)
                     UpdateBoundingBoxes();
@@ -527,10 +532,7 @@ namespace Kinovea.ScreenManager
             if (trackStatus == TrackStatus.Configuration)
                 return;
 
-            Point[] points = new Point[end - start + 1];
-            for (int i = 0; i <= end - start; i++)
-                points[i] = transformer.Transform(positions[start + i].Point);
-
+            Point[] points = GetPolyline(start, end, transformer);
             if (points.Length <= 1)
                 return;
             
@@ -551,6 +553,71 @@ namespace Kinovea.ScreenManager
                 }
             }
         }
+        /// <summary>
+        /// Returns the screen space vertices of the trajectory between two points.
+        /// The whole trajectory is transformed once and kept until the transform or the points change.
+        /// Consecutive points falling on the same pixel are merged, so long tracks at high frame rates
+        /// don't send more vertices than there are pixels along the path.
+        /// </summary>
+        private Point[] GetPolyline(int start, int end, IImageToViewportTransformer transformer)
+        {
+            // The transform is a scale and a translation, two reference points are enough to detect zoom and pan.
+            Point origin = transformer.Transform(PointF.Empty);
+            Point far = transformer.Transform(new PointF(4096, 4096));
+
+            Point[] vertices = polyline;
+            int[] indices = polylineIndices;
+            if (vertices == null || origin != polylineOrigin || far != polylineFar)
+            {
+                BuildPolyline(transformer, out vertices, out indices);
+                polylineOrigin = origin;
+                polylineFar = far;
+                polyline = vertices;
+                polylineIndices = indices;
+            }
+
+            // Vertices holding the runs of pixels that contain the start and end points.
+            int first = UpperBound(indices, start) - 1;
+            int last = UpperBound(indices, end) - 1;
+            if (first < 0 || last < first)
+                return new Point[0];
+
+            Point[] points = new Point[last - first + 1];
+            Array.Copy(vertices, first, points, 0, points.Length);
+            return points;
+        }
+        private void BuildPolyline(IImageToViewportTransformer transformer, out Point[] vertices, out int[] indices)
+        {
+            List<Point> pointList = new List<Point>();
+            List<int> indexList = new List<int>();
+            for (int i = 0; i < positions.Count; i++)
+            {
+                Point p = transformer.Transform(positions[i].Point);
+                if (pointList.Count > 0 && pointList[pointList.Count - 1] == p)
+                    continue;
+
+                pointList.Add(p);
+                indexList.Add(i);
+            }
+
+            vertices = pointList.ToArray();
+            indices = indexList.ToArray();
+        }
+        private static int UpperBound(int[] values, int value)
+        {
+            int low = 0;
+            int high = values.Length;
+            while (low < high)
+            {
+                int mid = low + (high - low) / 2;
+                if (values[mid] <= value)
+                    low = mid + 1;
+                else
+                    high = mid;
+            }
+
+            return low;
+        }
         private void DrawMarker(Graphics canvas,  double fadingFactor, IImageToViewportTransformer transformer)
         {
             int radius = defaultCrossRadius;
@@ -833,6 +900,7 @@ namespace Kinovea.ScreenManager
                 // Image will be reseted at mouse up. (=> UpdateTrackPoint)
                 positions[currentPoint].X += dx;
                 positions[currentPoint].Y += dy;
+                polyline = null;
             }
             else
             {
@@ -926,6 +994,7 @@ namespace Kinovea.ScreenManager
             if (currentPoint < positions.Count - 1)
                 positions.RemoveRange(currentPoint + 1, positions.Count - currentPoint - 1);
 
+            polyline = null;
             endTimeStamp = positions[positions.Count - 1].T;
 
             UpdateKinematics();
@@ -944,14 +1013,17 @@ namespace Kinovea.ScreenManager
         #endregion
         
         #region Tracking
-        public void TrackCurrentPosition(VideoFrame current)
+        /// <summary>
+        /// Match the previous point in the current image. Returns true if the trajectory was modified.
+        /// </summary>
+        public bool TrackCurrentPosition(VideoFrame current)
         {
             // Match the previous point in current image.
             // New points to trajectories are always created from here, 
 
             TrackPointBlock closestFrame = positions.Last() as TrackPointBlock;
             if (closestFrame == null || current.Timestamp <= closestFrame.T)
-                return;
+                return false;
 
             if (closestFrame.Template == null)
             {
@@ -967,10 +1039,11 @@ namespace Kinovea.ScreenManager
             if (p == null)
             {
                 StopTracking();
-                return;
+                return closestFrame.Template == null;
             }
             
             positions.Add(p);
+            polyline = null;
 
             if (!bMatched)
                 StopTracking();
@@ -979,6 +1052,7 @@ namespace Kinovea.ScreenManager
             endTimeStamp = positions.Last().T;
             ComputeFlatDistance();
             IntegrateKeyframes();
+            return true;
         }
         private void ComputeFlatDistance()
         {
@@ -1022,6 +1096,8 @@ namespace Kinovea.ScreenManager
             
             if(atp != null)
                  positions[currentPoint] = atp;
+
+            polyline = null;
             
             // Update the mini label (attach, position of label, and text).
             for (int i = 0; i < keyframesLabels.Count; i++)
@@ -1066,6 +1142,14 @@ namespace Kinovea.ScreenManager
         
         #region KVA Serialization
         public void WriteXml(XmlWriter w, SerializationFilter filter)
+        {
+            WriteXml(w, filter, null);
+        }
+
+        /// <summary>
+        /// Writes the track. When a snapshot is passed the track points are stored in it instead of inline.
+        /// </summary>
+        public void WriteXml(XmlWriter w, SerializationFilter filter, MetadataSnapshot snapshot)
         {
             if (ShouldSerializeCore(filter))
             {
@@ -1089,7 +1173,7 @@ namespace Kinovea.ScreenManager
                 tracker.Parameters.WriteXml(w);
                 w.WriteEndElement();
 
-                TrackPointsToXml(w);
+                TrackPointsToXml(w, snapshot);
 
                 w.WriteStartElement("MainLabel");
                 w.WriteAttributeString("Text", name);
@@ -1132,12 +1216,20 @@ namespace Kinovea.ScreenManager
             //    TrackPointsToSpreadsheetXml(w);
             //}
         }
-        private void TrackPointsToXml(XmlWriter w)
+        private void TrackPointsToXml(XmlWriter w, MetadataSnapshot snapshot)
         {
             w.WriteStartElement("TrackPointList");
             w.WriteAttributeString("Count", positions.Count.ToString());
             
-            if(positions.Count > 0)
+            if (snapshot != null)
+            {
+                SidecarSample[] samples = new SidecarSample[positions.Count];
+                for (int i = 0; i < positions.Count; i++)
+                    samples[i] = new SidecarSample(positions[i].T, positions[i].X, positions[i].Y, 0);
+
+                w.WriteAttributeString("Sidecar", snapshot.AddSeries(identifier.ToString(), samples));
+            }
+            else if(positions.Count > 0)
             {
                 foreach (AbstractTrackPoint tp in positions)
                 {
@@ -1180,8 +1272,17 @@ namespace Kinovea.ScreenManager
         }
 
         public void ReadXml(XmlReader xmlReader, PointF scale, TimestampMapper timestampMapper)
+        {
+            ReadXml(xmlReader, scale, timestampMapper, null);
+        }
+
+        /// <summary>
+        /// Reads the track. The sidecar holds the track points stored out of the KVA, if any.
+        /// </summary>
+        public void ReadXml(XmlReader xmlReader, PointF scale, TimestampMapper timestampMapper, MetadataSidecar sidecar)
         {
             invalid = true;
+            tracker.Dispose();
             tracker = new TrackerBlock2(GetTrackerParameters(new Size(800, 600)));
                 
             if (timestampMapper == null)
@@ -1231,7 +1332,7 @@ namespace Kinovea.ScreenManager
                         tracker.Parameters = TrackerParameters.ReadXml(xmlReader, scale);
                         break;
                     case "TrackPointList":
-                        ParseTrackPointList(xmlReader, scale, timestampMapper);
+                        ParseTrackPointList(xmlReader, scale, timestampMapper, sidecar);
                         break;
                     case "DrawingStyle":
                         style = new DrawingStyle(xmlReader);
@@ -1254,6 +1355,12 @@ namespace Kinovea.ScreenManager
             
             xmlReader.ReadEndElement();
             scalingDone = true;
+
+            // Lookups by time rely on the points being sorted. Files written by Kinovea always are.
+            if (!IsSortedByTime())
+                positions = positions.OrderBy(p => p.T).ToList();
+
+            polyline = null;
             
             if (positions.Count > 0)
             {
@@ -1273,10 +1380,23 @@ namespace Kinovea.ScreenManager
             // Depending on the order of parsing the main style initialization may have not impacted the mini labels.
             AfterMainStyleChange();
         }
-        public void ParseTrackPointList(XmlReader xmlReader, PointF scale, TimestampMapper timestampMapper)
+        public void ParseTrackPointList(XmlReader xmlReader, PointF scale, TimestampMapper timestampMapper, MetadataSidecar sidecar)
         {
             positions.Clear();
+
+            bool isEmpty = xmlReader.IsEmptyElement;
+
+            string seriesId = null;
+            if (xmlReader.MoveToAttribute("Sidecar"))
+                seriesId = xmlReader.ReadContentAsString();
+
             xmlReader.ReadStartElement();
+
+            if (seriesId != null)
+                ParseTrackPointList(sidecar, seriesId, scale, timestampMapper);
+
+            if (isEmpty)
+                return;
             
             while(xmlReader.NodeType == XmlNodeType.Element)
             {
@@ -1299,6 +1419,22 @@ namespace Kinovea.ScreenManager
             
             xmlReader.ReadEndElement();
         }
+        private void ParseTrackPointList(MetadataSidecar sidecar, string seriesId, PointF scale, TimestampMapper timestampMapper)
+        {
+            SidecarSample[] samples;
+            if (sidecar == null || !sidecar.TryGetSeries(seriesId, out samples))
+            {
+                log.ErrorFormat("Track points {0} not found in the sidecar.", seriesId);
+                return;
+            }
+
+            foreach (SidecarSample sample in samples)
+            {
+                // Time is stored in absolute timestamps.
+                PointF point = new PointF(sample.X, sample.Y).Scale(scale.X, scale.Y);
+                positions.Add(tracker.CreateOrphanTrackPoint(point, timestampMapper(sample.T)));
+            }
+        }
         public void ParseKeyframeLabelList(XmlReader xmlReader, PointF scale)
         {
             keyframesLabels.Clear();
@@ -1339,6 +1475,7 @@ namespace Kinovea.ScreenManager
                 return;
 
             TrackerParameters parameters = GetTrackerParameters(imageSize);
+            tracker.Dispose();
             tracker = new TrackerBlock2(parameters);
         }
         #endregion
@@ -1358,7 +1495,18 @@ namespace Kinovea.ScreenManager
         public void Clear()
         {
             positions.Clear();
+            polyline = null;
             keyframesLabels.Clear();
+            tracker.Dispose();
+        }
+
+        /// <summary>
+        /// Releases the tracker working images when the track is removed from the metadata.
+        /// The track stays usable, for example after undoing the deletion.
+        /// </summary>
+        public void ReleaseTracker()
+        {
+            tracker.Dispose();
         }
         public void IntegrateKeyframes()
         {
@@ -1527,20 +1675,43 @@ namespace Kinovea.ScreenManager
         {
             // Find the closest registered timestamp
             // Parameter is given in absolute timestamp.
-            long minErr = long.MaxValue;
-            int closest = 0;
+            // Points are sorted by time, on a tie the earlier point wins.
+            if (positions.Count == 0)
+                return 0;
 
-            for (int i = 0; i < positions.Count; i++)
+            int low = 0;
+            int high = positions.Count;
+            while (low < high)
             {
-                long err = Math.Abs(positions[i].T - currentTimestamp);
-                if (err < minErr)
-                {
-                    minErr = err;
-                    closest = i;
-                }
+                int mid = low + (high - low) / 2;
+                if (positions[mid].T < currentTimestamp)
+                    low = mid + 1;
+                else
+                    high = mid;
+            }
+
+            if (low == positions.Count)
+                return positions.Count - 1;
+
+            if (low > 0 && currentTimestamp - positions[low - 1].T <= positions[low].T - currentTimestamp)
+            {
+                // Go back to the first of the points sharing this time.
+                low--;
+                while (low > 0 && positions[low - 1].T == positions[low].T)
+                    low--;
+            }
+
+            return low;
+        }
+        private bool IsSortedByTime()
+        {
+            for (int i = 1; i < positions.Count; i++)
+            {
+                if (positions[i].T < positions[i - 1].T)
+                    return false;
             }
 
-            return closest;
+            return true;
         }
         
         private void BindStyle()
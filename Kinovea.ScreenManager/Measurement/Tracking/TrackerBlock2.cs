@@ -40,6 +40,9 @@ namespace Kinovea.ScreenManager
     /// - use the template found in image I-1.
     /// - save the template in point at image I.
     /// - no need to save the relative search window as points are saved in absolute coords.
+    ///
+    /// When the search window is large compared to the template, the matching is done coarse to fine
+    /// on grey level images through a PyramidMatcher, instead of over the whole window at full resolution.
     /// </summary>
     public class TrackerBlock2 : AbstractTracker
     {
@@ -61,6 +64,7 @@ namespace Kinovea.ScreenManager
         private Size blockWindow = new Size(20, 20);
         private Size searchWindow = new Size(100, 100);
         private TrackerParameters parameters;
+        private PyramidMatcher pyramidMatcher = new PyramidMatcher();
 
         // Monitoring, debugging.
         private static readonly bool monitoring = false;
@@ -109,6 +113,27 @@ namespace Kinovea.ScreenManager
                 Bitmap tpl = lastTrackPoint.Template;
 
                 BitmapData imageData = img.LockBits( new Rectangle( 0, 0, img.Width, img.Height ), ImageLockMode.ReadOnly, img.PixelFormat );
+
+                int levels = PyramidMatcher.GetLevels(searchZone.Size, tpl.Size);
+                if (levels > 0)
+                {
+                    // Coarse to fine.
+                    Point matchLocation;
+                    double score = pyramidMatcher.Match(imageData, searchZone, tpl, levels, out matchLocation);
+                    img.UnlockBits(imageData);
+
+                    PointF bestCandidatePyramid = new PointF(-1, -1);
+                    if (score > similarityTreshold)
+                    {
+                        PointF loc = RefineLocation(pyramidMatcher.FineMap.Data, pyramidMatcher.FineMapLocation, parameters.RefinementNeighborhood);
+                        loc = loc.Translate(pyramidMatcher.FineMapOrigin.X + subpixel.X, pyramidMatcher.FineMapOrigin.Y + subpixel.Y);
+                        bestCandidatePyramid = new PointF(searchZone.Left + loc.X + tpl.Width / 2, searchZone.Top + loc.Y + tpl.Height / 2);
+                    }
+
+                    currentPoint = CreateMatchedTrackPoint(bestCandidatePyramid, score, lastPoint, position, img, previousPoints);
+                    return true;
+                }
+
                 BitmapData templateData = tpl.LockBits(new Rectangle( 0, 0, tpl.Width, tpl.Height ), ImageLockMode.ReadOnly, tpl.PixelFormat );
 
                 Image<Bgra, Byte> cvImage = new Image<Bgra, Byte>(imageData.Width, imageData.Height, imageData.Stride, imageData.Scan0);
@@ -163,19 +188,7 @@ namespace Kinovea.ScreenManager
                 }
                 #endregion
 
-                // Result of the matching.
-                if(bestCandidate.X != -1 && bestCandidate.Y != -1)
-                {
-                    currentPoint = CreateTrackPoint(false, bestCandidate, bestScore, position, img, previousPoints);
-                    ((TrackPointBlock)currentPoint).Similarity = bestScore;
-                }
-                else
-                {
-                    // No match. Create the point at the center of the search window (whatever that might be).
-                    currentPoint = CreateTrackPoint(false, lastPoint, 0.0f, position, img, previousPoints);
-                    log.Debug("Track failed. No block over the similarity treshold in the search window.");
-                }
-
+                currentPoint = CreateMatchedTrackPoint(bestCandidate, bestScore, lastPoint, position, img, previousPoints);
                 matched = true;
             }
             else
@@ -293,6 +306,26 @@ namespace Kinovea.ScreenManager
 
             return tpb;
         }
+        /// <summary>
+        /// Creates the track point resulting from the matching.
+        /// </summary>
+        private AbstractTrackPoint CreateMatchedTrackPoint(PointF bestCandidate, double bestScore, PointF lastPoint, long position, Bitmap img, List<AbstractTrackPoint> previousPoints)
+        {
+            AbstractTrackPoint currentPoint;
+            if(bestCandidate.X != -1 && bestCandidate.Y != -1)
+            {
+                currentPoint = CreateTrackPoint(false, bestCandidate, bestScore, position, img, previousPoints);
+                ((TrackPointBlock)currentPoint).Similarity = bestScore;
+            }
+            else
+            {
+                // No match. Create the point at the center of the search window (whatever that might be).
+                currentPoint = CreateTrackPoint(false, lastPoint, 0.0f, position, img, previousPoints);
+                log.Debug("Track failed. No block over the similarity treshold in the search window.");
+            }
+
+            return currentPoint;
+        }
         public override AbstractTrackPoint CreateOrphanTrackPoint(PointF p, long t)
         {
             // This creates a bare bone TrackPoint.
@@ -335,6 +368,12 @@ namespace Kinovea.ScreenManager
         {
             return position.Box(searchWindow);
         }
+
+        public override void Dispose()
+        {
+            // The matcher reallocates its working images on demand so the tracker stays usable afterwards.
+            pyramidMatcher.Dispose();
+        }
         #endregion
 
         private void SetParameters(TrackerParameters parameters)
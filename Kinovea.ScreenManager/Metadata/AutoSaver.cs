@@ -21,7 +21,8 @@ along with Kinovea. If not, see http://www.gnu.org/licenses/.
 #endregion
 using System;
 using System.IO;
-using System.Timers;
+using System.Threading.Tasks;
+using System.Windows.Forms;
 
 using Kinovea.Services;
 
@@ -30,6 +31,7 @@ namespace Kinovea.ScreenManager
     /// <summary>
     /// Automatically triggers metadata autosave at regular intervals.
     /// Implements its own IsDirty mechanics to avoid interfering with user manual saving.
+    /// The snapshot of the metadata is taken on the UI thread and written to disk in the background.
     /// </summary>
     public class AutoSaver
     {
@@ -37,7 +39,10 @@ namespace Kinovea.ScreenManager
         private bool enabled;
         private Metadata metadata;
         private Timer timer = new Timer();
-        private int referenceHash;
+        private AutosaveJournal journal = new AutosaveJournal();
+        private volatile bool writing;
+        private long referenceVersion;
+        private int clearCount;
         private static readonly int interval = 30 * 1000;
         private static readonly log4net.ILog log = log4net.LogManager.GetLogger(System.Reflection.MethodBase.GetCurrentMethod().DeclaringType);
         #endregion
@@ -48,7 +53,7 @@ namespace Kinovea.ScreenManager
             enabled = true;
 
             timer.Interval = interval;
-            timer.Elapsed += (s, e) => Tick();
+            timer.Tick += (s, e) => Tick();
         }
 
         public void FreshStart()
@@ -78,26 +83,60 @@ namespace Kinovea.ScreenManager
             if (!enabled || metadata == null)
                 return;
 
-            referenceHash = metadata.GetContentHash();
-            log.DebugFormat("Autosave cleared. - {0}", referenceHash);
+            referenceVersion = metadata.ContentVersion;
+            clearCount++;
+            log.DebugFormat("Autosave cleared. - {0}", referenceVersion);
         }
         public void Tick()
         {
             Save();
         }
 
+        /// <summary>
+        /// Deletes the autosave files. Pending background writes are discarded.
+        /// </summary>
+        public void Delete(string folder)
+        {
+            journal.Delete(folder);
+        }
+
         private void Save()
         {
             if (!enabled || metadata == null)
                 return;
 
-            int hash = metadata.GetContentHash();
-            if (hash != referenceHash)
+            // If the previous autosave is still being written, try again at the next tick.
+            if (writing)
+                return;
+
+            long version = metadata.ContentVersion;
+            if (version == referenceVersion)
+                return;
+
+            log.DebugFormat("Autosave saving. - {0}", version);
+            MetadataSnapshot snapshot = metadata.TakeAutosaveSnapshot();
+            string folder = metadata.TempFolder;
+            int epoch = journal.Epoch;
+            int clears = clearCount;
+
+            // The version is only considered saved once the files are written, a failed write is retried at the next tick.
+            // The continuation runs on the UI thread, like Clear.
+            writing = true;
+            Task.Factory.StartNew(() => journal.Write(snapshot, folder, epoch)).ContinueWith(t =>
             {
-                log.DebugFormat("Autosave saving. - {0}", hash);
-                metadata.PerformAutosave();
-                referenceHash = hash;
-            }
+                writing = false;
+
+                if (t.IsFaulted)
+                {
+                    log.Error("An error happened while writing the autosave files.");
+                    log.Error(t.Exception.InnerException);
+                    return;
+                }
+
+                // Do not go back to an older version if the reference was reset in the meantime.
+                if (clears == clearCount)
+                    referenceVersion = version;
+            }, TaskScheduler.FromCurrentSynchronizationContext());
         }
     }
 }
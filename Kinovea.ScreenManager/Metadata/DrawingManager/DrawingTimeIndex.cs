@@ -0,0 +1,297 @@
+﻿#region License
+/*
+Copyright © Joan Charmant 2012.
+jcharmant@gmail.com
+
+This file is part of Kinovea.
+
+Kinovea is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2
+as published by the Free Software Foundation.
+
+Kinovea is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Kinovea. If not, see http://www.gnu.org/licenses/.
+
+*/
+#endregion
+using System;
+using System.Collections.Generic;
+using Kinovea.Services;
+
+namespace Kinovea.ScreenManager
+{
+    /// <summary>
+    /// Index of the drawings attached to keyframes by the span of time during which they may be visible.
+    ///
+    /// The span of a drawing is derived from its fading configuration, extended by the tracked range for trackable drawings.
+    /// In fading mode this lets the renderer only consider the drawings that may be visible at the current time
+    /// instead of every drawing of every keyframe. Drawings without a fading configuration or always visible
+    /// are kept aside and always returned.
+    ///
+    /// The index is updated incrementally when keyframes and drawings are added, removed or modified.
+    /// Changes to the default fading preferences or to the tracking data are picked up at query time,
+    /// only the trackable drawings whose tracked range changed are indexed again.
+    /// </summary>
+    public class DrawingTimeIndex
+    {
+        private class Entry
+        {
+            public Keyframe Keyframe;
+            public AbstractDrawing Drawing;
+            public long Start;
+            public long End;
+            public bool Bounded;
+            public long TrackingVersion;
+            public bool Tracked;
+            public long TrackedStart;
+            public long TrackedEnd;
+        }
+
+        private TrackabilityManager trackabilityManager;
+        private Dictionary<Guid, Entry> entries = new Dictionary<Guid, Entry>();
+        private List<Entry> spans = new List<Entry>();          // Bounded entries sorted by start time.
+        private List<Entry> unbounded = new List<Entry>();
+        private List<Entry> trackables = new List<Entry>();
+        private long maxLength;
+        private int defaultFadingHash;
+        private long trackingVersion;
+        private object locker = new object();
+
+        public DrawingTimeIndex(TrackabilityManager trackabilityManager)
+        {
+            this.trackabilityManager = trackabilityManager;
+            defaultFadingHash = PreferencesManager.PlayerPreferences.DefaultFading.ContentHash;
+            trackingVersion = trackabilityManager.ContentVersion;
+        }
+
+        /// <summary>
+        /// Adds or updates the drawing.
+        /// </summary>
+        public void Add(Keyframe keyframe, AbstractDrawing drawing)
+        {
+            lock (locker)
+            {
+                if (entries.ContainsKey(drawing.Id))
+                    RemoveEntry(entries[drawing.Id]);
+
+                Entry entry = new Entry();
+                entry.Keyframe = keyframe;
+                entry.Drawing = drawing;
+                entries.Add(drawing.Id, entry);
+
+                if (drawing is ITrackable)
+                    trackables.Add(entry);
+
+                InsertEntry(entry);
+            }
+        }
+
+        public void AddKeyframe(Keyframe keyframe)
+        {
+            foreach (AbstractDrawing drawing in keyframe.Drawings)
+                Add(keyframe, drawing);
+        }
+
+        public void Remove(Guid drawingId)
+        {
+            lock (locker)
+            {
+                Entry entry;
+                if (!entries.TryGetValue(drawingId, out entry))
+                    return;
+
+                RemoveEntry(entry);
+                entries.Remove(drawingId);
+                if (entry.Drawing is ITrackable)
+                    trackables.Remove(entry);
+            }
+        }
+
+        public void RemoveKeyframe(Keyframe keyframe)
+        {
+            foreach (AbstractDrawing drawing in keyframe.Drawings)
+                Remove(drawing.Id);
+        }
+
+        /// <summary>
+        /// Recomputes the span of the drawing after a change of its fading configuration.
+        /// </summary>
+        public void Update(Guid drawingId)
+        {
+            lock (locker)
+            {
+                Entry entry;
+                if (!entries.TryGetValue(drawingId, out entry))
+                    return;
+
+                RemoveEntry(entry);
+                InsertEntry(entry);
+            }
+        }
+
+        public void Clear()
+        {
+            lock (locker)
+            {
+                entries.Clear();
+                spans.Clear();
+                unbounded.Clear();
+                trackables.Clear();
+                maxLength = 0;
+            }
+        }
+
+        /// <summary>
+        /// Collects the drawings that may be visible at this time, and the keyframes they belong to.
+        /// </summary>
+        public void Query(long timestamp, List<Keyframe> keyframes, HashSet<AbstractDrawing> drawings)
+        {
+            lock (locker)
+            {
+                Validate();
+
+                // Only the entries starting in the window of the longest span can contain the time.
+                int first = LowerBound(timestamp - maxLength);
+                for (int i = first; i < spans.Count && spans[i].Start <= timestamp; i++)
+                {
+                    if (spans[i].End >= timestamp)
+                        Collect(spans[i], keyframes, drawings);
+                }
+
+                foreach (Entry entry in unbounded)
+                    Collect(entry, keyframes, drawings);
+            }
+        }
+
+        /// <summary>
+        /// Picks up the changes that aren't signaled individually.
+        /// </summary>
+        private void Validate()
+        {
+            int hash = PreferencesManager.PlayerPreferences.DefaultFading.ContentHash;
+            if (hash != defaultFadingHash)
+            {
+                defaultFadingHash = hash;
+                List<Entry> all = new List<Entry>(entries.Values);
+                spans.Clear();
+                unbounded.Clear();
+                maxLength = 0;
+                foreach (Entry entry in all)
+                    InsertEntry(entry);
+            }
+
+            long version = trackabilityManager.ContentVersion;
+            if (version != trackingVersion)
+            {
+                trackingVersion = version;
+                foreach (Entry entry in trackables)
+                {
+                    if (!TrackedSpanChanged(entry))
+                        continue;
+
+                    RemoveEntry(entry);
+                    InsertEntry(entry);
+                }
+            }
+        }
+
+        private bool TrackedSpanChanged(Entry entry)
+        {
+            // Most trackers don't change from one frame to the next, only check the range of those that did.
+            long version = trackabilityManager.GetContentVersion(entry.Drawing.Id);
+            if (version == entry.TrackingVersion)
+                return false;
+
+            entry.TrackingVersion = version;
+
+            long start;
+            long end;
+            bool tracked = trackabilityManager.GetTrackedSpan(entry.Drawing.Id, out start, out end);
+            if (tracked != entry.Tracked)
+                return true;
+
+            return tracked && (start != entry.TrackedStart || end != entry.TrackedEnd);
+        }
+
+        private void Collect(Entry entry, List<Keyframe> keyframes, HashSet<AbstractDrawing> drawings)
+        {
+            drawings.Add(entry.Drawing);
+            if (!keyframes.Contains(entry.Keyframe))
+                keyframes.Add(entry.Keyframe);
+        }
+
+        private void ComputeSpan(Entry entry)
+        {
+            InfosFading infosFading = entry.Drawing.InfosFading;
+            entry.Bounded = infosFading != null && infosFading.GetVisibleSpan(out entry.Start, out entry.End);
+            if (!(entry.Drawing is ITrackable))
+                return;
+
+            // Trackable drawings are also visible around their tracked values.
+            // The tracked range is kept to detect when the entry must be indexed again.
+            entry.TrackingVersion = trackabilityManager.GetContentVersion(entry.Drawing.Id);
+            entry.Tracked = trackabilityManager.GetTrackedSpan(entry.Drawing.Id, out entry.TrackedStart, out entry.TrackedEnd);
+            if (!entry.Bounded || !entry.Tracked)
+                return;
+
+            long fading = infosFading.GetTrackingFadingTimestamps();
+            entry.Start = Math.Min(entry.Start, entry.TrackedStart - fading);
+            entry.End = Math.Max(entry.End, entry.TrackedEnd + fading);
+        }
+
+        private void InsertEntry(Entry entry)
+        {
+            ComputeSpan(entry);
+            if (!entry.Bounded)
+            {
+                unbounded.Add(entry);
+                return;
+            }
+
+            spans.Insert(LowerBound(entry.Start), entry);
+            maxLength = Math.Max(maxLength, entry.End - entry.Start);
+        }
+
+        private void RemoveEntry(Entry entry)
+        {
+            if (!entry.Bounded)
+            {
+                unbounded.Remove(entry);
+                return;
+            }
+
+            for (int i = LowerBound(entry.Start); i < spans.Count && spans[i].Start == entry.Start; i++)
+            {
+                if (spans[i] != entry)
+                    continue;
+
+                spans.RemoveAt(i);
+                break;
+            }
+        }
+
+        /// <summary>
+        /// Returns the index of the first span starting at or after the time.
+        /// </summary>
+        private int LowerBound(long time)
+        {
+            int low = 0;
+            int high = spans.Count;
+            while (low < high)
+            {
+                int mid = low + (high - low) / 2;
+                if (spans[mid].Start < time)
+                    low = mid + 1;
+                else
+                    high = mid;
+            }
+
+            return low;
+        }
+    }
+}
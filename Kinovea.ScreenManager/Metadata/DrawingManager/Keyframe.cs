@@ -28,6 +28,7 @@ using System.IO;
 using System.Xml;
 using System.Xml.Serialization;
 using Kinovea.Services;
+using Kinovea.Video.FFMpeg;
 
 namespace Kinovea.ScreenManager
 {
@@ -68,7 +69,14 @@ namespace Kinovea.ScreenManager
         public string Comments
         {
             get { return comments; }
-            set { comments = value; }
+            set 
+            {
+                if (comments == value)
+                    return;
+
+                comments = value;
+                AfterContentChanged();
+            }
         }
         public string Title
         {
@@ -80,6 +88,7 @@ namespace Kinovea.ScreenManager
             { 
                 title = value;
                 metadata.UpdateTrajectoriesForKeyframes();
+                AfterContentChanged();
             }
         }
 
@@ -91,7 +100,11 @@ namespace Kinovea.ScreenManager
             }
             set
             {
+                if (color == value)
+                    return;
+
                 color = value;
+                AfterContentChanged();
             }
         }
         public string TimeCode
@@ -169,7 +182,7 @@ namespace Kinovea.ScreenManager
             
             Rectangle rect = UIHelper.RatioStretch(image.Size, new Size(100, 75));
             this.thumbnail = new Bitmap(image, rect.Width, rect.Height);
-            this.disabledThumbnail = BitmapHelper.Grayscale(thumbnail);
+            this.disabledThumbnail = ImageKernels.Grayscale(thumbnail);
         }
         #endregion
 
@@ -317,6 +330,11 @@ namespace Kinovea.ScreenManager
         #endregion
 
         #region LowerLevel Helpers
+        private void AfterContentChanged()
+        {
+            if (metadata != null)
+                metadata.SetDirty();
+        }
         private int GetContentHash()
         {
             int hash = 0;
@@ -224,6 +224,9 @@ namespace Kinovea.ScreenManager
                     isMovingAnObject = false;
                     break;
             }
+
+            if (isMovingAnObject)
+                metadata.SetDirty();
             
             return isMovingAnObject;
         }
@@ -54,6 +54,7 @@ namespace Kinovea.ScreenManager
         public EventHandler<MultiDrawingItemEventArgs> MultiDrawingItemAdded;
         public EventHandler MultiDrawingItemDeleted;
         public EventHandler CameraCalibrationAsked;
+        public EventHandler VideoFilterInvalidated;
             
         public RelayCommand<ITrackable> AddTrackableDrawingCommand { get; set; }
         public RelayCommand<ITrackable> DeleteTrackableDrawingCommand { get; set; }
@@ -75,17 +76,52 @@ namespace Kinovea.ScreenManager
         {
             get 
             {
+                long currentVersion = ContentVersion;
+                bool dirty = currentVersion != referenceVersion;
+                log.DebugFormat("Dirty:{0}, reference version:{1}, current:{2}.", dirty.ToString(), referenceVersion, currentVersion);
+
+#if DEBUG
+                // Consistency check: a change of content that didn't bump the version is a missing call to SetDirty.
                 int currentHash = GetContentHash();
-                bool dirty = currentHash != referenceHash;
-                log.DebugFormat("Dirty:{0}, reference hash:{1}, current:{2}.", dirty.ToString(), referenceHash, currentHash);
+                if (!dirty && currentHash != referenceHash)
+                    log.ErrorFormat("Content changed without a version change. Reference hash:{0}, current:{1}.", referenceHash, currentHash);
+#endif
+
                 return dirty;
             }
         }
+
+        /// <summary>
+        /// Generation number of the content. Changes each time something that is saved to KVA is modified.
+        /// Comparing two values is enough to know if the content changed in between.
+        /// </summary>
+        public long ContentVersion
+        {
+            get { return Interlocked.Read(ref contentVersion) + trackabilityManager.ContentVersion; }
+        }
         public bool KVAImporting
         {
             get { return kvaImporting; }
         }
 
+        /// <summary>
+        /// Binary sidecar of the KVA being imported, holding the time series stored out of the XML.
+        /// Only set during the import.
+        /// </summary>
+        public MetadataSidecar Sidecar
+        {
+            get { return sidecar; }
+            set { sidecar = value; }
+        }
+
+        /// <summary>
+        /// Folder where the autosave files of this metadata are stored.
+        /// </summary>
+        public string TempFolder
+        {
+            get { return tempFolder; }
+        }
+
         /// <summary>
         /// The path to the KVA file this metadata was imported from or last saved.
         /// Returns an empty string if the file is a default KVA, to avoid overwriting them.
@@ -127,11 +163,31 @@ namespace Kinovea.ScreenManager
             get { return imageTransform; }
         }
 
-        public ImageAspectRatio ImageAspect { get; set; }
-        public ImageRotation ImageRotation { get; set; }
-        public bool Mirrored { get; set; }
-        public Demosaicing Demosaicing { get; set; }
-        public bool Deinterlacing { get; set; }
+        public ImageAspectRatio ImageAspect
+        {
+            get { return imageAspect; }
+            set { SetDirty(ref imageAspect, value); }
+        }
+        public ImageRotation ImageRotation
+        {
+            get { return imageRotation; }
+            set { SetDirty(ref imageRotation, value); }
+        }
+        public bool Mirrored
+        {
+            get { return mirrored; }
+            set { SetDirty(ref mirrored, value); }
+        }
+        public Demosaicing Demosaicing
+        {
+            get { return demosaicing; }
+            set { SetDirty(ref demosaicing, value); }
+        }
+        public bool Deinterlacing
+        {
+            get { return deinterlacing; }
+            set { SetDirty(ref deinterlacing, value); }
+        }
 
         /// <summary>
         /// Path to the video file this metadata was created on.
@@ -264,12 +320,12 @@ namespace Kinovea.ScreenManager
         public long SelectionStart
         {
             get { return selectionStart; }
-            set { selectionStart = value; }
+            set { SetDirty(ref selectionStart, value); }
         }
         public long SelectionEnd
         {
             get { return selectionEnd; }
-            set { selectionEnd = value; }
+            set { SetDirty(ref selectionEnd, value); }
         }
 
         /// <summary>
@@ -278,7 +334,7 @@ namespace Kinovea.ScreenManager
         public long TimeOrigin
         {
             get { return timeOrigin; }
-            set { timeOrigin = value; }
+            set { SetDirty(ref timeOrigin, value); }
         }
         public bool TestGridVisible
         {
@@ -336,8 +392,11 @@ namespace Kinovea.ScreenManager
         private bool initialized;
         private TimeCodeBuilder timecodeBuilder;
         private HistoryStack historyStack;
+        private long contentVersion;
+        private long referenceVersion;
         private int referenceHash;
         private bool kvaImporting;
+        private MetadataSidecar sidecar;
         private bool captureKVA;
 
         // Folders
@@ -348,6 +407,7 @@ namespace Kinovea.ScreenManager
 
         // Keyframes & attached drawings.
         private List<Keyframe> keyframes = new List<Keyframe>();
+        private DrawingTimeIndex drawingTimeIndex;
         private Keyframe hitKeyframe;
         private AbstractDrawing hitDrawing;
         
@@ -372,6 +432,11 @@ namespace Kinovea.ScreenManager
         private CalibrationHelper calibrationHelper = new CalibrationHelper();
         private Temporizer calibrationChangedTemporizer;
         private ImageTransform imageTransform = new ImageTransform();
+        private ImageAspectRatio imageAspect;
+        private ImageRotation imageRotation;
+        private bool mirrored;
+        private Demosaicing demosaicing;
+        private bool deinterlacing;
 
         // Timing information
         private long averageTimeStampsPerFrame = 1;
@@ -404,6 +469,11 @@ namespace Kinovea.ScreenManager
             this.timecodeBuilder = timecodeBuilder;
 
             calibrationHelper.CalibrationChanged += CalibrationHelper_CalibrationChanged;
+            drawingTimeIndex = new DrawingTimeIndex(trackabilityManager);
+
+            // Every undoable action is a change of content, this also covers undo and redo.
+            if (historyStack != null)
+                historyStack.HistoryChanged += (s, e) => SetDirty();
             
             autoSaver = new AutoSaver(this);
             
@@ -445,8 +515,10 @@ namespace Kinovea.ScreenManager
         {
             keyframes.Add(keyframe);
             keyframes.Sort();
+            drawingTimeIndex.AddKeyframe(keyframe);
             SelectKeyframe(keyframe);
             UpdateTrajectoriesForKeyframes();
+            SetDirty();
             
             if (KeyframeAdded != null)
                 KeyframeAdded(this, new KeyframeEventArgs(keyframe.Id));
@@ -460,10 +532,13 @@ namespace Kinovea.ScreenManager
 
                 foreach (AbstractDrawing drawing in keyframe.Drawings)
                     BeforeDrawingDeletion(drawing);
+
+                drawingTimeIndex.RemoveKeyframe(keyframe);
             }
 
             keyframes.RemoveAll(k => k.Id == id);
             UpdateTrajectoriesForKeyframes();
+            SetDirty();
             
             if (KeyframeDeleted != null)
                 KeyframeDeleted(this, new KeyframeEventArgs(id));
@@ -584,13 +659,17 @@ namespace Kinovea.ScreenManager
                 if (keyframe.Position < k.Position)
                 {
                     keyframes.Insert(i, keyframe);
+                    drawingTimeIndex.AddKeyframe(keyframe);
                     processed = true;
                     break;
                 }
                 else if (keyframe.Position == k.Position)
                 {
                     foreach (AbstractDrawing ad in keyframe.Drawings)
+                    {
                         k.Drawings.Add(ad);
+                        drawingTimeIndex.Add(k, ad);
+                    }
 
                     processed = true;
                     break;
@@ -598,7 +677,10 @@ namespace Kinovea.ScreenManager
             }
 
             if (!processed)
+            {
                 keyframes.Add(keyframe);
+                drawingTimeIndex.AddKeyframe(keyframe);
+            }
 
             // Post-init for the new drawings.
             foreach (AbstractDrawing ad in keyframe.Drawings)
@@ -757,6 +839,7 @@ namespace Kinovea.ScreenManager
                 return;
 
             keyframe.AddDrawing(drawing);
+            SetDirty();
             drawing.InfosFading.ReferenceTimestamp = keyframe.Position;
             drawing.InfosFading.AverageTimeStampsPerFrame = averageTimeStampsPerFrame;
             if (captureKVA)
@@ -765,6 +848,8 @@ namespace Kinovea.ScreenManager
                 drawing.InfosFading.AlwaysVisible = true;
             }
 
+            drawingTimeIndex.Add(keyframe, drawing);
+
             SelectKeyframe(keyframe);
             SelectDrawing(drawing);
 
@@ -781,6 +866,7 @@ namespace Kinovea.ScreenManager
         {
             multidrawing.Add(item);
             SelectDrawing(multidrawing);
+            SetDirty();
 
             if (MultiDrawingItemAdded != null)
                 MultiDrawingItemAdded(this, new MultiDrawingItemEventArgs(item, multidrawing));
@@ -793,6 +879,7 @@ namespace Kinovea.ScreenManager
         {
             chronoManager.AddDrawing(chrono);
             chrono.ParentMetadata = this;
+            SetDirty();
             
             hitDrawing = chrono;
 
@@ -808,6 +895,7 @@ namespace Kinovea.ScreenManager
         public void AddTrack(DrawingTrack track)
         {
             trackManager.AddDrawing(track);
+            SetDirty();
 
             track.ParentMetadata = this;
             
@@ -837,6 +925,12 @@ namespace Kinovea.ScreenManager
                 track.UpdateKinematics();
                 track.IntegrateKeyframes();
             }
+            else if (drawing != null)
+            {
+                drawingTimeIndex.Update(drawing.Id);
+            }
+
+            SetDirty();
 
             if (DrawingModified != null)
                 DrawingModified(this, new DrawingEventArgs(drawing, managerId));
@@ -866,7 +960,11 @@ namespace Kinovea.ScreenManager
             BeforeDrawingDeletion(drawing);
             
             manager.RemoveDrawing(drawingId);
+            if (manager is Keyframe)
+                drawingTimeIndex.Remove(drawingId);
+
             DeselectAll();
+            SetDirty();
             
             if (DrawingDeleted != null)
                 DrawingDeleted(this, EventArgs.Empty);
@@ -880,6 +978,7 @@ namespace Kinovea.ScreenManager
 
             manager.Remove(itemId);
             DeselectAll();
+            SetDirty();
 
             if (MultiDrawingItemDeleted != null)
                 MultiDrawingItemDeleted(this, EventArgs.Empty);
@@ -909,6 +1008,7 @@ namespace Kinovea.ScreenManager
                 return;
             
             string key = initializable.InitializeCommit(point);
+            SetDirty();
 
             if (string.IsNullOrEmpty(key))
                 return;
@@ -924,6 +1024,7 @@ namespace Kinovea.ScreenManager
                 return;
 
             string key = initializable.InitializeEnd(cancelCurrentPoint);
+            SetDirty();
 
             if (string.IsNullOrEmpty(key) || !cancelCurrentPoint)
                 return;
@@ -1233,9 +1334,11 @@ namespace Kinovea.ScreenManager
         }
         public void PerformTracking(VideoFrame videoframe)
         {
-            foreach(DrawingTrack t in Tracks())
-                if (t.Status == TrackStatus.Edit)
-                    t.TrackCurrentPosition(videoframe);
+            foreach (DrawingTrack t in Tracks())
+            {
+                if (t.Status == TrackStatus.Edit && t.TrackCurrentPosition(videoframe))
+                    SetDirty();
+            }
         }
         public void StopAllTracking()
         {
@@ -1246,14 +1349,19 @@ namespace Kinovea.ScreenManager
         {
             foreach (DrawingTrack t in Tracks())
                 t.Clear();
+
+            SetDirty();
         }
 
         public void UpdateTrackPoint(Bitmap bitmap)
         {
             // Happens when mouse up and editing a track.
             DrawingTrack t = hitDrawing as DrawingTrack;
-            if(t != null && (t.Status == TrackStatus.Edit || t.Status == TrackStatus.Configuration))
+            if (t != null && (t.Status == TrackStatus.Edit || t.Status == TrackStatus.Configuration))
+            {
                 t.UpdateTrackPoint(bitmap);
+                SetDirty();
+            }
         }
         public int GetContentHash()
         {
@@ -1275,9 +1383,22 @@ namespace Kinovea.ScreenManager
         }
         public void CleanupHash()
         {
+            referenceVersion = ContentVersion;
+#if DEBUG
             referenceHash = GetContentHash();
+#endif
             autoSaver.Clear();
-            log.Debug(String.Format("Metadata content hash reset:{0}.", referenceHash));
+            log.Debug(String.Format("Metadata content version reset:{0}.", referenceVersion));
+        }
+
+        /// <summary>
+        /// Signal a change of content. To be called by anything that modifies data saved to KVA 
+        /// outside of the methods of this class, the history stack and the trackability manager.
+        /// This may be called from a background thread.
+        /// </summary>
+        public void SetDirty()
+        {
+            Interlocked.Increment(ref contentVersion);
         }
         public void ResizeFinished()
         {
@@ -1343,6 +1464,9 @@ namespace Kinovea.ScreenManager
 
             if (drawing is DrawingDistortionGrid)
                 ((DrawingDistortionGrid)drawing).LensCalibrationAsked -= LensCalibrationAsked;
+
+            if (drawing is DrawingTrack)
+                ((DrawingTrack)drawing).ReleaseTracker();
         }
 
         public void BeforeKVAImport()
@@ -1377,7 +1501,7 @@ namespace Kinovea.ScreenManager
         {
             DeleteTempDirectory();
             SetupTempDirectory(id);
-            string autosaveFile = Path.Combine(tempFolder, "autosave.kva");
+            string autosaveFile = Path.Combine(tempFolder, AutosaveJournal.KvaFilename);
             bool recovered = false;
             if (File.Exists(autosaveFile))
             {
@@ -1411,10 +1535,13 @@ namespace Kinovea.ScreenManager
         {
             autoSaver.Start();
         }
-        public void PerformAutosave()
+        /// <summary>
+        /// Takes a copy of the content for autosave, to be written to disk in the background.
+        /// </summary>
+        public MetadataSnapshot TakeAutosaveSnapshot()
         {
             MetadataSerializer serializer = new MetadataSerializer();
-            serializer.SaveToFile(this, Path.Combine(tempFolder, "autosave.kva"));
+            return serializer.SaveToSnapshot(this, AutosaveJournal.SidecarFilename);
         }
         #endregion
         
@@ -1500,6 +1627,42 @@ namespace Kinovea.ScreenManager
             
             return result;
         }
+        /// <summary>
+        /// Collects the keyframe drawings that may be visible at this time in fading mode, in painting order.
+        /// Keyframes are in the same Z order as GetKeyframesZOrder, the closest next keyframe is painted last.
+        /// Only the drawings whose visible span contains the time are returned.
+        /// </summary>
+        public List<AbstractDrawing> GetFadingDrawings(long timestamp)
+        {
+            List<Keyframe> visibleKeyframes = new List<Keyframe>();
+            HashSet<AbstractDrawing> visibleDrawings = new HashSet<AbstractDrawing>();
+            drawingTimeIndex.Query(timestamp, visibleKeyframes, visibleDrawings);
+
+            // Top of Z order first: keyframes at or after the time by increasing position, then keyframes before by decreasing position.
+            visibleKeyframes.Sort((a, b) =>
+            {
+                bool aNext = a.Position >= timestamp;
+                bool bNext = b.Position >= timestamp;
+                if (aNext != bNext)
+                    return aNext ? -1 : 1;
+
+                return aNext ? a.Position.CompareTo(b.Position) : b.Position.CompareTo(a.Position);
+            });
+
+            List<AbstractDrawing> drawings = new List<AbstractDrawing>(visibleDrawings.Count);
+            for (int i = visibleKeyframes.Count - 1; i >= 0; i--)
+            {
+                List<AbstractDrawing> keyframeDrawings = visibleKeyframes[i].Drawings;
+                for (int j = keyframeDrawings.Count - 1; j >= 0; j--)
+                {
+                    if (visibleDrawings.Contains(keyframeDrawings[j]))
+                        drawings.Add(keyframeDrawings[j]);
+                }
+            }
+
+            return drawings;
+        }
+
         public int[] GetKeyframesZOrder(long _iTimestamp)
         {
             // TODO:turn this into an iterator.
@@ -1576,6 +1739,15 @@ namespace Kinovea.ScreenManager
             activeVideoFilterType = VideoFilterType.None;
         }
 
+        /// <summary>
+        /// Called by video filters when their image changed outside of a user action, for example after background loading.
+        /// </summary>
+        public void InvalidateVideoFilter()
+        {
+            if (VideoFilterInvalidated != null)
+                VideoFilterInvalidated(this, EventArgs.Empty);
+        }
+
         public void WriteVideoFilters(XmlWriter w)
         {
             foreach (var pair in videoFilters)
@@ -1613,6 +1785,7 @@ namespace Kinovea.ScreenManager
             }
 
             r.ReadEndElement();
+            SetDirty();
         }
         #endregion
 
@@ -1622,8 +1795,10 @@ namespace Kinovea.ScreenManager
         private void ResetCoreContent()
         {
             // Semi reset: we keep Image size and AverageTimeStampsPerFrame
+            SetDirty();
             trackabilityManager.Clear();
             keyframes.Clear();
+            drawingTimeIndex.Clear();
             ClearTracking();
             trackManager.Clear();
             chronoManager.Clear();
@@ -1774,8 +1949,21 @@ namespace Kinovea.ScreenManager
         }
         private void CalibrationHelper_CalibrationChanged(object sender, EventArgs e)
         {
+            SetDirty();
             AfterCalibrationChanged();
         }
+
+        /// <summary>
+        /// Assigns the field and signals a change of content if the value is different.
+        /// </summary>
+        private void SetDirty<T>(ref T field, T value)
+        {
+            if (EqualityComparer<T>.Default.Equals(field, value))
+                return;
+
+            field = value;
+            SetDirty();
+        }
         private void AfterCalibrationChanged()
         {
             if (drawingCoordinateSystem.CalibrationHelper == null)
@@ -1878,9 +2066,7 @@ namespace Kinovea.ScreenManager
         }
         private void DeleteAutosaveFile()
         {
-            string autosaveFile = Path.Combine(tempFolder, "autosave.kva");
-            if (File.Exists(autosaveFile))
-                File.Delete(autosaveFile);
+            autoSaver.Delete(tempFolder);
         }
         private void LensCalibrationAsked(object sender, EventArgs e)
         {
@@ -0,0 +1,250 @@
+﻿#region License
+/*
+Copyright © Joan Charmant 2012.
+jcharmant@gmail.com
+
+This file is part of Kinovea.
+
+Kinovea is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2
+as published by the Free Software Foundation.
+
+Kinovea is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Kinovea. If not, see http://www.gnu.org/licenses/.
+
+*/
+#endregion
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+
+namespace Kinovea.ScreenManager
+{
+    /// <summary>
+    /// Writes autosave snapshots to the temporary folder of the metadata, for crash recovery.
+    ///
+    /// The KVA part is rewritten only when it changed, and always replaced in one step so a crash never leaves a partial file.
+    /// The dense time series go to the sidecar, used as a journal: only the series that changed since the previous
+    /// autosave are appended. The journal is compacted when the superseded records take more room than the live ones.
+    ///
+    /// Writes may happen on any thread but are serialized.
+    /// </summary>
+    public class AutosaveJournal
+    {
+        public const string KvaFilename = "autosave.kva";
+        public const string SidecarFilename = "autosave.kvd";
+
+        /// <summary>
+        /// Generation of the autosave files. Snapshots taken before a call to Delete are discarded.
+        /// </summary>
+        public int Epoch
+        {
+            get { return epoch; }
+        }
+
+        private object locker = new object();
+        private volatile int epoch;
+        private string folder;
+        private byte[] lastKva;
+        private Dictionary<string, SidecarSample[]> written = new Dictionary<string, SidecarSample[]>();
+        private Dictionary<string, long> liveBytes = new Dictionary<string, long>();
+        private long journalBytes;
+        private static readonly log4net.ILog log = log4net.LogManager.GetLogger(System.Reflection.MethodBase.GetCurrentMethod().DeclaringType);
+
+        /// <summary>
+        /// Writes the snapshot to the folder.
+        /// The epoch is the value of Epoch at the time the snapshot was taken.
+        /// </summary>
+        public void Write(MetadataSnapshot snapshot, string folder, int epoch)
+        {
+            lock (locker)
+            {
+                if (epoch != this.epoch)
+                {
+                    log.DebugFormat("Autosave snapshot discarded, the autosave files were deleted in the meantime.");
+                    return;
+                }
+
+                if (folder != this.folder)
+                {
+                    Reset();
+                    this.folder = folder;
+                }
+
+                if (!Directory.Exists(folder))
+                    Directory.CreateDirectory(folder);
+
+                // The sidecar must be complete before the KVA referencing it is replaced.
+                try
+                {
+                    WriteSidecar(snapshot);
+                    WriteKva(snapshot);
+                }
+                catch
+                {
+                    // The journal may end with a torn record and the bookkeeping may count records that didn't make it.
+                    // Forget everything so the next write compacts the sidecar from scratch.
+                    Reset();
+                    throw;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Deletes the autosave files of the folder and forgets what was written.
+        /// </summary>
+        public void Delete(string folder)
+        {
+            lock (locker)
+            {
+                epoch++;
+                Reset();
+
+                if (string.IsNullOrEmpty(folder))
+                    return;
+
+                DeleteFile(Path.Combine(folder, KvaFilename));
+                DeleteFile(Path.Combine(folder, SidecarFilename));
+            }
+        }
+
+        private void WriteSidecar(MetadataSnapshot snapshot)
+        {
+            string path = Path.Combine(folder, SidecarFilename);
+
+            long live = liveBytes.Values.Sum();
+            bool compact = journalBytes == 0 || !File.Exists(path) || journalBytes > 2 * live + 4096;
+            if (compact)
+            {
+                RewriteSidecar(snapshot, path);
+                return;
+            }
+
+            List<string> changed = snapshot.Series.Keys.Where(id => !IsWritten(id, snapshot.Series[id])).ToList();
+            List<string> removed = written.Keys.Where(id => !snapshot.Series.ContainsKey(id)).ToList();
+            if (changed.Count == 0 && removed.Count == 0)
+                return;
+
+            using (FileStream stream = new FileStream(path, FileMode.Append, FileAccess.Write, FileShare.Read))
+            using (BinaryWriter w = new BinaryWriter(stream, Encoding.UTF8))
+            {
+                foreach (string id in changed)
+                {
+                    int bytes = MetadataSidecar.WriteRecord(w, id, snapshot.Series[id]);
+                    journalBytes += bytes;
+                    liveBytes[id] = bytes;
+                    written[id] = snapshot.Series[id];
+                }
+
+                foreach (string id in removed)
+                {
+                    journalBytes += MetadataSidecar.WriteRecord(w, id, null);
+                    liveBytes.Remove(id);
+                    written.Remove(id);
+                }
+
+                w.Flush();
+                stream.Flush(true);
+            }
+
+            log.DebugFormat("Autosave journal: {0} series appended, {1} removed.", changed.Count, removed.Count);
+        }
+
+        private void RewriteSidecar(MetadataSnapshot snapshot, string path)
+        {
+            string temp = path + ".tmp";
+
+            written.Clear();
+            liveBytes.Clear();
+            journalBytes = 0;
+
+            using (FileStream stream = new FileStream(temp, FileMode.Create, FileAccess.Write, FileShare.None))
+            using (BinaryWriter w = new BinaryWriter(stream, Encoding.UTF8))
+            {
+                MetadataSidecar.WriteHeader(w);
+                journalBytes = stream.Position;
+
+                foreach (KeyValuePair<string, SidecarSample[]> pair in snapshot.Series)
+                {
+                    int bytes = MetadataSidecar.WriteRecord(w, pair.Key, pair.Value);
+                    journalBytes += bytes;
+                    liveBytes[pair.Key] = bytes;
+                    written[pair.Key] = pair.Value;
+                }
+
+                w.Flush();
+                stream.Flush(true);
+            }
+
+            ReplaceFile(temp, path);
+            log.DebugFormat("Autosave journal compacted: {0} series.", snapshot.Series.Count);
+        }
+
+        private void WriteKva(MetadataSnapshot snapshot)
+        {
+            string path = Path.Combine(folder, KvaFilename);
+
+            if (lastKva != null && File.Exists(path) && lastKva.SequenceEqual(snapshot.Kva))
+            {
+                // Only the time series changed, keep the date of the last save accurate for the recovery dialog.
+                File.SetLastWriteTime(path, DateTime.Now);
+                return;
+            }
+
+            string temp = path + ".tmp";
+            File.WriteAllBytes(temp, snapshot.Kva);
+            ReplaceFile(temp, path);
+            lastKva = snapshot.Kva;
+        }
+
+        private bool IsWritten(string id, SidecarSample[] samples)
+        {
+            SidecarSample[] previous;
+            if (!written.TryGetValue(id, out previous))
+                return false;
+
+            if (ReferenceEquals(previous, samples))
+                return true;
+
+            if (previous.Length != samples.Length)
+                return false;
+
+            for (int i = 0; i < samples.Length; i++)
+            {
+                if (!previous[i].Equals(samples[i]))
+                    return false;
+            }
+
+            return true;
+        }
+
+        private void Reset()
+        {
+            lastKva = null;
+            written.Clear();
+            liveBytes.Clear();
+            journalBytes = 0;
+        }
+
+        private static void ReplaceFile(string source, string destination)
+        {
+            if (File.Exists(destination))
+                File.Replace(source, destination, null);
+            else
+                File.Move(source, destination);
+        }
+
+        private static void DeleteFile(string path)
+        {
+            if (File.Exists(path))
+                File.Delete(path);
+        }
+    }
+}
@@ -29,6 +29,8 @@ namespace Kinovea.ScreenManager
         private long inputAverageTimeStampsPerFrame;
         private long inputFirstTimeStamp;
         private long inputTimeOrigin;
+        private string inputSource;
+        private MetadataSnapshot snapshot;
         private static readonly log4net.ILog log = log4net.LogManager.GetLogger(System.Reflection.MethodBase.GetCurrentMethod().DeclaringType);
 
         public void Load(Metadata metadata, string source, bool isFile)
@@ -86,6 +88,46 @@ namespace Kinovea.ScreenManager
             return builder.ToString();
         }
 
+        /// <summary>
+        /// Takes a copy of the metadata that can be written to disk from another thread.
+        /// The dense time series are kept aside for the binary sidecar and the KVA references them.
+        /// Must be called on the thread owning the metadata.
+        /// </summary>
+        public MetadataSnapshot SaveToSnapshot(Metadata metadata, string sidecarName)
+        {
+            if (metadata == null)
+                throw new ArgumentNullException("metadata");
+
+            this.metadata = metadata;
+            snapshot = new MetadataSnapshot(sidecarName);
+
+            XmlWriterSettings settings = new XmlWriterSettings();
+            settings.Indent = true;
+            settings.CloseOutput = true;
+
+            using (MemoryStream stream = new MemoryStream())
+            {
+                using (XmlWriter w = XmlWriter.Create(stream, settings))
+                {
+                    try
+                    {
+                        WriteXml(w);
+                    }
+                    catch (Exception e)
+                    {
+                        log.Error("An error happened during the writing of the kva snapshot");
+                        log.Error(e);
+                    }
+                }
+
+                snapshot.Kva = stream.ToArray();
+            }
+
+            MetadataSnapshot result = snapshot;
+            snapshot = null;
+            return result;
+        }
+
         /// <summary>
         /// Save to the last known storage location of this KVA if any, otherwise ask for a target filename.
         /// </summary>
@@ -211,6 +253,7 @@ namespace Kinovea.ScreenManager
                 settings.IgnoreWhitespace = true;
                 settings.CloseInput = true;
 
+                inputSource = isFile ? source : null;
                 reader = isFile ? XmlReader.Create(kva, settings) : XmlReader.Create(new StringReader(kva), settings);
                 Load(reader);
                 if (relativeTrajectories)
@@ -228,6 +271,8 @@ namespace Kinovea.ScreenManager
             {
                 if (reader != null)
                     reader.Close();
+
+                metadata.Sidecar = null;
             }
         }
         private void Load(XmlReader r)
@@ -262,6 +307,9 @@ namespace Kinovea.ScreenManager
                         if (string.IsNullOrEmpty(metadata.VideoPath))
                             metadata.VideoPath = fullPath;
                         break;
+                    case "Sidecar":
+                        LoadSidecar(r.ReadElementContentAsString());
+                        break;
                     case "GlobalTitle":
                         metadata.GlobalTitle = r.ReadElementContentAsString();
                         break;
@@ -331,7 +379,7 @@ namespace Kinovea.ScreenManager
                         metadata.DrawingCoordinateSystem.ReadXml(r);
                         break;
                     case "Trackability":
-                        metadata.TrackabilityManager.ReadXml(r, scaling, RemapTimestamp);
+                        metadata.TrackabilityManager.ReadXml(r, scaling, RemapTimestamp, metadata.Sidecar);
                         break;
                     case "VideoFilters":
                         metadata.ReadVideoFilters(r);
@@ -406,6 +454,22 @@ namespace Kinovea.ScreenManager
 
             r.ReadEndElement();
         }
+        private void LoadSidecar(string filename)
+        {
+            // The sidecar is always next to the KVA.
+            if (string.IsNullOrEmpty(inputSource) || string.IsNullOrEmpty(filename))
+                return;
+
+            string path = Path.Combine(Path.GetDirectoryName(inputSource), Path.GetFileName(filename));
+            if (!File.Exists(path))
+            {
+                log.ErrorFormat("The sidecar referenced by the KVA couldn't be found: {0}.", path);
+                return;
+            }
+
+            metadata.Sidecar = MetadataSidecar.Load(path);
+            log.DebugFormat("Loaded KVA sidecar with {0} series.", metadata.Sidecar.Count);
+        }
         private PointF GetScaling()
         {
             PointF scaling = new PointF(1.0f, 1.0f);
@@ -474,6 +538,9 @@ namespace Kinovea.ScreenManager
             w.WriteElementString("OriginalFilename", Path.GetFileNameWithoutExtension(metadata.VideoPath));
             w.WriteElementString("FullPath", metadata.VideoPath);
 
+            if (snapshot != null)
+                w.WriteElementString("Sidecar", snapshot.SidecarName);
+
             if (!string.IsNullOrEmpty(metadata.GlobalTitle))
                 w.WriteElementString("GlobalTitle", metadata.GlobalTitle);
 
@@ -545,7 +612,7 @@ namespace Kinovea.ScreenManager
                 //if (filter != SerializationFilter.Spreadsheet)
                 w.WriteAttributeString("id", track.Id.ToString());
                 w.WriteAttributeString("name", track.Name);
-                track.WriteXml(w, filter);
+                track.WriteXml(w, filter, snapshot);
                 w.WriteEndElement();
             }
 
@@ -587,7 +654,7 @@ namespace Kinovea.ScreenManager
         private void WriteTrackablePoints(XmlWriter w)
         {
             w.WriteStartElement("Trackability");
-            metadata.TrackabilityManager.WriteXml(w);
+            metadata.TrackabilityManager.WriteXml(w, snapshot);
             w.WriteEndElement();
         }
         private void WriteVideoFilters(XmlWriter w)
@@ -0,0 +1,159 @@
+﻿#region License
+/*
+Copyright © Joan Charmant 2012.
+jcharmant@gmail.com
+
+This file is part of Kinovea.
+
+Kinovea is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2
+as published by the Free Software Foundation.
+
+Kinovea is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Kinovea. If not, see http://www.gnu.org/licenses/.
+
+*/
+#endregion
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Text;
+
+namespace Kinovea.ScreenManager
+{
+    /// <summary>
+    /// Binary sidecar of a KVA file, holding the dense time series (track points, trackable point timelines).
+    /// The KVA references each series by id, from the element that would otherwise contain the samples inline.
+    ///
+    /// The file is a header followed by a sequence of length-prefixed records, one per series.
+    /// A later record for the same id supersedes the earlier ones, and a record with a negative count removes the series.
+    /// This lets the file be used as an append-only journal: a truncated last record, for example after a crash
+    /// in the middle of a write, is ignored.
+    /// </summary>
+    public class MetadataSidecar
+    {
+        public int Count
+        {
+            get { return series.Count; }
+        }
+
+        private const int magic = 0x4353564B; // "KVSC".
+        private const int formatVersion = 1;
+        private const int sampleSize = 8 + 4 + 4 + 1;
+        private Dictionary<string, SidecarSample[]> series = new Dictionary<string, SidecarSample[]>();
+        private static readonly log4net.ILog log = log4net.LogManager.GetLogger(System.Reflection.MethodBase.GetCurrentMethod().DeclaringType);
+
+        /// <summary>
+        /// Returns the samples of the series, or false if the sidecar doesn't have this series.
+        /// </summary>
+        public bool TryGetSeries(string id, out SidecarSample[] samples)
+        {
+            return series.TryGetValue(id, out samples);
+        }
+
+        /// <summary>
+        /// Reads all the records of the sidecar file and keeps the latest version of each series.
+        /// </summary>
+        public static MetadataSidecar Load(string path)
+        {
+            MetadataSidecar sidecar = new MetadataSidecar();
+
+            using (FileStream stream = new FileStream(path, FileMode.Open, FileAccess.Read, FileShare.Read))
+            using (BinaryReader r = new BinaryReader(stream, Encoding.UTF8))
+            {
+                if (stream.Length < 8 || r.ReadInt32() != magic)
+                {
+                    log.ErrorFormat("The file is not a KVA sidecar: {0}.", path);
+                    return sidecar;
+                }
+
+                int version = r.ReadInt32();
+                if (version > formatVersion)
+                {
+                    log.ErrorFormat("Unsupported KVA sidecar version: {0}.", version);
+                    return sidecar;
+                }
+
+                while (stream.Length - stream.Position >= 4)
+                {
+                    int length = r.ReadInt32();
+                    if (length < 0 || stream.Length - stream.Position < length)
+                    {
+                        log.DebugFormat("Truncated record at the end of the sidecar, ignored.");
+                        break;
+                    }
+
+                    byte[] payload = r.ReadBytes(length);
+                    try
+                    {
+                        using (BinaryReader pr = new BinaryReader(new MemoryStream(payload), Encoding.UTF8))
+                            sidecar.ReadRecord(pr);
+                    }
+                    catch (EndOfStreamException)
+                    {
+                        log.ErrorFormat("Corrupted record in the sidecar, ignored.");
+                    }
+                }
+            }
+
+            return sidecar;
+        }
+
+        public static void WriteHeader(BinaryWriter w)
+        {
+            w.Write(magic);
+            w.Write(formatVersion);
+        }
+
+        /// <summary>
+        /// Writes one record. Passing null samples writes a removal record for this id.
+        /// Returns the number of bytes written.
+        /// </summary>
+        public static int WriteRecord(BinaryWriter w, string id, SidecarSample[] samples)
+        {
+            using (MemoryStream payload = new MemoryStream(samples == null ? 64 : 64 + samples.Length * sampleSize))
+            using (BinaryWriter pw = new BinaryWriter(payload, Encoding.UTF8))
+            {
+                pw.Write(id);
+                pw.Write(samples == null ? -1 : samples.Length);
+                if (samples != null)
+                {
+                    foreach (SidecarSample sample in samples)
+                    {
+                        pw.Write(sample.T);
+                        pw.Write(sample.X);
+                        pw.Write(sample.Y);
+                        pw.Write(sample.Source);
+                    }
+                }
+
+                pw.Flush();
+                w.Write((int)payload.Length);
+                w.Write(payload.GetBuffer(), 0, (int)payload.Length);
+                return 4 + (int)payload.Length;
+            }
+        }
+
+        private void ReadRecord(BinaryReader r)
+        {
+            string id = r.ReadString();
+            int count = r.ReadInt32();
+            if (count < 0)
+            {
+                series.Remove(id);
+                return;
+            }
+
+            SidecarSample[] samples = new SidecarSample[count];
+            for (int i = 0; i < count; i++)
+                samples[i] = new SidecarSample(r.ReadInt64(), r.ReadSingle(), r.ReadSingle(), r.ReadByte());
+
+            series[id] = samples;
+        }
+    }
+}
@@ -0,0 +1,74 @@
+﻿#region License
+/*
+Copyright © Joan Charmant 2012.
+jcharmant@gmail.com
+
+This file is part of Kinovea.
+
+Kinovea is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2
+as published by the Free Software Foundation.
+
+Kinovea is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Kinovea. If not, see http://www.gnu.org/licenses/.
+
+*/
+#endregion
+using System;
+using System.Collections.Generic;
+
+namespace Kinovea.ScreenManager
+{
+    /// <summary>
+    /// Copy of the metadata taken on the UI thread, to be written to disk from another thread.
+    /// The light content is kept as KVA XML, and the dense time series are kept as sample arrays
+    /// that the XML references by id. Nothing in the snapshot is shared with the live metadata.
+    /// </summary>
+    public class MetadataSnapshot
+    {
+        /// <summary>
+        /// The KVA XML, UTF-8 encoded.
+        /// </summary>
+        public byte[] Kva
+        {
+            get { return kva; }
+            set { kva = value; }
+        }
+
+        /// <summary>
+        /// File name of the sidecar, as written in the KVA.
+        /// </summary>
+        public string SidecarName
+        {
+            get { return sidecarName; }
+        }
+
+        public Dictionary<string, SidecarSample[]> Series
+        {
+            get { return series; }
+        }
+
+        private byte[] kva;
+        private string sidecarName;
+        private Dictionary<string, SidecarSample[]> series = new Dictionary<string, SidecarSample[]>();
+
+        public MetadataSnapshot(string sidecarName)
+        {
+            this.sidecarName = sidecarName;
+        }
+
+        /// <summary>
+        /// Adds a series to the snapshot and returns the id to reference it from the KVA.
+        /// </summary>
+        public string AddSeries(string id, SidecarSample[] samples)
+        {
+            series[id] = samples;
+            return id;
+        }
+    }
+}
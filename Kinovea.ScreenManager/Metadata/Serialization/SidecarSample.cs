@@ -0,0 +1,50 @@
+﻿#region License
+/*
+Copyright © Joan Charmant 2012.
+jcharmant@gmail.com
+
+This file is part of Kinovea.
+
+Kinovea is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2
+as published by the Free Software Foundation.
+
+Kinovea is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Kinovea. If not, see http://www.gnu.org/licenses/.
+
+*/
+#endregion
+using System;
+
+namespace Kinovea.ScreenManager
+{
+    /// <summary>
+    /// A single sample of a dense time series stored in the binary sidecar of a KVA.
+    /// Used for both track points and trackable point timelines.
+    /// </summary>
+    public struct SidecarSample : IEquatable<SidecarSample>
+    {
+        public long T;
+        public float X;
+        public float Y;
+        public byte Source;
+
+        public SidecarSample(long t, float x, float y, byte source)
+        {
+            this.T = t;
+            this.X = x;
+            this.Y = y;
+            this.Source = source;
+        }
+
+        public bool Equals(SidecarSample other)
+        {
+            return T == other.T && X == other.X && Y == other.Y && Source == other.Source;
+        }
+    }
+}
@@ -135,7 +135,14 @@ namespace Kinovea.ScreenManager
                 if(videoReader != null)
                 {
                     videoReader.Options = new VideoOptions(PreferencesManager.PlayerPreferences.AspectRatio, ImageRotation.Rotate0, Demosaicing.None, PreferencesManager.PlayerPreferences.DeinterlaceByDefault);
-                    return videoReader.Open(filePath);
+                    videoReader.ConfigurePreBuffer(PreferencesManager.PlayerPreferences.PreBufferBehind, PreferencesManager.PlayerPreferences.PreBufferAhead);
+                    OpenVideoResult result = videoReader.Open(filePath);
+
+                    // The calibration is kept across loads, the new reader must rectify the images if the calibration says so.
+                    if (result == OpenVideoResult.Success && metadata != null && videoReader.CanChangeFrameTransform)
+                        videoReader.ChangeFrameTransform(GetFrameTransform());
+
+                    return result;
                 }
                 else
                 {
@@ -229,6 +236,29 @@ namespace Kinovea.ScreenManager
             return VideoReader.ChangeDeinterlace(value);
         }
 
+        /// <summary>
+        /// Turn on or off the lens distortion correction of the decoded images.
+        /// </summary>
+        public bool ChangeUndistortion(bool value)
+        {
+            if (!VideoReader.CanChangeFrameTransform)
+                return false;
+
+            metadata.CalibrationHelper.ImageRectified = value;
+            return VideoReader.ChangeFrameTransform(GetFrameTransform());
+        }
+
+        /// <summary>
+        /// Returns a new instance of the transform applied to the decoded images, or null if none.
+        /// </summary>
+        public IFrameTransform GetFrameTransform()
+        {
+            if (!metadata.CalibrationHelper.ImageRectified)
+                return null;
+
+            return new UndistortionFrameTransform(metadata.CalibrationHelper);
+        }
+
         /// <summary>
         /// Consolidate image options after metadata import.
         /// </summary>
@@ -356,7 +386,7 @@ namespace Kinovea.ScreenManager
         public void ActivateVideoFilter(VideoFilterType type)
         {
             metadata.ActivateVideoFilter(type);
-            metadata.ActiveVideoFilter.SetFrames(VideoReader.WorkingZoneFrames);
+            metadata.ActiveVideoFilter.SetFrames(VideoReader);
         }
         
         public void DeactivateVideoFilter()
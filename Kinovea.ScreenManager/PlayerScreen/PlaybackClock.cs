@@ -0,0 +1,103 @@
+﻿#region License
+/*
+Copyright © Joan Charmant 2021.
+jcharmant@gmail.com
+
+This file is part of Kinovea.
+
+Kinovea is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2
+as published by the Free Software Foundation.
+
+Kinovea is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Kinovea. If not, see http://www.gnu.org/licenses/.
+*/
+#endregion
+using System;
+using System.Diagnostics;
+
+namespace Kinovea.ScreenManager
+{
+    /// <summary>
+    /// Clock of the play loop, decoupled from the frame rate of the video.
+    ///
+    /// Frames are presented at most at the refresh rate of the monitor. When the video has more frames per second
+    /// than that at the current speed, only one frame every "stride" frames is presented and the timer ticks once per presented frame.
+    /// The stride is known when playback starts, so the reader can avoid decoding the frames that will not be shown.
+    /// The position is computed from the elapsed time rather than from the number of ticks,
+    /// so late ticks and the rounding of the timer interval don't make the playback drift.
+    /// </summary>
+    public class PlaybackClock
+    {
+        #region Properties
+        /// <summary>
+        /// Number of video frames between two presented frames.
+        /// </summary>
+        public int Stride
+        {
+            get { return stride; }
+        }
+
+        /// <summary>
+        /// Interval between two ticks of the timer, in milliseconds.
+        /// </summary>
+        public int TickInterval
+        {
+            get { return tickInterval; }
+        }
+
+        /// <summary>
+        /// Interval between two video frames at the current speed, in milliseconds.
+        /// </summary>
+        public double FrameInterval
+        {
+            get { return frameInterval; }
+        }
+        #endregion
+
+        #region Members
+        // Tolerance on the ratio between the refresh interval and the frame interval,
+        // so a video at exactly twice the refresh rate is not shown at a third of its frames.
+        private const double tolerance = 0.05;
+        private int stride = 1;
+        private int tickInterval = 40;
+        private double frameInterval = 40;
+        private long presented;
+        private Stopwatch stopwatch = new Stopwatch();
+        #endregion
+
+        /// <summary>
+        /// Restarts the clock at the current frame.
+        /// refreshRate is the number of images per second the monitor can show, 0 to present every frame.
+        /// </summary>
+        public void Start(double frameInterval, double refreshRate)
+        {
+            this.frameInterval = Math.Max(frameInterval, 0.001);
+
+            stride = 1;
+            if (refreshRate > 0)
+                stride = Math.Max(1, (int)Math.Ceiling((1000.0 / refreshRate) / this.frameInterval - tolerance));
+
+            tickInterval = Math.Max(1, (int)Math.Round(this.frameInterval * stride));
+            presented = 0;
+            stopwatch.Restart();
+        }
+
+        /// <summary>
+        /// Returns the number of presented frames that became due since the last call.
+        /// The caller should advance by this number times the stride, in video frames.
+        /// </summary>
+        public int Advance()
+        {
+            long due = (long)(stopwatch.Elapsed.TotalMilliseconds / (frameInterval * stride));
+            int steps = (int)(due - presented);
+            presented = due;
+            return steps;
+        }
+    }
+}
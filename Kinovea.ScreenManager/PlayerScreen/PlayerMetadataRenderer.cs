@@ -0,0 +1,205 @@
+﻿#region License
+/*
+Copyright © Joan Charmant 2021.
+jcharmant@gmail.com
+
+This file is part of Kinovea.
+
+Kinovea is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2
+as published by the Free Software Foundation.
+
+Kinovea is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Kinovea. If not, see http://www.gnu.org/licenses/.
+*/
+#endregion
+using System;
+using System.Collections.Generic;
+using System.Drawing;
+using System.Drawing.Drawing2D;
+using System.Drawing.Text;
+using Kinovea.Services;
+
+namespace Kinovea.ScreenManager
+{
+    /// <summary>
+    /// Paints the content of the metadata on top of a video image: background fader, drawings and magnifier.
+    ///
+    /// This is the compositing part of the player rendering, without dependency on the player controls.
+    /// It is used by the player screen for the viewport and for exports, and by the batch exporter.
+    /// The capture screen uses the simpler MetadataRenderer.
+    /// Each instance keeps its own static drawing layers, so one renderer must not be shared between threads.
+    /// </summary>
+    public class PlayerMetadataRenderer : IDisposable
+    {
+        #region Members
+        private Metadata metadata;
+        private StaticDrawingLayer extraDrawingsLayer = new StaticDrawingLayer();
+        private StaticDrawingLayer keyframeDrawingsLayer = new StaticDrawingLayer();
+        private List<AbstractDrawing> layerDrawings = new List<AbstractDrawing>();
+        private List<AbstractDrawing> animatedDrawings = new List<AbstractDrawing>();
+        #endregion
+
+        #region ctor/dtor
+        public PlayerMetadataRenderer(Metadata metadata)
+        {
+            this.metadata = metadata;
+        }
+        ~PlayerMetadataRenderer()
+        {
+            Dispose(false);
+        }
+        public void Dispose()
+        {
+            Dispose(true);
+            GC.SuppressFinalize(this);
+        }
+        protected virtual void Dispose(bool disposing)
+        {
+            if (disposing)
+            {
+                extraDrawingsLayer.Dispose();
+                keyframeDrawingsLayer.Dispose();
+            }
+        }
+        #endregion
+
+        #region Public methods
+        /// <summary>
+        /// Paints the complete export image: the video frame at its own size and the metadata on top.
+        /// The canvas must not be extracted from the source image, as the magnifier reads from it.
+        /// </summary>
+        public void RenderFrame(Bitmap image, Graphics canvas, Size referenceSize, long timestamp)
+        {
+            ImageTransform transform = new ImageTransform(referenceSize);
+            Rectangle destination = GetDestination(image.Size);
+
+            canvas.PixelOffsetMode = PixelOffsetMode.HighSpeed;
+            if (metadata.Mirrored)
+                canvas.DrawImage(image, destination, new Rectangle(Point.Empty, image.Size), GraphicsUnit.Pixel);
+            else
+                canvas.DrawImageUnscaled(image, 0, 0);
+
+            RenderBackground(canvas, destination);
+            RenderDrawings(canvas, image.Size, transform, metadata.GetKeyframeIndex(timestamp), timestamp, false);
+            RenderMagnifier(image, canvas, transform, referenceSize);
+        }
+
+        /// <summary>
+        /// Returns the destination rectangle of the image, flipped horizontally if the video is mirrored.
+        /// </summary>
+        public Rectangle GetDestination(Size renderingSize)
+        {
+            if (metadata.Mirrored)
+                return new Rectangle(renderingSize.Width, 0, -renderingSize.Width, renderingSize.Height);
+            else
+                return new Rectangle(0, 0, renderingSize.Width, renderingSize.Height);
+        }
+
+        /// <summary>
+        /// Paints the background fader over the image.
+        /// </summary>
+        public void RenderBackground(Graphics canvas, Rectangle destination)
+        {
+            Color backgroundColor = PreferencesManager.PlayerPreferences.BackgroundColor;
+            if (backgroundColor.A == 0)
+                return;
+
+            using (SolidBrush brush = new SolidBrush(backgroundColor))
+                canvas.FillRectangle(brush, destination);
+        }
+
+        /// <summary>
+        /// Paints the drawings visible at this time.
+        /// In the viewport, the drawings that don't change between frames are rendered once into a cached layer.
+        /// </summary>
+        public void RenderDrawings(Graphics canvas, Size renderingSize, ImageTransform transformer, int keyframeIndex, long timestamp, bool viewport)
+        {
+            DistortionHelper distorter = metadata.CalibrationHelper.DistortionHelper;
+
+            // Prepare for drawings
+            canvas.SmoothingMode = SmoothingMode.AntiAlias;
+            canvas.TextRenderingHint = TextRenderingHint.AntiAlias;
+
+            if (metadata.ActiveVideoFilter != null)
+                metadata.ActiveVideoFilter.DrawExtra(canvas, transformer, timestamp);
+
+            foreach (DrawingChrono chrono in metadata.ChronoManager.Drawings)
+            {
+                bool selected = metadata.HitDrawing == chrono;
+                chrono.Draw(canvas, distorter, transformer, selected, timestamp);
+            }
+
+            foreach (DrawingTrack track in metadata.TrackManager.Drawings)
+            {
+                bool selected = metadata.HitDrawing == track;
+                track.Draw(canvas, distorter, transformer, selected, timestamp);
+            }
+
+            RenderLayer(canvas, renderingSize, extraDrawingsLayer, metadata.ExtraDrawings, distorter, transformer, timestamp, viewport);
+
+            layerDrawings.Clear();
+            if (PreferencesManager.PlayerPreferences.DefaultFading.Enabled)
+            {
+                // If fading is on, we ask the drawings that may be visible at this position to draw themselves
+                // with their respective fading factor. They come in reverse keyframes z order so the closest
+                // next keyframe gets drawn on top (last).
+                layerDrawings.AddRange(metadata.GetFadingDrawings(timestamp));
+            }
+            else if (keyframeIndex >= 0)
+            {
+                // if fading is off, only draw the current keyframe.
+                // Draw all drawings in reverse order to get first object on the top of Z-order.
+                Keyframe keyframe = metadata.Keyframes[keyframeIndex];
+                for (int drawingIndex = keyframe.Drawings.Count - 1; drawingIndex >= 0; drawingIndex--)
+                    layerDrawings.Add(keyframe.Drawings[drawingIndex]);
+            }
+
+            RenderLayer(canvas, renderingSize, keyframeDrawingsLayer, layerDrawings, distorter, transformer, timestamp, viewport);
+        }
+
+        /// <summary>
+        /// Paints the magnifier, if any.
+        /// The canvas must not be extracted from the source image.
+        /// </summary>
+        public void RenderMagnifier(Bitmap image, Graphics canvas, ImageTransform transform, Size referenceSize)
+        {
+            if (image != null && metadata.Magnifier.Mode != MagnifierMode.None)
+                metadata.Magnifier.Draw(image, canvas, transform, metadata.Mirrored, referenceSize);
+        }
+
+        /// <summary>
+        /// Releases the cached layers. They will be rendered again on the next viewport rendering.
+        /// </summary>
+        public void Invalidate()
+        {
+            extraDrawingsLayer.Invalidate();
+            keyframeDrawingsLayer.Invalidate();
+        }
+        #endregion
+
+        #region Private methods
+        private void RenderLayer(Graphics canvas, Size renderingSize, StaticDrawingLayer layer, IEnumerable<AbstractDrawing> drawings, DistortionHelper distorter, ImageTransform transformer, long timestamp, bool viewport)
+        {
+            IEnumerable<AbstractDrawing> directDrawings = drawings;
+            if (viewport)
+            {
+                animatedDrawings.Clear();
+                layer.Draw(canvas, renderingSize, drawings, metadata, distorter, transformer, timestamp, animatedDrawings);
+                directDrawings = animatedDrawings;
+            }
+
+            foreach (AbstractDrawing drawing in directDrawings)
+            {
+                bool selected = drawing == metadata.HitDrawing;
+                drawing.Draw(canvas, distorter, transformer, selected, timestamp);
+            }
+        }
+        #endregion
+    }
+}
@@ -151,6 +151,19 @@ namespace Kinovea.ScreenManager
                 RefreshImage();
             }
         }
+        public bool Undistorted
+        {
+            get { return frameServer.Metadata.CalibrationHelper.ImageRectified; }
+            set
+            {
+                bool uncached = frameServer.ChangeUndistortion(value);
+
+                if (uncached && frameServer.VideoReader.DecodingMode == VideoDecodingMode.Caching)
+                    view.UpdateWorkingZone(true);
+
+                RefreshImage();
+            }
+        }
         public VideoFilterType ActiveVideoFilterType
         {
             get { return frameServer.Metadata.ActiveVideoFilterType; }
@@ -249,6 +262,23 @@ namespace Kinovea.ScreenManager
             }
         }
 
+        /// <summary>
+        /// Gets or sets the time origin as an absolute timestamp of the video.
+        /// </summary>
+        public long AbsoluteTimeOrigin
+        {
+            get
+            {
+                return frameServer.Metadata.TimeOrigin;
+            }
+
+            set
+            {
+                frameServer.Metadata.TimeOrigin = value;
+                view.TimeOriginUpdatedFromSync();
+            }
+        }
+
         /// <summary>
         /// Returns the interval between frames in milliseconds, taking slow motion slider into account.
         /// This is suitable for a playback timer or metadata in saved file.
@@ -657,6 +687,15 @@ namespace Kinovea.ScreenManager
             view.ForcePosition(timestamp, allowUIUpdate);
         }
         
+        /// <summary>
+        /// Paint the passed frame with all the drawings of this screen, at the frame size.
+        /// The frame doesn't have to come from this screen's own reader.
+        /// </summary>
+        public bool GetFlushedImage(VideoFrame vf, Bitmap output)
+        {
+            return view.GetFlushedImage(vf, output);
+        }
+
         public void GotoPrevKeyframe()
         {
             view.GotoPreviousKeyframe();
@@ -677,7 +716,7 @@ namespace Kinovea.ScreenManager
         /// </summary>
         public void ActivateVideoFilter(VideoFilterType type)
         {
-            if (!IsCaching)
+            if (!frameServer.Loaded)
                 return;
             
             frameServer.ActivateVideoFilter(type);
@@ -887,7 +926,7 @@ namespace Kinovea.ScreenManager
         /// <summary>
         /// Convert from real time in microseconds relative to working zone start into absolute timestamps.
         /// </summary>
-        private long RelativeRealTimeToAbsoluteTimestamp(long time)
+        public long RelativeRealTimeToAbsoluteTimestamp(long time)
         {
             double realtimeSeconds = (double)time / 1000000;
             double videoSeconds = realtimeSeconds * frameServer.Metadata.HighSpeedFactor;
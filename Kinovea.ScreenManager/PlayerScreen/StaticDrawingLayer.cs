@@ -0,0 +1,176 @@
+﻿#region License
+/*
+Copyright © Joan Charmant 2012.
+jcharmant@gmail.com
+
+This file is part of Kinovea.
+
+Kinovea is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2
+as published by the Free Software Foundation.
+
+Kinovea is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Kinovea. If not, see http://www.gnu.org/licenses/.
+
+*/
+#endregion
+using System;
+using System.Collections.Generic;
+using System.Drawing;
+using System.Drawing.Drawing2D;
+using System.Drawing.Imaging;
+using System.Drawing.Text;
+using System.Linq;
+
+namespace Kinovea.ScreenManager
+{
+    /// <summary>
+    /// Retained rendering of the drawings that look the same from one frame to the next.
+    ///
+    /// The static drawings are rasterized into a transparent layer at the rendering size,
+    /// and the layer is composited on the viewport in a single blit.
+    /// The layer is only rendered again when its signature changes: rendering size, zoom and pan, calibration,
+    /// and for each static drawing its identity, content hash and current opacity.
+    ///
+    /// Only the static drawings that come before the first animated drawing (selected, tracked, multi-drawings, labels being edited)
+    /// are cached. That drawing and all the following ones are handed back to the caller to be drawn directly on top of the layer,
+    /// so the paint order is kept.
+    /// </summary>
+    public class StaticDrawingLayer : IDisposable
+    {
+        private Bitmap layer;
+        private List<AbstractDrawing> layerDrawings = new List<AbstractDrawing>();
+        private List<long> layerSignature = new List<long>();
+        private List<AbstractDrawing> staticDrawings = new List<AbstractDrawing>();
+        private List<long> signature = new List<long>();
+
+        ~StaticDrawingLayer()
+        {
+            Dispose(false);
+        }
+        public void Dispose()
+        {
+            Dispose(true);
+            GC.SuppressFinalize(this);
+        }
+        protected virtual void Dispose(bool disposing)
+        {
+            if (disposing)
+                Invalidate();
+        }
+
+        /// <summary>
+        /// Draws the static drawings from the layer, rendering it first if needed.
+        /// The drawings are passed in paint order. The ones that must be drawn directly, from the first animated one on, are added to animated, in the same order.
+        /// </summary>
+        public void Draw(Graphics canvas, Size size, IEnumerable<AbstractDrawing> drawings, Metadata metadata, DistortionHelper distorter, ImageTransform transformer, long timestamp, List<AbstractDrawing> animated)
+        {
+            staticDrawings.Clear();
+            signature.Clear();
+
+            // Measurements change with time when the calibration is tracked, nothing is static.
+            bool timeDependent =
+                metadata.TrackabilityManager.HasData(metadata.CalibrationHelper.CalibrationDrawingId) ||
+                metadata.TrackabilityManager.HasData(metadata.DrawingCoordinateSystem.Id);
+
+            bool direct = timeDependent;
+            foreach (AbstractDrawing drawing in drawings)
+            {
+                // Empty multi-drawings paint nothing, skipping them keeps the drawings after them in the layer.
+                if (drawing is AbstractMultiDrawing && ((AbstractMultiDrawing)drawing).Count == 0)
+                    continue;
+
+                if (direct || IsAnimated(drawing, metadata))
+                {
+                    direct = true;
+                    animated.Add(drawing);
+                    continue;
+                }
+
+                double opacity = drawing.InfosFading == null ? 1.0 : drawing.InfosFading.GetOpacityFactor(timestamp);
+                if (opacity <= 0)
+                    continue;
+
+                staticDrawings.Add(drawing);
+                signature.Add(drawing.ContentHash);
+                signature.Add((long)Math.Round(opacity * 255));
+            }
+
+            if (staticDrawings.Count == 0)
+                return;
+
+            signature.Add(size.Width);
+            signature.Add(size.Height);
+            signature.Add(BitConverter.DoubleToInt64Bits(transformer.Scale));
+            signature.Add(transformer.ZoomWindow.X);
+            signature.Add(transformer.ZoomWindow.Y);
+            signature.Add(metadata.CalibrationHelper.ContentHash);
+
+            if (layer == null || !staticDrawings.SequenceEqual(layerDrawings) || !signature.SequenceEqual(layerSignature))
+                Render(size, distorter, transformer, timestamp);
+
+            canvas.DrawImageUnscaled(layer, 0, 0);
+        }
+
+        /// <summary>
+        /// Releases the layer. It will be rendered again on the next call to Draw.
+        /// </summary>
+        public void Invalidate()
+        {
+            if (layer != null)
+            {
+                layer.Dispose();
+                layer = null;
+            }
+
+            layerDrawings.Clear();
+            layerSignature.Clear();
+        }
+
+        private static bool IsAnimated(AbstractDrawing drawing, Metadata metadata)
+        {
+            if (drawing == metadata.HitDrawing || drawing is AbstractMultiDrawing)
+                return true;
+
+            if (drawing is DrawingText && ((DrawingText)drawing).Editing)
+                return true;
+
+            return drawing is ITrackable && metadata.TrackabilityManager.HasData(drawing.Id);
+        }
+
+        private void Render(Size size, DistortionHelper distorter, ImageTransform transformer, long timestamp)
+        {
+            if (layer == null || layer.Size != size)
+            {
+                if (layer != null)
+                    layer.Dispose();
+
+                layer = new Bitmap(size.Width, size.Height, PixelFormat.Format32bppPArgb);
+            }
+
+            using (Graphics g = Graphics.FromImage(layer))
+            {
+                g.Clear(Color.Transparent);
+                g.SmoothingMode = SmoothingMode.AntiAlias;
+                g.TextRenderingHint = TextRenderingHint.AntiAlias;
+
+                foreach (AbstractDrawing drawing in staticDrawings)
+                    drawing.Draw(g, distorter, transformer, false, timestamp);
+            }
+
+            // Swap the buffers so the current lists become the reference.
+            List<AbstractDrawing> tempDrawings = layerDrawings;
+            layerDrawings = staticDrawings;
+            staticDrawings = tempDrawings;
+
+            List<long> tempSignature = layerSignature;
+            layerSignature = signature;
+            signature = tempSignature;
+        }
+    }
+}
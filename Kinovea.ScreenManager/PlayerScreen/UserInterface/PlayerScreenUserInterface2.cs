@@ -27,6 +27,7 @@ using System.ComponentModel;
 using System.Drawing;
 using System.Drawing.Drawing2D;
 using System.Drawing.Imaging;
+using System.Diagnostics;
 using System.IO;
 using System.Runtime.InteropServices;
 using System.Threading;
@@ -266,7 +267,7 @@ namespace Kinovea.ScreenManager
         private uint m_IdMultimediaTimer;
         private PlayingMode m_ePlayingMode = PlayingMode.Loop;
         private bool m_bIsBusyRendering;
-        private int m_RenderingDrops;
+        private PlaybackClock m_PlaybackClock = new PlaybackClock();
         private object m_TimingSync = new object();
 
         // Timing
@@ -325,6 +326,7 @@ namespace Kinovea.ScreenManager
         private MessageToaster m_MessageToaster;
         private bool m_Constructed;
         private CursorManager cursorManager = new CursorManager();
+        private PlayerMetadataRenderer metadataRenderer;
 
         #region Context Menus
         private ContextMenuStrip popMenu = new ContextMenuStrip();
@@ -357,6 +359,7 @@ namespace Kinovea.ScreenManager
         private ToolStripMenuItem mnuDrawingTrackingConfigure = new ToolStripMenuItem();
         private ToolStripMenuItem mnuDrawingTrackingStart = new ToolStripMenuItem();
         private ToolStripMenuItem mnuDrawingTrackingStop = new ToolStripMenuItem();
+        private ToolStripMenuItem mnuDrawingTrackingToEnd = new ToolStripMenuItem();
         private ToolStripSeparator mnuSepDrawing = new ToolStripSeparator();
         private ToolStripSeparator mnuSepDrawing2 = new ToolStripSeparator();
         private ToolStripSeparator mnuSepDrawing3 = new ToolStripSeparator();
@@ -366,6 +369,7 @@ namespace Kinovea.ScreenManager
 
         private ContextMenuStrip popMenuTrack = new ContextMenuStrip();
         private ToolStripMenuItem mnuRestartTracking = new ToolStripMenuItem();
+        private ToolStripMenuItem mnuTrackToEnd = new ToolStripMenuItem();
         private ToolStripMenuItem mnuStopTracking = new ToolStripMenuItem();
         private ToolStripMenuItem mnuDeleteTrajectory = new ToolStripMenuItem();
         private ToolStripMenuItem mnuDeleteEndOfTrajectory = new ToolStripMenuItem();
@@ -407,6 +411,8 @@ namespace Kinovea.ScreenManager
             m_FrameServer.Metadata.DrawingDeleted += (s, e) => AfterDrawingDeleted();
             m_FrameServer.Metadata.MultiDrawingItemAdded += (s, e) => AfterMultiDrawingItemAdded();
             m_FrameServer.Metadata.MultiDrawingItemDeleted += (s, e) => AfterMultiDrawingItemDeleted();
+            m_FrameServer.Metadata.VideoFilterInvalidated += (s, e) => AfterVideoFilterInvalidated();
+            metadataRenderer = new PlayerMetadataRenderer(m_FrameServer.Metadata);
 
             InitializeComponent();
             InitializeInfobar();
@@ -462,6 +468,7 @@ namespace Kinovea.ScreenManager
             m_FrameServer.Unload();
             ResetData();
             videoFilterIsActive = false;
+            metadataRenderer.Invalidate();
 
             // 2. Reset all interface.
             ShowHideRenderingSurface(false);
@@ -687,14 +694,7 @@ namespace Kinovea.ScreenManager
         /// </summary>
         private void RestoreActiveVideoFilter()
         {
-            if (m_FrameServer.VideoReader.DecodingMode != VideoDecodingMode.Caching)
-            {
-                // The filter is not allowed to be activated.
-                // This may happen if we load a KVA after having lowered the cache size.
-                m_FrameServer.DeactivateVideoFilter();
-                DeactivateVideoFilter();
-            }
-            else if (m_FrameServer.Metadata.ActiveVideoFilterType == VideoFilterType.None)
+            if (m_FrameServer.Metadata.ActiveVideoFilterType == VideoFilterType.None)
             {
                 // Exiting filter.
                 m_FrameServer.DeactivateVideoFilter();
@@ -752,6 +752,11 @@ namespace Kinovea.ScreenManager
                 OnPauseAsked();
                 VideoSection newZone = new VideoSection(m_iSelStart, m_iSelEnd);
                 m_FrameServer.VideoReader.UpdateWorkingZone(newZone, _bForceReload, PreferencesManager.PlayerPreferences.WorkingZoneMemory, ProgressWorker);
+
+                // The filter may have to switch between cached and decoded frames.
+                if (videoFilterIsActive)
+                    m_FrameServer.Metadata.ActiveVideoFilter.SetFrames(m_FrameServer.VideoReader);
+
                 ResizeUpdate(true);
             }
 
@@ -872,6 +877,9 @@ namespace Kinovea.ScreenManager
             ReloadTooltipsCulture();
             ReloadToolsCulture();
             ReloadMenusCulture();
+
+            // Labels of the drawings may be localized.
+            metadataRenderer.Invalidate();
             m_KeyframeCommentsHub.RefreshUICulture();
             for (int i = 0; i < keyframeBoxes.Count; i++)
                 keyframeBoxes[i].RefreshUICulture();
@@ -904,6 +912,11 @@ namespace Kinovea.ScreenManager
             StretchSqueezeSurface(true);
             DoInvalidate();
         }
+        private void AfterVideoFilterInvalidated()
+        {
+            if (videoFilterIsActive)
+                DoInvalidate();
+        }
         
         public void SetSyncMergeImage(Bitmap _SyncMergeImage, bool _bUpdateUI)
         {
@@ -1183,9 +1196,11 @@ namespace Kinovea.ScreenManager
             mnuDrawingTrackingStart.Image = Properties.Drawings.trackingplay;
             mnuDrawingTrackingStop.Click += mnuDrawingTrackingToggle_Click;
             mnuDrawingTrackingStop.Image = Properties.Drawings.trackstop;
+            mnuDrawingTrackingToEnd.Click += mnuTrackToEnd_Click;
+            mnuDrawingTrackingToEnd.Image = Properties.Drawings.trackingplay;
             mnuDrawingTracking.Image = Properties.Drawings.track;
             //mnuDrawingTracking.DropDownItems.AddRange(new ToolStripItem[] { mnuDrawingTrackingConfigure, new ToolStripSeparator(), mnuDrawingTrackingStart, mnuDrawingTrackingStop, new ToolStripSeparator(), mnuDrawingTrackingShowNotTracked });
-            mnuDrawingTracking.DropDownItems.AddRange(new ToolStripItem[] { mnuDrawingTrackingStart, mnuDrawingTrackingStop });
+            mnuDrawingTracking.DropDownItems.AddRange(new ToolStripItem[] { mnuDrawingTrackingStart, mnuDrawingTrackingStop, mnuDrawingTrackingToEnd });
 
             mnuCutDrawing.Click += new EventHandler(mnuCutDrawing_Click);
             mnuCutDrawing.Image = Properties.Drawings.cut;
@@ -1201,6 +1216,9 @@ namespace Kinovea.ScreenManager
             mnuRestartTracking.Click += new EventHandler(mnuRestartTracking_Click);
             mnuRestartTracking.Visible = false;
             mnuRestartTracking.Image = Properties.Drawings.trackingplay;
+            mnuTrackToEnd.Click += mnuTrackToEnd_Click;
+            mnuTrackToEnd.Visible = false;
+            mnuTrackToEnd.Image = Properties.Drawings.trackingplay;
             mnuDeleteTrajectory.Click += new EventHandler(mnuDeleteTrajectory_Click);
             mnuDeleteTrajectory.Image = Properties.Drawings.delete;
             mnuDeleteEndOfTrajectory.Click += new EventHandler(mnuDeleteEndOfTrajectory_Click);
@@ -1474,6 +1492,8 @@ namespace Kinovea.ScreenManager
                 popMenuTrack.Dispose();
                 popMenuMagnifier.Dispose();
                 popMenuFilter.Dispose();
+
+                metadataRenderer.Dispose();
             }
 
             base.Dispose(disposing);
@@ -2371,19 +2391,26 @@ namespace Kinovea.ScreenManager
         #endregion
 
         #region Timers & Playloop
-        private void StartMultimediaTimer(int _interval)
+        private void StartMultimediaTimer(double _frameInterval)
         {
-            //log.DebugFormat("starting playback timer at {0} ms interval.", _interval);
             ActivateKeyframe(-1);
             m_DropWatcher.Restart();
             m_LoopWatcher.Restart();
 
+            // Tracking needs all the frames, otherwise don't present more frames than the monitor can show.
+            double refreshRate = m_FrameServer.Metadata.Tracking ? 0 : UIHelper.GetMonitorFramerate(Handle);
+            m_PlaybackClock.Start(_frameInterval, refreshRate);
+            int interval = m_PlaybackClock.TickInterval;
+            //log.DebugFormat("starting playback timer at {0} ms interval, stride:{1}.", interval, m_PlaybackClock.Stride);
+
             Application.Idle += Application_Idle;
             m_FrameServer.VideoReader.BeforePlayloop();
+            m_FrameServer.VideoReader.UpdatePresentationStride(m_PlaybackClock.Stride);
+            m_FrameServer.VideoReader.UpdatePlaybackSpeed(m_FrameServer.VideoReader.Info.FrameIntervalMilliseconds / m_PlaybackClock.FrameInterval);
             m_FrameServer.Metadata.PauseAutosave();
 
             uint eventType = NativeMethods.TIME_PERIODIC | NativeMethods.TIME_KILL_SYNCHRONOUS;
-            m_IdMultimediaTimer = NativeMethods.timeSetEvent((uint)_interval, (uint)_interval, m_TimerCallback, UIntPtr.Zero, eventType);
+            m_IdMultimediaTimer = NativeMethods.timeSetEvent((uint)interval, (uint)interval, m_TimerCallback, UIntPtr.Zero, eventType);
             m_bIsCurrentlyPlaying = true;
         }
         private void StopMultimediaTimer()
@@ -2395,6 +2422,7 @@ namespace Kinovea.ScreenManager
             m_bIsCurrentlyPlaying = false;
             Application.Idle -= Application_Idle;
             m_FrameServer.Metadata.UnpauseAutosave();
+            m_FrameServer.VideoReader.UpdatePlaybackSpeed(0);
 
             log.DebugFormat("Playback paused. Avg frame time: {0:0.000} ms. Drop ratio: {1:0.00}", m_LoopWatcher.Average, m_DropWatcher.Ratio);
         }
@@ -2403,35 +2431,36 @@ namespace Kinovea.ScreenManager
             if (!m_FrameServer.Loaded)
                 return;
 
-            // We cannot change the pointer to current here in case the UI is painting it,
-            // so we will pass the number of drops along to the rendering.
-            // The rendering will then ask for an update of the pointer to current, skipping as
-            // many frames we missed during the interval.
+            // We cannot change the pointer to current here in case the UI is painting it.
+            // The rendering will ask the playback clock which frame is due, skipping as
+            // many frames as we missed while the UI was busy.
             lock (m_TimingSync)
             {
                 if (!m_bIsBusyRendering)
                 {
-                    int drops = m_RenderingDrops;
-                    BeginInvoke((Action)delegate { Rendering_Invoked(drops); });
+                    BeginInvoke((Action)Rendering_Invoked);
                     m_bIsBusyRendering = true;
-                    m_RenderingDrops = 0;
                     m_DropWatcher.AddDropStatus(false);
                 }
                 else
                 {
-                    m_RenderingDrops++;
                     m_DropWatcher.AddDropStatus(true);
                 }
             }
         }
-        private void Rendering_Invoked(int missedFrames)
+        private void Rendering_Invoked()
         {
             // This is in UI thread space.
             // Rendering in the context of continuous playback (play loop).
             m_TimeWatcher.Restart();
 
+            // The timer interval is rounded to the millisecond, a tick may come before the next frame is due.
+            int steps = m_PlaybackClock.Advance();
+            if (steps <= 0)
+                return;
+
             bool tracking = m_FrameServer.Metadata.Tracking;
-            int skip = tracking ? 0 : missedFrames;
+            int skip = tracking ? 0 : (steps * m_PlaybackClock.Stride) - 1;
 
             long estimateNext = m_iCurrentPosition + ((skip + 1) * m_FrameServer.VideoReader.Info.AverageTimeStampsPerFrame);
 
@@ -2450,7 +2479,8 @@ namespace Kinovea.ScreenManager
                 // This means if we missed the previous frame because the UI was busy, we won't 
                 // render it now either. On the other hand, it means we will have less chance to
                 // miss the next frame while trying to render an already outdated one.
-                // We must also "unreset" the rendering drop counter, since we didn't actually render the frame.
+                // The reader keeps track of the frames it couldn't move to and the clock keeps running,
+                // so the next rendering will catch up.
                 if (m_FrameServer.VideoReader.Drops > 0)
                 {
                     if (m_FrameServer.VideoReader.Drops > m_MaxDecodingDrops)
@@ -2458,11 +2488,6 @@ namespace Kinovea.ScreenManager
                         log.DebugFormat("Failsafe triggered on Decoding Drops ({0})", m_FrameServer.VideoReader.Drops);
                         ForceSlowdown();
                     }
-                    else
-                    {
-                        lock (m_TimingSync)
-                            m_RenderingDrops = missedFrames;
-                    }
                 }
                 else if (m_FrameServer.VideoReader.Current != null)
                 {
@@ -2613,16 +2638,21 @@ namespace Kinovea.ScreenManager
         }
         private void StopPlaying(bool _bAllowUIUpdate)
         {
-            if (!m_FrameServer.Loaded || !m_bIsCurrentlyPlaying)
+            if (!m_FrameServer.Loaded)
+                return;
+
+            // Back to showing every frame. This is not done when the timer is only restarted (loop, speed change)
+            // to keep the frames already buffered on the playback grid.
+            // The loop may have killed the timer already, so this is done even if we are not playing anymore.
+            m_FrameServer.VideoReader.UpdatePresentationStride(1);
+
+            if (!m_bIsCurrentlyPlaying)
                 return;
 
             StopMultimediaTimer();
 
             lock (m_TimingSync)
-            {
                 m_bIsBusyRendering = false;
-                m_RenderingDrops = 0;
-            }
 
             m_iFramesToDecode = 0;
 
@@ -2633,9 +2663,9 @@ namespace Kinovea.ScreenManager
                 UpdatePositionUI();
             }
         }
-        private int GetPlaybackFrameInterval()
+        private double GetPlaybackFrameInterval()
         {
-            return (int)Math.Round(timeMapper.GetInterval(sldrSpeed.Value));
+            return timeMapper.GetInterval(sldrSpeed.Value);
         }
         private void DeselectionTimer_OnTick(object sender, EventArgs e)
         {
@@ -2700,10 +2730,12 @@ namespace Kinovea.ScreenManager
             mnuDrawingTrackingConfigure.Text = ScreenManagerLang.Generic_ConfigurationElipsis;
             mnuDrawingTrackingStart.Text = ScreenManagerLang.mnuDrawingTrackingStart;
             mnuDrawingTrackingStop.Text = ScreenManagerLang.mnuDrawingTrackingStop;
+            mnuDrawingTrackingToEnd.Text = ScreenManagerLang.mnuTrackToEndOfZone;
 
             // 3. Tracking pop menu (Restart, Stop tracking)
             mnuStopTracking.Text = ScreenManagerLang.mnuStopTracking;
             mnuRestartTracking.Text = ScreenManagerLang.mnuRestartTracking;
+            mnuTrackToEnd.Text = ScreenManagerLang.mnuTrackToEndOfZone;
             mnuDeleteTrajectory.Text = ScreenManagerLang.mnuDeleteTrajectory;
             mnuDeleteTrajectory.ShortcutKeys = HotkeySettingsManager.GetMenuShortcut("PlayerScreen", (int)PlayerScreenCommands.DeleteDrawing);
             mnuDeleteEndOfTrajectory.Text = ScreenManagerLang.mnuDeleteEndOfTrajectory;
@@ -3065,17 +3097,19 @@ namespace Kinovea.ScreenManager
                     if (customMenus)
                         popMenuTrack.Items.Add(new ToolStripSeparator());
 
-                    popMenuTrack.Items.AddRange(new ToolStripItem[] { mnuStopTracking, mnuRestartTracking, new ToolStripSeparator(), mnuDeleteEndOfTrajectory, mnuDeleteTrajectory });
+                    popMenuTrack.Items.AddRange(new ToolStripItem[] { mnuStopTracking, mnuRestartTracking, mnuTrackToEnd, new ToolStripSeparator(), mnuDeleteEndOfTrajectory, mnuDeleteTrajectory });
 
                     if (track.Status == TrackStatus.Edit)
                     {
                         mnuStopTracking.Visible = true;
                         mnuRestartTracking.Visible = false;
+                        mnuTrackToEnd.Visible = true;
                     }
                     else
                     {
                         mnuStopTracking.Visible = false;
                         mnuRestartTracking.Visible = true;
+                        mnuTrackToEnd.Visible = false;
                     }
 
                     panelCenter.ContextMenuStrip = popMenuTrack;
@@ -3222,6 +3256,7 @@ namespace Kinovea.ScreenManager
                 bool tracked = ToggleTrackingCommand.CurrentState(drawing);
                 mnuDrawingTrackingStart.Visible = !tracked;
                 mnuDrawingTrackingStop.Visible = tracked;
+                mnuDrawingTrackingToEnd.Visible = tracked;
                 popMenu.Items.Add(mnuDrawingTracking);
             }
         }
@@ -3371,6 +3406,7 @@ namespace Kinovea.ScreenManager
                                 else
                                 {
                                     m_FrameServer.Metadata.ActiveVideoFilter.Move((float)fDeltaX, (float)fDeltaY, ModifierKeys);
+                                    m_FrameServer.Metadata.SetDirty();
                                     DoInvalidate();
                                 }
                             }
@@ -3405,6 +3441,7 @@ namespace Kinovea.ScreenManager
                         else
                         {
                             m_FrameServer.Metadata.ActiveVideoFilter.Move((float)fDeltaX, (float)fDeltaY, ModifierKeys);
+                            m_FrameServer.Metadata.SetDirty();
                             DoInvalidate();
                         }
                     }
@@ -3544,7 +3581,7 @@ namespace Kinovea.ScreenManager
                         }
                     }
 
-                    FlushOnGraphics(m_FrameServer.CurrentImage, e.Graphics, m_viewportManipulator.RenderingSize, iKeyFrameIndex, m_iCurrentPosition, m_FrameServer.ImageTransform);
+                    FlushOnGraphics(m_FrameServer.CurrentImage, e.Graphics, m_viewportManipulator.RenderingSize, iKeyFrameIndex, m_iCurrentPosition, m_FrameServer.ImageTransform, true);
 
                     if (m_MessageToaster.Enabled)
                         m_MessageToaster.Draw(e.Graphics);
@@ -3579,10 +3616,11 @@ namespace Kinovea.ScreenManager
             if (!m_FrameServer.Metadata.TextEditingInProgress)
                 pbSurfaceScreen.Focus();
         }
-        private void FlushOnGraphics(Bitmap _sourceImage, Graphics g, Size _renderingSize, int _iKeyFrameIndex, long _iPosition, ImageTransform _transform)
+        private void FlushOnGraphics(Bitmap _sourceImage, Graphics g, Size _renderingSize, int _iKeyFrameIndex, long _iPosition, ImageTransform _transform, bool _viewport = false)
         {
             // This function is used both by the main rendering loop and by image export functions.
             // Video export get its image from the VideoReader or the cache.
+            // The static drawings layers are only used for the main rendering loop.
 
             // Notes on performances:
             // - The global performance depends on the size of the *source* image. Not destination.
@@ -3603,7 +3641,7 @@ namespace Kinovea.ScreenManager
 
             m_TimeWatcher.LogTime("Before DrawImage");
 
-            Rectangle rDst = m_FrameServer.Metadata.Mirrored ? new Rectangle(_renderingSize.Width, 0, -_renderingSize.Width, _renderingSize.Height) : new Rectangle(0, 0, _renderingSize.Width, _renderingSize.Height);
+            Rectangle rDst = metadataRenderer.GetDestination(_renderingSize);
             
             if (m_viewportManipulator.MayDrawUnscaled && m_FrameServer.VideoReader.CanDrawUnscaled)
             {
@@ -3673,91 +3711,14 @@ namespace Kinovea.ScreenManager
             }
 
             // Background fader.
-            Color backgroundColor = PreferencesManager.PlayerPreferences.BackgroundColor;
-            if (backgroundColor.A != 0)
-            {
-                SolidBrush brush = new SolidBrush(backgroundColor);
-                g.FillRectangle(brush, rDst);
-                brush.Dispose();
-            }
+            metadataRenderer.RenderBackground(g, rDst);
 
             if ((m_bIsCurrentlyPlaying && PreferencesManager.PlayerPreferences.DrawOnPlay) || !m_bIsCurrentlyPlaying)
             {
-                FlushDrawingsOnGraphics(g, _transform, _iKeyFrameIndex, _iPosition);
-                FlushMagnifierOnGraphics(_sourceImage, g, _transform);
+                metadataRenderer.RenderDrawings(g, _renderingSize, _transform, _iKeyFrameIndex, _iPosition, _viewport);
+                metadataRenderer.RenderMagnifier(_sourceImage, g, _transform, m_FrameServer.VideoReader.Info.ReferenceSize);
             }
         }
-        private void FlushDrawingsOnGraphics(Graphics canvas, ImageTransform transformer, int keyFrameIndex, long timestamp)
-        {
-            DistortionHelper distorter = m_FrameServer.Metadata.CalibrationHelper.DistortionHelper;
-
-            // Prepare for drawings
-            canvas.SmoothingMode = SmoothingMode.AntiAlias;
-            canvas.TextRenderingHint = System.Drawing.Text.TextRenderingHint.AntiAlias;
-
-            if (m_FrameServer.Metadata.ActiveVideoFilter != null)
-                m_FrameServer.Metadata.ActiveVideoFilter.DrawExtra(canvas, transformer, timestamp);
-
-            foreach (DrawingChrono chrono in m_FrameServer.Metadata.ChronoManager.Drawings)
-            {
-                bool selected = m_FrameServer.Metadata.HitDrawing == chrono;
-                chrono.Draw(canvas, distorter, transformer, selected, timestamp);
-            }
-
-            foreach (DrawingTrack track in m_FrameServer.Metadata.TrackManager.Drawings)
-            {
-                bool selected = m_FrameServer.Metadata.HitDrawing == track;
-                track.Draw(canvas, distorter, transformer, selected, timestamp);
-            }
-
-            foreach (AbstractDrawing drawing in m_FrameServer.Metadata.ExtraDrawings)
-            {
-                bool selected = m_FrameServer.Metadata.HitDrawing == drawing;
-                drawing.Draw(canvas, distorter, transformer, selected, timestamp);
-            }
-
-            if (PreferencesManager.PlayerPreferences.DefaultFading.Enabled)
-            {
-                // If fading is on, we ask all drawings to draw themselves with their respective
-                // fading factor for this position.
-
-                int[] zOrder = m_FrameServer.Metadata.GetKeyframesZOrder(timestamp);
-
-                // Draw in reverse keyframes z order so the closest next keyframe gets drawn on top (last).
-                for (int kfIndex = zOrder.Length - 1; kfIndex >= 0; kfIndex--)
-                {
-                    Keyframe keyframe = m_FrameServer.Metadata.Keyframes[zOrder[kfIndex]];
-                    for (int drawingIndex = keyframe.Drawings.Count - 1; drawingIndex >= 0; drawingIndex--)
-                    {
-                        bool selected = keyframe.Drawings[drawingIndex] == m_FrameServer.Metadata.HitDrawing;
-                        keyframe.Drawings[drawingIndex].Draw(canvas, distorter, transformer, selected, timestamp);
-                    }
-                }
-            }
-            else if (keyFrameIndex >= 0)
-            {
-                // if fading is off, only draw the current keyframe.
-                // Draw all drawings in reverse order to get first object on the top of Z-order.
-                Keyframe keyframe = m_FrameServer.Metadata.Keyframes[keyFrameIndex];
-                for (int drawingIndex = keyframe.Drawings.Count - 1; drawingIndex >= 0; drawingIndex--)
-                {
-                    bool selected = keyframe.Drawings[drawingIndex] == m_FrameServer.Metadata.HitDrawing;
-                    keyframe.Drawings[drawingIndex].Draw(canvas, distorter, transformer, selected, timestamp);
-                }
-            }
-            else
-            {
-                // This is not a Keyframe, and fading is off.
-                // Hence, there is no drawings to draw here.
-            }
-        }
-        private void FlushMagnifierOnGraphics(Bitmap currentImage, Graphics canvas, ImageTransform transform)
-        {
-            // Note: the Graphics object must not be the one extracted from the image itself.
-            // If needed, clone the image.
-            if (currentImage != null && m_FrameServer.Metadata.Magnifier.Mode != MagnifierMode.None)
-                m_FrameServer.Metadata.Magnifier.Draw(currentImage, canvas, transform, m_FrameServer.Metadata.Mirrored, m_FrameServer.VideoReader.Info.ReferenceSize);
-        }
         public void DoInvalidate()
         {
             // This function should be the single point where we call for rendering.
@@ -3771,6 +3732,7 @@ namespace Kinovea.ScreenManager
             if (SetAsActiveScreen != null)
                 SetAsActiveScreen(this, EventArgs.Empty);
 
+            m_FrameServer.Metadata.SetDirty();
             DoInvalidate();
         }
         public void InitializeEndFromMenu(bool cancelLastPoint)
@@ -4508,6 +4470,10 @@ namespace Kinovea.ScreenManager
                 memento.UpdateCommandName(drawing.Name);
                 m_FrameServer.HistoryStack.PushNewCommand(memento);
             }
+            else if (fcd.DialogResult == DialogResult.OK)
+            {
+                m_FrameServer.Metadata.SetDirty();
+            }
 
             fcd.Dispose();
             DoInvalidate();
@@ -4540,6 +4506,7 @@ namespace Kinovea.ScreenManager
             drawing.InfosFading.AlwaysVisible = true;
             drawing.InfosFading.UseDefault = false;
             m_FrameServer.HistoryStack.PushNewCommand(memento);
+            m_FrameServer.Metadata.ModifiedDrawing(managerId, drawing.Id);
             DoInvalidate();
         }
         private void mnuVisibilityDefault_Click(object sender, EventArgs e)
@@ -4556,6 +4523,7 @@ namespace Kinovea.ScreenManager
             drawing.InfosFading.AlwaysVisible = false;
             drawing.InfosFading.UseDefault = true;
             m_FrameServer.HistoryStack.PushNewCommand(memento);
+            m_FrameServer.Metadata.ModifiedDrawing(managerId, drawing.Id);
             DoInvalidate();
         }
         private void mnuVisibilityCustom_Click(object sender, EventArgs e)
@@ -4575,6 +4543,7 @@ namespace Kinovea.ScreenManager
             drawing.InfosFading.AlwaysVisible = false;
             drawing.InfosFading.UseDefault = false;
             m_FrameServer.HistoryStack.PushNewCommand(memento);
+            m_FrameServer.Metadata.ModifiedDrawing(managerId, drawing.Id);
             DoInvalidate();
 
             // Go to configuration immediately.
@@ -4588,6 +4557,12 @@ namespace Kinovea.ScreenManager
             FormsHelper.Locate(f);
             f.ShowDialog();
             f.Dispose();
+
+            Keyframe keyframe = m_FrameServer.Metadata.HitKeyframe;
+            if (keyframe != null && drawing != null)
+                m_FrameServer.Metadata.ModifiedDrawing(keyframe.Id, drawing.Id);
+            else
+                m_FrameServer.Metadata.SetDirty();
             DoInvalidate();
         }
 
@@ -4762,6 +4737,10 @@ namespace Kinovea.ScreenManager
             DoInvalidate();
             UpdateFramesMarkers();
         }
+        private void mnuTrackToEnd_Click(object sender, EventArgs e)
+        {
+            TrackToEndOfZone();
+        }
         private void mnuRestartTracking_Click(object sender, EventArgs e)
         {
             DrawingTrack track = m_FrameServer.Metadata.HitDrawing as DrawingTrack;
@@ -5379,6 +5358,87 @@ namespace Kinovea.ScreenManager
 
             m_FrameServer.VideoReader.AfterFrameEnumeration();
         }
+
+        /// <summary>
+        /// Track all the currently tracked drawings from the current position to the end of the working zone, 
+        /// as fast as possible and without rendering. The user can cancel at any time, what has been tracked so far is kept.
+        /// </summary>
+        public void TrackToEndOfZone()
+        {
+            if (!m_FrameServer.Loaded || !m_FrameServer.Metadata.Tracking || m_iCurrentPosition >= m_iSelEnd)
+                return;
+
+            StopPlaying();
+            CheckCustomDecodingSize(true);
+
+            long start = m_iCurrentPosition;
+            long last = start;
+            ProgressWorker((s, e) => last = TrackBatch(s as BackgroundWorker, e, start));
+
+            // Land on the last tracked frame.
+            m_iFramesToDecode = 1;
+            ShowNextFrame(last, true);
+            UpdatePositionUI();
+            UpdateFramesMarkers();
+            RefreshImage();
+        }
+
+        /// <summary>
+        /// Runs in the background thread of the progress dialog. 
+        /// Frames are taken from the reader in sequence (straight from the cache if the working zone is cached).
+        /// Only the decoding and the matching of the trackable points run here, the drawings and tracks 
+        /// are updated on the UI thread, one frame at a time, while this thread waits.
+        /// Returns the timestamp of the last tracked frame.
+        /// </summary>
+        private long TrackBatch(BackgroundWorker bgWorker, DoWorkEventArgs e, long start)
+        {
+            long interval = m_FrameServer.VideoReader.Info.AverageTimeStampsPerFrame;
+            int total = (int)((m_iSelEnd - start) / interval) + 1;
+            int current = 0;
+            long last = start;
+            Stopwatch stopwatch = Stopwatch.StartNew();
+
+            m_FrameServer.VideoReader.BeforeFrameEnumeration();
+
+            foreach (VideoFrame vf in m_FrameServer.VideoReader.FrameEnumerator(start, 0))
+            {
+                if (bgWorker.CancellationPending)
+                {
+                    e.Cancel = true;
+                    break;
+                }
+
+                if (vf == null)
+                {
+                    log.Error("Frame enumerator yield null.");
+                    break;
+                }
+
+                // The starting frame is already tracked.
+                if (vf.Timestamp != start)
+                {
+                    var result = m_FrameServer.Metadata.TrackabilityManager.Match(vf);
+                    Invoke((Action)(() => CommitBatchTracking(result, vf)));
+                }
+
+                last = vf.Timestamp;
+                bgWorker.ReportProgress(current++, total);
+
+                if (!m_FrameServer.Metadata.Tracking)
+                    break;
+            }
+
+            m_FrameServer.VideoReader.AfterFrameEnumeration();
+
+            log.DebugFormat("Batch tracking: {0} frames in {1} ms.", current, stopwatch.ElapsedMilliseconds);
+            return last;
+        }
+
+        private void CommitBatchTracking(List<KeyValuePair<DrawingTracker, Dictionary<string, bool>>> result, VideoFrame vf)
+        {
+            m_FrameServer.Metadata.TrackabilityManager.Commit(result);
+            m_FrameServer.Metadata.PerformTracking(vf);
+        }
         
         /// <summary>
         /// Returns the image currently on screen with all drawings flushed, including grids, magnifier, mirroring, etc.
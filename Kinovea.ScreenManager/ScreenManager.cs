@@ -107,6 +107,7 @@ namespace Kinovea.ScreenManager
         private ToolStripMenuItem mnuToggleCommonCtrls = new ToolStripMenuItem();
 
         private ToolStripMenuItem mnuDeinterlace = new ToolStripMenuItem();
+        private ToolStripMenuItem mnuUndistort = new ToolStripMenuItem();
 
         private ToolStripMenuItem mnuDemosaic = new ToolStripMenuItem();
         private ToolStripMenuItem mnuDemosaicNone = new ToolStripMenuItem();
@@ -431,6 +432,10 @@ namespace Kinovea.ScreenManager
             mnuDeinterlace.Click += new EventHandler(mnuDeinterlaceOnClick);
             mnuDeinterlace.MergeAction = MergeAction.Append;
 
+            mnuUndistort.Checked = false;
+            mnuUndistort.Click += mnuUndistortOnClick;
+            mnuUndistort.MergeAction = MergeAction.Append;
+
             mnuDemosaicNone.Click += mnuDemosaicNone_Click;
             mnuDemosaicRGGB.Click += mnuDemosaicRGGB_Click;
             mnuDemosaicBGGR.Click += mnuDemosaicBGGR_Click;
@@ -481,6 +486,7 @@ namespace Kinovea.ScreenManager
             mnuCatchImage.DropDownItems.Add(mnuMirror);
             mnuCatchImage.DropDownItems.Add(mnuDemosaic);
             mnuCatchImage.DropDownItems.Add(mnuDeinterlace);
+            mnuCatchImage.DropDownItems.Add(mnuUndistort);
             //mnuCatchImage.DropDownItems.Add(new ToolStripSeparator());
             
             // Temporary hack for including filters sub menus until a full plugin system is in place.
@@ -1068,8 +1074,11 @@ namespace Kinovea.ScreenManager
 
                     // Image
                     mnuDeinterlace.Enabled = player.FrameServer.VideoReader.CanChangeDeinterlacing;
+                    mnuUndistort.Enabled = player.FrameServer.VideoReader.CanChangeFrameTransform && 
+                        player.FrameServer.Metadata.CalibrationHelper.DistortionHelper.Initialized;
                     mnuMirror.Enabled = true;
                     mnuDeinterlace.Checked = player.Deinterlaced;
+                    mnuUndistort.Checked = player.Undistorted;
                     mnuMirror.Checked = player.Mirrored;
                     if (!player.IsSingleFrame)
                     {
@@ -1122,8 +1131,10 @@ namespace Kinovea.ScreenManager
 
                     // Image
                     mnuDeinterlace.Enabled = false;
+                    mnuUndistort.Enabled = false;
                     mnuMirror.Enabled = true;
                     mnuDeinterlace.Checked = false;
+                    mnuUndistort.Checked = false;
                     mnuMirror.Checked = captureScreen.Mirrored;
                     ConfigureImageFormatMenus(captureScreen);
                     ConfigureImageRotationMenus(captureScreen);
@@ -1176,8 +1187,10 @@ namespace Kinovea.ScreenManager
 
                 // Image
                 mnuDeinterlace.Enabled = false;
+                mnuUndistort.Enabled = false;
                 mnuMirror.Enabled = false;
                 mnuDeinterlace.Checked = false;
+                mnuUndistort.Checked = false;
                 mnuMirror.Checked = false;
                 ConfigureImageFormatMenus(null);
                 ConfigureImageRotationMenus(null);
@@ -1323,7 +1336,7 @@ namespace Kinovea.ScreenManager
             {
                 VideoFilterType filterType = (VideoFilterType)menu.Tag;
                 menu.Visible = VideoFilterFactory.GetExperimental(filterType) ? Software.Experimental : true;
-                menu.Enabled = hasVideo && player.IsCaching;
+                menu.Enabled = hasVideo;
                 menu.Checked = hasVideo && player.ActiveVideoFilterType == filterType;
             }
         }
@@ -1478,6 +1491,7 @@ namespace Kinovea.ScreenManager
             
             // Image
             mnuDeinterlace.Text = ScreenManagerLang.mnuDeinterlace;
+            mnuUndistort.Text = ScreenManagerLang.mnuUndistort;
             mnuFormatAuto.Text = ScreenManagerLang.mnuFormatAuto;
             mnuFormatForce43.Text = ScreenManagerLang.mnuFormatForce43;
             mnuFormatForce169.Text = ScreenManagerLang.mnuFormatForce169;
@@ -2142,6 +2156,15 @@ namespace Kinovea.ScreenManager
                 player.Deinterlaced = mnuDeinterlace.Checked;	
             }
         }
+        private void mnuUndistortOnClick(object sender, EventArgs e)
+        {
+            PlayerScreen player = activeScreen as PlayerScreen;
+            if (player != null)
+            {
+                mnuUndistort.Checked = !mnuUndistort.Checked;
+                player.Undistorted = mnuUndistort.Checked;
+            }
+        }
         private void mnuFormatAutoOnClick(object sender, EventArgs e)
         {
             ChangeAspectRatio(ImageAspectRatio.Auto);
@@ -30,7 +30,7 @@ namespace Kinovea.ScreenManager
         private List<String> filenames;
         private Size maxImageSize;
         private BackgroundWorker bgWorker = new BackgroundWorker();
-        private const int thumbnailsToExtract = 5;
+        private const int thumbnailsToExtract = 1;     // Poster frame only, see ScrubFrameCache.
         private static readonly log4net.ILog log = log4net.LogManager.GetLogger(System.Reflection.MethodBase.GetCurrentMethod().DeclaringType);
         
         public SummaryLoader(List<String> filenames, Size maxImageSize)
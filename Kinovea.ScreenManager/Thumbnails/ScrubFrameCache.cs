@@ -0,0 +1,248 @@
+﻿/*
+Copyright © Joan Charmant 2008.
+jcharmant@gmail.com 
+ 
+This file is part of Kinovea.
+
+Kinovea is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2 
+as published by the Free Software Foundation.
+
+Kinovea is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Kinovea. If not, see http://www.gnu.org/licenses/.
+
+*/
+
+using System;
+using System.Collections.Generic;
+using System.ComponentModel;
+using System.Drawing;
+using System.IO;
+using Kinovea.Services;
+using Kinovea.Video;
+
+namespace Kinovea.ScreenManager
+{
+    /// <summary>
+    /// Frames used to scrub through a video when hovering its thumbnail.
+    /// 
+    /// The summaries only carry the poster frame. The scrub frames are extracted on demand, the first time a thumbnail is hovered, 
+    /// at the size of the thumbnail and from approximate seeks (no decoding past the keyframe).
+    /// The frames of all the thumbnails share a memory budget, the least recently used are evicted first.
+    /// Frames in use by a thumbnail are never evicted.
+    /// 
+    /// Must be used from the UI thread.
+    /// </summary>
+    public static class ScrubFrameCache
+    {
+        /// <summary>
+        /// Raised on the UI thread when the frames of a file are available.
+        /// </summary>
+        public static event EventHandler<EventArgs<string>> FramesLoaded;
+
+        private class Entry
+        {
+            public string Filename;
+            public Size Size;
+            public DateTime LastWriteTime;
+            public List<Bitmap> Frames;
+            public long Bytes;
+            public int References;
+        }
+
+        private class Request
+        {
+            public string Filename;
+            public Size Size;
+        }
+
+        private static Dictionary<string, LinkedListNode<Entry>> entries = new Dictionary<string, LinkedListNode<Entry>>(StringComparer.OrdinalIgnoreCase);
+        private static LinkedList<Entry> lru = new LinkedList<Entry>();   // Most recently used first.
+        private static long bytes;
+        private static BackgroundWorker worker;
+        private static Request pending;
+        private const int framesToExtract = 5;
+        private const long budget = 64 * 1024 * 1024;
+        private static readonly log4net.ILog log = log4net.LogManager.GetLogger(System.Reflection.MethodBase.GetCurrentMethod().DeclaringType);
+
+        /// <summary>
+        /// Returns the frames of the file if they are available at a size covering the requested size, or null.
+        /// The frames stay valid until the matching call to Release.
+        /// </summary>
+        public static List<Bitmap> Acquire(string filename, Size size)
+        {
+            LinkedListNode<Entry> node;
+            if (!entries.TryGetValue(filename, out node) || !IsValid(node.Value, size))
+                return null;
+
+            lru.Remove(node);
+            lru.AddFirst(node);
+            node.Value.References++;
+            return node.Value.Frames;
+        }
+
+        /// <summary>
+        /// Releases frames obtained from Acquire.
+        /// </summary>
+        public static void Release(string filename, List<Bitmap> frames)
+        {
+            LinkedListNode<Entry> node;
+            if (entries.TryGetValue(filename, out node) && node.Value.Frames == frames)
+            {
+                if (node.Value.References > 0)
+                    node.Value.References--;
+
+                Trim();
+                return;
+            }
+
+            // The frames were replaced by newer ones while in use.
+            foreach (Bitmap frame in frames)
+                frame.Dispose();
+
+            frames.Clear();
+        }
+
+        /// <summary>
+        /// Starts extracting the frames of the file in the background. FramesLoaded is raised when they are available.
+        /// Only the most recent request is kept while an extraction is running.
+        /// </summary>
+        public static void Load(string filename, Size size)
+        {
+            Request request = new Request();
+            request.Filename = filename;
+            request.Size = size;
+
+            if (worker != null)
+            {
+                pending = request;
+                return;
+            }
+
+            worker = new BackgroundWorker();
+            worker.DoWork += Worker_DoWork;
+            worker.RunWorkerCompleted += Worker_RunWorkerCompleted;
+            worker.RunWorkerAsync(request);
+        }
+
+        private static bool IsValid(Entry entry, Size size)
+        {
+            // Files being recorded grow, their frames must be extracted again.
+            return entry.Size.Width >= size.Width && entry.LastWriteTime == GetLastWriteTime(entry.Filename);
+        }
+
+        private static DateTime GetLastWriteTime(string filename)
+        {
+            try
+            {
+                return File.GetLastWriteTime(filename);
+            }
+            catch
+            {
+                return DateTime.MinValue;
+            }
+        }
+
+        private static void Worker_DoWork(object sender, DoWorkEventArgs e)
+        {
+            Request request = e.Argument as Request;
+            Entry entry = new Entry();
+            entry.Filename = request.Filename;
+            entry.Size = request.Size;
+            entry.LastWriteTime = GetLastWriteTime(request.Filename);
+
+            try
+            {
+                VideoReader reader = VideoTypeManager.GetVideoReader(Path.GetExtension(request.Filename));
+                if (reader != null)
+                {
+                    VideoSummary summary = reader.ExtractSummary(request.Filename, framesToExtract, request.Size);
+                    entry.Frames = summary.Thumbs;
+                }
+            }
+            catch (Exception exp)
+            {
+                log.ErrorFormat("Error while extracting scrub frames for {0}.", request.Filename);
+                log.Error(exp);
+            }
+
+            e.Result = entry;
+        }
+
+        private static void Worker_RunWorkerCompleted(object sender, RunWorkerCompletedEventArgs e)
+        {
+            worker = null;
+
+            Entry entry = e.Result as Entry;
+            if (entry != null && entry.Frames != null && entry.Frames.Count > 0)
+            {
+                Add(entry);
+                if (FramesLoaded != null)
+                    FramesLoaded(null, new EventArgs<string>(entry.Filename));
+            }
+
+            if (pending != null)
+            {
+                Request request = pending;
+                pending = null;
+                Load(request.Filename, request.Size);
+            }
+        }
+
+        private static void Add(Entry entry)
+        {
+            foreach (Bitmap frame in entry.Frames)
+                entry.Bytes += (long)frame.Width * frame.Height * Image.GetPixelFormatSize(frame.PixelFormat) / 8;
+
+            LinkedListNode<Entry> old;
+            if (entries.TryGetValue(entry.Filename, out old))
+            {
+                // Outdated frames still in use are left to their user.
+                if (old.Value.References == 0)
+                    Dispose(old.Value);
+
+                bytes -= old.Value.Bytes;
+                lru.Remove(old);
+                entries.Remove(entry.Filename);
+            }
+
+            entries.Add(entry.Filename, lru.AddFirst(entry));
+            bytes += entry.Bytes;
+            Trim();
+        }
+
+        /// <summary>
+        /// Evicts the least recently used frames until the cache fits in the budget.
+        /// </summary>
+        private static void Trim()
+        {
+            LinkedListNode<Entry> node = lru.Last;
+            while (bytes > budget && node != null)
+            {
+                LinkedListNode<Entry> previous = node.Previous;
+                if (node.Value.References == 0)
+                {
+                    bytes -= node.Value.Bytes;
+                    Dispose(node.Value);
+                    entries.Remove(node.Value.Filename);
+                    lru.Remove(node);
+                }
+
+                node = previous;
+            }
+        }
+
+        private static void Dispose(Entry entry)
+        {
+            foreach (Bitmap frame in entry.Frames)
+                frame.Dispose();
+
+            entry.Frames.Clear();
+        }
+    }
+}
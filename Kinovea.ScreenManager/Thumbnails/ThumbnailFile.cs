@@ -68,6 +68,7 @@ namespace Kinovea.ScreenManager
         private bool m_bIsSelected = false;
         private bool m_IsError;
         private List<Bitmap> m_Bitmaps;
+        private List<Bitmap> scrubFrames;   // Shared with the scrub frame cache, only while hovering.
         private Bitmap currentThumbnail;
         private FileDetails details = new FileDetails();
         private bool m_bIsImage;
@@ -110,6 +111,7 @@ namespace Kinovea.ScreenManager
             
             SetupTimer();
             SetupTextbox();
+            ScrubFrameCache.FramesLoaded += ScrubFrameCache_FramesLoaded;
             BuildContextMenus();
             RefreshUICulture();
         }
@@ -183,6 +185,9 @@ namespace Kinovea.ScreenManager
                 tmrThumbs.Tick -= tmrThumbs_Tick;
                 tmrThumbs.Dispose();
 
+                ScrubFrameCache.FramesLoaded -= ScrubFrameCache_FramesLoaded;
+                ReleaseScrubFrames();
+
                 tbFileName.KeyPress -= TbFileNameKeyPress;
                 tbFileName.Dispose();
 
@@ -334,6 +339,8 @@ namespace Kinovea.ScreenManager
         }
         public void DisposeImages()
         {
+            ReleaseScrubFrames();
+
             if(m_IsError || m_Bitmaps == null)
                 return;
             
@@ -423,12 +430,13 @@ namespace Kinovea.ScreenManager
         private void DrawPreviewRectangles(Graphics _canvas)
         {
             // Draw quick preview rectangles.
-            if(!m_Hovering || m_Bitmaps == null || m_Bitmaps.Count < 2)
+            List<Bitmap> frames = GetFrames();
+            if(!m_Hovering || frames == null || frames.Count < 2)
                 return;
 
-            int rectWidth = picBox.Width / m_Bitmaps.Count;
+            int rectWidth = picBox.Width / frames.Count;
             int rectHeight = 20;
-            for(int i=0;i<m_Bitmaps.Count;i++)
+            for(int i=0;i<frames.Count;i++)
             {
                 SolidBrush b = i == currentThumbnailIndex ? m_BrushQuickPreviewActive : m_BrushQuickPreviewInactive;
                 _canvas.FillRectangle(b, rectWidth * i, picBox.Height - rectHeight, rectWidth, rectHeight);	
@@ -513,15 +521,16 @@ namespace Kinovea.ScreenManager
 
         private void PicBoxMouseMove(object sender, MouseEventArgs e)
         {
-            if(m_IsError || m_Bitmaps == null || m_Bitmaps.Count < 1)
+            List<Bitmap> frames = GetFrames();
+            if(m_IsError || frames == null || frames.Count < 1)
                 return;
             
             if(e.Y > picBox.Height - 20)
             {
                 tmrThumbs.Stop();
-                int index = e.X / (picBox.Width / m_Bitmaps.Count);
-                currentThumbnailIndex = Math.Max(Math.Min(index, m_Bitmaps.Count - 1), 0);
-                currentThumbnail = m_Bitmaps[currentThumbnailIndex];
+                int index = e.X / Math.Max(picBox.Width / frames.Count, 1);
+                currentThumbnailIndex = Math.Max(Math.Min(index, frames.Count - 1), 0);
+                currentThumbnail = frames[currentThumbnailIndex];
                 picBox.Invalidate();
             }
             else
@@ -543,14 +552,15 @@ namespace Kinovea.ScreenManager
         private void tmrThumbs_Tick(object sender, EventArgs e) 
         {
             // This event occur when the user has been staying for a while on the same thumbnail. Loop between all stored images.
-            if(m_IsError || m_Bitmaps == null || m_Bitmaps.Count < 2)
+            List<Bitmap> frames = GetFrames();
+            if(m_IsError || frames == null || frames.Count < 2)
                 return;
             
             currentThumbnailIndex++;
-            if(currentThumbnailIndex >= m_Bitmaps.Count)
+            if(currentThumbnailIndex >= frames.Count)
                 currentThumbnailIndex = 0;
             
-            currentThumbnail = m_Bitmaps[currentThumbnailIndex];
+            currentThumbnail = frames[currentThumbnailIndex];
             picBox.Invalidate();
         }
 
@@ -558,16 +568,17 @@ namespace Kinovea.ScreenManager
         {
             m_Hovering = true;
         
-            if(m_IsError || m_Bitmaps == null || m_Bitmaps.Count < 2)
+            if(m_IsError || m_bIsImage || m_Bitmaps == null || m_Bitmaps.Count < 1)
                 return;
-            
-            // Instantly change image
-            currentThumbnailIndex = 1;
-            currentThumbnail = m_Bitmaps[currentThumbnailIndex];
-            picBox.Invalidate();
 
-            // Then start timer to slideshow.
-            tmrThumbs.Start();
+            // The summary only has the poster frame, the scrub frames are extracted the first time we hover.
+            if (scrubFrames == null)
+                scrubFrames = ScrubFrameCache.Acquire(m_FileName, picBox.Size);
+
+            if (scrubFrames == null)
+                ScrubFrameCache.Load(m_FileName, picBox.Size);
+            else
+                StartScrubbing();
         }
 
         private void PicBoxMouseLeave(object sender, EventArgs e)
@@ -584,6 +595,52 @@ namespace Kinovea.ScreenManager
                     picBox.Invalidate();	
                 }
             }
+
+            ReleaseScrubFrames();
+        }
+
+        private void ScrubFrameCache_FramesLoaded(object sender, EventArgs<string> e)
+        {
+            if (!m_Hovering || scrubFrames != null || e.Value != m_FileName)
+                return;
+
+            scrubFrames = ScrubFrameCache.Acquire(m_FileName, picBox.Size);
+            if (scrubFrames != null)
+                StartScrubbing();
+        }
+
+        private void StartScrubbing()
+        {
+            if (scrubFrames.Count < 2)
+                return;
+
+            // Instantly change image
+            currentThumbnailIndex = 1;
+            currentThumbnail = scrubFrames[currentThumbnailIndex];
+            picBox.Invalidate();
+
+            // Then start timer to slideshow.
+            tmrThumbs.Start();
+        }
+
+        private void ReleaseScrubFrames()
+        {
+            if (scrubFrames == null)
+                return;
+
+            if (m_Bitmaps != null && m_Bitmaps.Count > 0 && scrubFrames.Contains(currentThumbnail))
+            {
+                currentThumbnailIndex = 0;
+                currentThumbnail = m_Bitmaps[0];
+            }
+
+            ScrubFrameCache.Release(m_FileName, scrubFrames);
+            scrubFrames = null;
+        }
+
+        private List<Bitmap> GetFrames()
+        {
+            return scrubFrames ?? m_Bitmaps;
         }
 
         private void TbFileNameKeyPress(object sender, KeyPressEventArgs e)
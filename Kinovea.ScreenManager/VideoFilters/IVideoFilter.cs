@@ -84,10 +84,12 @@ namespace Kinovea.ScreenManager
         #region Methods
 
         /// <summary>
-        /// Called by the screen when the number or content of the frame buffer has changed.
+        /// Called by the screen when the working zone or the content of the frame buffer has changed.
         /// The filter should reset itself with the new frames, while keeping its existing settings when possible.
+        /// The frames are available from reader.WorkingZoneFrames when the working zone is cached,
+        /// otherwise the filter should only decode the frames it needs.
         /// </summary>
-        void SetFrames(IWorkingZoneFramesContainer framesContainer);
+        void SetFrames(VideoReader reader);
 
         /// <summary>
         /// Called when the main size of the final image has changed.
@@ -0,0 +1,292 @@
+﻿#region License
+/*
+Copyright © Joan Charmant 2021.
+jcharmant@gmail.com
+
+This file is part of Kinovea.
+
+Kinovea is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2
+as published by the Free Software Foundation.
+
+Kinovea is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Kinovea. If not, see http://www.gnu.org/licenses/.
+*/
+#endregion
+using System;
+using System.ComponentModel;
+using System.Drawing;
+using System.Drawing.Drawing2D;
+using System.Linq;
+using Kinovea.Services;
+using Kinovea.Video;
+
+namespace Kinovea.ScreenManager
+{
+    /// <summary>
+    /// Decodes the frames used by the tiles of a Kinogram when the working zone is not cached.
+    ///
+    /// The frames are decoded in the background by a private reader opened on the same file,
+    /// so the player can keep navigating meanwhile. Each frame is kept at a reduced scale,
+    /// just enough for the crops to be painted at the resolution of the tiles.
+    /// The tiles are available one by one as they are decoded, the TileLoaded event is raised on the UI thread.
+    /// </summary>
+    public class KinogramTileLoader : IDisposable
+    {
+        #region Events
+        public event EventHandler<EventArgs<int>> TileLoaded;
+        #endregion
+
+        #region Properties
+        /// <summary>
+        /// Scale of the loaded images relatively to the reference size of the video.
+        /// </summary>
+        public float Scale
+        {
+            get { return request == null ? 1.0f : request.Scale; }
+        }
+        #endregion
+
+        #region Members
+        private class Request
+        {
+            public Type ReaderType;
+            public string FilePath;
+            public VideoOptions Options;
+            public Size ReferenceSize;
+            public IFrameTransform Transform;
+            public long[] Timestamps;
+            public float Scale;
+
+            public bool SameAs(Request other)
+            {
+                return other != null &&
+                    ReaderType == other.ReaderType &&
+                    FilePath == other.FilePath &&
+                    ReferenceSize == other.ReferenceSize &&
+                    (Transform == null) == (other.Transform == null) &&
+                    Scale == other.Scale &&
+                    Timestamps.SequenceEqual(other.Timestamps);
+            }
+        }
+
+        private Request request;
+        private Bitmap[] tiles = new Bitmap[0];
+        private BackgroundWorker worker;
+        private static readonly log4net.ILog log = log4net.LogManager.GetLogger(System.Reflection.MethodBase.GetCurrentMethod().DeclaringType);
+        #endregion
+
+        #region ctor/dtor
+        ~KinogramTileLoader()
+        {
+            Dispose(false);
+        }
+        public void Dispose()
+        {
+            Dispose(true);
+            GC.SuppressFinalize(this);
+        }
+        protected virtual void Dispose(bool disposing)
+        {
+            if (disposing)
+                Clear();
+        }
+        #endregion
+
+        #region Public methods
+        /// <summary>
+        /// Starts decoding the frames at the passed timestamps of the video opened by the source reader.
+        /// Tiles already loaded for the same request are kept.
+        /// Must be called from the UI thread.
+        /// </summary>
+        public void Load(VideoReader source, long[] timestamps, float scale, IFrameTransform transform)
+        {
+            Request newRequest = CreateRequest(source, timestamps, scale, transform);
+            if (newRequest.SameAs(request))
+                return;
+
+            Clear();
+            request = newRequest;
+            tiles = new Bitmap[timestamps.Length];
+            if (timestamps.Length == 0)
+                return;
+
+            worker = new BackgroundWorker();
+            worker.WorkerReportsProgress = true;
+            worker.WorkerSupportsCancellation = true;
+            worker.DoWork += Worker_DoWork;
+            worker.ProgressChanged += Worker_ProgressChanged;
+            worker.RunWorkerAsync(request);
+        }
+
+        /// <summary>
+        /// Returns the image of the tile, or null if it is not loaded yet.
+        /// The image is owned by the loader.
+        /// </summary>
+        public Bitmap GetTile(int index)
+        {
+            if (index < 0 || index >= tiles.Length)
+                return null;
+
+            return tiles[index];
+        }
+
+        /// <summary>
+        /// Cancels the loading in progress and releases the loaded tiles.
+        /// </summary>
+        public void Clear()
+        {
+            if (worker != null)
+            {
+                worker.CancelAsync();
+                worker = null;
+            }
+
+            foreach (Bitmap tile in tiles)
+            {
+                if (tile != null)
+                    tile.Dispose();
+            }
+
+            tiles = new Bitmap[0];
+            request = null;
+        }
+
+        /// <summary>
+        /// Decodes the frames synchronously and passes them one by one to the callback, which takes ownership of the images.
+        /// The callback returns false to stop decoding.
+        /// This is used for exporting the Kinogram at full resolution without keeping all the frames in memory.
+        /// </summary>
+        public static void Decode(VideoReader source, long[] timestamps, float scale, IFrameTransform transform, Func<int, Bitmap, bool> callback)
+        {
+            Decode(CreateRequest(source, timestamps, scale, transform), callback);
+        }
+        #endregion
+
+        #region Private methods
+        private static Request CreateRequest(VideoReader source, long[] timestamps, float scale, IFrameTransform transform)
+        {
+            Request request = new Request();
+            request.ReaderType = source.GetType();
+            request.FilePath = source.FilePath;
+            request.Options = new VideoOptions(source.Options.ImageAspectRatio, source.Options.ImageRotation, source.Options.Demosaicing, source.Options.Deinterlace);
+            request.ReferenceSize = source.Info.ReferenceSize;
+            request.Transform = transform;
+            request.Timestamps = timestamps;
+            request.Scale = scale;
+            return request;
+        }
+
+        private void Worker_DoWork(object sender, DoWorkEventArgs e)
+        {
+            BackgroundWorker bgWorker = sender as BackgroundWorker;
+            Request workerRequest = e.Argument as Request;
+
+            Decode(workerRequest, (index, image) =>
+            {
+                if (bgWorker.CancellationPending)
+                {
+                    image.Dispose();
+                    return false;
+                }
+
+                bgWorker.ReportProgress(index, image);
+                return true;
+            });
+        }
+
+        private void Worker_ProgressChanged(object sender, ProgressChangedEventArgs e)
+        {
+            Bitmap image = e.UserState as Bitmap;
+            int index = e.ProgressPercentage;
+
+            // Images from a cancelled request.
+            if (sender != worker || index >= tiles.Length)
+            {
+                image.Dispose();
+                return;
+            }
+
+            if (tiles[index] != null)
+                tiles[index].Dispose();
+
+            tiles[index] = image;
+
+            if (TileLoaded != null)
+                TileLoaded(this, new EventArgs<int>(index));
+        }
+
+        private static void Decode(Request request, Func<int, Bitmap, bool> callback)
+        {
+            VideoReader reader = null;
+            try
+            {
+                reader = Activator.CreateInstance(request.ReaderType) as VideoReader;
+                reader.Options = request.Options;
+                OpenVideoResult result = reader.Open(request.FilePath);
+                if (result != OpenVideoResult.Success)
+                {
+                    log.ErrorFormat("Could not open the video for the Kinogram: {0}.", result);
+                    return;
+                }
+
+                Size size = new Size((int)(request.ReferenceSize.Width * request.Scale), (int)(request.ReferenceSize.Height * request.Scale));
+                size = new Size(Math.Max(1, size.Width), Math.Max(1, size.Height));
+
+                for (int i = 0; i < request.Timestamps.Length; i++)
+                {
+                    if (!reader.MoveTo(request.Timestamps[i]) || reader.Current == null || reader.Current.Image == null)
+                    {
+                        log.DebugFormat("Kinogram frame not decoded: {0}.", request.Timestamps[i]);
+                        continue;
+                    }
+
+                    Bitmap image = CopyScaled(reader.Current.Image, size, request.Transform);
+
+                    if (!callback(i, image))
+                        break;
+                }
+            }
+            catch (Exception e)
+            {
+                log.Error("Error while decoding the Kinogram frames.", e);
+            }
+            finally
+            {
+                if (reader != null && reader.Loaded)
+                    reader.Close();
+            }
+        }
+
+        /// <summary>
+        /// Copies the decoded image, which is owned by the reader, at the requested size.
+        /// The transform is applied at full size as it may depend on the image size.
+        /// </summary>
+        private static Bitmap CopyScaled(Bitmap source, Size size, IFrameTransform transform)
+        {
+            Bitmap copy = BitmapHelper.Copy(source);
+            if (transform != null)
+                transform.Apply(copy);
+
+            if (copy.Size == size)
+                return copy;
+
+            Bitmap image = new Bitmap(size.Width, size.Height, VideoReader.DecodingPixelFormat);
+            using (Graphics g = Graphics.FromImage(image))
+            {
+                g.PixelOffsetMode = PixelOffsetMode.HighQuality;
+                g.InterpolationMode = InterpolationMode.HighQualityBilinear;
+                g.DrawImage(copy, 0, 0, size.Width, size.Height);
+            }
+
+            copy.Dispose();
+            return image;
+        }
+        #endregion
+    }
+}
@@ -38,6 +38,9 @@ namespace Kinovea.ScreenManager
     /// 
     /// The parameters let the user change the subset of frames selected, the crop dimension,
     /// the number of columns and rows of the final composition, etc.
+    ///
+    /// When the working zone is cached the tiles are painted from the cached frames.
+    /// Otherwise only the frames used by the tiles are decoded, in the background, by the tile loader.
     /// </summary>
     public class VideoFilterKinogram : IVideoFilter
     {
@@ -93,7 +96,11 @@ namespace Kinovea.ScreenManager
         private Size canvasSize;    // Nominal size of output image, this is the same as frameSize unless the canvas is rotated.
         private bool rotatedCanvas = false;
         private KinogramParameters parameters = new KinogramParameters();
-        private IWorkingZoneFramesContainer framesContainer;
+        private VideoReader videoReader;
+        private IWorkingZoneFramesContainer framesContainer;    // Only set when the working zone is cached.
+        private KinogramTileLoader tileLoader = new KinogramTileLoader();
+        private int frameCount;                                 // Number of frames in the working zone.
+        private List<int> tileFrames = new List<int>();         // Index of the frame used by each tile, in the working zone.
         private Metadata metadata;
         private long timestamp;
         private Color BackgroundColor = Color.FromArgb(44, 44, 44);
@@ -135,6 +142,8 @@ namespace Kinovea.ScreenManager
             mnuGenerateNumbers.Click += MnuAutonumbers_Click;
             mnuDeleteNumbers.Click += MnuDeleteAutoNumbers_Click;
 
+            tileLoader.TileLoaded += TileLoader_TileLoaded;
+
             parameters = PreferencesManager.PlayerPreferences.Kinogram;
             AfterTileCountChange();
         }
@@ -155,22 +164,32 @@ namespace Kinovea.ScreenManager
             {
                 if (bitmap != null)
                     bitmap.Dispose();
+
+                tileLoader.Dispose();
             }
         }
         #endregion
 
         #region IVideoFilter methods
         
-        public void SetFrames(IWorkingZoneFramesContainer framesContainer)
+        public void SetFrames(VideoReader videoReader)
         {
             // Changing the number of frames in the source doesn't impact the grid arrangement.
             // If we don't have enough frames we just show black tiles.
-            this.framesContainer = framesContainer;
+            this.videoReader = videoReader;
+            this.framesContainer = null;
+            if (videoReader == null || !videoReader.Loaded)
+                return;
+
+            if (videoReader.DecodingMode == VideoDecodingMode.Caching)
+                framesContainer = videoReader.WorkingZoneFrames;
+
             if (framesContainer != null && framesContainer.Frames != null && framesContainer.Frames.Count > 0)
-            {
                 frameSize = framesContainer.Frames[0].Image.Size;
-                UpdateSize(frameSize);
-            }
+            else
+                frameSize = videoReader.Info.ReferenceSize;
+
+            UpdateSize(frameSize);
         }
 
         public void UpdateSize(Size size)
@@ -185,6 +204,7 @@ namespace Kinovea.ScreenManager
                 bitmap = new Bitmap(canvasSize.Width, canvasSize.Height);
             }
 
+            UpdateTiles();
             Update();
         }
 
@@ -229,8 +249,9 @@ namespace Kinovea.ScreenManager
         /// </summary>
         public void DrawExtra(Graphics canvas, IImageToViewportTransformer transformer, long timestamp)
         {
-            float step = (float)framesContainer.Frames.Count / parameters.TileCount;
-            IEnumerable<VideoFrame> frames = framesContainer.Frames.Where((frame, i) => i % step < 1);
+            if (videoReader == null || !videoReader.Loaded)
+                return;
+
             int cols = (int)Math.Ceiling((float)parameters.TileCount / parameters.Rows);
             Size cropSize = GetCropSize();
             Size fullSize = new Size(cropSize.Width * cols, cropSize.Height * parameters.Rows);
@@ -239,14 +260,10 @@ namespace Kinovea.ScreenManager
             paintArea = transformer.Transform(paintArea);
             Size tileSize = new Size(paintArea.Width / cols, paintArea.Height / parameters.Rows);
 
-            int index = 0;
-            foreach (VideoFrame f in frames)
+            for (int index = 0; index < tileFrames.Count; index++)
             {
-                if (f.Timestamp < timestamp)
-                {
-                    index++;
+                if (GetTileTimestamp(index) < timestamp)
                     continue;
-                }
 
                 Rectangle destRect = GetDestinationRectangle(index, cols, parameters.Rows, parameters.LeftToRight, paintArea, tileSize);
                 DrawHighlight(canvas, destRect);
@@ -272,7 +289,11 @@ namespace Kinovea.ScreenManager
 
         public void ResetData()
         {
+            this.videoReader = null;
             this.framesContainer = null;
+            tileLoader.Clear();
+            tileFrames.Clear();
+            frameCount = 0;
             this.parameters = PreferencesManager.PlayerPreferences.Kinogram;
             AfterTileCountChange();
         }
@@ -286,6 +307,7 @@ namespace Kinovea.ScreenManager
         {
             parameters.ReadXml(r);
             AfterTileCountChange();
+            UpdateTiles();
             Update();
         }
         #endregion
@@ -304,7 +326,10 @@ namespace Kinovea.ScreenManager
             g.InterpolationMode = InterpolationMode.HighQualityBilinear;
             g.SmoothingMode = SmoothingMode.HighQuality;
 
-            Paint(g, outputSize);
+            if (framesContainer != null)
+                Paint(g, outputSize);
+            else
+                PaintFullResolution(g, outputSize);
 
             // Annotations are expressed in the original frames coordinate system.
             Rectangle fitArea = UIHelper.RatioStretch(outputSize, canvasSize);
@@ -333,7 +358,7 @@ namespace Kinovea.ScreenManager
         /// </summary>
         public int GetTileCount(int tileCount)
         {
-            return Math.Min(framesContainer.Frames.Count, tileCount);
+            return Math.Min(frameCount, tileCount);
         }
 
         /// <summary>
@@ -341,8 +366,8 @@ namespace Kinovea.ScreenManager
         /// </summary>
         public float GetFrameInterval(int tileCount)
         {
-            int maxFrames = Math.Min(framesContainer.Frames.Count, tileCount);
-            float intervalFrames = (float)framesContainer.Frames.Count / maxFrames;
+            int maxFrames = Math.Min(frameCount, tileCount);
+            float intervalFrames = (float)frameCount / maxFrames;
             float intervalTimestamp = intervalFrames * metadata.AverageTimeStampsPerFrame;
             float intervalSeconds = (float)(intervalTimestamp/ metadata.AverageTimeStampsPerSecond);
             return intervalSeconds;
@@ -362,6 +387,7 @@ namespace Kinovea.ScreenManager
                 parameters = fck.Parameters.Clone();
                 AfterTileCountChange();
                 SaveAsDefaultParameters();
+                UpdateTiles();
             }
 
             fck.Dispose();
@@ -396,7 +422,7 @@ namespace Kinovea.ScreenManager
             Size fullSize = new Size(cropSize.Width * cols, cropSize.Height * parameters.Rows);
             Rectangle paintArea = UIHelper.RatioStretch(fullSize, canvasSize);
             Size tileSize = new Size(paintArea.Width / cols, paintArea.Height / parameters.Rows);
-            int tileCount = Math.Min(framesContainer.Frames.Count, parameters.TileCount);
+            int tileCount = Math.Min(frameCount, parameters.TileCount);
             
             List<PointF> numbers = new List<PointF>();
             for (int i = 0; i < tileCount; i++)
@@ -437,8 +463,8 @@ namespace Kinovea.ScreenManager
                 return;
 
             int goodTiles = newCount;
-            if (framesContainer != null && framesContainer.Frames != null && framesContainer.Frames.Count < newCount)
-                goodTiles = framesContainer.Frames.Count;
+            if (videoReader != null && frameCount < newCount)
+                goodTiles = frameCount;
 
             List<PointF> newCrops = new List<PointF>();
             if (oldCount < 2)
@@ -470,13 +496,11 @@ namespace Kinovea.ScreenManager
         /// </summary>
         private void AutoPositions()
         {
-            int count = Math.Min(parameters.TileCount, framesContainer.Frames.Count);
+            int count = Math.Min(parameters.TileCount, frameCount);
             if (count < 3)
                 return;
 
-            int goodTiles = parameters.TileCount;
-            if (framesContainer != null && framesContainer.Frames != null && framesContainer.Frames.Count < parameters.TileCount)
-                goodTiles = framesContainer.Frames.Count;
+            int goodTiles = count;
 
             List<PointF> newCrops = new List<PointF>();
             for (int i = 0; i < goodTiles; i++)
@@ -502,6 +526,116 @@ namespace Kinovea.ScreenManager
                 parameters.CropPositions.Add(PointF.Empty);
         }
 
+        #region Tiles
+        /// <summary>
+        /// Find the frames used by the tiles and start decoding them if the working zone is not cached.
+        /// Must be called after any change to the source, the canvas size, the number of tiles or the crop size.
+        /// </summary>
+        private void UpdateTiles()
+        {
+            frameCount = 0;
+            tileFrames.Clear();
+
+            if (framesContainer != null && framesContainer.Frames != null)
+                frameCount = framesContainer.Frames.Count;
+            else if (videoReader != null && videoReader.Loaded)
+                frameCount = (int)videoReader.EstimatedFrames;
+
+            float step = (float)frameCount / parameters.TileCount;
+            for (int i = 0; i < frameCount && tileFrames.Count < parameters.TileCount; i++)
+            {
+                if (i % step < 1)
+                    tileFrames.Add(i);
+            }
+
+            if (framesContainer != null || videoReader == null || !videoReader.Loaded)
+            {
+                tileLoader.Clear();
+                return;
+            }
+
+            tileLoader.Load(videoReader, GetTileTimestamps(), GetTileScale(), GetFrameTransform());
+        }
+
+        /// <summary>
+        /// Returns the nominal timestamps of the frames used by the tiles.
+        /// </summary>
+        private long[] GetTileTimestamps()
+        {
+            long[] timestamps = new long[tileFrames.Count];
+            for (int i = 0; i < tileFrames.Count; i++)
+                timestamps[i] = GetTileTimestamp(i);
+
+            return timestamps;
+        }
+
+        private long GetTileTimestamp(int index)
+        {
+            if (framesContainer != null && framesContainer.Frames != null && tileFrames[index] < framesContainer.Frames.Count)
+                return framesContainer.Frames[tileFrames[index]].Timestamp;
+
+            return videoReader.WorkingZone.Start + tileFrames[index] * videoReader.Info.AverageTimeStampsPerFrame;
+        }
+
+        /// <summary>
+        /// Returns the image used by the tile, or null if it is not available.
+        /// </summary>
+        private Bitmap GetTileImage(int index)
+        {
+            if (framesContainer == null)
+                return tileLoader.GetTile(index);
+
+            if (framesContainer.Frames == null || index >= tileFrames.Count || tileFrames[index] >= framesContainer.Frames.Count)
+                return null;
+
+            return framesContainer.Frames[tileFrames[index]].Image;
+        }
+
+        private float GetTileImageScale()
+        {
+            return framesContainer == null ? tileLoader.Scale : 1.0f;
+        }
+
+        /// <summary>
+        /// Returns the scale at which the frames must be decoded for the crops to be painted at the resolution of the tiles.
+        /// </summary>
+        private float GetTileScale()
+        {
+            int cols = (int)Math.Ceiling((float)parameters.TileCount / parameters.Rows);
+            Size cropSize = GetCropSize();
+            if (cropSize.Width <= 0 || cropSize.Height <= 0 || canvasSize.Width <= 0)
+                return 1.0f;
+
+            Size fullSize = new Size(cropSize.Width * cols, cropSize.Height * parameters.Rows);
+            Rectangle paintArea = UIHelper.RatioStretch(fullSize, canvasSize);
+            float scale = (float)paintArea.Width / fullSize.Width;
+
+            // Round up to limit reloads on small changes.
+            scale = (float)Math.Ceiling(scale * 20) / 20;
+            return Math.Min(1.0f, scale);
+        }
+
+        /// <summary>
+        /// Returns the transform the player applies to the decoded frames, if any.
+        /// </summary>
+        private IFrameTransform GetFrameTransform()
+        {
+            if (!metadata.CalibrationHelper.ImageRectified)
+                return null;
+
+            return new UndistortionFrameTransform(metadata.CalibrationHelper);
+        }
+
+        private void TileLoader_TileLoaded(object sender, EventArgs<int> e)
+        {
+            if (e.Value >= tileFrames.Count)
+                return;
+
+            Update(e.Value);
+            metadata.InvalidateVideoFilter();
+        }
+        #endregion
+
         #region Rendering
         /// <summary>
         /// Paint the composite or paint one tile on the internal bitmap.
@@ -509,9 +643,17 @@ namespace Kinovea.ScreenManager
         /// </summary>
         private void Update(int tile = -1)
         {
-            if (bitmap == null || framesContainer == null || framesContainer.Frames == null || framesContainer.Frames.Count < 1)
+            if (bitmap == null || frameCount < 1)
                 return;
 
+            if (framesContainer != null && (framesContainer.Frames == null || framesContainer.Frames.Count != frameCount))
+            {
+                // The cache was reloaded.
+                UpdateTiles();
+                if (frameCount < 1)
+                    return;
+            }
+
             Graphics g = Graphics.FromImage(bitmap);
             g.PixelOffsetMode = PixelOffsetMode.HighSpeed;
             g.CompositingQuality = CompositingQuality.HighSpeed;
@@ -526,28 +668,10 @@ namespace Kinovea.ScreenManager
         /// </summary>
         private void Paint(Graphics g, Size outputSize, int tile = -1)
         { 
-            float step = (float)framesContainer.Frames.Count / parameters.TileCount;
-            IEnumerable<VideoFrame> frames = framesContainer.Frames.Where((frame, i) => i % step < 1);
-
-            int cols = (int)Math.Ceiling((float)parameters.TileCount / parameters.Rows);
-            Size cropSize = GetCropSize();
-            Size fullSize = new Size(cropSize.Width * cols, cropSize.Height * parameters.Rows);
-
-            Rectangle paintArea = UIHelper.RatioStretch(fullSize, outputSize);
-            Size tileSize = new Size(paintArea.Width / cols, paintArea.Height / parameters.Rows);
-
             if (tile >= 0)
             {
                 // Render a single tile.
-                int index = tile;
-                VideoFrame f = frames.ToList()[index];
-                RectangleF srcRect = new RectangleF(parameters.CropPositions[index].X, parameters.CropPositions[index].Y, cropSize.Width, cropSize.Height);
-                Rectangle destRect = GetDestinationRectangle(index, cols, parameters.Rows, parameters.LeftToRight, paintArea, tileSize);
-                using (SolidBrush b = new SolidBrush(parameters.BorderColor))
-                    g.FillRectangle(b, destRect);
-
-                g.DrawImage(f.Image, destRect, srcRect, GraphicsUnit.Pixel);
-                DrawBorder(g, destRect);
+                PaintTile(g, outputSize, tile, GetTileImage(tile), GetTileImageScale());
             }
             else
             {
@@ -555,20 +679,58 @@ namespace Kinovea.ScreenManager
                 using (SolidBrush backgroundBrush = new SolidBrush(BackgroundColor))
                     g.FillRectangle(backgroundBrush, 0, 0, outputSize.Width, outputSize.Height);
                 
-                int index = 0;
-                foreach (VideoFrame f in frames)
-                {
-                    RectangleF srcRect = new RectangleF(parameters.CropPositions[index].X, parameters.CropPositions[index].Y, cropSize.Width, cropSize.Height);
-                    Rectangle destRect = GetDestinationRectangle(index, cols, parameters.Rows, parameters.LeftToRight, paintArea, tileSize);
+                for (int index = 0; index < tileFrames.Count; index++)
+                    PaintTile(g, outputSize, index, GetTileImage(index), GetTileImageScale());
+            }
+        }
+
+        /// <summary>
+        /// Paint the whole composite from frames decoded at full size, one at a time.
+        /// This is used for image export when the working zone is not cached.
+        /// </summary>
+        private void PaintFullResolution(Graphics g, Size outputSize)
+        {
+            using (SolidBrush backgroundBrush = new SolidBrush(BackgroundColor))
+                g.FillRectangle(backgroundBrush, 0, 0, outputSize.Width, outputSize.Height);
 
-                    using (SolidBrush b = new SolidBrush(parameters.BorderColor))
-                        g.FillRectangle(b, destRect);
+            if (videoReader == null || tileFrames.Count == 0)
+                return;
 
-                    g.DrawImage(f.Image, destRect, srcRect, GraphicsUnit.Pixel);
-                    DrawBorder(g, destRect);
-                    index++;
-                }
-            }
+            Cursor.Current = Cursors.WaitCursor;
+            KinogramTileLoader.Decode(videoReader, GetTileTimestamps(), 1.0f, GetFrameTransform(), (index, image) =>
+            {
+                PaintTile(g, outputSize, index, image, 1.0f);
+                image.Dispose();
+                return true;
+            });
+            Cursor.Current = Cursors.Default;
+        }
+
+        /// <summary>
+        /// Paint one tile. 
+        /// imageScale is the scale of the source image relatively to the frames, crop positions are expressed in the frames.
+        /// A tile whose image is not available yet is painted empty.
+        /// </summary>
+        private void PaintTile(Graphics g, Size outputSize, int index, Bitmap image, float imageScale)
+        {
+            int cols = (int)Math.Ceiling((float)parameters.TileCount / parameters.Rows);
+            Size cropSize = GetCropSize();
+            Size fullSize = new Size(cropSize.Width * cols, cropSize.Height * parameters.Rows);
+
+            Rectangle paintArea = UIHelper.RatioStretch(fullSize, outputSize);
+            Size tileSize = new Size(paintArea.Width / cols, paintArea.Height / parameters.Rows);
+
+            PointF cropPosition = parameters.CropPositions[index];
+            RectangleF srcRect = new RectangleF(cropPosition.X * imageScale, cropPosition.Y * imageScale, cropSize.Width * imageScale, cropSize.Height * imageScale);
+            Rectangle destRect = GetDestinationRectangle(index, cols, parameters.Rows, parameters.LeftToRight, paintArea, tileSize);
+
+            using (SolidBrush b = new SolidBrush(parameters.BorderColor))
+                g.FillRectangle(b, destRect);
+
+            if (image != null)
+                g.DrawImage(image, destRect, srcRect, GraphicsUnit.Pixel);
+
+            DrawBorder(g, destRect);
         }
 
         /// <summary>
@@ -673,7 +835,7 @@ namespace Kinovea.ScreenManager
             int row = (int)(p.Y / tileSize.Height);
             int index = row * cols + col;
 
-            if (index >= framesContainer.Frames.Count)
+            if (index >= frameCount)
                 return -1;
 
             return index;
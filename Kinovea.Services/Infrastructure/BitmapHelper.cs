@@ -12,6 +12,11 @@ namespace Kinovea.Services
 {
     public static class BitmapHelper
     {
+        // One decompressor per thread, created on first use and kept for the lifetime of the thread.
+        // TurboJPEG handles are not thread safe but are cheap to keep around, and the capture threads are long lived.
+        [ThreadStatic]
+        private static IntPtr jpegDecompressor;
+        private static readonly int[] jpegScalingDenominators = new int[] { 8, 4, 2 };
         private static readonly log4net.ILog log = log4net.LogManager.GetLogger(System.Reflection.MethodBase.GetCurrentMethod().DeclaringType);
 
         #region Copy a bitmap into another
@@ -257,33 +262,208 @@ namespace Kinovea.Services
         }
 
         /// <summary>
-        /// Copy the buffer into the bitmap.
-        /// The buffer is assumed JPEG. 
-        /// The Bitmap should be RGB24, already allocated.
-        /// The decoded array should already be allocated and big enough to hold the RGB24 frame bytes.
+        /// Copy an RGB24 buffer into an RGB24 bitmap, reduced by an integer factor.
+        /// The buffer is expected dense, at imageSize. The bitmap must be allocated at imageSize / factor.
+        /// Each destination pixel is the average of the corresponding factor x factor block, computed during the conversion.
+        /// </summary>
+        public static void FillFromRGB24Scaled(Bitmap bitmap, Size imageSize, bool topDown, byte[] buffer, int factor)
+        {
+            FillScaled(bitmap, imageSize, topDown, buffer, 3, factor);
+        }
+
+        /// <summary>
+        /// Copy an RGB32 buffer into an RGB24 bitmap, reduced by an integer factor.
+        /// The buffer is expected dense, at imageSize. The bitmap must be allocated at imageSize / factor.
         /// </summary>
-        public static void FillFromJPEG(Bitmap bitmap, Rectangle rect, byte[] decoded, byte[] buffer, int payloadLength, int pitch)
+        public static void FillFromRGB32Scaled(Bitmap bitmap, Size imageSize, bool topDown, byte[] buffer, int factor)
         {
-            // Convert JPEG to RGB24 buffer then to bitmap.
-            // Assumes the JPEG width is a multiple of 4.
+            FillScaled(bitmap, imageSize, topDown, buffer, 4, factor);
+        }
+
+        /// <summary>
+        /// Copy a Y800 buffer into an RGB24 bitmap, reduced by an integer factor.
+        /// The buffer is expected dense, at imageSize. The bitmap must be allocated at imageSize / factor.
+        /// </summary>
+        public static void FillFromY800Scaled(Bitmap bitmap, Size imageSize, bool topDown, byte[] buffer, int factor)
+        {
+            FillScaled(bitmap, imageSize, topDown, buffer, 1, factor);
+        }
+
+        /// <summary>
+        /// Box filter downscale fused with the conversion to RGB24.
+        /// The source rows are accumulated into a row of sums, so the source is read once, sequentially.
+        /// </summary>
+        private unsafe static void FillScaled(Bitmap bitmap, Size imageSize, bool topDown, byte[] buffer, int srcBytesPerPixel, int factor)
+        {
+            int width = Math.Min(bitmap.Width, imageSize.Width / factor);
+            int height = Math.Min(bitmap.Height, imageSize.Height / factor);
+            if (width <= 0 || height <= 0)
+                return;
+
+            int srcStride = imageSize.Width * srcBytesPerPixel;
+            int channels = srcBytesPerPixel == 1 ? 1 : 3;
+            int area = factor * factor;
+            int[] sums = new int[width * channels];
+
+            Rectangle rect = new Rectangle(0, 0, bitmap.Width, bitmap.Height);
+            BitmapData bmpData = bitmap.LockBits(rect, ImageLockMode.WriteOnly, bitmap.PixelFormat);
+            int dstStride = bmpData.Stride;
+
+            fixed (byte* pBuffer = buffer)
+            fixed (int* pSums = sums)
+            {
+                for (int i = 0; i < height; i++)
+                {
+                    for (int j = 0; j < sums.Length; j++)
+                        pSums[j] = 0;
 
-            IntPtr handle = tjnet.tjInitDecompress();
+                    for (int k = 0; k < factor; k++)
+                    {
+                        byte* src = pBuffer + ((i * factor) + k) * srcStride;
+                        int* sum = pSums;
+
+                        if (channels == 1)
+                        {
+                            for (int j = 0; j < width; j++)
+                            {
+                                for (int m = 0; m < factor; m++)
+                                    *sum += src[m];
+
+                                src += factor;
+                                sum++;
+                            }
+                        }
+                        else
+                        {
+                            for (int j = 0; j < width; j++)
+                            {
+                                for (int m = 0; m < factor; m++)
+                                {
+                                    sum[0] += src[0];
+                                    sum[1] += src[1];
+                                    sum[2] += src[2];
+                                    src += srcBytesPerPixel;
+                                }
+
+                                sum += 3;
+                            }
+                        }
+                    }
+
+                    int row = topDown ? i : height - 1 - i;
+                    byte* dst = (byte*)bmpData.Scan0.ToPointer() + (dstStride * row);
+                    int* s = pSums;
+
+                    if (channels == 1)
+                    {
+                        for (int j = 0; j < width; j++)
+                        {
+                            dst[0] = dst[1] = dst[2] = (byte)(*s / area);
+                            s++;
+                            dst += 3;
+                        }
+                    }
+                    else
+                    {
+                        for (int j = 0; j < width; j++)
+                        {
+                            dst[0] = (byte)(s[0] / area);
+                            dst[1] = (byte)(s[1] / area);
+                            dst[2] = (byte)(s[2] / area);
+                            s += 3;
+                            dst += 3;
+                        }
+                    }
+                }
+            }
+
+            bitmap.UnlockBits(bmpData);
+        }
+
+        /// <summary>
+        /// Decode the buffer into the bitmap.
+        /// The buffer is assumed JPEG.
+        /// The Bitmap should be RGB24 or RGB32, already allocated, either at the size of the JPEG image
+        /// or at one of its scaled down sizes as returned by GetJPEGScaledSize. In the latter case the image is
+        /// decoded directly at the reduced size by the scaled IDCT.
+        /// </summary>
+        public static void FillFromJPEG(Bitmap bitmap, byte[] buffer, int payloadLength)
+        {
+            IntPtr handle = GetJPEGDecompressor();
+            if (handle == IntPtr.Zero)
+                return;
+
+            TJPF pixelFormat;
+            if (bitmap.PixelFormat == PixelFormat.Format24bppRgb)
+                pixelFormat = TJPF.TJPF_BGR;
+            else if (bitmap.PixelFormat == PixelFormat.Format32bppRgb || bitmap.PixelFormat == PixelFormat.Format32bppArgb)
+                pixelFormat = TJPF.TJPF_BGRX;
+            else
+                return;
+
+            // Decode straight into the bitmap memory, using its actual stride.
+            Rectangle rect = new Rectangle(0, 0, bitmap.Width, bitmap.Height);
+            BitmapData bmpData = bitmap.LockBits(rect, ImageLockMode.WriteOnly, bitmap.PixelFormat);
+            int result = NativeMethods.tjDecompress2(handle, buffer, (uint)payloadLength, bmpData.Scan0, bitmap.Width, bmpData.Stride, bitmap.Height, (int)pixelFormat, (int)TJFLAG.TJFLAG_FASTDCT);
+            bitmap.UnlockBits(bmpData);
+
+            if (result != 0)
+                log.DebugFormat("Error while decoding JPEG frame.");
+        }
+
+        /// <summary>
+        /// Read the size of the image from the JPEG header.
+        /// Returns false if the header could not be parsed.
+        /// </summary>
+        public static bool GetJPEGSize(byte[] buffer, int payloadLength, out Size size)
+        {
+            size = Size.Empty;
+            IntPtr handle = GetJPEGDecompressor();
+            if (handle == IntPtr.Zero)
+                return false;
 
-            uint jpegSize = (uint)payloadLength;
             int width;
             int height;
             TJSAMP jpegSubsamp;
-            tjnet.tjDecompressHeader2(handle, buffer, jpegSize, out width, out height, out jpegSubsamp);
+            int result = tjnet.tjDecompressHeader2(handle, buffer, (uint)payloadLength, out width, out height, out jpegSubsamp);
+            if (result != 0)
+                return false;
+
+            size = new Size(width, height);
+            return true;
+        }
+
+        /// <summary>
+        /// Returns the smallest size the JPEG image can be decoded at (1/8, 1/4, 1/2 or full scale)
+        /// that still covers the target size. Decoding at a reduced scale skips most of the IDCT work.
+        /// </summary>
+        public static Size GetJPEGScaledSize(Size imageSize, Size targetSize)
+        {
+            foreach (int denominator in jpegScalingDenominators)
+            {
+                // Same rounding as TJSCALED.
+                int width = (imageSize.Width + denominator - 1) / denominator;
+                int height = (imageSize.Height + denominator - 1) / denominator;
+                if (width >= targetSize.Width && height >= targetSize.Height)
+                    return new Size(width, height);
+            }
 
-            tjnet.tjDecompress2(handle, buffer, jpegSize, decoded, width, pitch, height, TJPF.TJPF_BGR, TJFLAG.TJFLAG_FASTDCT);
+            return imageSize;
+        }
 
-            tjnet.tjDestroy(handle);
+        /// <summary>
+        /// Returns the decompressor of the calling thread, creating it if needed.
+        /// </summary>
+        private static IntPtr GetJPEGDecompressor()
+        {
+            if (jpegDecompressor == IntPtr.Zero)
+            {
+                jpegDecompressor = tjnet.tjInitDecompress();
+                if (jpegDecompressor == IntPtr.Zero)
+                    log.ErrorFormat("Could not initialize the JPEG decompressor.");
+            }
 
-            // Encapsulate into bitmap.
-            // Fixme: do we need the copy here? What about getting an IntPtr from tjnet and setting it to scan0?
-            BitmapData bmpData = bitmap.LockBits(rect, ImageLockMode.ReadWrite, bitmap.PixelFormat);
-            Marshal.Copy(decoded, 0, bmpData.Scan0, bmpData.Stride * bitmap.Height);
-            bitmap.UnlockBits(bmpData);
+            return jpegDecompressor;
         }
 
         #endregion
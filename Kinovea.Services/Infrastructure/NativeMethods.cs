@@ -10,5 +10,12 @@ namespace Kinovea.Services
     {
         [DllImport("msvcrt.dll", EntryPoint = "memcpy", CallingConvention = CallingConvention.Cdecl, SetLastError = false)]
         public static unsafe extern int memcpy(void* dest, void* src, int count);
+
+        /// <summary>
+        /// Overload of TurboJPEG decompression writing to unmanaged memory, typically the Scan0 of a locked Bitmap.
+        /// The TurboJpegNet binding only exposes a managed destination array.
+        /// </summary>
+        [DllImport("turbojpeg.dll", EntryPoint = "tjDecompress2", CallingConvention = CallingConvention.Cdecl)]
+        public static extern int tjDecompress2(IntPtr handle, byte[] jpegBuf, uint jpegSize, IntPtr dstBuf, int width, int pitch, int height, int pixelFormat, int flags);
     }
 }
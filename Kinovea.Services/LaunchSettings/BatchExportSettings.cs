@@ -0,0 +1,73 @@
+﻿#region License
+/*
+Copyright © Joan Charmant 2021.
+jcharmant@gmail.com
+
+This file is part of Kinovea.
+
+Kinovea is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2
+as published by the Free Software Foundation.
+
+Kinovea is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Kinovea. If not, see http://www.gnu.org/licenses/.
+
+*/
+#endregion
+using System;
+
+namespace Kinovea.Services
+{
+    /// <summary>
+    /// Configuration of a batch export run from the command line.
+    /// When present the program exports the files and exits without showing the user interface.
+    /// </summary>
+    public class BatchExportSettings
+    {
+        /// <summary>
+        /// Input videos: a file, a folder or a file pattern with wildcards.
+        /// The annotations are read from the side-car KVA file of each video.
+        /// </summary>
+        public string Input { get; set; }
+
+        /// <summary>
+        /// Folder where the exported files are written. Empty to write them next to the videos.
+        /// </summary>
+        public string OutputFolder { get; set; }
+
+        /// <summary>
+        /// Whether to export the annotated video.
+        /// </summary>
+        public bool ExportVideo { get; set; }
+
+        /// <summary>
+        /// Whether to export the measurements to CSV.
+        /// </summary>
+        public bool ExportCSV { get; set; }
+
+        /// <summary>
+        /// Maximum number of files exported at the same time. 0 for automatic.
+        /// </summary>
+        public int MaxJobs { get; set; }
+
+        /// <summary>
+        /// Memory budget for the frames of all the running exports, in megabytes. 0 for automatic.
+        /// </summary>
+        public int MemoryBudget { get; set; }
+
+        public BatchExportSettings()
+        {
+            Input = "";
+            OutputFolder = "";
+            ExportVideo = true;
+            ExportCSV = false;
+            MaxJobs = 0;
+            MemoryBudget = 0;
+        }
+    }
+}
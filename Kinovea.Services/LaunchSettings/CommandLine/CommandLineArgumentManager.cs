@@ -64,6 +64,11 @@ namespace Kinovea.Services
             options.Add("-workspace", "");
             options.Add("-video", "");
             options.Add("-speed", "100");
+            options.Add("-batch", "");
+            options.Add("-output", "");
+            options.Add("-export", "video");
+            options.Add("-jobs", "0");
+            options.Add("-memory", "0");
             CommandLineArgumentParser.DefineOptionalParameter(options);
 
             // Note: it doesn't make sense to define flags that default to true.
@@ -130,6 +135,7 @@ namespace Kinovea.Services
                     string video = CommandLineArgumentParser.GetParamValue("-video");
                     string speed = CommandLineArgumentParser.GetParamValue("-speed");
                     bool stretch = CommandLineArgumentParser.IsSwitchOn("-stretch");
+                    string batch = CommandLineArgumentParser.GetParamValue("-batch");
 
                     // General program state.
                     if (!string.IsNullOrEmpty(name))
@@ -137,8 +143,12 @@ namespace Kinovea.Services
 
                     LaunchSettingsManager.ShowExplorer = !hideExplorer;
 
-                    // Workspace.
-                    if (!string.IsNullOrEmpty(workspace))
+                    if (!string.IsNullOrEmpty(batch))
+                    {
+                        // Headless export, the screens are not loaded.
+                        LaunchSettingsManager.BatchExport = ParseBatchExport(batch);
+                    }
+                    else if (!string.IsNullOrEmpty(workspace))
                     {
                         Workspace w = new Workspace();
                         bool loaded = w.Load(workspace);
@@ -179,6 +189,28 @@ namespace Kinovea.Services
                 PrintUsage();
             }
         }
+        private static BatchExportSettings ParseBatchExport(string input)
+        {
+            BatchExportSettings settings = new BatchExportSettings();
+            settings.Input = input;
+            settings.OutputFolder = CommandLineArgumentParser.GetParamValue("-output");
+
+            string export = CommandLineArgumentParser.GetParamValue("-export").ToLower();
+            settings.ExportVideo = export == "video" || export == "all";
+            settings.ExportCSV = export == "csv" || export == "all";
+            if (!settings.ExportVideo && !settings.ExportCSV)
+                throw new CommandLineArgumentException(string.Format("Unknown export type: {0}.", export));
+
+            int jobs;
+            if (int.TryParse(CommandLineArgumentParser.GetParamValue("-jobs"), NumberStyles.Any, CultureInfo.InvariantCulture, out jobs))
+                settings.MaxJobs = Math.Max(0, jobs);
+
+            int memory;
+            if (int.TryParse(CommandLineArgumentParser.GetParamValue("-memory"), NumberStyles.Any, CultureInfo.InvariantCulture, out memory))
+                settings.MemoryBudget = Math.Max(0, memory);
+
+            return settings;
+        }
         private static void PrintUsage()
         {
             AttachConsole(-1);
@@ -187,6 +219,8 @@ namespace Kinovea.Services
             Console.WriteLine("USAGE:");
             Console.WriteLine("kinovea.exe");
             Console.WriteLine("    [-name <string>] [-hideExplorer] [-workspace <path>] [-video <path>] [-speed <0-200>] [-stretch]");
+            Console.WriteLine("kinovea.exe");
+            Console.WriteLine("    -batch <path> [-output <path>] [-export <video|csv|all>] [-jobs <count>] [-memory <MB>]");
             Console.WriteLine();
             Console.WriteLine("OPTIONS:");
             Console.WriteLine("  -name: name of this instance of Kinovea. Used in the window title and to select a preference file.");
@@ -195,11 +229,17 @@ namespace Kinovea.Services
             Console.WriteLine("  -video: path to a video to load.");
             Console.WriteLine("  -speed: playback speed to play the video at, as a percentage of its original framerate. Default: 100.");
             Console.WriteLine("  -stretch: the video will be expanded to fit the screen size. Default: false.");
+            Console.WriteLine("  -batch: video file, folder or file pattern to export with their side-car KVA, without starting the user interface.");
+            Console.WriteLine("  -output: folder where the batch exported files are written. Default: next to the videos.");
+            Console.WriteLine("  -export: what to export in batch mode, the annotated video, the measurements in CSV, or both. Default: video.");
+            Console.WriteLine("  -jobs: maximum number of files exported at the same time. Default: half the number of processors.");
+            Console.WriteLine("  -memory: memory budget in megabytes shared by the concurrent exports. Default: based on the physical memory.");
             Console.WriteLine();
             Console.WriteLine("EXAMPLES:");
             Console.WriteLine("1. > kinovea.exe -name Replay -workspace myReplayWorkspace.xml");
             Console.WriteLine("2. > kinovea.exe -video test.mkv -stretch");
             Console.WriteLine("3. > kinovea.exe -video test.mkv -speed 50");
+            Console.WriteLine("4. > kinovea.exe -batch \"D:\\Sessions\\*.mp4\" -output D:\\Export -export all -jobs 4");
         }
     }
 }
@@ -36,6 +36,11 @@ namespace Kinovea.Services
 
         public static string Name { get; set; }
 
+        /// <summary>
+        /// Batch export to run instead of launching the user interface, or null.
+        /// </summary>
+        public static BatchExportSettings BatchExport { get; set; }
+
         public static void ClearScreenDescriptions()
         {
             ScreenDescriptions.Clear();
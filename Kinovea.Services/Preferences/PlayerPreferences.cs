@@ -106,6 +106,16 @@ namespace Kinovea.Services
             get { return workingZoneMemory; }
             set { workingZoneMemory = value; }
         }
+        public int PreBufferBehind
+        {
+            get { return preBufferBehind; }
+            set { preBufferBehind = value; }
+        }
+        public int PreBufferAhead
+        {
+            get { return preBufferAhead; }
+            set { preBufferAhead = value; }
+        }
         public bool SyncLockSpeed
         {
             get { return syncLockSpeed;}
@@ -214,6 +224,8 @@ namespace Kinovea.Services
         private bool deinterlaceByDefault;
         private bool interactiveFrameTracker = true;
         private int workingZoneMemory = 768;
+        private int preBufferBehind = 8;
+        private int preBufferAhead = 16;
         private InfosFading defaultFading = new InfosFading();
         private Color backgroundColor = Color.FromArgb(0, 255, 255, 255);
         private Color defaultBackgroundColor = Color.FromArgb(0, 255, 255, 255);
@@ -255,6 +267,8 @@ namespace Kinovea.Services
             writer.WriteElementString("DeinterlaceByDefault", deinterlaceByDefault ? "true" : "false");
             writer.WriteElementString("InteractiveFrameTracker", interactiveFrameTracker ? "true" : "false");
             writer.WriteElementString("WorkingZoneMemory", workingZoneMemory.ToString());
+            writer.WriteElementString("PreBufferBehind", preBufferBehind.ToString());
+            writer.WriteElementString("PreBufferAhead", preBufferAhead.ToString());
             writer.WriteElementString("SyncLockSpeed", syncLockSpeed ? "true" : "false");
             writer.WriteElementString("SyncByMotion", syncByMotion ? "true" : "false");
             writer.WriteElementString("ImageFormat", imageFormat.ToString());
@@ -353,6 +367,12 @@ namespace Kinovea.Services
                     case "WorkingZoneMemory":
                         workingZoneMemory = reader.ReadElementContentAsInt();
                         break;
+                    case "PreBufferBehind":
+                        preBufferBehind = reader.ReadElementContentAsInt();
+                        break;
+                    case "PreBufferAhead":
+                        preBufferAhead = reader.ReadElementContentAsInt();
+                        break;
                     case "SyncLockSpeed":
                         syncLockSpeed = XmlHelper.ParseBoolean(reader.ReadElementContentAsString());
                         break;
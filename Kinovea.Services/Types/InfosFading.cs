@@ -268,6 +268,33 @@ namespace Kinovea.Services
             return Math.Max(baselineOpacity, relativeOpacity);
         }
 
+        /// <summary>
+        /// Computes the range of timestamps outside of which the opacity is zero.
+        /// Returns false if the drawing is visible during the entire video.
+        /// </summary>
+        public bool GetVisibleSpan(out long start, out long end)
+        {
+            InfosFading info = useDefault ? PreferencesManager.PlayerPreferences.DefaultFading : this;
+
+            start = long.MinValue;
+            end = long.MaxValue;
+            if (info.alwaysVisible)
+                return false;
+
+            long fadingTimestamps = info.fadingFrames * averageTimeStampsPerFrame;
+            start = referenceTimestamp - fadingTimestamps;
+            end = referenceTimestamp + ((info.opaqueFrames - 1) * averageTimeStampsPerFrame) + fadingTimestamps;
+            return true;
+        }
+
+        /// <summary>
+        /// Returns the time distance to the closest tracked value beyond which a trackable drawing is no longer visible.
+        /// </summary>
+        public long GetTrackingFadingTimestamps()
+        {
+            return fadingFrames * averageTimeStampsPerFrame;
+        }
+
         public bool IsVisible(long referenceTimestamp, long testTimestamp, int visibleFrames)
         {
             return ComputeOpacityFactor(referenceTimestamp, testTimestamp, (long)visibleFrames) > 0;
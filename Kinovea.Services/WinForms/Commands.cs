@@ -47,7 +47,8 @@ namespace Kinovea.Services
         
         GotoSyncPoint,
         ToggleSyncMerge,
-        AddKeyframe
+        AddKeyframe,
+        SyncOnAudio
     }
 
     public enum PlayerScreenCommands
@@ -172,7 +172,8 @@ namespace Kinovea.Services
                     hk(DualPlayerCommands.GotoNextKeyframe, Keys.Control | Keys.Right),
                     hk(DualPlayerCommands.GotoSyncPoint, Keys.F8),
                     hk(DualPlayerCommands.ToggleSyncMerge, Keys.F9),
-                    hk(DualPlayerCommands.AddKeyframe, Keys.Insert)
+                    hk(DualPlayerCommands.AddKeyframe, Keys.Insert),
+                    hk(DualPlayerCommands.SyncOnAudio, Keys.Shift | Keys.F8)
                     }
                 },
                 { "PlayerScreen", new HotkeyCommand[]{
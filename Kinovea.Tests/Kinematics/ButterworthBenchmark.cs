@@ -0,0 +1,67 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Linq;
+using System.Text;
+using Kinovea.ScreenManager;
+
+namespace Kinovea.Tests.Kinematics
+{
+    /// <summary>
+    /// Measures the latency of the Butterworth cutoff frequency sweep against the number of samples and the number of cutoffs.
+    /// </summary>
+    public class ButterworthBenchmark
+    {
+        private static Random random = new Random();
+
+        public static void Test()
+        {
+            double fs = 240;
+            int[] sampleCounts = new int[] { 100, 1000, 10000, 50000 };
+            int[] cutoffCounts = new int[] { 10, 50, 100, 200 };
+
+            // Warm up the JIT and the thread pool.
+            Run(CreateSamples(1000, fs), fs, 100, 3);
+
+            Console.WriteLine("Samples\tCutoffs\tAverage (ms)");
+            foreach (int sampleCount in sampleCounts)
+            {
+                double[] samples = CreateSamples(sampleCount, fs);
+                foreach (int cutoffCount in cutoffCounts)
+                {
+                    int loops = sampleCount >= 10000 ? 5 : 20;
+                    double average = Run(samples, fs, cutoffCount, loops);
+                    Console.WriteLine("{0}\t{1}\t{2:0.000}", sampleCount, cutoffCount, average);
+                }
+            }
+
+            Console.ReadKey();
+        }
+
+        private static double Run(double[] samples, double fs, int cutoffs, int loops)
+        {
+            ButterworthFilter filter = new ButterworthFilter();
+            int bestCutoffIndex;
+
+            Stopwatch sw = Stopwatch.StartNew();
+            for (int i = 0; i < loops; i++)
+                filter.FilterSamples(samples, fs, cutoffs, out bestCutoffIndex);
+
+            double elapsed = (double)sw.ElapsedTicks / Stopwatch.Frequency;
+            return (elapsed * 1000) / loops;
+        }
+
+        private static double[] CreateSamples(int count, double fs)
+        {
+            // Smooth motion with measurement noise, similar to a tracked coordinate.
+            double[] samples = new double[count];
+            for (int i = 0; i < count; i++)
+            {
+                double t = i / fs;
+                samples[i] = 200 + 100 * Math.Sin(2 * Math.PI * 1.5 * t) + (random.NextDouble() - 0.5) * 2;
+            }
+
+            return samples;
+        }
+    }
+}
@@ -0,0 +1,68 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Drawing;
+using System.Linq;
+using System.Text;
+using Kinovea.ScreenManager;
+using Kinovea.Services;
+
+namespace Kinovea.Tests.Metadata
+{
+    /// <summary>
+    /// Checks that the fading drawings returned by the metadata follow the changes of visibility of the drawings.
+    /// </summary>
+    public class DrawingTimeIndexTester
+    {
+        private static readonly log4net.ILog log = log4net.LogManager.GetLogger(System.Reflection.MethodBase.GetCurrentMethod().DeclaringType);
+        private const long interval = 1000;
+
+        public void Test()
+        {
+            TestAlwaysVisible();
+        }
+
+        private void TestAlwaysVisible()
+        {
+            Kinovea.ScreenManager.Metadata metadata = new Kinovea.ScreenManager.Metadata(null, (timestamp, type, format, symbol) => timestamp.ToString());
+            metadata.AverageTimeStampsPerFrame = interval;
+
+            Keyframe keyframe = new Keyframe(100 * interval, "", metadata, "", Color.White);
+            metadata.AddKeyframe(keyframe);
+            DrawingCrossMark drawing = new DrawingCrossMark(PointF.Empty, keyframe.Position, interval);
+            metadata.AddDrawing(keyframe, drawing);
+
+            // Custom fading: visible for a few frames around the keyframe only.
+            drawing.InfosFading.UseDefault = false;
+            drawing.InfosFading.AlwaysVisible = false;
+            drawing.InfosFading.FadingFrames = 5;
+            drawing.InfosFading.OpaqueFrames = 1;
+            metadata.ModifiedDrawing(keyframe.Id, drawing.Id);
+
+            long inside = keyframe.Position;
+            long outside = keyframe.Position + 1000 * interval;
+            Check("Custom fading, at keyframe", metadata, drawing, inside, true);
+            Check("Custom fading, far from keyframe", metadata, drawing, outside, false);
+
+            // Same changes as the "Always visible" menu.
+            drawing.InfosFading.AlwaysVisible = true;
+            drawing.InfosFading.UseDefault = false;
+            metadata.ModifiedDrawing(keyframe.Id, drawing.Id);
+            Check("Always visible, at keyframe", metadata, drawing, inside, true);
+            Check("Always visible, far from keyframe", metadata, drawing, outside, true);
+
+            // And back to custom fading.
+            drawing.InfosFading.AlwaysVisible = false;
+            metadata.ModifiedDrawing(keyframe.Id, drawing.Id);
+            Check("Back to custom fading, far from keyframe", metadata, drawing, outside, false);
+        }
+
+        private void Check(string name, Kinovea.ScreenManager.Metadata metadata, AbstractDrawing drawing, long timestamp, bool expected)
+        {
+            bool visible = metadata.GetFadingDrawings(timestamp).Contains(drawing);
+            if (visible == expected)
+                log.DebugFormat("{0}: passed.", name);
+            else
+                log.ErrorFormat("{0}: failed. Expected visible:{1}, got:{2}.", name, expected, visible);
+        }
+    }
+}
@@ -0,0 +1,127 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Drawing;
+using System.Drawing.Imaging;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Xml;
+using Kinovea.ScreenManager;
+
+namespace Kinovea.Tests.Metadata
+{
+    /// <summary>
+    /// Checks that the coarse to fine matcher gives the same similarity scores as the exhaustive search,
+    /// so tracks saved in existing KVA files keep tracking with their stored thresholds.
+    /// </summary>
+    public class TrackerTester
+    {
+        private static readonly log4net.ILog log = log4net.LogManager.GetLogger(System.Reflection.MethodBase.GetCurrentMethod().DeclaringType);
+        private const string kvaParameters =
+            "<TrackerParameters>" +
+            "<SimilarityThreshold>0.5</SimilarityThreshold>" +
+            "<TemplateUpdateThreshold>0.8</TemplateUpdateThreshold>" +
+            "<RefinementNeighborhood>1</RefinementNeighborhood>" +
+            "<SearchWindow>160;160</SearchWindow>" +
+            "<BlockWindow>32;32</BlockWindow>" +
+            "</TrackerParameters>";
+
+        public void Test()
+        {
+            TrackerParameters parameters;
+            using (XmlReader r = XmlReader.Create(new StringReader(kvaParameters)))
+            {
+                r.MoveToContent();
+                parameters = TrackerParameters.ReadXml(r, new PointF(1, 1));
+            }
+
+            TestTrack("Small motion", parameters, new Point(5, -3), 0);
+            TestTrack("Large motion", parameters, new Point(37, 29), 0);
+            TestTrack("Large motion with noise", parameters, new Point(-41, 23), 40);
+        }
+
+        private void TestTrack(string name, TrackerParameters parameters, Point motion, int noise)
+        {
+            Random random = new Random(42);
+            Size size = new Size(400, 300);
+            Color[,] texture = CreateTexture(random, size.Width + 100, size.Height + 100);
+
+            Point start = new Point(200, 150);
+            Bitmap reference = CreateFrame(texture, size, Point.Empty, random, 0);
+            Bitmap current = CreateFrame(texture, size, motion, random, noise);
+
+            Rectangle templateBounds = new Rectangle(start.X - parameters.BlockWindow.Width / 2, start.Y - parameters.BlockWindow.Height / 2, parameters.BlockWindow.Width, parameters.BlockWindow.Height);
+            Bitmap template = reference.Clone(templateBounds, reference.PixelFormat);
+            TrackFrame frame = new TrackFrame(0, start, template, PositionningSource.Manual);
+
+            TrackResult exhaustive = Tracker.Track(parameters.SearchWindow, frame, current);
+            TrackResult pyramid;
+            using (PyramidMatcher matcher = new PyramidMatcher())
+                pyramid = Tracker.Track(parameters.SearchWindow, frame, current, matcher);
+
+            Point expected = new Point(start.X + motion.X, start.Y + motion.Y);
+            bool passed =
+                pyramid.Location == expected &&
+                exhaustive.Location == expected &&
+                pyramid.Similarity >= parameters.SimilarityThreshold &&
+                Math.Abs(pyramid.Similarity - exhaustive.Similarity) < 0.001 &&
+                (pyramid.Similarity < parameters.TemplateUpdateThreshold) == (exhaustive.Similarity < parameters.TemplateUpdateThreshold);
+
+            if (passed)
+                log.DebugFormat("{0}: passed. Similarity:{1:0.000}.", name, pyramid.Similarity);
+            else
+                log.ErrorFormat("{0}: failed. Expected {1}, exhaustive: {2} ({3:0.000}), pyramid: {4} ({5:0.000}).",
+                    name, expected, exhaustive.Location, exhaustive.Similarity, pyramid.Location, pyramid.Similarity);
+
+            template.Dispose();
+            reference.Dispose();
+            current.Dispose();
+        }
+
+        /// <summary>
+        /// Random coloured blocks, large enough for the template to carry structure at the coarse levels.
+        /// </summary>
+        private Color[,] CreateTexture(Random random, int width, int height)
+        {
+            const int block = 6;
+            Color[,] texture = new Color[width, height];
+            for (int y = 0; y < height; y += block)
+            {
+                for (int x = 0; x < width; x += block)
+                {
+                    Color color = Color.FromArgb(random.Next(256), random.Next(256), random.Next(256));
+                    for (int j = y; j < Math.Min(y + block, height); j++)
+                        for (int i = x; i < Math.Min(x + block, width); i++)
+                            texture[i, j] = color;
+                }
+            }
+
+            return texture;
+        }
+
+        private Bitmap CreateFrame(Color[,] texture, Size size, Point motion, Random random, int noise)
+        {
+            // The content moves by the motion vector, so we read the texture at the opposite offset.
+            Bitmap bitmap = new Bitmap(size.Width, size.Height, PixelFormat.Format32bppPArgb);
+            int margin = 50;
+            for (int y = 0; y < size.Height; y++)
+            {
+                for (int x = 0; x < size.Width; x++)
+                {
+                    Color c = texture[x - motion.X + margin, y - motion.Y + margin];
+                    if (noise > 0)
+                        c = Color.FromArgb(Clamp(c.R + random.Next(-noise, noise)), Clamp(c.G + random.Next(-noise, noise)), Clamp(c.B + random.Next(-noise, noise)));
+
+                    bitmap.SetPixel(x, y, c);
+                }
+            }
+
+            return bitmap;
+        }
+
+        private int Clamp(int value)
+        {
+            return Math.Max(0, Math.Min(255, value));
+        }
+    }
+}
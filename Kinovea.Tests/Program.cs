@@ -4,6 +4,7 @@ using System.Linq;
 using System.Text;
 using Kinovea.Tests.Metadata;
 using Kinovea.Tests.HistoryStackTester;
+using Kinovea.Tests.Kinematics;
 using System.Threading;
 
 namespace Kinovea.Tests
@@ -16,11 +17,14 @@ namespace Kinovea.Tests
             //TestKSVFuzzer();
             //TestHistoryStack();
             //TestLineClipping();
+            //TestDrawingTimeIndex();
+            //TestTracker();
 
             TestTime();
 
             // Performance
             //ImageCopy.Test();
+            //ButterworthBenchmark.Test();
         }
         private static void TestKVAFuzzer()
         {
@@ -58,6 +62,18 @@ namespace Kinovea.Tests
             tester.Test();
         }
 
+        private static void TestDrawingTimeIndex()
+        {
+            DrawingTimeIndexTester tester = new DrawingTimeIndexTester();
+            tester.Test();
+        }
+
+        private static void TestTracker()
+        {
+            TrackerTester tester = new TrackerTester();
+            tester.Test();
+        }
+
         private static void TestTime()
         {
             //TimeTester tester = new TimeTester();
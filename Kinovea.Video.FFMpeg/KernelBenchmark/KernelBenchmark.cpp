@@ -0,0 +1,158 @@
+#pragma region License
+/*
+Copyright  Joan Charmant 2021.
+jcharmant@gmail.com
+
+This file is part of Kinovea.
+
+Kinovea is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2
+as published by the Free Software Foundation.
+
+Kinovea is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Kinovea. If not, see http://www.gnu.org/licenses/.
+
+*/
+#pragma endregion
+
+
+//---------------------------------------------------------------------------------------------------------------
+// Benchmark of the native image kernels.
+//
+// Usage: KernelBenchmark [width height] [iterations]
+//
+// Times each kernel on a synthetic image, 1920x1080 by default, at every level supported by the CPU.
+// Prints the median time per image and the throughput in megabytes of source data per second.
+// Run the Release build, the Debug build is not optimized.
+//---------------------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "Kernels.h"
+
+namespace
+{
+    int width = 1920;
+    int height = 1080;
+    int iterations = 50;
+
+    std::vector<uint8_t> gray;
+    std::vector<uint8_t> bgr24;
+    std::vector<uint8_t> bgra;
+    std::vector<uint8_t> yuv;
+    std::vector<uint8_t> dst;
+    std::vector<uint8_t> dstYUV;
+
+    void Fill(std::vector<uint8_t>& buffer, size_t size)
+    {
+        uint32_t seed = 1;
+        buffer.resize(size);
+        for (size_t i = 0; i < size; i++)
+        {
+            seed = seed * 1664525 + 1013904223;
+            buffer[i] = (uint8_t)(seed >> 24);
+        }
+    }
+
+    // Runs the kernel a number of times and prints the median duration.
+    template<typename Kernel>
+    void Measure(const char* name, size_t sourceBytes, Kernel kernel)
+    {
+        std::vector<double> durations;
+        kernel();
+        for (int i = 0; i < iterations; i++)
+        {
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            kernel();
+            std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+            durations.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+
+        std::sort(durations.begin(), durations.end());
+        double median = durations[durations.size() / 2];
+        double throughput = median > 0 ? (sourceBytes / (1024.0 * 1024.0)) / (median / 1000.0) : 0;
+        printf("  %-22s %8.3f ms %10.1f MB/s\n", name, median, throughput);
+    }
+
+    void Run()
+    {
+        int w = width;
+        int h = height;
+        size_t pixels = (size_t)w * h;
+        int chromaWidth = (w + 1) / 2;
+        size_t chromaSize = (size_t)chromaWidth * ((h + 1) / 2);
+        uint8_t* y = &yuv[0];
+        uint8_t* u = y + pixels;
+        uint8_t* v = u + chromaSize;
+        uint8_t* dy = &dstYUV[0];
+        uint8_t* du = dy + pixels;
+        uint8_t* dv = du + chromaSize;
+        uint8_t* out = &dst[0];
+
+        Measure("copy bgra", pixels * 4, [&]() { ik_copy(&bgra[0], w * 4, out, w * 4, w, h, 4); });
+        Measure("bgr24 to bgra", pixels * 3, [&]() { ik_bgr24_to_bgra(&bgr24[0], w * 3, out, w * 4, w, h); });
+        Measure("bgra to bgr24", pixels * 4, [&]() { ik_bgra_to_bgr24(&bgra[0], w * 4, out, w * 3, w, h); });
+        Measure("gray to bgra", pixels, [&]() { ik_gray_to_bgra(&gray[0], w, out, w * 4, w, h); });
+        Measure("gray to bgr24", pixels, [&]() { ik_gray_to_bgr24(&gray[0], w, out, w * 3, w, h); });
+        Measure("bgra to gray", pixels * 4, [&]() { ik_bgra_to_gray(&bgra[0], w * 4, out, w, w, h); });
+        Measure("bgr24 to gray", pixels * 3, [&]() { ik_bgr24_to_gray(&bgr24[0], w * 3, out, w, w, h); });
+        Measure("yuv420p to bgra", pixels + chromaSize * 2, [&]() { ik_yuv420p_to_bgra(y, w, u, chromaWidth, v, chromaWidth, out, w * 4, w, h); });
+        Measure("bgra to yuv420p", pixels * 4, [&]() { ik_bgra_to_yuv420p(&bgra[0], w * 4, dy, w, du, chromaWidth, dv, chromaWidth, w, h); });
+        Measure("bgr24 to yuv420p", pixels * 3, [&]() { ik_bgr24_to_yuv420p(&bgr24[0], w * 3, dy, w, du, chromaWidth, dv, chromaWidth, w, h); });
+        Measure("bayer to bgra", pixels, [&]() { ik_bayer_to_bgra(&gray[0], w, out, w * 4, w, h, IK_BAYER_RGGB); });
+        Measure("flip bgra", pixels * 4, [&]() { ik_copy(&bgra[0] + (h - 1) * (size_t)w * 4, -w * 4, out, w * 4, w, h, 4); });
+        Measure("mirror bgra", pixels * 4, [&]() { ik_rotate_flip(&bgra[0], w * 4, out, w * 4, w, h, 4, IK_ROTATE_NONE, 1); });
+        Measure("rotate 90 bgra", pixels * 4, [&]() { ik_rotate_flip(&bgra[0], w * 4, out, h * 4, w, h, 4, IK_ROTATE_90, 0); });
+        Measure("rotate 180 bgra", pixels * 4, [&]() { ik_rotate_flip(&bgra[0], w * 4, out, w * 4, w, h, 4, IK_ROTATE_180, 0); });
+        Measure("rotate 270 bgr24", pixels * 3, [&]() { ik_rotate_flip(&bgr24[0], w * 3, out, h * 3, w, h, 3, IK_ROTATE_270, 0); });
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc >= 3)
+    {
+        width = atoi(argv[1]);
+        height = atoi(argv[2]);
+    }
+
+    if (argc >= 4)
+        iterations = atoi(argv[3]);
+
+    if (width <= 0 || height <= 0 || iterations <= 0)
+    {
+        printf("Usage: KernelBenchmark [width height] [iterations]\n");
+        return 1;
+    }
+
+    size_t pixels = (size_t)width * height;
+    size_t yuvSize = pixels + 2 * (size_t)((width + 1) / 2) * ((height + 1) / 2);
+    Fill(gray, pixels);
+    Fill(bgr24, pixels * 3);
+    Fill(bgra, pixels * 4);
+    Fill(yuv, yuvSize);
+    dst.resize(pixels * 4);
+    dstYUV.resize(yuvSize);
+
+    ik_level supported = ik_detect_level();
+    printf("Image kernels version %d, %dx%d, %d iterations, supported level: %s.\n", ik_version(), width, height, iterations, ik_level_name(supported));
+
+    for (int level = IK_LEVEL_SCALAR; level <= supported; level++)
+    {
+        ik_set_level((ik_level)level);
+        printf("\n%s\n", ik_level_name(ik_get_level()));
+        Run();
+    }
+
+    return 0;
+}
@@ -0,0 +1,572 @@
+#pragma region License
+/*
+Copyright  Joan Charmant 2021.
+jcharmant@gmail.com
+
+This file is part of Kinovea.
+
+Kinovea is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2
+as published by the Free Software Foundation.
+
+Kinovea is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Kinovea. If not, see http://www.gnu.org/licenses/.
+
+*/
+#pragma endregion
+
+//---------------------------------------------------------------------------------------------------------------
+// Tests of the native image kernels.
+//
+// Usage: KernelTests [golden folder] [--update]
+//
+// Three kinds of tests, run at every level supported by the CPU:
+// - Golden images: each kernel converts a synthetic image and the result must match the reference file byte for byte.
+//   The references are PGM, PPM and PAM images that can be opened in an image viewer, and raw I420 for YUV.
+//   --update regenerates them from the scalar level, after a deliberate change of the formulas.
+// - Known values: a few colors checked against the BT.601 tables.
+// - Consistency: odd sizes, padded and negative strides, and a reference rotation written independently.
+//
+// Runs headless, the exit code is the number of failures.
+// On failure the actual image is written next to the executable for inspection.
+//---------------------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "Kernels.h"
+
+namespace
+{
+    const int GoldenWidth = 37;
+    const int GoldenHeight = 23;
+
+    struct Image
+    {
+        int width;
+        int height;
+        int channels;
+        std::vector<uint8_t> data;
+
+        Image() : width(0), height(0), channels(0) {}
+        Image(int width, int height, int channels) : width(width), height(height), channels(channels), data((size_t)width * height * channels) {}
+
+        int Stride() const { return width * channels; }
+        uint8_t* Row(int y) { return &data[0] + (size_t)y * Stride(); }
+        const uint8_t* Row(int y) const { return &data[0] + (size_t)y * Stride(); }
+    };
+
+    // Planes of a YUV420P image, stored one after the other like I420.
+    struct YUVImage
+    {
+        int width;
+        int height;
+        Image y;
+        Image u;
+        Image v;
+
+        YUVImage(int width, int height)
+            : width(width), height(height), y(width, height, 1), u((width + 1) / 2, (height + 1) / 2, 1), v((width + 1) / 2, (height + 1) / 2, 1) {}
+
+        std::vector<uint8_t> Bytes() const
+        {
+            std::vector<uint8_t> bytes(y.data);
+            bytes.insert(bytes.end(), u.data.begin(), u.data.end());
+            bytes.insert(bytes.end(), v.data.begin(), v.data.end());
+            return bytes;
+        }
+    };
+
+    std::string goldenFolder = "Golden";
+    bool update = false;
+    int failures = 0;
+    int passed = 0;
+    uint32_t seed = 1;
+
+    uint8_t Random()
+    {
+        seed = seed * 1664525 + 1013904223;
+        return (uint8_t)(seed >> 24);
+    }
+
+    //-----------------------------------------------------------------------------------------------------------
+    // Synthetic images: gradients to see the orientation and the colors in the references, plus noise to cover all values.
+    //-----------------------------------------------------------------------------------------------------------
+    Image MakeColor(int width, int height, int channels, uint32_t start)
+    {
+        seed = start;
+        Image image(width, height, channels);
+        for (int y = 0; y < height; y++)
+        {
+            uint8_t* p = image.Row(y);
+            for (int x = 0; x < width; x++, p += channels)
+            {
+                p[0] = (uint8_t)(width > 1 ? x * 255 / (width - 1) : 0);
+                p[1] = (uint8_t)(height > 1 ? y * 255 / (height - 1) : 0);
+                p[2] = (uint8_t)((x + y) % 8 == 0 ? 255 : Random());
+                if (channels == 4)
+                    p[3] = Random();
+            }
+        }
+
+        return image;
+    }
+
+    Image MakeGray(int width, int height, uint32_t start)
+    {
+        seed = start;
+        Image image(width, height, 1);
+        for (int y = 0; y < height; y++)
+        {
+            uint8_t* p = image.Row(y);
+            for (int x = 0; x < width; x++)
+                p[x] = (uint8_t)((x * 7 + y * 3) % 256 ^ (Random() & 0x0F));
+        }
+
+        return image;
+    }
+
+    YUVImage MakeYUV(int width, int height, uint32_t start)
+    {
+        // Chroma over the full range, including the values that make the conversion saturate.
+        YUVImage image(width, height);
+        image.y = MakeGray(width, height, start);
+        for (size_t i = 0; i < image.u.data.size(); i++)
+        {
+            image.u.data[i] = Random();
+            image.v.data[i] = Random();
+        }
+
+        return image;
+    }
+
+    //-----------------------------------------------------------------------------------------------------------
+    // Golden files.
+    //-----------------------------------------------------------------------------------------------------------
+    bool WriteFile(const std::string& path, const std::string& header, const std::vector<uint8_t>& bytes)
+    {
+        FILE* file = fopen(path.c_str(), "wb");
+        if (file == nullptr)
+            return false;
+
+        fwrite(header.data(), 1, header.size(), file);
+        fwrite(bytes.data(), 1, bytes.size(), file);
+        fclose(file);
+        return true;
+    }
+
+    bool ReadFile(const std::string& path, std::vector<uint8_t>& bytes)
+    {
+        FILE* file = fopen(path.c_str(), "rb");
+        if (file == nullptr)
+            return false;
+
+        bytes.clear();
+        uint8_t buffer[4096];
+        size_t read;
+        while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+            bytes.insert(bytes.end(), buffer, buffer + read);
+
+        fclose(file);
+        return true;
+    }
+
+    // PNM header for gray, BGR24 or BGRA images. The files store the channels in RGB order.
+    std::string PNMHeader(const Image& image)
+    {
+        char header[128];
+        if (image.channels == 4)
+            sprintf(header, "P7\nWIDTH %d\nHEIGHT %d\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n", image.width, image.height);
+        else
+            sprintf(header, "P%d\n%d %d\n255\n", image.channels == 1 ? 5 : 6, image.width, image.height);
+
+        return header;
+    }
+
+    std::string Extension(int channels)
+    {
+        return channels == 1 ? ".pgm" : (channels == 3 ? ".ppm" : ".pam");
+    }
+
+    std::vector<uint8_t> PNMBytes(const Image& image)
+    {
+        std::vector<uint8_t> bytes(image.data);
+        if (image.channels > 1)
+        {
+            for (size_t i = 0; i < bytes.size(); i += image.channels)
+            {
+                uint8_t blue = bytes[i];
+                bytes[i] = bytes[i + 2];
+                bytes[i + 2] = blue;
+            }
+        }
+
+        return bytes;
+    }
+
+    void Report(bool success, const std::string& name)
+    {
+        if (success)
+        {
+            passed++;
+            return;
+        }
+
+        failures++;
+        printf("[FAIL] %s (%s)\n", name.c_str(), ik_level_name(ik_get_level()));
+    }
+
+    void CheckGolden(const std::string& name, const std::string& extension, const std::string& header, const std::vector<uint8_t>& actual)
+    {
+        std::string path = goldenFolder + "/" + name + extension;
+        if (update)
+        {
+            if (!WriteFile(path, header, actual))
+                printf("Could not write %s\n", path.c_str());
+
+            return;
+        }
+
+        std::vector<uint8_t> expected;
+        bool success = ReadFile(path, expected) &&
+            expected.size() == header.size() + actual.size() &&
+            memcmp(&expected[0], header.data(), header.size()) == 0 &&
+            memcmp(&expected[header.size()], actual.data(), actual.size()) == 0;
+
+        if (!success)
+            WriteFile(name + "." + ik_level_name(ik_get_level()) + ".actual" + extension, header, actual);
+
+        Report(success, "golden " + name);
+    }
+
+    void CheckGolden(const std::string& name, const Image& actual)
+    {
+        CheckGolden(name, Extension(actual.channels), PNMHeader(actual), PNMBytes(actual));
+    }
+
+    void CheckGolden(const std::string& name, const YUVImage& actual)
+    {
+        CheckGolden(name, ".yuv", "", actual.Bytes());
+    }
+
+    //-----------------------------------------------------------------------------------------------------------
+    // Reference rotation, written from the definition rather than from the kernels.
+    //-----------------------------------------------------------------------------------------------------------
+    Image ReferenceRotateFlip(const Image& src, ik_rotation rotation, bool mirror)
+    {
+        bool swap = rotation == IK_ROTATE_90 || rotation == IK_ROTATE_270;
+        Image dst(swap ? src.height : src.width, swap ? src.width : src.height, src.channels);
+        int w = src.width;
+        int h = src.height;
+
+        for (int y = 0; y < dst.height; y++)
+        {
+            for (int x = 0; x < dst.width; x++)
+            {
+                int rx = mirror ? dst.width - 1 - x : x;
+                int sx;
+                int sy;
+                switch (rotation)
+                {
+                case IK_ROTATE_90: sx = y; sy = h - 1 - rx; break;
+                case IK_ROTATE_180: sx = w - 1 - rx; sy = h - 1 - y; break;
+                case IK_ROTATE_270: sx = w - 1 - y; sy = rx; break;
+                default: sx = rx; sy = y; break;
+                }
+
+                memcpy(dst.Row(y) + x * dst.channels, src.Row(sy) + sx * src.channels, src.channels);
+            }
+        }
+
+        return dst;
+    }
+
+    Image RotateFlip(const Image& src, ik_rotation rotation, bool mirror)
+    {
+        bool swap = rotation == IK_ROTATE_90 || rotation == IK_ROTATE_270;
+        Image dst(swap ? src.height : src.width, swap ? src.width : src.height, src.channels);
+        ik_rotate_flip(&src.data[0], src.Stride(), &dst.data[0], dst.Stride(), src.width, src.height, src.channels, rotation, mirror ? 1 : 0);
+        return dst;
+    }
+
+    const char* RotationName(ik_rotation rotation)
+    {
+        switch (rotation)
+        {
+        case IK_ROTATE_90: return "90";
+        case IK_ROTATE_180: return "180";
+        case IK_ROTATE_270: return "270";
+        default: return "0";
+        }
+    }
+
+    const char* BayerName(ik_bayer pattern)
+    {
+        switch (pattern)
+        {
+        case IK_BAYER_BGGR: return "bggr";
+        case IK_BAYER_GRBG: return "grbg";
+        case IK_BAYER_GBRG: return "gbrg";
+        default: return "rggb";
+        }
+    }
+
+    //-----------------------------------------------------------------------------------------------------------
+    // Conversions through a common signature, for the consistency tests.
+    //-----------------------------------------------------------------------------------------------------------
+    typedef void (*Convert)(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height);
+
+    struct Conversion
+    {
+        const char* name;
+        Convert convert;
+        int srcChannels;
+        int dstChannels;
+    };
+
+    const Conversion conversions[] =
+    {
+        { "bgr24_to_bgra", ik_bgr24_to_bgra, 3, 4 },
+        { "bgra_to_bgr24", ik_bgra_to_bgr24, 4, 3 },
+        { "gray_to_bgra", ik_gray_to_bgra, 1, 4 },
+        { "gray_to_bgr24", ik_gray_to_bgr24, 1, 3 },
+        { "bgra_to_gray", ik_bgra_to_gray, 4, 1 },
+        { "bgr24_to_gray", ik_bgr24_to_gray, 3, 1 },
+    };
+
+    Image Run(const Conversion& conversion, const Image& src)
+    {
+        Image dst(src.width, src.height, conversion.dstChannels);
+        conversion.convert(&src.data[0], src.Stride(), &dst.data[0], dst.Stride(), src.width, src.height);
+        return dst;
+    }
+
+    Image MakeSource(int channels, int width, int height, uint32_t start)
+    {
+        return channels == 1 ? MakeGray(width, height, start) : MakeColor(width, height, channels, start);
+    }
+
+    YUVImage ToYUV(const Image& src)
+    {
+        YUVImage dst(src.width, src.height);
+        if (src.channels == 4)
+            ik_bgra_to_yuv420p(&src.data[0], src.Stride(), &dst.y.data[0], dst.y.Stride(), &dst.u.data[0], dst.u.Stride(), &dst.v.data[0], dst.v.Stride(), src.width, src.height);
+        else
+            ik_bgr24_to_yuv420p(&src.data[0], src.Stride(), &dst.y.data[0], dst.y.Stride(), &dst.u.data[0], dst.u.Stride(), &dst.v.data[0], dst.v.Stride(), src.width, src.height);
+
+        return dst;
+    }
+
+    Image ToBGRA(const YUVImage& src)
+    {
+        Image dst(src.width, src.height, 4);
+        ik_yuv420p_to_bgra(&src.y.data[0], src.y.Stride(), &src.u.data[0], src.u.Stride(), &src.v.data[0], src.v.Stride(), &dst.data[0], dst.Stride(), src.width, src.height);
+        return dst;
+    }
+
+    Image Demosaic(const Image& src, ik_bayer pattern)
+    {
+        Image dst(src.width, src.height, 4);
+        ik_bayer_to_bgra(&src.data[0], src.Stride(), &dst.data[0], dst.Stride(), src.width, src.height, pattern);
+        return dst;
+    }
+
+    //-----------------------------------------------------------------------------------------------------------
+    // Tests.
+    //-----------------------------------------------------------------------------------------------------------
+    void TestGolden()
+    {
+        Image bgra = MakeColor(GoldenWidth, GoldenHeight, 4, 1);
+        Image bgr = MakeColor(GoldenWidth, GoldenHeight, 3, 1);
+        Image gray = MakeGray(GoldenWidth, GoldenHeight, 2);
+
+        if (update)
+        {
+            CheckGolden("source_bgra", bgra);
+            CheckGolden("source_bgr24", bgr);
+            CheckGolden("source_gray", gray);
+        }
+
+        for (size_t i = 0; i < sizeof(conversions) / sizeof(conversions[0]); i++)
+        {
+            const Conversion& conversion = conversions[i];
+            const Image& src = conversion.srcChannels == 4 ? bgra : (conversion.srcChannels == 3 ? bgr : gray);
+            CheckGolden(conversion.name, Run(conversion, src));
+        }
+
+        CheckGolden("yuv420p_to_bgra", ToBGRA(MakeYUV(GoldenWidth, GoldenHeight, 3)));
+        CheckGolden("bgra_to_yuv420p", ToYUV(bgra));
+        CheckGolden("bgr24_to_yuv420p", ToYUV(bgr));
+
+        const ik_bayer patterns[] = { IK_BAYER_RGGB, IK_BAYER_BGGR, IK_BAYER_GRBG, IK_BAYER_GBRG };
+        for (int i = 0; i < 4; i++)
+            CheckGolden(std::string("bayer_") + BayerName(patterns[i]) + "_to_bgra", Demosaic(gray, patterns[i]));
+
+        const ik_rotation rotations[] = { IK_ROTATE_NONE, IK_ROTATE_90, IK_ROTATE_180, IK_ROTATE_270 };
+        for (int i = 0; i < 4; i++)
+        {
+            for (int mirror = 0; mirror < 2; mirror++)
+            {
+                std::string name = std::string("rotate_") + RotationName(rotations[i]) + (mirror ? "_mirror" : "");
+                CheckGolden(name, RotateFlip(bgra, rotations[i], mirror != 0));
+            }
+        }
+    }
+
+    void TestKnownValues()
+    {
+        // Black, white, red, green, blue, in BGRA, and their BT.601 values, within one for the integer approximation.
+        const uint8_t colors[5][4] = { { 0, 0, 0, 255 }, { 255, 255, 255, 255 }, { 0, 0, 255, 255 }, { 0, 255, 0, 255 }, { 255, 0, 0, 255 } };
+        const uint8_t expectedY[5] = { 16, 235, 81, 145, 41 };
+        const uint8_t expectedU[5] = { 128, 128, 90, 54, 240 };
+        const uint8_t expectedV[5] = { 128, 128, 240, 34, 110 };
+        const uint8_t expectedGray[5] = { 0, 255, 77, 149, 29 };
+
+        for (int i = 0; i < 5; i++)
+        {
+            // 2x2 block of the same color.
+            Image block(2, 2, 4);
+            for (int p = 0; p < 4; p++)
+                memcpy(&block.data[p * 4], colors[i], 4);
+
+            YUVImage yuv = ToYUV(block);
+            bool success = abs(yuv.y.data[0] - expectedY[i]) <= 1 && abs(yuv.u.data[0] - expectedU[i]) <= 1 && abs(yuv.v.data[0] - expectedV[i]) <= 1;
+            Report(success, "known values yuv " + std::to_string(i));
+
+            Image gray(2, 2, 1);
+            ik_bgra_to_gray(&block.data[0], block.Stride(), &gray.data[0], gray.Stride(), 2, 2);
+            Report(gray.data[0] == expectedGray[i], "known values gray " + std::to_string(i));
+
+            // Back to BGRA, within the rounding of the limited range.
+            Image back = ToBGRA(yuv);
+            bool close = true;
+            for (int c = 0; c < 3; c++)
+                close &= abs(back.data[c] - colors[i][c]) <= 3;
+
+            Report(close, "known values bgra " + std::to_string(i));
+        }
+    }
+
+    void TestConsistency()
+    {
+        // Sizes around the block sizes of the vectorized rows.
+        const int sizes[][2] = { { 1, 1 }, { 2, 2 }, { 3, 5 }, { 15, 3 }, { 16, 4 }, { 17, 9 }, { 31, 2 }, { 33, 7 }, { 64, 64 }, { 301, 97 } };
+
+        ik_level level = ik_get_level();
+
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+        {
+            int width = sizes[s][0];
+            int height = sizes[s][1];
+            std::string size = std::to_string(width) + "x" + std::to_string(height);
+
+            for (size_t i = 0; i < sizeof(conversions) / sizeof(conversions[0]); i++)
+            {
+                const Conversion& conversion = conversions[i];
+                Image src = MakeSource(conversion.srcChannels, width, height, (uint32_t)(s + 7));
+
+                ik_set_level(IK_LEVEL_SCALAR);
+                Image expected = Run(conversion, src);
+                ik_set_level(level);
+                Image actual = Run(conversion, src);
+                Report(expected.data == actual.data, std::string(conversion.name) + " " + size);
+
+                // Padded source rows, destination written bottom-up.
+                int srcStride = src.Stride() + 13;
+                int dstStride = expected.Stride() + 7;
+                std::vector<uint8_t> padded((size_t)srcStride * height, 0xCD);
+                for (int y = 0; y < height; y++)
+                    memcpy(&padded[(size_t)y * srcStride], src.Row(y), src.Stride());
+
+                std::vector<uint8_t> flipped((size_t)dstStride * height, 0xCD);
+                uint8_t* lastRow = &flipped[(size_t)(height - 1) * dstStride];
+                conversion.convert(&padded[0], srcStride, lastRow, -dstStride, width, height);
+
+                bool success = true;
+                for (int y = 0; y < height; y++)
+                {
+                    const uint8_t* row = &flipped[(size_t)(height - 1 - y) * dstStride];
+                    success &= memcmp(row, expected.Row(y), expected.Stride()) == 0;
+                    success &= row[expected.Stride()] == 0xCD;
+                }
+
+                Report(success, std::string(conversion.name) + " strides " + size);
+            }
+
+            YUVImage yuv = MakeYUV(width, height, (uint32_t)s);
+            Image bgra = MakeColor(width, height, 4, (uint32_t)s);
+            Image bgr = MakeColor(width, height, 3, (uint32_t)s);
+            Image gray = MakeGray(width, height, (uint32_t)s);
+
+            ik_set_level(IK_LEVEL_SCALAR);
+            Image expectedBGRA = ToBGRA(yuv);
+            std::vector<uint8_t> expectedYUV = ToYUV(bgra).Bytes();
+            std::vector<uint8_t> expectedYUV24 = ToYUV(bgr).Bytes();
+            Image expectedBayer = Demosaic(gray, IK_BAYER_GRBG);
+            ik_set_level(level);
+
+            Report(ToBGRA(yuv).data == expectedBGRA.data, "yuv420p_to_bgra " + size);
+            Report(ToYUV(bgra).Bytes() == expectedYUV, "bgra_to_yuv420p " + size);
+            Report(ToYUV(bgr).Bytes() == expectedYUV24, "bgr24_to_yuv420p " + size);
+            Report(Demosaic(gray, IK_BAYER_GRBG).data == expectedBayer.data, "bayer_to_bgra " + size);
+
+            const ik_rotation rotations[] = { IK_ROTATE_NONE, IK_ROTATE_90, IK_ROTATE_180, IK_ROTATE_270 };
+            for (int channels = 1; channels <= 4; channels++)
+            {
+                if (channels == 2)
+                    continue;
+
+                Image src = MakeSource(channels, width, height, (uint32_t)s);
+                for (int r = 0; r < 4; r++)
+                {
+                    for (int mirror = 0; mirror < 2; mirror++)
+                    {
+                        bool success = RotateFlip(src, rotations[r], mirror != 0).data == ReferenceRotateFlip(src, rotations[r], mirror != 0).data;
+                        Report(success, std::string("rotate ") + RotationName(rotations[r]) + (mirror ? " mirror " : " ") + std::to_string(channels) + " " + size);
+                    }
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--update") == 0)
+            update = true;
+        else
+            goldenFolder = argv[i];
+    }
+
+    ik_level supported = ik_detect_level();
+    printf("Image kernels version %d, supported level: %s.\n", ik_version(), ik_level_name(supported));
+
+    if (update)
+    {
+        ik_set_level(IK_LEVEL_SCALAR);
+        TestGolden();
+        printf("Golden images written to %s.\n", goldenFolder.c_str());
+        return 0;
+    }
+
+    for (int level = IK_LEVEL_SCALAR; level <= supported; level++)
+    {
+        ik_set_level((ik_level)level);
+        TestGolden();
+        TestKnownValues();
+        TestConsistency();
+    }
+
+    printf("%d passed, %d failed.\n", passed, failures);
+    return failures;
+}
@@ -0,0 +1,168 @@
+#pragma region License
+/*
+Copyright  Joan Charmant 2021.
+jcharmant@gmail.com
+
+This file is part of Kinovea.
+
+Kinovea is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2
+as published by the Free Software Foundation.
+
+Kinovea is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Kinovea. If not, see http://www.gnu.org/licenses/.
+
+*/
+#pragma endregion
+
+#include "ImageKernels.h"
+
+using namespace System::Diagnostics;
+using namespace System::Runtime::InteropServices;
+
+using namespace Kinovea::Video::FFMpeg;
+
+///<summary>
+/// Copies a dense buffer into an allocated bitmap of the same size, converting the pixel format on the way.
+/// The buffer is flipped vertically if it is bottom-up.
+///</summary>
+void ImageKernels::Fill(Bitmap^ bitmap, array<Byte>^ buffer, Kinovea::Services::ImageFormat format, bool topDown)
+{
+    int dstBpp = BytesPerPixel(bitmap->PixelFormat);
+    if (dstBpp == 0 || buffer == nullptr)
+        return;
+
+    int width = bitmap->Width;
+    int height = bitmap->Height;
+    int srcBpp = 0;
+    switch (format)
+    {
+    case Kinovea::Services::ImageFormat::RGB24: srcBpp = 3; break;
+    case Kinovea::Services::ImageFormat::RGB32: srcBpp = 4; break;
+    case Kinovea::Services::ImageFormat::Y800: srcBpp = 1; break;
+    default:
+        log->ErrorFormat("Unsupported image format for fill: {0}.", format);
+        return;
+    }
+
+    if (buffer->Length < width * height * srcBpp)
+    {
+        log->Error("Buffer too small for the bitmap.");
+        return;
+    }
+
+    System::Drawing::Rectangle rect(0, 0, width, height);
+    BitmapData^ bmpData = bitmap->LockBits(rect, ImageLockMode::WriteOnly, bitmap->PixelFormat);
+    pin_ptr<Byte> pBuffer = &buffer[0];
+
+    const uint8_t* src = pBuffer;
+    int srcStride = width * srcBpp;
+    uint8_t* dst = (uint8_t*)bmpData->Scan0.ToPointer();
+    int dstStride = bmpData->Stride;
+    if (!topDown)
+    {
+        dst += (ptrdiff_t)dstStride * (height - 1);
+        dstStride = -dstStride;
+    }
+
+    if (srcBpp == dstBpp)
+        ik_copy(src, srcStride, dst, dstStride, width, height, srcBpp);
+    else if (srcBpp == 1)
+        (dstBpp == 3 ? ik_gray_to_bgr24 : ik_gray_to_bgra)(src, srcStride, dst, dstStride, width, height);
+    else if (srcBpp == 3)
+        ik_bgr24_to_bgra(src, srcStride, dst, dstStride, width, height);
+    else
+        ik_bgra_to_bgr24(src, srcStride, dst, dstStride, width, height);
+
+    bitmap->UnlockBits(bmpData);
+}
+
+///<summary>
+/// Allocates a new bitmap with the gray levels of the source, in the same pixel format.
+/// The source must be 32 bits per pixel.
+///</summary>
+Bitmap^ ImageKernels::Grayscale(Bitmap^ src)
+{
+    if (BytesPerPixel(src->PixelFormat) != 4)
+        return nullptr;
+
+    int width = src->Width;
+    int height = src->Height;
+    System::Drawing::Rectangle rect(0, 0, width, height);
+    Bitmap^ dst = gcnew Bitmap(width, height, src->PixelFormat);
+
+    BitmapData^ srcData = src->LockBits(rect, ImageLockMode::ReadOnly, src->PixelFormat);
+    BitmapData^ dstData = dst->LockBits(rect, ImageLockMode::WriteOnly, dst->PixelFormat);
+
+    // Convert one row at a time through a gray row to stay in cache.
+    uint8_t* gray = new uint8_t[width];
+    uint8_t* srcRow = (uint8_t*)srcData->Scan0.ToPointer();
+    uint8_t* dstRow = (uint8_t*)dstData->Scan0.ToPointer();
+    for (int y = 0; y < height; y++)
+    {
+        ik_bgra_to_gray(srcRow, srcData->Stride, gray, width, width, 1);
+        ik_gray_to_bgra(gray, width, dstRow, dstData->Stride, width, 1);
+        srcRow += srcData->Stride;
+        dstRow += dstData->Stride;
+    }
+
+    delete[] gray;
+    src->UnlockBits(srcData);
+    dst->UnlockBits(dstData);
+
+    return dst;
+}
+
+///<summary>
+/// Rotates the bitmap clockwise then mirrors it horizontally if requested, like Bitmap::RotateFlip.
+/// Returns a new bitmap, or the source itself if there is nothing to do. The source is not modified.
+///</summary>
+Bitmap^ ImageKernels::RotateFlip(Bitmap^ src, ImageRotation rotation, bool mirror)
+{
+    if (rotation == ImageRotation::Rotate0 && !mirror)
+        return src;
+
+    int bpp = BytesPerPixel(src->PixelFormat);
+    if (bpp == 0)
+    {
+        log->ErrorFormat("Unsupported pixel format for rotation: {0}.", src->PixelFormat);
+        return src;
+    }
+
+    int width = src->Width;
+    int height = src->Height;
+    bool transposed = rotation == ImageRotation::Rotate90 || rotation == ImageRotation::Rotate270;
+    Bitmap^ dst = transposed ? gcnew Bitmap(height, width, src->PixelFormat) : gcnew Bitmap(width, height, src->PixelFormat);
+    dst->SetResolution(src->HorizontalResolution, src->VerticalResolution);
+
+    BitmapData^ srcData = src->LockBits(System::Drawing::Rectangle(0, 0, width, height), ImageLockMode::ReadOnly, src->PixelFormat);
+    BitmapData^ dstData = dst->LockBits(System::Drawing::Rectangle(0, 0, dst->Width, dst->Height), ImageLockMode::WriteOnly, dst->PixelFormat);
+
+    ik_rotate_flip((uint8_t*)srcData->Scan0.ToPointer(), srcData->Stride, (uint8_t*)dstData->Scan0.ToPointer(), dstData->Stride,
+        width, height, bpp, (ik_rotation)rotation, mirror ? 1 : 0);
+
+    src->UnlockBits(srcData);
+    dst->UnlockBits(dstData);
+
+    return dst;
+}
+
+int ImageKernels::BytesPerPixel(PixelFormat format)
+{
+    switch (format)
+    {
+    case PixelFormat::Format24bppRgb:
+        return 3;
+    case PixelFormat::Format32bppRgb:
+    case PixelFormat::Format32bppArgb:
+    case PixelFormat::Format32bppPArgb:
+        return 4;
+    default:
+        return 0;
+    }
+}
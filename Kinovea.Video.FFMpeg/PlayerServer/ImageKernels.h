@@ -0,0 +1,85 @@
+#pragma region License
+/*
+Copyright  Joan Charmant 2021.
+jcharmant@gmail.com
+
+This file is part of Kinovea.
+
+Kinovea is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2
+as published by the Free Software Foundation.
+
+Kinovea is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Kinovea. If not, see http://www.gnu.org/licenses/.
+
+*/
+#pragma endregion
+
+//-----------------------------------------------------------------------------
+// ImageKernels - managed entry point to the native image kernels.
+//
+// Fills, converts and rotates GDI+ bitmaps through the kernels of Kernels.h,
+// in place of the per-pixel loops and of Bitmap::RotateFlip.
+// Supported bitmaps are Format24bppRgb and the 32bpp formats.
+//-----------------------------------------------------------------------------
+
+#pragma once
+
+#include "Kernels.h"
+
+using namespace System;
+using namespace System::Drawing;
+using namespace System::Drawing::Imaging;
+using namespace System::Reflection;
+using namespace Kinovea::Services;
+
+namespace Kinovea { namespace Video { namespace FFMpeg
+{
+    public enum class KernelLevel
+    {
+        Scalar = IK_LEVEL_SCALAR,
+        SSE41 = IK_LEVEL_SSE41,
+        AVX2 = IK_LEVEL_AVX2
+    };
+
+    public ref class ImageKernels abstract sealed
+    {
+    // Public properties
+    public:
+        // Best level supported by the CPU.
+        static property KernelLevel SupportedLevel {
+            KernelLevel get() {
+                return (KernelLevel)ik_detect_level();
+            }
+        }
+
+        // Level used by the kernels. Setting a level above the supported one selects the supported one.
+        static property KernelLevel Level {
+            KernelLevel get() {
+                return (KernelLevel)ik_get_level();
+            }
+            void set(KernelLevel value) {
+                ik_set_level((ik_level)value);
+            }
+        }
+
+    // Public Methods
+    public:
+        static void Fill(Bitmap^ bitmap, array<Byte>^ buffer, Kinovea::Services::ImageFormat format, bool topDown);
+        static Bitmap^ Grayscale(Bitmap^ src);
+        static Bitmap^ RotateFlip(Bitmap^ src, ImageRotation rotation, bool mirror);
+
+    // Private Methods
+    private:
+        static int BytesPerPixel(PixelFormat format);
+
+    // Members
+    private:
+        static log4net::ILog^ log = log4net::LogManager::GetLogger(MethodBase::GetCurrentMethod()->DeclaringType);
+    };
+}}}
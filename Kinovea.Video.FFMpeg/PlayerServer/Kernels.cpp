@@ -0,0 +1,556 @@
+#pragma region License
+/*
+Copyright  Joan Charmant 2021.
+jcharmant@gmail.com
+
+This file is part of Kinovea.
+
+Kinovea is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2
+as published by the Free Software Foundation.
+
+Kinovea is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Kinovea. If not, see http://www.gnu.org/licenses/.
+
+*/
+#pragma endregion
+
+//---------------------------------------------------------------------------------------------------------------
+// Scalar kernels, CPU detection and dispatch.
+// This file is compiled as native code, it must not be compiled with /clr nor with /arch:AVX2.
+//
+// Fixed point formulas, the vectorized versions must compute exactly the same values:
+// - Gray:  (29 B + 150 G + 77 R + 128) >> 8.
+// - Y:     ((25 B + 129 G + 66 R + 128) >> 8) + 16.
+// - U:     ((112 B - 74 G - 38 R + 128) >> 8) + 128, on the rounded average of the 2x2 block.
+// - V:     ((-18 B - 94 G + 112 R + 128) >> 8) + 128, on the rounded average of the 2x2 block.
+// - BGRA from YUV, with C = Y - 16, D = U - 128, E = V - 128, in 6 bits of fraction:
+//          R = (75 C + 102 E + 32) >> 6, G = (75 C - 25 D - 52 E + 32) >> 6, B = (75 C + 129 D + 32) >> 6.
+//          The vectorized versions compute this in saturated 16-bit, it only saturates for values clipped to 255.
+//---------------------------------------------------------------------------------------------------------------
+
+#include <string.h>
+
+#include "Kernels.h"
+#include "KernelsInternal.h"
+
+#ifdef IK_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+using namespace Kinovea::Video::FFMpeg::Kernels;
+
+namespace
+{
+    const int TransposeTile = 32;
+
+    inline uint8_t Clip(int value)
+    {
+        return (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+    }
+
+    //-----------------------------------------------------------------------------------------------------------
+    // Dispatch.
+    //-----------------------------------------------------------------------------------------------------------
+#ifdef IK_X86
+    void CPUID(int info[4], int leaf)
+    {
+#ifdef _MSC_VER
+        __cpuidex(info, leaf, 0);
+#else
+        __cpuid_count(leaf, 0, info[0], info[1], info[2], info[3]);
+#endif
+    }
+
+    uint64_t XGETBV()
+    {
+#ifdef _MSC_VER
+        return _xgetbv(0);
+#else
+        uint32_t eax, edx;
+        __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return ((uint64_t)edx << 32) | eax;
+#endif
+    }
+#endif
+
+    ik_level DetectLevel()
+    {
+#ifdef IK_X86
+        int info[4];
+        CPUID(info, 0);
+        int maxLeaf = info[0];
+        if (maxLeaf < 1)
+            return IK_LEVEL_SCALAR;
+
+        CPUID(info, 1);
+        bool ssse3 = (info[2] & (1 << 9)) != 0;
+        bool sse41 = (info[2] & (1 << 19)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if (!ssse3 || !sse41)
+            return IK_LEVEL_SCALAR;
+
+        // AVX2 also needs the OS to save the YMM registers on context switches.
+        if (maxLeaf >= 7 && osxsave && avx && (XGETBV() & 6) == 6)
+        {
+            CPUID(info, 7);
+            if ((info[1] & (1 << 5)) != 0)
+                return IK_LEVEL_AVX2;
+        }
+
+        return IK_LEVEL_SSE41;
+#else
+        return IK_LEVEL_SCALAR;
+#endif
+    }
+
+    struct Dispatcher
+    {
+        KernelTable tables[3];
+        ik_level supported;
+        volatile int level;
+
+        Dispatcher()
+        {
+            // The vectorized translation units are not entered at all when the CPU doesn't support them,
+            // the compiler may use their instruction set anywhere in them, including in the Fill functions.
+            supported = DetectLevel();
+
+            FillScalar(&tables[IK_LEVEL_SCALAR]);
+            tables[IK_LEVEL_SSE41] = tables[IK_LEVEL_SCALAR];
+            if (supported >= IK_LEVEL_SSE41)
+                FillSSE41(&tables[IK_LEVEL_SSE41]);
+
+            tables[IK_LEVEL_AVX2] = tables[IK_LEVEL_SSE41];
+            if (supported >= IK_LEVEL_AVX2)
+                FillAVX2(&tables[IK_LEVEL_AVX2]);
+
+            level = supported;
+        }
+    };
+
+    Dispatcher& GetDispatcher()
+    {
+        static Dispatcher dispatcher;
+        return dispatcher;
+    }
+
+    const KernelTable& Table()
+    {
+        Dispatcher& dispatcher = GetDispatcher();
+        return dispatcher.tables[dispatcher.level];
+    }
+
+    bool IsEmpty(const void* src, const void* dst, int width, int height)
+    {
+        return src == nullptr || dst == nullptr || width <= 0 || height <= 0;
+    }
+
+    // Row of the image mirrored at the borders, so the rows around the edges keep the parity of the Bayer pattern.
+    int Reflect(int index, int size)
+    {
+        if (index < 0)
+            return size > 1 ? 1 : 0;
+
+        if (index >= size)
+            return size > 1 ? size - 2 : 0;
+
+        return index;
+    }
+
+    void ConvertPlane(ConvertRow convert, const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height)
+    {
+        for (int i = 0; i < height; i++)
+            convert(src + (intptr_t)i * srcStride, dst + (intptr_t)i * dstStride, width);
+    }
+
+    void ConvertPlane(ConvertRowBpp convert, const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height, int bytesPerPixel)
+    {
+        for (int i = 0; i < height; i++)
+            convert(src + (intptr_t)i * srcStride, dst + (intptr_t)i * dstStride, width, bytesPerPixel);
+    }
+
+    void BGRToYUV420P(const uint8_t* src, int srcStride, uint8_t* y, int yStride, uint8_t* u, int uStride, uint8_t* v, int vStride, int width, int height, int bytesPerPixel)
+    {
+        if (IsEmpty(src, y, width, height) || u == nullptr || v == nullptr)
+            return;
+
+        const KernelTable& table = Table();
+        for (int i = 0; i < height; i += 2)
+        {
+            const uint8_t* src0 = src + (intptr_t)i * srcStride;
+            const uint8_t* src1 = i + 1 < height ? src0 + srcStride : src0;
+
+            table.bgrToLuma(src0, y + (intptr_t)i * yStride, width, bytesPerPixel);
+            if (i + 1 < height)
+                table.bgrToLuma(src1, y + (intptr_t)(i + 1) * yStride, width, bytesPerPixel);
+
+            table.bgrToChroma(src0, src1, u + (intptr_t)(i / 2) * uStride, v + (intptr_t)(i / 2) * vStride, width, bytesPerPixel);
+        }
+    }
+}
+
+namespace Kinovea { namespace Video { namespace FFMpeg { namespace Kernels
+{
+    //-----------------------------------------------------------------------------------------------------------
+    // Scalar rows.
+    //-----------------------------------------------------------------------------------------------------------
+    void BGR24ToBGRARow(const uint8_t* src, uint8_t* dst, int width)
+    {
+        for (int x = 0; x < width; x++, src += 3, dst += 4)
+        {
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+            dst[3] = 255;
+        }
+    }
+
+    void BGRAToBGR24Row(const uint8_t* src, uint8_t* dst, int width)
+    {
+        for (int x = 0; x < width; x++, src += 4, dst += 3)
+        {
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+        }
+    }
+
+    void GrayToBGRARow(const uint8_t* src, uint8_t* dst, int width)
+    {
+        for (int x = 0; x < width; x++, dst += 4)
+        {
+            dst[0] = dst[1] = dst[2] = src[x];
+            dst[3] = 255;
+        }
+    }
+
+    void GrayToBGR24Row(const uint8_t* src, uint8_t* dst, int width)
+    {
+        for (int x = 0; x < width; x++, dst += 3)
+            dst[0] = dst[1] = dst[2] = src[x];
+    }
+
+    void BGRToGrayRow(const uint8_t* src, uint8_t* dst, int width, int bytesPerPixel)
+    {
+        for (int x = 0; x < width; x++, src += bytesPerPixel)
+            dst[x] = (uint8_t)((29 * src[0] + 150 * src[1] + 77 * src[2] + 128) >> 8);
+    }
+
+    void BGRToLumaRow(const uint8_t* src, uint8_t* dst, int width, int bytesPerPixel)
+    {
+        for (int x = 0; x < width; x++, src += bytesPerPixel)
+            dst[x] = (uint8_t)(((25 * src[0] + 129 * src[1] + 66 * src[2] + 128) >> 8) + 16);
+    }
+
+    void BGRToChromaRow(const uint8_t* src0, const uint8_t* src1, uint8_t* u, uint8_t* v, int width, int bytesPerPixel)
+    {
+        for (int x = 0; x < width; x += 2)
+        {
+            // The last column is repeated for odd widths.
+            int a = x * bytesPerPixel;
+            int b = (x + 1 < width ? x + 1 : x) * bytesPerPixel;
+
+            int blue = (src0[a + 0] + src0[b + 0] + src1[a + 0] + src1[b + 0] + 2) >> 2;
+            int green = (src0[a + 1] + src0[b + 1] + src1[a + 1] + src1[b + 1] + 2) >> 2;
+            int red = (src0[a + 2] + src0[b + 2] + src1[a + 2] + src1[b + 2] + 2) >> 2;
+
+            u[x / 2] = (uint8_t)(((112 * blue - 74 * green - 38 * red + 128) >> 8) + 128);
+            v[x / 2] = (uint8_t)(((-18 * blue - 94 * green + 112 * red + 128) >> 8) + 128);
+        }
+    }
+
+    void YUV420PToBGRARow(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* dst, int width)
+    {
+        for (int x = 0; x < width; x++, dst += 4)
+        {
+            int c = 75 * (y[x] - 16);
+            int d = u[x / 2] - 128;
+            int e = v[x / 2] - 128;
+
+            dst[0] = Clip((c + 129 * d + 32) >> 6);
+            dst[1] = Clip((c - 25 * d - 52 * e + 32) >> 6);
+            dst[2] = Clip((c + 102 * e + 32) >> 6);
+            dst[3] = 255;
+        }
+    }
+
+    void BayerToBGRARow(const uint8_t* above, const uint8_t* row, const uint8_t* below, uint8_t* dst, int width, int redColumn, int rowKind)
+    {
+        // Column of the red or blue pixels of this row, the other columns are green.
+        int colorColumn = rowKind == BayerRedRow ? redColumn : 1 - redColumn;
+
+        for (int x = 0; x < width; x++, dst += 4)
+        {
+            int left = Reflect(x - 1, width);
+            int right = Reflect(x + 1, width);
+
+            int center = row[x];
+            int horizontal = (row[left] + row[right] + 1) >> 1;
+            int vertical = (above[x] + below[x] + 1) >> 1;
+
+            int own;
+            int green;
+            int other;
+            if ((x & 1) == colorColumn)
+            {
+                own = center;
+                green = (row[left] + row[right] + above[x] + below[x] + 2) >> 2;
+                other = (above[left] + above[right] + below[left] + below[right] + 2) >> 2;
+            }
+            else
+            {
+                // Green pixel: the color of the row is on the sides, the other color above and below.
+                own = horizontal;
+                green = center;
+                other = vertical;
+            }
+
+            int red = rowKind == BayerRedRow ? own : other;
+            int blue = rowKind == BayerRedRow ? other : own;
+            dst[0] = (uint8_t)blue;
+            dst[1] = (uint8_t)green;
+            dst[2] = (uint8_t)red;
+            dst[3] = 255;
+        }
+    }
+
+    void ReverseRow(const uint8_t* src, uint8_t* dst, int width, int bytesPerPixel)
+    {
+        const uint8_t* s = src + (intptr_t)(width - 1) * bytesPerPixel;
+        for (int x = 0; x < width; x++, s -= bytesPerPixel, dst += bytesPerPixel)
+        {
+            for (int c = 0; c < bytesPerPixel; c++)
+                dst[c] = s[c];
+        }
+    }
+
+    void TransposeBlock(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height, int bytesPerPixel)
+    {
+        // Walk the image by tiles so both the source rows and the destination rows stay in cache.
+        for (int by = 0; by < height; by += TransposeTile)
+        {
+            int endY = by + TransposeTile < height ? by + TransposeTile : height;
+            for (int bx = 0; bx < width; bx += TransposeTile)
+            {
+                int endX = bx + TransposeTile < width ? bx + TransposeTile : width;
+                for (int y = by; y < endY; y++)
+                {
+                    const uint8_t* s = src + (intptr_t)y * srcStride + (intptr_t)bx * bytesPerPixel;
+                    uint8_t* d = dst + (intptr_t)bx * dstStride + (intptr_t)y * bytesPerPixel;
+                    for (int x = bx; x < endX; x++, s += bytesPerPixel, d += dstStride)
+                    {
+                        for (int c = 0; c < bytesPerPixel; c++)
+                            d[c] = s[c];
+                    }
+                }
+            }
+        }
+    }
+
+    void FillScalar(KernelTable* table)
+    {
+        table->bgr24ToBGRA = BGR24ToBGRARow;
+        table->bgraToBGR24 = BGRAToBGR24Row;
+        table->grayToBGRA = GrayToBGRARow;
+        table->grayToBGR24 = GrayToBGR24Row;
+        table->bgrToGray = BGRToGrayRow;
+        table->bgrToLuma = BGRToLumaRow;
+        table->bgrToChroma = BGRToChromaRow;
+        table->yuv420pToBGRA = YUV420PToBGRARow;
+        table->bayerToBGRA = BayerToBGRARow;
+        table->reverse = ReverseRow;
+        table->transpose = TransposeBlock;
+    }
+}}}}
+
+//---------------------------------------------------------------------------------------------------------------
+// Public interface.
+//---------------------------------------------------------------------------------------------------------------
+int ik_version(void)
+{
+    return IK_VERSION;
+}
+
+ik_level ik_detect_level(void)
+{
+    return GetDispatcher().supported;
+}
+
+ik_level ik_get_level(void)
+{
+    return (ik_level)GetDispatcher().level;
+}
+
+ik_level ik_set_level(ik_level level)
+{
+    Dispatcher& dispatcher = GetDispatcher();
+    if (level < IK_LEVEL_SCALAR)
+        level = IK_LEVEL_SCALAR;
+
+    if (level > dispatcher.supported)
+        level = dispatcher.supported;
+
+    dispatcher.level = level;
+    return level;
+}
+
+const char* ik_level_name(ik_level level)
+{
+    switch (level)
+    {
+    case IK_LEVEL_SSE41:
+        return "SSE4.1";
+    case IK_LEVEL_AVX2:
+        return "AVX2";
+    case IK_LEVEL_SCALAR:
+    default:
+        return "Scalar";
+    }
+}
+
+void ik_copy(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height, int bytesPerPixel)
+{
+    if (IsEmpty(src, dst, width, height))
+        return;
+
+    size_t length = (size_t)width * bytesPerPixel;
+    for (int i = 0; i < height; i++)
+        memcpy(dst + (intptr_t)i * dstStride, src + (intptr_t)i * srcStride, length);
+}
+
+void ik_bgr24_to_bgra(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height)
+{
+    if (!IsEmpty(src, dst, width, height))
+        ConvertPlane(Table().bgr24ToBGRA, src, srcStride, dst, dstStride, width, height);
+}
+
+void ik_bgra_to_bgr24(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height)
+{
+    if (!IsEmpty(src, dst, width, height))
+        ConvertPlane(Table().bgraToBGR24, src, srcStride, dst, dstStride, width, height);
+}
+
+void ik_gray_to_bgra(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height)
+{
+    if (!IsEmpty(src, dst, width, height))
+        ConvertPlane(Table().grayToBGRA, src, srcStride, dst, dstStride, width, height);
+}
+
+void ik_gray_to_bgr24(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height)
+{
+    if (!IsEmpty(src, dst, width, height))
+        ConvertPlane(Table().grayToBGR24, src, srcStride, dst, dstStride, width, height);
+}
+
+void ik_bgra_to_gray(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height)
+{
+    if (!IsEmpty(src, dst, width, height))
+        ConvertPlane(Table().bgrToGray, src, srcStride, dst, dstStride, width, height, 4);
+}
+
+void ik_bgr24_to_gray(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height)
+{
+    if (!IsEmpty(src, dst, width, height))
+        ConvertPlane(Table().bgrToGray, src, srcStride, dst, dstStride, width, height, 3);
+}
+
+void ik_yuv420p_to_bgra(const uint8_t* y, int yStride, const uint8_t* u, int uStride, const uint8_t* v, int vStride,
+    uint8_t* dst, int dstStride, int width, int height)
+{
+    if (IsEmpty(y, dst, width, height) || u == nullptr || v == nullptr)
+        return;
+
+    YUVRow convert = Table().yuv420pToBGRA;
+    for (int i = 0; i < height; i++)
+    {
+        convert(y + (intptr_t)i * yStride, u + (intptr_t)(i / 2) * uStride, v + (intptr_t)(i / 2) * vStride,
+            dst + (intptr_t)i * dstStride, width);
+    }
+}
+
+void ik_bgra_to_yuv420p(const uint8_t* src, int srcStride,
+    uint8_t* y, int yStride, uint8_t* u, int uStride, uint8_t* v, int vStride, int width, int height)
+{
+    BGRToYUV420P(src, srcStride, y, yStride, u, uStride, v, vStride, width, height, 4);
+}
+
+void ik_bgr24_to_yuv420p(const uint8_t* src, int srcStride,
+    uint8_t* y, int yStride, uint8_t* u, int uStride, uint8_t* v, int vStride, int width, int height)
+{
+    BGRToYUV420P(src, srcStride, y, yStride, u, uStride, v, vStride, width, height, 3);
+}
+
+void ik_bayer_to_bgra(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height, ik_bayer pattern)
+{
+    if (IsEmpty(src, dst, width, height))
+        return;
+
+    // Kind of the first row and column of the red pixels. The blue pixels are on the other column.
+    int firstRowKind = (pattern == IK_BAYER_RGGB || pattern == IK_BAYER_GRBG) ? BayerRedRow : BayerBlueRow;
+    int redColumn = (pattern == IK_BAYER_RGGB || pattern == IK_BAYER_GBRG) ? 0 : 1;
+
+    BayerRow convert = Table().bayerToBGRA;
+    for (int i = 0; i < height; i++)
+    {
+        const uint8_t* row = src + (intptr_t)i * srcStride;
+        const uint8_t* above = src + (intptr_t)Reflect(i - 1, height) * srcStride;
+        const uint8_t* below = src + (intptr_t)Reflect(i + 1, height) * srcStride;
+        int rowKind = (i & 1) == 0 ? firstRowKind : 1 - firstRowKind;
+        convert(above, row, below, dst + (intptr_t)i * dstStride, width, redColumn, rowKind);
+    }
+}
+
+void ik_rotate_flip(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height,
+    int bytesPerPixel, ik_rotation rotation, int mirror)
+{
+    if (IsEmpty(src, dst, width, height))
+        return;
+
+    const KernelTable& table = Table();
+    const uint8_t* lastSrcRow = src + (intptr_t)(height - 1) * srcStride;
+
+    // Every orientation is a copy, a reversal of rows or a transposition,
+    // with the source or the destination walked bottom-up.
+    switch (rotation)
+    {
+    case IK_ROTATE_90:
+        if (mirror)
+            table.transpose(src, srcStride, dst, dstStride, width, height, bytesPerPixel);
+        else
+            table.transpose(lastSrcRow, -srcStride, dst, dstStride, width, height, bytesPerPixel);
+        break;
+    case IK_ROTATE_270:
+    {
+        uint8_t* lastDstRow = dst + (intptr_t)(width - 1) * dstStride;
+        if (mirror)
+            table.transpose(lastSrcRow, -srcStride, lastDstRow, -dstStride, width, height, bytesPerPixel);
+        else
+            table.transpose(src, srcStride, lastDstRow, -dstStride, width, height, bytesPerPixel);
+        break;
+    }
+    case IK_ROTATE_180:
+        if (mirror)
+            ik_copy(lastSrcRow, -srcStride, dst, dstStride, width, height, bytesPerPixel);
+        else
+            ConvertPlane(table.reverse, lastSrcRow, -srcStride, dst, dstStride, width, height, bytesPerPixel);
+        break;
+    case IK_ROTATE_NONE:
+    default:
+        if (mirror)
+            ConvertPlane(table.reverse, src, srcStride, dst, dstStride, width, height, bytesPerPixel);
+        else
+            ik_copy(src, srcStride, dst, dstStride, width, height, bytesPerPixel);
+        break;
+    }
+}
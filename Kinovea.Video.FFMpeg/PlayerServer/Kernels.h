@@ -0,0 +1,122 @@
+#pragma region License
+/*
+Copyright  Joan Charmant 2021.
+jcharmant@gmail.com
+
+This file is part of Kinovea.
+
+Kinovea is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2
+as published by the Free Software Foundation.
+
+Kinovea is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Kinovea. If not, see http://www.gnu.org/licenses/.
+
+*/
+#pragma endregion
+
+//---------------------------------------------------------------------------------------------------------------
+// Native image kernels.
+//
+// Pixel format conversions, flips and rotations shared by the reader, the writers and the capture pipeline.
+// The kernels are plain native code, compiled without /clr, and exposed through a C interface
+// so they can be called from managed code, from the native benchmark and from the tests alike.
+//
+// Each kernel has a scalar implementation and some have SSE4.1 and AVX2 implementations.
+// The best level supported by the CPU is selected on first use. All levels produce the exact same bytes,
+// the vectorized code uses the same fixed point arithmetic as the scalar code.
+//
+// Conventions:
+// - Pixel formats are named after the byte order in memory: BGRA is Format32bppArgb/Rgb, BGR24 is Format24bppRgb.
+// - Strides are in bytes and may be negative. A negative stride with a pointer to the last row reads or writes
+//   the image bottom-up, this is how vertical flips are done during conversions.
+// - YUV420P is BT.601 limited range, chroma is subsampled on 2x2 blocks, the last block is partial for odd sizes.
+// - Gray is the BT.601 luma of the color image, in full range.
+// - Source and destination must not overlap.
+//
+// The interface is versioned, new kernels may be added but existing signatures don't change.
+//---------------------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+
+#define IK_VERSION 1
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef enum ik_level
+{
+    IK_LEVEL_SCALAR = 0,
+    IK_LEVEL_SSE41 = 1,
+    IK_LEVEL_AVX2 = 2
+} ik_level;
+
+// Color of the top-left 2x2 block of the sensor.
+typedef enum ik_bayer
+{
+    IK_BAYER_RGGB = 0,
+    IK_BAYER_BGGR = 1,
+    IK_BAYER_GRBG = 2,
+    IK_BAYER_GBRG = 3
+} ik_bayer;
+
+// Clockwise rotation.
+typedef enum ik_rotation
+{
+    IK_ROTATE_NONE = 0,
+    IK_ROTATE_90 = 1,
+    IK_ROTATE_180 = 2,
+    IK_ROTATE_270 = 3
+} ik_rotation;
+
+int ik_version(void);
+
+// Best level supported by the CPU and the operating system.
+ik_level ik_detect_level(void);
+
+// Level currently used by the kernels.
+ik_level ik_get_level(void);
+
+// Forces the level used by the kernels, for tests and benchmarks.
+// The level is capped to the supported one, the effective level is returned.
+ik_level ik_set_level(ik_level level);
+
+const char* ik_level_name(ik_level level);
+
+// Row by row copy, bytesPerPixel is 1, 3 or 4.
+void ik_copy(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height, int bytesPerPixel);
+
+void ik_bgr24_to_bgra(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height);
+void ik_bgra_to_bgr24(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height);
+void ik_gray_to_bgra(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height);
+void ik_gray_to_bgr24(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height);
+void ik_bgra_to_gray(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height);
+void ik_bgr24_to_gray(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height);
+
+void ik_yuv420p_to_bgra(const uint8_t* y, int yStride, const uint8_t* u, int uStride, const uint8_t* v, int vStride,
+    uint8_t* dst, int dstStride, int width, int height);
+void ik_bgra_to_yuv420p(const uint8_t* src, int srcStride,
+    uint8_t* y, int yStride, uint8_t* u, int uStride, uint8_t* v, int vStride, int width, int height);
+void ik_bgr24_to_yuv420p(const uint8_t* src, int srcStride,
+    uint8_t* y, int yStride, uint8_t* u, int uStride, uint8_t* v, int vStride, int width, int height);
+
+// Bilinear demosaicing of an 8-bit sensor image.
+void ik_bayer_to_bgra(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height, ik_bayer pattern);
+
+// Rotates the image clockwise then mirrors it horizontally if requested, like GDI+ RotateFlip.
+// width and height are the size of the source, the destination is height x width for 90 and 270.
+void ik_rotate_flip(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height,
+    int bytesPerPixel, ik_rotation rotation, int mirror);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,228 @@
+#pragma region License
+/*
+Copyright  Joan Charmant 2021.
+jcharmant@gmail.com
+
+This file is part of Kinovea.
+
+Kinovea is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2
+as published by the Free Software Foundation.
+
+Kinovea is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Kinovea. If not, see http://www.gnu.org/licenses/.
+
+*/
+#pragma endregion
+
+//---------------------------------------------------------------------------------------------------------------
+// AVX2 kernels.
+// This file is compiled as native code with /arch:AVX2, the functions are only called after the CPU and the OS
+// were checked for AVX2. Nothing in this file may run before that, so there are no constants at namespace scope.
+//
+// Most 256-bit instructions work on two independent 128-bit lanes, the pixels are reordered across lanes
+// before packing or after unpacking. The pixel formats without an AVX2 version keep the SSE4.1 one.
+// See Kernels.cpp for the fixed point formulas.
+//---------------------------------------------------------------------------------------------------------------
+
+#include "KernelsInternal.h"
+
+#ifdef IK_X86
+
+#include <immintrin.h>
+
+using namespace Kinovea::Video::FFMpeg::Kernels;
+
+namespace
+{
+    // (c0 B + c1 G + c2 R + 128) >> 8 for 16 BGRA pixels, as bytes.
+    __m128i WeightedSum16(const uint8_t* src, __m256i coefficients)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i round = _mm256_set1_epi32(128);
+
+        __m256i p0 = _mm256_loadu_si256((const __m256i*)(src + 0));
+        __m256i p1 = _mm256_loadu_si256((const __m256i*)(src + 32));
+
+        // The horizontal add within lanes puts pixels 0-3 in the low lane and 4-7 in the high lane.
+        __m256i s0 = _mm256_hadd_epi32(
+            _mm256_madd_epi16(_mm256_unpacklo_epi8(p0, zero), coefficients),
+            _mm256_madd_epi16(_mm256_unpackhi_epi8(p0, zero), coefficients));
+        __m256i s1 = _mm256_hadd_epi32(
+            _mm256_madd_epi16(_mm256_unpacklo_epi8(p1, zero), coefficients),
+            _mm256_madd_epi16(_mm256_unpackhi_epi8(p1, zero), coefficients));
+        s0 = _mm256_srli_epi32(_mm256_add_epi32(s0, round), 8);
+        s1 = _mm256_srli_epi32(_mm256_add_epi32(s1, round), 8);
+
+        // Packing interleaves the lanes: 0-3, 8-11, 4-7, 12-15.
+        __m256i words = _mm256_permute4x64_epi64(_mm256_packs_epi32(s0, s1), _MM_SHUFFLE(3, 1, 2, 0));
+        return _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+    }
+
+    void GrayToBGRARowAVX2(const uint8_t* src, uint8_t* dst, int width)
+    {
+        const __m256i mask = _mm256_setr_epi8(
+            0, 0, 0, -1, 1, 1, 1, -1, 2, 2, 2, -1, 3, 3, 3, -1,
+            4, 4, 4, -1, 5, 5, 5, -1, 6, 6, 6, -1, 7, 7, 7, -1);
+        const __m256i alpha = _mm256_set1_epi32((int)0xFF000000);
+
+        int x = 0;
+        for (; x + 32 <= width; x += 32)
+        {
+            for (int i = 0; i < 32; i += 8)
+            {
+                // Same 8 gray values in both lanes, each lane expands 4 of them.
+                __m256i gray = _mm256_broadcastq_epi64(_mm_loadl_epi64((const __m128i*)(src + x + i)));
+                _mm256_storeu_si256((__m256i*)(dst + (x + i) * 4), _mm256_or_si256(_mm256_shuffle_epi8(gray, mask), alpha));
+            }
+        }
+
+        GrayToBGRARowSSE41(src + x, dst + x * 4, width - x);
+    }
+
+    void BGRToGrayRowAVX2(const uint8_t* src, uint8_t* dst, int width, int bytesPerPixel)
+    {
+        if (bytesPerPixel != 4)
+        {
+            BGRToGrayRowSSE41(src, dst, width, bytesPerPixel);
+            return;
+        }
+
+        const __m256i coefficients = _mm256_setr_epi16(29, 150, 77, 0, 29, 150, 77, 0, 29, 150, 77, 0, 29, 150, 77, 0);
+
+        int x = 0;
+        for (; x + 16 <= width; x += 16)
+            _mm_storeu_si128((__m128i*)(dst + x), WeightedSum16(src + x * 4, coefficients));
+
+        BGRToGrayRow(src + x * 4, dst + x, width - x, 4);
+    }
+
+    void BGRToLumaRowAVX2(const uint8_t* src, uint8_t* dst, int width, int bytesPerPixel)
+    {
+        if (bytesPerPixel != 4)
+        {
+            BGRToLumaRowSSE41(src, dst, width, bytesPerPixel);
+            return;
+        }
+
+        const __m256i coefficients = _mm256_setr_epi16(25, 129, 66, 0, 25, 129, 66, 0, 25, 129, 66, 0, 25, 129, 66, 0);
+        const __m128i offset = _mm_set1_epi8(16);
+
+        int x = 0;
+        for (; x + 16 <= width; x += 16)
+            _mm_storeu_si128((__m128i*)(dst + x), _mm_add_epi8(WeightedSum16(src + x * 4, coefficients), offset));
+
+        BGRToLumaRow(src + x * 4, dst + x, width - x, 4);
+    }
+
+    void YUV420PToBGRARowAVX2(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* dst, int width)
+    {
+        const __m256i k16 = _mm256_set1_epi16(16);
+        const __m256i k128 = _mm256_set1_epi16(128);
+        const __m256i k32 = _mm256_set1_epi16(32);
+        const __m256i kY = _mm256_set1_epi16(75);
+        const __m256i kRV = _mm256_set1_epi16(102);
+        const __m256i kGU = _mm256_set1_epi16(-25);
+        const __m256i kGV = _mm256_set1_epi16(-52);
+        const __m256i kBU = _mm256_set1_epi16(129);
+        const __m256i alpha = _mm256_set1_epi8(-1);
+
+        // Blocks of 32 pixels, x stays even so the chroma of the tail is aligned.
+        int x = 0;
+        for (; x + 32 <= width; x += 32)
+        {
+            // Pixels 0-15 and 16-31, in order.
+            __m256i luma = _mm256_loadu_si256((const __m256i*)(y + x));
+            __m256i y0 = _mm256_mullo_epi16(_mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(luma)), k16), kY);
+            __m256i y1 = _mm256_mullo_epi16(_mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(luma, 1)), k16), kY);
+
+            // Chroma 0-3, 8-11 | 4-7, 12-15, so that duplicating within lanes gives pixels 0-15 and 16-31 in order.
+            __m256i d = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(u + x / 2))), k128);
+            __m256i e = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(v + x / 2))), k128);
+            d = _mm256_permute4x64_epi64(d, _MM_SHUFFLE(3, 1, 2, 0));
+            e = _mm256_permute4x64_epi64(e, _MM_SHUFFLE(3, 1, 2, 0));
+            __m256i d0 = _mm256_unpacklo_epi16(d, d);
+            __m256i d1 = _mm256_unpackhi_epi16(d, d);
+            __m256i e0 = _mm256_unpacklo_epi16(e, e);
+            __m256i e1 = _mm256_unpackhi_epi16(e, e);
+
+            __m256i b0 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(y0, _mm256_mullo_epi16(d0, kBU)), k32), 6);
+            __m256i b1 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(y1, _mm256_mullo_epi16(d1, kBU)), k32), 6);
+            __m256i g0 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(_mm256_adds_epi16(y0, _mm256_mullo_epi16(d0, kGU)), _mm256_mullo_epi16(e0, kGV)), k32), 6);
+            __m256i g1 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(_mm256_adds_epi16(y1, _mm256_mullo_epi16(d1, kGU)), _mm256_mullo_epi16(e1, kGV)), k32), 6);
+            __m256i r0 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(y0, _mm256_mullo_epi16(e0, kRV)), k32), 6);
+            __m256i r1 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(y1, _mm256_mullo_epi16(e1, kRV)), k32), 6);
+
+            // Bytes of pixels 0-7, 16-23 | 8-15, 24-31.
+            __m256i b = _mm256_packus_epi16(b0, b1);
+            __m256i g = _mm256_packus_epi16(g0, g1);
+            __m256i r = _mm256_packus_epi16(r0, r1);
+
+            __m256i bgLo = _mm256_unpacklo_epi8(b, g);
+            __m256i bgHi = _mm256_unpackhi_epi8(b, g);
+            __m256i raLo = _mm256_unpacklo_epi8(r, alpha);
+            __m256i raHi = _mm256_unpackhi_epi8(r, alpha);
+
+            // Pixels 0-3, 8-11 | 4-7, 12-15 and 16-19, 24-27 | 20-23, 28-31.
+            __m256i q0 = _mm256_unpacklo_epi16(bgLo, raLo);
+            __m256i q1 = _mm256_unpackhi_epi16(bgLo, raLo);
+            __m256i q2 = _mm256_unpacklo_epi16(bgHi, raHi);
+            __m256i q3 = _mm256_unpackhi_epi16(bgHi, raHi);
+
+            _mm256_storeu_si256((__m256i*)(dst + x * 4 + 0), _mm256_permute2x128_si256(q0, q1, 0x20));
+            _mm256_storeu_si256((__m256i*)(dst + x * 4 + 32), _mm256_permute2x128_si256(q0, q1, 0x31));
+            _mm256_storeu_si256((__m256i*)(dst + x * 4 + 64), _mm256_permute2x128_si256(q2, q3, 0x20));
+            _mm256_storeu_si256((__m256i*)(dst + x * 4 + 96), _mm256_permute2x128_si256(q2, q3, 0x31));
+        }
+
+        YUV420PToBGRARowSSE41(y + x, u + x / 2, v + x / 2, dst + x * 4, width - x);
+    }
+
+    void ReverseRowAVX2(const uint8_t* src, uint8_t* dst, int width, int bytesPerPixel)
+    {
+        if (bytesPerPixel != 4)
+        {
+            ReverseRowSSE41(src, dst, width, bytesPerPixel);
+            return;
+        }
+
+        const __m256i order = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+
+        int x = 0;
+        for (; x + 8 <= width; x += 8)
+        {
+            __m256i pixels = _mm256_loadu_si256((const __m256i*)(src + (width - x - 8) * 4));
+            _mm256_storeu_si256((__m256i*)(dst + x * 4), _mm256_permutevar8x32_epi32(pixels, order));
+        }
+
+        ReverseRowSSE41(src, dst + x * 4, width - x, 4);
+    }
+}
+
+namespace Kinovea { namespace Video { namespace FFMpeg { namespace Kernels
+{
+    void FillAVX2(KernelTable* table)
+    {
+        table->grayToBGRA = GrayToBGRARowAVX2;
+        table->bgrToGray = BGRToGrayRowAVX2;
+        table->bgrToLuma = BGRToLumaRowAVX2;
+        table->yuv420pToBGRA = YUV420PToBGRARowAVX2;
+        table->reverse = ReverseRowAVX2;
+    }
+}}}}
+
+#else
+
+namespace Kinovea { namespace Video { namespace FFMpeg { namespace Kernels
+{
+    void FillAVX2(KernelTable* table)
+    {
+    }
+}}}}
+
+#endif
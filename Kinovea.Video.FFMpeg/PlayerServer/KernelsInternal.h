@@ -0,0 +1,94 @@
+#pragma region License
+/*
+Copyright  Joan Charmant 2021.
+jcharmant@gmail.com
+
+This file is part of Kinovea.
+
+Kinovea is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2
+as published by the Free Software Foundation.
+
+Kinovea is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Kinovea. If not, see http://www.gnu.org/licenses/.
+
+*/
+#pragma endregion
+
+//---------------------------------------------------------------------------------------------------------------
+// Dispatch table of the image kernels, shared between the scalar and the vectorized translation units.
+//
+// The public functions in Kernels.cpp walk the rows and handle the strides, the table entries only process rows
+// or blocks of contiguous memory. Each level starts from the table of the level below and replaces the entries
+// it has a faster version of. The vectorized rows process as many pixels as they can and call the scalar row
+// for the remaining ones, so the results don't depend on the level.
+//
+// Do not include any header with inline functions or templates in the vectorized translation units.
+// The linker keeps a single copy of each inline function, it could pick the one compiled for AVX2.
+//---------------------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define IK_X86
+#endif
+
+namespace Kinovea { namespace Video { namespace FFMpeg { namespace Kernels
+{
+    typedef void (*ConvertRow)(const uint8_t* src, uint8_t* dst, int width);
+    typedef void (*ConvertRowBpp)(const uint8_t* src, uint8_t* dst, int width, int bytesPerPixel);
+    typedef void (*YUVRow)(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* dst, int width);
+    typedef void (*ChromaRow)(const uint8_t* src0, const uint8_t* src1, uint8_t* u, uint8_t* v, int width, int bytesPerPixel);
+    typedef void (*BayerRow)(const uint8_t* above, const uint8_t* row, const uint8_t* below, uint8_t* dst, int width, int redColumn, int rowKind);
+    typedef void (*Transpose)(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height, int bytesPerPixel);
+
+    // Kind of Bayer row: the row contains red pixels, or blue pixels.
+    const int BayerRedRow = 0;
+    const int BayerBlueRow = 1;
+
+    struct KernelTable
+    {
+        ConvertRow bgr24ToBGRA;
+        ConvertRow bgraToBGR24;
+        ConvertRow grayToBGRA;
+        ConvertRow grayToBGR24;
+        ConvertRowBpp bgrToGray;
+        ConvertRowBpp bgrToLuma;
+        ChromaRow bgrToChroma;
+        YUVRow yuv420pToBGRA;
+        BayerRow bayerToBGRA;
+        ConvertRowBpp reverse;
+        Transpose transpose;
+    };
+
+    void FillScalar(KernelTable* table);
+    void FillSSE41(KernelTable* table);
+    void FillAVX2(KernelTable* table);
+
+    // Scalar rows, also used for the tail of the vectorized rows.
+    void BGR24ToBGRARow(const uint8_t* src, uint8_t* dst, int width);
+    void BGRAToBGR24Row(const uint8_t* src, uint8_t* dst, int width);
+    void GrayToBGRARow(const uint8_t* src, uint8_t* dst, int width);
+    void GrayToBGR24Row(const uint8_t* src, uint8_t* dst, int width);
+    void BGRToGrayRow(const uint8_t* src, uint8_t* dst, int width, int bytesPerPixel);
+    void BGRToLumaRow(const uint8_t* src, uint8_t* dst, int width, int bytesPerPixel);
+    void BGRToChromaRow(const uint8_t* src0, const uint8_t* src1, uint8_t* u, uint8_t* v, int width, int bytesPerPixel);
+    void YUV420PToBGRARow(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* dst, int width);
+    void BayerToBGRARow(const uint8_t* above, const uint8_t* row, const uint8_t* below, uint8_t* dst, int width, int redColumn, int rowKind);
+    void ReverseRow(const uint8_t* src, uint8_t* dst, int width, int bytesPerPixel);
+    void TransposeBlock(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height, int bytesPerPixel);
+
+    // SSE4.1 rows, also used for the tail of the AVX2 rows and for the pixel formats without an AVX2 version.
+    void BGRToGrayRowSSE41(const uint8_t* src, uint8_t* dst, int width, int bytesPerPixel);
+    void BGRToLumaRowSSE41(const uint8_t* src, uint8_t* dst, int width, int bytesPerPixel);
+    void GrayToBGRARowSSE41(const uint8_t* src, uint8_t* dst, int width);
+    void YUV420PToBGRARowSSE41(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* dst, int width);
+    void ReverseRowSSE41(const uint8_t* src, uint8_t* dst, int width, int bytesPerPixel);
+}}}}
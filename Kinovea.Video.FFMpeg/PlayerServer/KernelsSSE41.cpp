@@ -0,0 +1,346 @@
+#pragma region License
+/*
+Copyright  Joan Charmant 2021.
+jcharmant@gmail.com
+
+This file is part of Kinovea.
+
+Kinovea is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2
+as published by the Free Software Foundation.
+
+Kinovea is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Kinovea. If not, see http://www.gnu.org/licenses/.
+
+*/
+#pragma endregion
+
+//---------------------------------------------------------------------------------------------------------------
+// SSE4.1 kernels.
+// This file is compiled as native code, the functions are only called after the CPU was checked for SSE4.1.
+// See Kernels.cpp for the fixed point formulas.
+//---------------------------------------------------------------------------------------------------------------
+
+#include "KernelsInternal.h"
+
+#ifdef IK_X86
+
+#include <smmintrin.h>
+
+using namespace Kinovea::Video::FFMpeg::Kernels;
+
+namespace
+{
+    // The constants are built in the functions rather than at namespace scope,
+    // so nothing in this file runs before the CPU is checked.
+
+    // Load 16 pixels of BGRA or BGR24 as four vectors of 4 BGRx pixels, the alpha of BGR24 pixels is zero.
+    void LoadPixels(const uint8_t* src, int bytesPerPixel, __m128i* pixels)
+    {
+        const __m128i expand = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+
+        if (bytesPerPixel == 4)
+        {
+            pixels[0] = _mm_loadu_si128((const __m128i*)(src + 0));
+            pixels[1] = _mm_loadu_si128((const __m128i*)(src + 16));
+            pixels[2] = _mm_loadu_si128((const __m128i*)(src + 32));
+            pixels[3] = _mm_loadu_si128((const __m128i*)(src + 48));
+        }
+        else
+        {
+            __m128i in0 = _mm_loadu_si128((const __m128i*)(src + 0));
+            __m128i in1 = _mm_loadu_si128((const __m128i*)(src + 16));
+            __m128i in2 = _mm_loadu_si128((const __m128i*)(src + 32));
+            pixels[0] = _mm_shuffle_epi8(in0, expand);
+            pixels[1] = _mm_shuffle_epi8(_mm_alignr_epi8(in1, in0, 12), expand);
+            pixels[2] = _mm_shuffle_epi8(_mm_alignr_epi8(in2, in1, 8), expand);
+            pixels[3] = _mm_shuffle_epi8(_mm_srli_si128(in2, 4), expand);
+        }
+    }
+
+    // (c0 B + c1 G + c2 R + 128) >> 8 for 4 BGRx pixels, as 32-bit values.
+    __m128i WeightedSum(__m128i pixels, __m128i coefficients)
+    {
+        __m128i zero = _mm_setzero_si128();
+        __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), coefficients);
+        __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), coefficients);
+        __m128i sum = _mm_hadd_epi32(lo, hi);
+        return _mm_srli_epi32(_mm_add_epi32(sum, _mm_set1_epi32(128)), 8);
+    }
+
+    __m128i WeightedSum16(const __m128i* pixels, __m128i coefficients)
+    {
+        __m128i s0 = WeightedSum(pixels[0], coefficients);
+        __m128i s1 = WeightedSum(pixels[1], coefficients);
+        __m128i s2 = WeightedSum(pixels[2], coefficients);
+        __m128i s3 = WeightedSum(pixels[3], coefficients);
+        return _mm_packus_epi16(_mm_packs_epi32(s0, s1), _mm_packs_epi32(s2, s3));
+    }
+
+    void BGR24ToBGRARowSSE41(const uint8_t* src, uint8_t* dst, int width)
+    {
+        const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+
+        int x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+            __m128i pixels[4];
+            LoadPixels(src + x * 3, 3, pixels);
+            _mm_storeu_si128((__m128i*)(dst + x * 4 + 0), _mm_or_si128(pixels[0], alpha));
+            _mm_storeu_si128((__m128i*)(dst + x * 4 + 16), _mm_or_si128(pixels[1], alpha));
+            _mm_storeu_si128((__m128i*)(dst + x * 4 + 32), _mm_or_si128(pixels[2], alpha));
+            _mm_storeu_si128((__m128i*)(dst + x * 4 + 48), _mm_or_si128(pixels[3], alpha));
+        }
+
+        BGR24ToBGRARow(src + x * 3, dst + x * 4, width - x);
+    }
+
+    void BGRAToBGR24RowSSE41(const uint8_t* src, uint8_t* dst, int width)
+    {
+        const __m128i pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+
+        int x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+            // Pack each group of 4 pixels to 12 bytes and stitch them into 48 bytes.
+            __m128i p0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + x * 4 + 0)), pack);
+            __m128i p1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + x * 4 + 16)), pack);
+            __m128i p2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + x * 4 + 32)), pack);
+            __m128i p3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + x * 4 + 48)), pack);
+            _mm_storeu_si128((__m128i*)(dst + x * 3 + 0), _mm_or_si128(p0, _mm_slli_si128(p1, 12)));
+            _mm_storeu_si128((__m128i*)(dst + x * 3 + 16), _mm_or_si128(_mm_srli_si128(p1, 4), _mm_slli_si128(p2, 8)));
+            _mm_storeu_si128((__m128i*)(dst + x * 3 + 32), _mm_or_si128(_mm_srli_si128(p2, 8), _mm_slli_si128(p3, 4)));
+        }
+
+        BGRAToBGR24Row(src + x * 4, dst + x * 3, width - x);
+    }
+
+    void GrayToBGR24RowSSE41(const uint8_t* src, uint8_t* dst, int width)
+    {
+        const __m128i mask0 = _mm_setr_epi8(0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5);
+        const __m128i mask1 = _mm_setr_epi8(5, 5, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10);
+        const __m128i mask2 = _mm_setr_epi8(10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 14, 14, 14, 15, 15, 15);
+
+        int x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+            __m128i gray = _mm_loadu_si128((const __m128i*)(src + x));
+            _mm_storeu_si128((__m128i*)(dst + x * 3 + 0), _mm_shuffle_epi8(gray, mask0));
+            _mm_storeu_si128((__m128i*)(dst + x * 3 + 16), _mm_shuffle_epi8(gray, mask1));
+            _mm_storeu_si128((__m128i*)(dst + x * 3 + 32), _mm_shuffle_epi8(gray, mask2));
+        }
+
+        GrayToBGR24Row(src + x, dst + x * 3, width - x);
+    }
+
+    void TransposeSSE41(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height, int bytesPerPixel)
+    {
+        if (bytesPerPixel != 4)
+        {
+            TransposeBlock(src, srcStride, dst, dstStride, width, height, bytesPerPixel);
+            return;
+        }
+
+        const int tile = 32;
+        int width4 = width & ~3;
+        int height4 = height & ~3;
+
+        for (int by = 0; by < height4; by += tile)
+        {
+            int endY = by + tile < height4 ? by + tile : height4;
+            for (int bx = 0; bx < width4; bx += tile)
+            {
+                int endX = bx + tile < width4 ? bx + tile : width4;
+                for (int y = by; y < endY; y += 4)
+                {
+                    const uint8_t* s = src + (intptr_t)y * srcStride;
+                    uint8_t* d = dst + (intptr_t)y * 4;
+                    for (int x = bx; x < endX; x += 4)
+                    {
+                        __m128i r0 = _mm_loadu_si128((const __m128i*)(s + (intptr_t)0 * srcStride + x * 4));
+                        __m128i r1 = _mm_loadu_si128((const __m128i*)(s + (intptr_t)1 * srcStride + x * 4));
+                        __m128i r2 = _mm_loadu_si128((const __m128i*)(s + (intptr_t)2 * srcStride + x * 4));
+                        __m128i r3 = _mm_loadu_si128((const __m128i*)(s + (intptr_t)3 * srcStride + x * 4));
+
+                        __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+                        __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+                        __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+                        __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+
+                        _mm_storeu_si128((__m128i*)(d + (intptr_t)(x + 0) * dstStride), _mm_unpacklo_epi64(t0, t1));
+                        _mm_storeu_si128((__m128i*)(d + (intptr_t)(x + 1) * dstStride), _mm_unpackhi_epi64(t0, t1));
+                        _mm_storeu_si128((__m128i*)(d + (intptr_t)(x + 2) * dstStride), _mm_unpacklo_epi64(t2, t3));
+                        _mm_storeu_si128((__m128i*)(d + (intptr_t)(x + 3) * dstStride), _mm_unpackhi_epi64(t2, t3));
+                    }
+                }
+            }
+        }
+
+        // Columns on the right, then rows at the bottom.
+        if (width4 < width)
+            TransposeBlock(src + width4 * 4, srcStride, dst + (intptr_t)width4 * dstStride, dstStride, width - width4, height, 4);
+
+        if (height4 < height)
+            TransposeBlock(src + (intptr_t)height4 * srcStride, srcStride, dst + height4 * 4, dstStride, width4, height - height4, 4);
+    }
+}
+
+namespace Kinovea { namespace Video { namespace FFMpeg { namespace Kernels
+{
+    void GrayToBGRARowSSE41(const uint8_t* src, uint8_t* dst, int width)
+    {
+        const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+
+        int x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+            __m128i gray = _mm_loadu_si128((const __m128i*)(src + x));
+            __m128i lo = _mm_unpacklo_epi8(gray, gray);
+            __m128i hi = _mm_unpackhi_epi8(gray, gray);
+            _mm_storeu_si128((__m128i*)(dst + x * 4 + 0), _mm_or_si128(_mm_unpacklo_epi16(lo, lo), alpha));
+            _mm_storeu_si128((__m128i*)(dst + x * 4 + 16), _mm_or_si128(_mm_unpackhi_epi16(lo, lo), alpha));
+            _mm_storeu_si128((__m128i*)(dst + x * 4 + 32), _mm_or_si128(_mm_unpacklo_epi16(hi, hi), alpha));
+            _mm_storeu_si128((__m128i*)(dst + x * 4 + 48), _mm_or_si128(_mm_unpackhi_epi16(hi, hi), alpha));
+        }
+
+        GrayToBGRARow(src + x, dst + x * 4, width - x);
+    }
+
+    void BGRToGrayRowSSE41(const uint8_t* src, uint8_t* dst, int width, int bytesPerPixel)
+    {
+        const __m128i coefficients = _mm_setr_epi16(29, 150, 77, 0, 29, 150, 77, 0);
+
+        int x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+            __m128i pixels[4];
+            LoadPixels(src + x * bytesPerPixel, bytesPerPixel, pixels);
+            _mm_storeu_si128((__m128i*)(dst + x), WeightedSum16(pixels, coefficients));
+        }
+
+        BGRToGrayRow(src + x * bytesPerPixel, dst + x, width - x, bytesPerPixel);
+    }
+
+    void BGRToLumaRowSSE41(const uint8_t* src, uint8_t* dst, int width, int bytesPerPixel)
+    {
+        const __m128i coefficients = _mm_setr_epi16(25, 129, 66, 0, 25, 129, 66, 0);
+        const __m128i offset = _mm_set1_epi8(16);
+
+        int x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+            __m128i pixels[4];
+            LoadPixels(src + x * bytesPerPixel, bytesPerPixel, pixels);
+            _mm_storeu_si128((__m128i*)(dst + x), _mm_add_epi8(WeightedSum16(pixels, coefficients), offset));
+        }
+
+        BGRToLumaRow(src + x * bytesPerPixel, dst + x, width - x, bytesPerPixel);
+    }
+
+    void YUV420PToBGRARowSSE41(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* dst, int width)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i k16 = _mm_set1_epi16(16);
+        const __m128i k128 = _mm_set1_epi16(128);
+        const __m128i k32 = _mm_set1_epi16(32);
+        const __m128i kY = _mm_set1_epi16(75);
+        const __m128i kRV = _mm_set1_epi16(102);
+        const __m128i kGU = _mm_set1_epi16(-25);
+        const __m128i kGV = _mm_set1_epi16(-52);
+        const __m128i kBU = _mm_set1_epi16(129);
+        const __m128i alpha = _mm_set1_epi8(-1);
+
+        // Blocks of 16 pixels, x stays even so the chroma of the tail is aligned.
+        int x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+            __m128i luma = _mm_loadu_si128((const __m128i*)(y + x));
+            __m128i y0 = _mm_mullo_epi16(_mm_sub_epi16(_mm_cvtepu8_epi16(luma), k16), kY);
+            __m128i y1 = _mm_mullo_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(luma, zero), k16), kY);
+
+            __m128i d = _mm_sub_epi16(_mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(u + x / 2))), k128);
+            __m128i e = _mm_sub_epi16(_mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(v + x / 2))), k128);
+            __m128i d0 = _mm_unpacklo_epi16(d, d);
+            __m128i d1 = _mm_unpackhi_epi16(d, d);
+            __m128i e0 = _mm_unpacklo_epi16(e, e);
+            __m128i e1 = _mm_unpackhi_epi16(e, e);
+
+            __m128i b0 = _mm_srai_epi16(_mm_adds_epi16(_mm_adds_epi16(y0, _mm_mullo_epi16(d0, kBU)), k32), 6);
+            __m128i b1 = _mm_srai_epi16(_mm_adds_epi16(_mm_adds_epi16(y1, _mm_mullo_epi16(d1, kBU)), k32), 6);
+            __m128i g0 = _mm_srai_epi16(_mm_adds_epi16(_mm_adds_epi16(_mm_adds_epi16(y0, _mm_mullo_epi16(d0, kGU)), _mm_mullo_epi16(e0, kGV)), k32), 6);
+            __m128i g1 = _mm_srai_epi16(_mm_adds_epi16(_mm_adds_epi16(_mm_adds_epi16(y1, _mm_mullo_epi16(d1, kGU)), _mm_mullo_epi16(e1, kGV)), k32), 6);
+            __m128i r0 = _mm_srai_epi16(_mm_adds_epi16(_mm_adds_epi16(y0, _mm_mullo_epi16(e0, kRV)), k32), 6);
+            __m128i r1 = _mm_srai_epi16(_mm_adds_epi16(_mm_adds_epi16(y1, _mm_mullo_epi16(e1, kRV)), k32), 6);
+
+            __m128i b = _mm_packus_epi16(b0, b1);
+            __m128i g = _mm_packus_epi16(g0, g1);
+            __m128i r = _mm_packus_epi16(r0, r1);
+
+            __m128i bgLo = _mm_unpacklo_epi8(b, g);
+            __m128i bgHi = _mm_unpackhi_epi8(b, g);
+            __m128i raLo = _mm_unpacklo_epi8(r, alpha);
+            __m128i raHi = _mm_unpackhi_epi8(r, alpha);
+
+            _mm_storeu_si128((__m128i*)(dst + x * 4 + 0), _mm_unpacklo_epi16(bgLo, raLo));
+            _mm_storeu_si128((__m128i*)(dst + x * 4 + 16), _mm_unpackhi_epi16(bgLo, raLo));
+            _mm_storeu_si128((__m128i*)(dst + x * 4 + 32), _mm_unpacklo_epi16(bgHi, raHi));
+            _mm_storeu_si128((__m128i*)(dst + x * 4 + 48), _mm_unpackhi_epi16(bgHi, raHi));
+        }
+
+        YUV420PToBGRARow(y + x, u + x / 2, v + x / 2, dst + x * 4, width - x);
+    }
+
+    void ReverseRowSSE41(const uint8_t* src, uint8_t* dst, int width, int bytesPerPixel)
+    {
+        int x = 0;
+        if (bytesPerPixel == 4)
+        {
+            for (; x + 4 <= width; x += 4)
+            {
+                __m128i pixels = _mm_loadu_si128((const __m128i*)(src + (width - x - 4) * 4));
+                _mm_storeu_si128((__m128i*)(dst + x * 4), _mm_shuffle_epi32(pixels, _MM_SHUFFLE(0, 1, 2, 3)));
+            }
+        }
+        else if (bytesPerPixel == 1)
+        {
+            const __m128i mask = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+            for (; x + 16 <= width; x += 16)
+            {
+                __m128i pixels = _mm_loadu_si128((const __m128i*)(src + width - x - 16));
+                _mm_storeu_si128((__m128i*)(dst + x), _mm_shuffle_epi8(pixels, mask));
+            }
+        }
+
+        // The remaining destination pixels are the reverse of the first source pixels.
+        ReverseRow(src, dst + x * bytesPerPixel, width - x, bytesPerPixel);
+    }
+
+    void FillSSE41(KernelTable* table)
+    {
+        table->bgr24ToBGRA = BGR24ToBGRARowSSE41;
+        table->bgraToBGR24 = BGRAToBGR24RowSSE41;
+        table->grayToBGRA = GrayToBGRARowSSE41;
+        table->grayToBGR24 = GrayToBGR24RowSSE41;
+        table->bgrToGray = BGRToGrayRowSSE41;
+        table->bgrToLuma = BGRToLumaRowSSE41;
+        table->yuv420pToBGRA = YUV420PToBGRARowSSE41;
+        table->reverse = ReverseRowSSE41;
+        table->transpose = TransposeSSE41;
+    }
+}}}}
+
+#else
+
+namespace Kinovea { namespace Video { namespace FFMpeg { namespace Kernels
+{
+    void FillSSE41(KernelTable* table)
+    {
+    }
+}}}}
+
+#endif
@@ -79,7 +79,7 @@ namespace Kinovea { namespace Video { namespace FFMpeg
 {
     [SupportedExtensions(
         ".3gp;.asf;.avi;.dv;.flv;.f4v;\
-        .m1v;.m2p;.m2t;.m2ts;.mts;.m2v;.m4v;.ts;.ts1;.ts2;.avr;\
+        .gif;.m1v;.m2p;.m2t;.m2ts;.mts;.m2v;.m4v;.ts;.ts1;.ts2;.avr;\
         .mkv;.mod;.mov;.moov;.mpg;.mpeg;.tod;.mxf;\
         .mp4;.mpv;.ogg;.ogm;.ogv;.qt;.rm;.swf;.vob;.webm;.wmv;.y4m;\
         *"
@@ -147,15 +147,20 @@ namespace Kinovea { namespace Video { namespace FFMpeg
         virtual bool MoveNext(int _skip, bool _decodeIfNecessary) override;
         virtual bool MoveTo(int64_t _timestamp) override;
         virtual VideoSummary^ ExtractSummary(String^ _filePath, int _thumbs, Size _maxSize) override;
+        virtual array<float>^ ExtractAudio(String^ _filePath, int _sampleRate, Func<float, bool>^ _progress) override;
         virtual void PostLoad() override;
         virtual String^ ReadMetadata() override;
         virtual bool ChangeAspectRatio(ImageAspectRatio _ratio) override;
         virtual bool ChangeImageRotation(ImageRotation rotation) override;
         virtual bool ChangeDemosaicing(Demosaicing demosaicing) override;
         virtual bool ChangeDeinterlace(bool _deint) override;
+        virtual bool ChangeFrameTransform(IFrameTransform^ _transform) override;
         virtual bool ChangeDecodingSize(Size _size) override;
         virtual void DisableCustomDecodingSize() override;
         virtual void BeforePlayloop() override;
+        virtual void ConfigurePreBuffer(int _framesBehind, int _framesAhead) override;
+        virtual void UpdatePlaybackSpeed(double _speed) override;
+        virtual void UpdatePresentationStride(int _stride) override;
         virtual void BeforeFrameEnumeration() override;
         virtual void AfterFrameEnumeration() override;
         virtual void UpdateWorkingZone(VideoSection _newZone, bool _forceReload, int _maxMemory, Action<DoWorkEventHandler^>^ _workerFn) override;
@@ -185,6 +190,7 @@ namespace Kinovea { namespace Video { namespace FFMpeg
         bool m_Prepend;
         Size m_DecodingSize;
         bool m_CanDrawUnscaled;
+        IFrameTransform^ m_FrameTransform;
 
         // Frame containers
         IVideoFramesContainer^ m_FramesContainer;
@@ -200,6 +206,7 @@ namespace Kinovea { namespace Video { namespace FFMpeg
         AVFormatContext* m_pFormatCtx;
         AVCodecContext* m_pCodecCtx;
         TimestampInfo m_TimestampInfo;
+        int64_t m_DecodedTimestamp;
         static const enum AVPixelFormat m_PixelFormatFFmpeg = AV_PIX_FMT_BGRA;
         static const int DecodingQuality = SWS_FAST_BILINEAR;
 
@@ -217,12 +224,15 @@ namespace Kinovea { namespace Video { namespace FFMpeg
         ReadResult ReadFrame(int64_t _iTimeStampToSeekTo, int _iFramesToDecode, bool _approximate);
         int SeekTo(int64_t _target);
         bool RescaleAndConvert(AVFrame* _pOutputFrame, AVFrame* _pInputFrame, int _OutputWidth, int _OutputHeight, int _OutputFmt, bool _bDeinterlace);
+        bool ConvertWithKernels(AVFrame* _pOutputFrame, AVFrame* _pInputFrame, AVPixelFormat _srcFormat, int _OutputWidth, int _OutputHeight, int _OutputFmt);
         static void DisposeFrame(VideoFrame^ _frame);
         static int GetStreamIndex(AVFormatContext* _pFormatCtx, int _iCodecType);
+        static void AppendResampled(SwrContext* _pSwrCtx, const uint8_t** _input, int _inputSamples, int _inputRate, int _outputRate, System::Collections::Generic::List<float>^ _samples);
         void UpdateReferenceSizes(ImageAspectRatio _ratio, bool verbose);
         Size FixSize(Size _size, bool sideways);
         void ResetDecodingSize();
         void PreBufferingWorker(Object^ _canceler);
+        void PrefetchBlock(PrefetchRequest^ _request, ThreadCanceler^ _canceler);
         bool WorkingZoneFitsInMemory(VideoSection _newZone, int _maxMemory);
         bool ReadMany(BackgroundWorker^ _bgWorker, VideoSection _section, bool _prepend);
         void SwitchDecodingMode(VideoDecodingMode _mode);
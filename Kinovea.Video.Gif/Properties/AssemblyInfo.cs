@@ -1,17 +0,0 @@
-﻿using System;
-using System.Reflection;
-using System.Runtime.InteropServices;
-using System.Resources;
-
-[assembly: AssemblyTitle("Kinovea.Video.Gif")]
-[assembly: AssemblyDescription("Kinovea - Reader for animated Gif")]
-[assembly: AssemblyConfiguration("")]
-[assembly: AssemblyCompany("Kinovea")]
-[assembly: AssemblyProduct("Kinovea")]
-[assembly: AssemblyCopyright("Copyright © 2006-2021 - Joan Charmant and contributors.")]
-[assembly: AssemblyTrademark("")]
-[assembly: AssemblyCulture("")]
-[assembly: AssemblyVersion("1.0.0")]
-[assembly: AssemblyFileVersion("1.0.0")]
-[assembly: NeutralResourcesLanguageAttribute("en")]
-[assembly: ComVisible(false)]
@@ -40,7 +40,8 @@ namespace Kinovea.Video
         CanChangeDecodingSize = 256,
         CanScaleIndefinitely = 512,
         CanChangeImageRotation = 1024,
-        CanChangeDemosaicing = 2048
+        CanChangeDemosaicing = 2048,
+        CanChangeFrameTransform = 4096
     }
     
     /// <summary>
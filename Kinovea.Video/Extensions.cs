@@ -34,12 +34,23 @@ namespace Kinovea.Video
         /// Extract a rectangular region out of a bitmap.
         /// </summary>
         public static Bitmap ExtractTemplate(this Bitmap image, Rectangle region)
+        {
+            BitmapData imageData = image.LockBits( new Rectangle( 0, 0, image.Width, image.Height ), ImageLockMode.ReadOnly, image.PixelFormat );
+            Bitmap template = imageData.ExtractTemplate(region);
+            image.UnlockBits(imageData);
+            
+            return template;
+        }
+
+        /// <summary>
+        /// Extract a rectangular region out of an already locked 32bpp image.
+        /// </summary>
+        public static Bitmap ExtractTemplate(this BitmapData imageData, Rectangle region)
         {
             // TODO: test perfs by simply drawing in the new image.
             
             Bitmap template = new Bitmap(region.Width, region.Height, PixelFormat.Format32bppPArgb);
             
-            BitmapData imageData = image.LockBits( new Rectangle( 0, 0, image.Width, image.Height ), ImageLockMode.ReadOnly, image.PixelFormat );
             BitmapData templateData = template.LockBits(new Rectangle( 0, 0, template.Width, template.Height ), ImageLockMode.ReadWrite, template.PixelFormat );
                 
             int pixelSize = 4;
@@ -49,8 +60,8 @@ namespace Kinovea.Video
             int tplOffset = tplStride - templateWidthInBytes;
             
             int imgStride = imageData.Stride;
-            int imageWidthInBytes = image.Width * pixelSize;
-            int imgOffset = imgStride - (image.Width * pixelSize) + imageWidthInBytes - templateWidthInBytes;
+            int imageWidthInBytes = imageData.Width * pixelSize;
+            int imgOffset = imgStride - (imageData.Width * pixelSize) + imageWidthInBytes - templateWidthInBytes;
             
             int startY = Math.Max(0, region.Top);
             int startX = Math.Max(0, region.Left);
@@ -76,7 +87,6 @@ namespace Kinovea.Video
                 }
             }
             
-            image.UnlockBits(imageData);
             template.UnlockBits(templateData);
             
             return template;
@@ -44,6 +44,7 @@ namespace Kinovea.Video
         
         #region Members
         private List<VideoFrame> m_Frames = new List<VideoFrame>();
+        private TimestampIndex m_Index = new TimestampIndex();
         private int m_CurrentIndex = -1;
         private VideoFrame m_Current;
         private VideoSection m_WorkingZone = VideoSection.Empty;
@@ -99,16 +100,22 @@ namespace Kinovea.Video
             if( m_Current != null && _timestamp == m_Current.Timestamp)
                 return true;
 
-            m_CurrentIndex = m_Frames.FindIndex(f => f.Timestamp >= _timestamp);
+            m_CurrentIndex = m_Index.FindIndex(_timestamp);
             UpdateCurrentFrame();
             return true;
         }
         public void Add(VideoFrame _frame)
         {
             if(m_PrependingBlock)
+            {
+                m_Index.Insert(m_InsertIndex, _frame.Timestamp);
                 m_Frames.Insert(m_InsertIndex++, _frame);
+            }
             else
+            {
+                m_Index.Add(_frame.Timestamp);
                 m_Frames.Add(_frame);
+            }
                 
             UpdateWorkingZone();
         }
@@ -121,6 +128,7 @@ namespace Kinovea.Video
                 DisposeFrame(frame);
                 
             m_Frames.Clear();
+            m_Index.Clear();
             m_WorkingZone = VideoSection.Empty;
         }
         /// <summary>
@@ -150,6 +158,7 @@ namespace Kinovea.Video
                 m_CurrentIndex-=removedAtLeft;
             
             m_Frames.RemoveAll(frame => object.ReferenceEquals(null, frame));
+            m_Index.Rebuild(m_Frames);
             
             m_CurrentIndex = Math.Max(0, m_CurrentIndex);
             m_Current = m_Frames[m_CurrentIndex];
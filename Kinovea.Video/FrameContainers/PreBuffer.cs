@@ -30,19 +30,29 @@ using Kinovea.Services;
 namespace Kinovea.Video
 {
     /// <summary>
-    /// A buffer to anticipate some frames from the future, and remember some from the past.
+    /// A buffer to anticipate some frames from the future, and remember some from the past.
     /// The prebuffered section is entirely contained inside the working zone boundaries.
     /// It is a contiguous set of frames, except that it may wrap over the end of the working zone.
+    ///
+    /// The buffer keeps a window of frames behind and ahead of the current frame, the decoding thread asks for
+    /// the next piece of work with WaitForRequest. Frames ahead are decoded one at a time and roll over to the start
+    /// of the working zone when the end is reached, so the loop point is already decoded when playback gets there.
+    /// Frames behind are decoded in blocks, as each block costs a seek.
+    /// The split of the window follows the playback: during playback the side ahead grows with the speed,
+    /// when paused and stepping backward the sides are mirrored.
+    /// When the playback only presents one frame every "stride" frames, only those frames are stored,
+    /// and moves are counted in presented frames.
     /// </summary>
     /// <remarks>
     /// Naming:
     /// - Segment: the section of prebuffered frames, contained inside the working zone.
-    /// - OldFramesCapacity: the number of frames kept that are older than the current point.
+    /// - Behind/Ahead capacity: the number of frames kept before and after the current frame.
     ///
     /// Thread safety:
     /// Locking is necessary around all access to m_Frames as it is read and written by both the UI and the decoding thread.
     /// Assumedly, there is no need to lock around access to m_Current.
     /// This is because m_Frames is only accessed for add by the decoding thread and this has no impact on m_Current reference.
+    /// Prepended frames shift m_CurrentIndex, this is done under the lock.
     /// The only thing that alters the reference to m_Current are: MoveNext, MoveTo, PurgeOutsiders, Clear.
     /// All these are initiated by the UI thread itself, so it will not be using m_Current simultaneously.
     /// Similarly, drop count is only updated in MoveNext and MoveTo, so only from the UI thread.
@@ -59,20 +69,40 @@ namespace Kinovea.Video
         public int Drops { 
             get { return m_Drops; }
         }
+        /// <summary>
+        /// Whether the current prepend request still expects frames.
+        /// </summary>
+        public bool Prepending {
+            get { lock(m_Locker) return IsPrepending(); }
+        }
         #endregion
         
         #region Members
         private List<VideoFrame> m_Frames = new List<VideoFrame>();
         private VideoSection m_Segment = VideoSection.Empty;
         private VideoSection m_WorkingZone = VideoSection.Empty;
+        private long m_FrameInterval;
         private int m_CurrentIndex = -1;
         private VideoFrame m_Current;
+        private long m_LastPosition = -1;
         private readonly object m_Locker = new object();
         
-        private int m_DefaultTotalCapacity = 25;
-        private int m_TotalCapacity = 25;
-        private int m_DefaultOldFramesCapacity = 8;
-        private int m_OldFramesCapacity = 8; // Will later be taken from Prefs, possibly in MB instead of frames.
+        // Window configuration, and its current split depending on direction and speed.
+        private int m_FramesBehind = 8;
+        private int m_FramesAhead = 16;
+        private int m_BehindCapacity = 8;
+        private int m_AheadCapacity = 16;
+        private bool m_Backward;
+        private double m_Speed;
+        private int m_Stride = 1;
+
+        // State of the request being served by the decoding thread.
+        private PrefetchRequest m_Request;
+        private int m_PrependIndex = -1;
+        private int m_Prepended;
+        private long m_PrependStall = -1;
+        private bool m_EndReached;
+
         private int m_Drops;
         private VideoFrameDisposer m_DisposeBitmap;
         private TimeWatcher m_TimeWatcher = new TimeWatcher();
@@ -109,7 +139,7 @@ namespace Kinovea.Video
             lock(m_Locker)
             {
                 int lastIndex = m_Frames.Count - 1;
-                int expectedCurrentIndex = m_CurrentIndex + m_Drops + _frames - 1;
+                int expectedCurrentIndex = m_CurrentIndex + m_Drops + ToSteps(_frames) - 1;
             
                 if(expectedCurrentIndex < lastIndex)
                 {
@@ -125,17 +155,27 @@ namespace Kinovea.Video
                 
                 if(m_CurrentIndex >= 0 && m_CurrentIndex <= lastIndex)
                     m_Current = m_Frames[m_CurrentIndex];
+
+                UpdateDirection(false);
             }
             
-            // ForgetOldFrames will take another lock, should it be inside the first ?
+            // Trim will take another lock, should it be inside the first ?
             // It will possibily do a Pulse.
-            ForgetOldFrames();
+            Trim();
             //m_TimeWatcher.DumpTimes();
             return read;
         }
         public bool MoveTo(long _timestamp)
         {
             m_Drops = 0;
+
+            // The direction is updated even if the frame isn't there yet,
+            // the reader will decode it and move again after clearing the buffer.
+            lock(m_Locker)
+            {
+                if(m_LastPosition >= 0 && _timestamp != m_LastPosition && _timestamp != m_WorkingZone.Start)
+                    UpdateDirection(_timestamp < m_LastPosition);
+            }
                 
             if(!Contains(_timestamp))
                 return false;
@@ -145,20 +185,18 @@ namespace Kinovea.Video
 
             lock(m_Locker)
             {
-                foreach(int i in SortedFrames())
-                {
-                    if(m_Frames[i].Timestamp >= _timestamp)
-                    {
-                        m_CurrentIndex = i;
-                        break;
-                    }
-                }
+                int index = FindIndex(_timestamp);
+                if(index >= 0)
+                    m_CurrentIndex = index;
             
                 if(m_CurrentIndex >= 0 && m_CurrentIndex <= m_Frames.Count - 1)
                     m_Current = m_Frames[m_CurrentIndex];
+
+                if(m_Current != null)
+                    m_LastPosition = m_Current.Timestamp;
             }
             
-            ForgetOldFrames();
+            Trim();
             
             return true;
         }
@@ -169,22 +207,29 @@ namespace Kinovea.Video
         public bool HasNext(int _skip)
         {
             lock(m_Locker)
-                return m_CurrentIndex + m_Drops + _skip + 1 < m_Frames.Count;
+                return m_CurrentIndex + m_Drops + ToSteps(_skip + 1) < m_Frames.Count;
         }
         public void Add(VideoFrame _frame)
         {
             lock(m_Locker)
             {
-                //log.DebugFormat("Add - Pushing frame [{0}] to prebuffer. ({1}/{2}).", _frame.Timestamp, m_Frames.Count+1, m_TotalCapacity);
-                m_Frames.Add(_frame);
-                UpdateSegment();
-                while (m_Frames.Count >= m_TotalCapacity)
+                //log.DebugFormat("Add - Pushing frame [{0}] to prebuffer. ({1}).", _frame.Timestamp, m_Request);
+                if(m_Request == null)
                 {
-                    // Will release its lock and freeze until there is a pulse.
-                    // We do this after the actual Add so the decoding thread, when woken up,
-                    // can check for cancellation *before* pushing another frame.
-                    Monitor.Wait(m_Locker);
+                    // Synchronous decoding from the UI thread, the decoding thread is stopped.
+                    m_Frames.Add(_frame);
+                }
+                else if(m_Request.Kind == PrefetchKind.Prepend)
+                {
+                    AddBehind(_frame);
+                }
+                else
+                {
+                    AddAhead(_frame);
                 }
+
+                UpdateSegment();
+                Monitor.PulseAll(m_Locker);
             }
         }
         public bool Contains(long _timestamp)
@@ -216,42 +261,141 @@ namespace Kinovea.Video
                 m_CurrentIndex = -1;
                 m_Drops = 0;
                 m_Segment = VideoSection.Empty;
-                m_TotalCapacity = m_DefaultTotalCapacity;
-                m_OldFramesCapacity = m_DefaultOldFramesCapacity;
+                m_PrependIndex = -1;
+                m_PrependStall = -1;
+                m_EndReached = false;
                 
-                Monitor.Pulse(m_Locker);
+                Monitor.PulseAll(m_Locker);
             }
         }
-        public void UnblockAndMakeRoom()
+
+        /// <summary>
+        /// Sets the number of frames kept behind and ahead of the current frame, at normal speed and going forward.
+        /// </summary>
+        public void SetWindow(int _framesBehind, int _framesAhead)
         {
             lock(m_Locker)
             {
-                // This is used to temporarily deactivate the prebuffering thread without 
-                // completely clearing it. The decoding thread is potentially waiting on a full buffer,
-                // so we must discard at least one frame to make it run again and check for cancellation.
-                // However, the next Add is assumed to run on the UI thread, so it must not block.
-                // So we actually need to have two empty slots: one to push the read,
-                // and one to make that push non-blocking.
-                log.Debug("Unblocking prebuffering thread and making room for a non blocking addition.");
+                m_FramesBehind = Math.Max(1, _framesBehind);
+                m_FramesAhead = Math.Max(2, _framesAhead);
+                UpdateCapacities();
+                Monitor.PulseAll(m_Locker);
+            }
                 
-                while(m_Frames.Count > m_TotalCapacity - 2)
-                {
-                    DisposeFrame(m_Frames[0]);
-                    m_Frames.RemoveAt(0);
-                    m_CurrentIndex--;
-                }
-                UpdateSegment();
+            log.DebugFormat("Prebuffer window: {0} frames behind, {1} frames ahead.", m_FramesBehind, m_FramesAhead);
+        }
                 
-                Monitor.Pulse(m_Locker);
+        /// <summary>
+        /// Sets the playback speed as the number of frames shown per frame interval of the video. 0 when paused.
+        /// </summary>
+        public void SetSpeed(double _speed)
+        {
+            lock(m_Locker)
+            {
+                m_Speed = Math.Max(0, _speed);
+                UpdateCapacities();
+                Monitor.PulseAll(m_Locker);
             }
         }
         
-        public void UpdateWorkingZone(VideoSection _newZone)
+        /// <summary>
+        /// Sets the number of video frames between two presented frames during playback. 1 when paused.
+        /// </summary>
+        public void SetStride(int _stride)
+        {
+            lock(m_Locker)
+            {
+                _stride = Math.Max(1, _stride);
+                if(_stride == m_Stride)
+                    return;
+
+                // Keep the frames that fall on the new grid around the current frame.
+                // Coming from a sparse buffer, the only frame we know to be on the grid is the current one.
+                Decimate(m_Stride == 1 ? _stride : int.MaxValue);
+
+                m_Stride = _stride;
+                UpdateCapacities();
+                Monitor.PulseAll(m_Locker);
+            }
+        }
+
+        /// <summary>
+        /// Blocks the decoding thread until the window needs more frames, and returns what to decode.
+        /// Returns null when the thread should exit.
+        /// The request is active until EndRequest, the frames added in the meantime are placed according to it.
+        /// </summary>
+        public PrefetchRequest WaitForRequest(ThreadCanceler _canceler)
+        {
+            lock(m_Locker)
+            {
+                while(true)
+                {
+                    // The cancellation is checked under the lock so the pulse from Unblock can't be missed.
+                    if(_canceler.CancellationPending)
+                        return null;
+
+                    PrefetchRequest request = NextRequest();
+                    if(request != null)
+                    {
+                        m_Request = request;
+                        m_Prepended = 0;
+                        m_PrependIndex = request.Kind == PrefetchKind.Prepend ? 0 : -1;
+                        if(request.Kind == PrefetchKind.Rollover)
+                            m_EndReached = false;
+
+                        return request;
+                    }
+
+                    Monitor.Wait(m_Locker);
+                }
+            }
+        }
+        public void EndRequest()
+        {
+            lock(m_Locker)
+            {
+                // A block that didn't bring any new frame would be asked again and again.
+                // This happens when the seek can't land before the first frame.
+                if(m_Request != null && m_Request.Kind == PrefetchKind.Prepend && m_Prepended == 0)
+                    m_PrependStall = m_Request.From;
+
+                m_Request = null;
+                m_PrependIndex = -1;
+            }
+        }
+
+        /// <summary>
+        /// Signals that the decoder couldn't read past the last frame. The next frames ahead will come from the start of the working zone.
+        /// </summary>
+        public void MarkEnd()
+        {
+            lock(m_Locker)
+            {
+                m_EndReached = true;
+                Monitor.PulseAll(m_Locker);
+            }
+        }
+
+        /// <summary>
+        /// Wakes the decoding thread up so it can check for cancellation.
+        /// </summary>
+        public void Unblock()
+        {
+            lock(m_Locker)
+                Monitor.PulseAll(m_Locker);
+        }
+
+        public void UpdateWorkingZone(VideoSection _newZone, long _frameInterval)
         {
             if(m_Frames.Count > 0)
                 Clear();
             
-            m_WorkingZone = _newZone;
+            lock(m_Locker)
+            {
+                m_WorkingZone = _newZone;
+                m_FrameInterval = _frameInterval;
+                m_EndReached = false;
+            }
         }
         /// <summary>
         /// Remove all items that are outside the working zone.
@@ -285,8 +429,10 @@ namespace Kinovea.Video
                 
                 m_Frames.RemoveAll(frame => object.ReferenceEquals(null, frame));
                 UpdateSegment();
+                m_PrependIndex = -1;
+                m_EndReached = false;
                 
-                Monitor.Pulse(m_Locker);
+                Monitor.PulseAll(m_Locker);
             }
         }
         public bool IsRolloverJump(long _timestamp)
@@ -309,6 +455,186 @@ namespace Kinovea.Video
         #endregion
         
         #region Private methods
+        private PrefetchRequest NextRequest()
+        {
+            // Decide what the decoding thread should do next, if anything.
+            // Frames ahead come first, they are the ones needed for playback.
+            // Always inside a lock.
+            if(m_Frames.Count == 0)
+                return new PrefetchRequest(PrefetchKind.Append, -1, m_WorkingZone.Start);
+
+            if(IsComplete())
+                return null;
+
+            int behind = Math.Max(0, m_CurrentIndex);
+            int ahead = m_Frames.Count - 1 - m_CurrentIndex;
+            long first = m_Frames[0].Timestamp;
+            long last = m_Frames[m_Frames.Count - 1].Timestamp;
+
+            // A short working zone is decoded entirely, whatever the window.
+            if(ahead < m_AheadCapacity || ZoneFits())
+            {
+                if(m_EndReached)
+                    return new PrefetchRequest(PrefetchKind.Rollover, last, m_WorkingZone.Start);
+                else
+                    return new PrefetchRequest(PrefetchKind.Append, last, last + m_Stride * m_FrameInterval, m_Stride);
+            }
+
+            // Wait for the frames behind to be half gone before decoding a new block, to amortize the seek.
+            // Frames behind are only useful when paused, for stepping back.
+            bool canPrepend = m_Speed == 0 && m_FrameInterval > 0 && !m_Segment.Wrapped && !IsZoneStart(first) && first != m_PrependStall;
+            if(canPrepend && behind <= m_BehindCapacity / 2)
+            {
+                long target = Math.Max(m_WorkingZone.Start, first - (m_BehindCapacity - behind) * m_FrameInterval);
+                return new PrefetchRequest(PrefetchKind.Prepend, first, target);
+            }
+
+            return null;
+        }
+        private void AddAhead(VideoFrame _frame)
+        {
+            // Always inside a lock.
+            long last = m_Frames.Count == 0 ? -1 : m_Frames[m_Frames.Count - 1].Timestamp;
+            if(last != m_Request.From || IsComplete())
+            {
+                // The frames ahead were trimmed while this one was decoding.
+                DisposeFrame(_frame);
+            }
+            else if(_frame.Timestamp > m_WorkingZone.End)
+            {
+                DisposeFrame(_frame);
+                m_EndReached = true;
+            }
+            else if(_frame.Timestamp < m_WorkingZone.Start)
+            {
+                DisposeFrame(_frame);
+            }
+            else
+            {
+                m_Frames.Add(_frame);
+            }
+        }
+        private void AddBehind(VideoFrame _frame)
+        {
+            // Insert the frames of the block in order, in front of the buffer.
+            // Always inside a lock.
+            if(m_PrependIndex < 0 || _frame.Timestamp >= m_Request.From)
+            {
+                // Reached the frames we already had, or the buffer was cleared in the meantime.
+                DisposeFrame(_frame);
+                m_PrependIndex = -1;
+                return;
+            }
+
+            m_Frames.Insert(m_PrependIndex, _frame);
+            m_PrependIndex++;
+            m_Prepended++;
+            if(m_CurrentIndex >= 0)
+                m_CurrentIndex++;
+        }
+        private bool IsPrepending()
+        {
+            return m_Request != null && m_Request.Kind == PrefetchKind.Prepend && m_PrependIndex >= 0;
+        }
+        private bool IsZoneStart(long _timestamp)
+        {
+            return _timestamp < m_WorkingZone.Start + Math.Max(1, m_FrameInterval);
+        }
+        private bool IsComplete()
+        {
+            // Whether the buffer holds the entire working zone.
+            // Always inside a lock.
+            if(m_Frames.Count == 0)
+                return false;
+
+            if(m_Segment.Wrapped)
+                return m_Segment.End + m_Stride * m_FrameInterval >= m_Segment.Start;
+            else
+                return m_EndReached && IsZoneStart(m_Segment.Start);
+        }
+        private bool ZoneFits()
+        {
+            // Short working zones are kept entirely, looping then never needs to decode.
+            if(m_FrameInterval <= 0 || m_WorkingZone.IsEmpty)
+                return false;
+
+            long frames = (m_WorkingZone.End - m_WorkingZone.Start) / (m_Stride * m_FrameInterval) + 1;
+            return frames <= m_FramesBehind + m_FramesAhead;
+        }
+        private void UpdateDirection(bool _backward)
+        {
+            // Always inside a lock.
+            if(m_Current != null)
+                m_LastPosition = m_Current.Timestamp;
+
+            if(_backward == m_Backward)
+                return;
+
+            m_Backward = _backward;
+            UpdateCapacities();
+        }
+        private void UpdateCapacities()
+        {
+            // The total is constant, only the split changes.
+            // During playback the side ahead follows the speed: fast playback consumes more frames per decoding slot
+            // and slow motion leaves time to keep more frames behind, for stepping back.
+            // Stepping backward is only possible when paused, the configured split is then mirrored.
+            // Always inside a lock.
+            int total = m_FramesBehind + m_FramesAhead;
+            int forward = m_FramesAhead;
+            if(m_Speed > 0)
+                forward = (int)Math.Ceiling(m_FramesAhead * m_Speed / m_Stride);
+
+            forward = Math.Min(Math.Max(forward, 2), total - 1);
+
+            if(m_Backward && m_Speed == 0)
+            {
+                m_BehindCapacity = forward;
+                m_AheadCapacity = total - forward;
+            }
+            else
+            {
+                m_AheadCapacity = forward;
+                m_BehindCapacity = total - forward;
+            }
+        }
+        private int ToSteps(int _frames)
+        {
+            // Convert a move in video frames to a move in stored frames.
+            if(m_Stride == 1 || _frames <= 0)
+                return _frames;
+
+            return Math.Max(1, _frames / m_Stride);
+        }
+        private void Decimate(int _step)
+        {
+            // Keep one frame every _step frames, aligned on the current frame.
+            // Always inside a lock.
+            if(m_CurrentIndex < 0)
+                return;
+
+            List<VideoFrame> kept = new List<VideoFrame>();
+            int currentIndex = 0;
+            for(int i = 0; i < m_Frames.Count; i++)
+            {
+                if((i - m_CurrentIndex) % _step != 0)
+                {
+                    DisposeFrame(m_Frames[i]);
+                    continue;
+                }
+
+                if(i == m_CurrentIndex)
+                    currentIndex = kept.Count;
+
+                kept.Add(m_Frames[i]);
+            }
+
+            m_Frames = kept;
+            m_CurrentIndex = currentIndex;
+            m_PrependIndex = -1;
+            m_EndReached = false;
+            UpdateSegment();
+        }
         private IEnumerable<int> SortedFrames()
         {
             // /!\ Should only be called from inside a lock construct.
@@ -351,30 +677,90 @@ namespace Kinovea.Video
             if(m_Frames.Count < 2 || !m_Segment.Wrapped)
                 return 0;
             
-            int i = 1;
-            while(m_Frames[i].Timestamp > m_Frames[i-1].Timestamp)
-                i++;
+            // Frames before the break are all later than the first frame, frames after it are all earlier.
+            long first = m_Frames[0].Timestamp;
+            int low = 1;
+            int high = m_Frames.Count;
+            while(low < high)
+            {
+                int mid = low + ((high - low) >> 1);
+                if(m_Frames[mid].Timestamp >= first)
+                    low = mid + 1;
+                else
+                    high = mid;
+            }
+            
+            return low;
+        }
+        private int FindIndex(long _timestamp)
+        {
+            // Return the index of the first frame in timestamp order that is at or after the passed timestamp, or -1.
+            // The buffer is made of at most two sorted runs: [wrapIndex, count) then [0, wrapIndex).
+            // Always inside a lock.
+            int wrapIndex = GetWrapIndex();
+            int index = LowerBound(wrapIndex, m_Frames.Count, _timestamp);
+            if(index < m_Frames.Count)
+                return index;
             
-            return i;
+            index = LowerBound(0, wrapIndex, _timestamp);
+            return index < wrapIndex ? index : -1;
         }
-        private void ForgetOldFrames()
+        private int LowerBound(int _start, int _end, long _timestamp)
         {
-            if(m_CurrentIndex < m_OldFramesCapacity)
-                return;
-
+            int low = _start;
+            int high = _end;
+            while(low < high)
+            {
+                int mid = low + ((high - low) >> 1);
+                if(m_Frames[mid].Timestamp < _timestamp)
+                    low = mid + 1;
+                else
+                    high = mid;
+            }
+            
+            return low;
+        }
+        private void Trim()
+        {
+            // Forget the frames that are outside the window around the current frame.
             lock(m_Locker)
             {
-                int framesToForget = m_CurrentIndex - m_OldFramesCapacity + 1;
+                if(m_CurrentIndex < 0)
+                    return;
                 
-                for(int i=0;i<framesToForget;i++)
-                    DisposeFrame(m_Frames[i]);
+                // Short working zones are kept entirely, but the decoding thread may still be waiting for the current frame to move.
+                if(ZoneFits())
+                {
+                    Monitor.PulseAll(m_Locker);
+                    return;
+                }
+                
+                int ahead = m_Frames.Count - 1 - m_CurrentIndex;
+                if(ahead > m_AheadCapacity)
+                {
+                    int framesToForget = ahead - m_AheadCapacity;
+                    int start = m_Frames.Count - framesToForget;
+                    for(int i = start; i < m_Frames.Count; i++)
+                        DisposeFrame(m_Frames[i]);
+
+                    m_Frames.RemoveRange(start, framesToForget);
+                    m_EndReached = false;
+                }
 
-                m_Frames.RemoveRange(0, framesToForget);
-                m_CurrentIndex -= framesToForget;
+                // Frames in front can't be removed while a block is being inserted there.
+                if(m_CurrentIndex > m_BehindCapacity && !IsPrepending())
+                {
+                    int framesToForget = m_CurrentIndex - m_BehindCapacity;
+                    for(int i = 0; i < framesToForget; i++)
+                        DisposeFrame(m_Frames[i]);
+
+                    m_Frames.RemoveRange(0, framesToForget);
+                    m_CurrentIndex -= framesToForget;
+                }
                 
                 UpdateSegment();
                 
-                Monitor.Pulse(m_Locker);
+                Monitor.PulseAll(m_Locker);
             }
         }
         #endregion
@@ -0,0 +1,85 @@
+﻿#region License
+/*
+Copyright © Joan Charmant 2021.
+jcharmant@gmail.com
+
+This file is part of Kinovea.
+
+Kinovea is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2
+as published by the Free Software Foundation.
+
+Kinovea is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Kinovea. If not, see http://www.gnu.org/licenses/.
+*/
+#endregion
+using System;
+
+namespace Kinovea.Video
+{
+    public enum PrefetchKind
+    {
+        /// <summary>
+        /// Decode the frame following the last frame of the buffer.
+        /// </summary>
+        Append,
+
+        /// <summary>
+        /// Decode the first frame of the working zone after the end was reached, for looping.
+        /// </summary>
+        Rollover,
+
+        /// <summary>
+        /// Decode a block of frames right before the first frame of the buffer.
+        /// </summary>
+        Prepend
+    }
+
+    /// <summary>
+    /// A unit of work for the prebuffering thread, decided by the prefetch policy of the PreBuffer.
+    /// </summary>
+    public class PrefetchRequest
+    {
+        public PrefetchKind Kind { get; private set; }
+
+        /// <summary>
+        /// The buffered frame the request continues from: the last frame for Append and Rollover, the first frame for Prepend.
+        /// -1 if the buffer is empty.
+        /// </summary>
+        public long From { get; private set; }
+
+        /// <summary>
+        /// Timestamp to seek to if the decoder is not already positioned right after From.
+        /// </summary>
+        public long Target { get; private set; }
+
+        /// <summary>
+        /// Number of frames to decode linearly from From, only the last one is kept.
+        /// Greater than one when the playback only presents one frame every few frames.
+        /// </summary>
+        public int Frames { get; private set; }
+
+        public PrefetchRequest(PrefetchKind _kind, long _from, long _target)
+            : this(_kind, _from, _target, 1)
+        {
+        }
+
+        public PrefetchRequest(PrefetchKind _kind, long _from, long _target, int _frames)
+        {
+            Kind = _kind;
+            From = _from;
+            Target = _target;
+            Frames = _frames;
+        }
+
+        public override string ToString()
+        {
+            return string.Format("{0} from [{1}], target:[{2}], frames:{3}", Kind, From, Target, Frames);
+        }
+    }
+}
@@ -0,0 +1,152 @@
+﻿#region License
+/*
+Copyright © Joan Charmant 2011.
+jcharmant@gmail.com
+
+This file is part of Kinovea.
+
+Kinovea is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2
+as published by the Free Software Foundation.
+
+Kinovea is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Kinovea. If not, see http://www.gnu.org/licenses/.
+*/
+#endregion
+using System;
+using System.Collections.Generic;
+
+namespace Kinovea.Video
+{
+    /// <summary>
+    /// Contiguous array of timestamps, parallel to a list of frames sorted by time.
+    /// Lookups are direct arithmetic when the frames are evenly spaced (constant frame rate files)
+    /// and binary search otherwise.
+    /// </summary>
+    public class TimestampIndex
+    {
+        public int Count
+        {
+            get { return m_Timestamps.Count; }
+        }
+
+        private List<long> m_Timestamps = new List<long>();
+        private bool m_Analyzed;
+        private long m_Interval;    // Common interval between consecutive timestamps, 0 if the spacing is irregular.
+
+        public void Add(long _timestamp)
+        {
+            int count = m_Timestamps.Count;
+            m_Timestamps.Add(_timestamp);
+
+            // Appending keeps the analysis valid as long as the spacing is unchanged.
+            if (m_Analyzed && m_Interval != 0 && count > 0 && _timestamp - m_Timestamps[count - 1] != m_Interval)
+                m_Interval = 0;
+            else if (count < 2)
+                m_Analyzed = false;
+        }
+
+        public void Insert(int _index, long _timestamp)
+        {
+            m_Timestamps.Insert(_index, _timestamp);
+            m_Analyzed = false;
+        }
+
+        public void Clear()
+        {
+            m_Timestamps.Clear();
+            m_Analyzed = false;
+        }
+
+        /// <summary>
+        /// Rebuild the index from scratch. To be used after bulk removals.
+        /// </summary>
+        public void Rebuild(List<VideoFrame> _frames)
+        {
+            m_Timestamps.Clear();
+            if (m_Timestamps.Capacity < _frames.Count)
+                m_Timestamps.Capacity = _frames.Count;
+
+            foreach (VideoFrame frame in _frames)
+                m_Timestamps.Add(frame.Timestamp);
+
+            m_Analyzed = false;
+        }
+
+        /// <summary>
+        /// Returns the index of the first frame whose timestamp is greater or equal to the passed timestamp,
+        /// or -1 if there is no such frame.
+        /// </summary>
+        public int FindIndex(long _timestamp)
+        {
+            int count = m_Timestamps.Count;
+            if (count == 0 || _timestamp > m_Timestamps[count - 1])
+                return -1;
+
+            if (_timestamp <= m_Timestamps[0])
+                return 0;
+
+            if (!m_Analyzed)
+                Analyze();
+
+            if (m_Interval > 0)
+            {
+                long offset = _timestamp - m_Timestamps[0];
+                long index = offset / m_Interval;
+                if (offset % m_Interval != 0)
+                    index++;
+
+                return (int)Math.Min(index, count - 1);
+            }
+
+            return LowerBound(m_Timestamps, 0, count, _timestamp);
+        }
+
+        /// <summary>
+        /// Index of the first element of the sorted range [_start, _end) that is greater or equal to the value,
+        /// or _end if all elements are smaller.
+        /// </summary>
+        private static int LowerBound(List<long> _values, int _start, int _end, long _value)
+        {
+            int low = _start;
+            int high = _end;
+            while (low < high)
+            {
+                int mid = low + ((high - low) >> 1);
+                if (_values[mid] < _value)
+                    low = mid + 1;
+                else
+                    high = mid;
+            }
+
+            return low;
+        }
+
+        private void Analyze()
+        {
+            m_Analyzed = true;
+            m_Interval = 0;
+
+            int count = m_Timestamps.Count;
+            if (count < 2)
+                return;
+
+            long interval = m_Timestamps[1] - m_Timestamps[0];
+            if (interval <= 0)
+                return;
+
+            for (int i = 2; i < count; i++)
+            {
+                if (m_Timestamps[i] - m_Timestamps[i - 1] != interval)
+                    return;
+            }
+
+            m_Interval = interval;
+        }
+    }
+}
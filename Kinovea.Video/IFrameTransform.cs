@@ -0,0 +1,38 @@
+﻿#region License
+/*
+Copyright © Joan Charmant 2011.
+jcharmant@gmail.com 
+ 
+This file is part of Kinovea.
+
+Kinovea is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License version 2 
+as published by the Free Software Foundation.
+
+Kinovea is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Kinovea. If not, see http://www.gnu.org/licenses/.
+*/
+#endregion
+using System;
+using System.Drawing;
+
+namespace Kinovea.Video
+{
+    /// <summary>
+    /// Image transformation applied by the video reader to each decoded image, before it enters the frame container.
+    /// The transformation is done once per frame and the result is what gets cached, played back and tracked.
+    /// Implementations are called from the decoding thread.
+    /// </summary>
+    public interface IFrameTransform
+    {
+        /// <summary>
+        /// Transform the image in place. The image may be at a reduced decoding size.
+        /// </summary>
+        void Apply(Bitmap image);
+    }
+}
@@ -119,6 +119,9 @@ namespace Kinovea.Video
         {
             get { return (Flags & VideoCapabilities.CanScaleIndefinitely) != 0; }
         }
+        public bool CanChangeFrameTransform {
+            get { return (Flags & VideoCapabilities.CanChangeFrameTransform) != 0; }
+        }
         #endregion
 
         #region Members
@@ -217,6 +220,25 @@ namespace Kinovea.Video
             // Might be used to ensure the prebuffering thread is started.
             // Does nothing by default. Override to implement.
         }
+        public virtual void ConfigurePreBuffer(int framesBehind, int framesAhead)
+        {
+            // Called before opening a video, with the number of frames to keep around the current frame.
+            // Does nothing by default. Override to implement.
+        }
+        public virtual void UpdatePlaybackSpeed(double speed)
+        {
+            // Called when the playback starts, changes speed or stops.
+            // The speed is the number of video frames shown per frame interval of the video, 0 when paused.
+            // Might be used to balance the prebuffered frames between the past and the future.
+            // Does nothing by default. Override to implement.
+        }
+        public virtual void UpdatePresentationStride(int stride)
+        {
+            // Called when the playback starts or stops, with the number of video frames between two presented frames.
+            // The frames in between will not be shown, the reader may skip converting or even decoding them.
+            // 1 when paused, all frames may then be shown.
+            // Does nothing by default. Override to implement.
+        }
         
         /// <summary>
         /// Force a specific aspect ratio.
@@ -254,6 +276,15 @@ namespace Kinovea.Video
             // Does nothing by default. Override to implement.
             return false;
         }
+        /// <summary>
+        /// Set the transformation applied to each decoded image, or null for none.
+        /// </summary>
+        /// <returns>returns true if the cache has been invalidated by the operation</returns>
+        public virtual bool ChangeFrameTransform(IFrameTransform transform)
+        {
+            // Does nothing by default. Override to implement.
+            return false;
+        }
         
         /// <summary>
         /// Ask the reader to provide its images at a specific size.
@@ -277,11 +308,18 @@ namespace Kinovea.Video
         /// Provide a lazy enumerator on each frame of the Working Zone.
         /// </summary>
         public IEnumerable<VideoFrame> FrameEnumerator(long interval)
+        {
+            return FrameEnumerator(WorkingZone.Start, interval);
+        }
+        /// <summary>
+        /// Enumerates frames from the passed time to the end of the working zone.
+        /// </summary>
+        public IEnumerable<VideoFrame> FrameEnumerator(long start, long interval)
         {
             if(DecodingMode == VideoDecodingMode.PreBuffering)
                 throw new ThreadStateException("Frame enumerator called while prebuffering");
             
-            bool hasMore = MoveFirst();
+            bool hasMore = MoveTo(start);
             yield return Current;
             
             while(hasMore)
@@ -303,6 +341,16 @@ namespace Kinovea.Video
         {
             return "";
         }
+
+        /// <summary>
+        /// Decodes the audio track to mono samples at the requested rate, placed on the timeline of the file: sample 0 is at time 0.
+        /// Returns null if there is no audio, if the reader doesn't support audio, or if the progress callback returned false.
+        /// Called from a background thread, the implementation must not use the state of the opened video.
+        /// </summary>
+        public virtual float[] ExtractAudio(string filePath, int sampleRate, Func<float, bool> progress)
+        {
+            return null;
+        }
         public virtual void ResetDrops()
         {
             // Called when the decoding drop counter should be reset (for example after forced slow down.)
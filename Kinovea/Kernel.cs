@@ -105,25 +105,7 @@ namespace Kinovea.Root
         #region Constructor
         public RootKernel()
         {
-            log.Debug("Loading video readers.");
-            List<Type> videoReaders = new List<Type>();
-            videoReaders.Add(typeof(Video.Bitmap.VideoReaderBitmap));
-            videoReaders.Add(typeof(Video.FFMpeg.VideoReaderFFMpeg));
-            videoReaders.Add(typeof(Video.GIF.VideoReaderGIF));
-            videoReaders.Add(typeof(Video.SVG.VideoReaderSVG));
-            videoReaders.Add(typeof(Video.Synthetic.VideoReaderSynthetic));
-            VideoTypeManager.LoadVideoReaders(videoReaders);
-
-            log.Debug("Loading built-in camera managers.");
-            CameraTypeManager.LoadCameraManager(typeof(Camera.DirectShow.CameraManagerDirectShow));
-            CameraTypeManager.LoadCameraManager(typeof(Camera.HTTP.CameraManagerHTTP));
-            CameraTypeManager.LoadCameraManager(typeof(Camera.FrameGenerator.CameraManagerFrameGenerator));
-
-            log.Debug("Loading camera managers plugins.");
-            CameraTypeManager.LoadCameraManagersPlugins();
-
-            log.Debug("Loading tools.");
-            ToolManager.LoadTools();
+            LoadModules();
 
             BuildSubTree();
             mainWindow = new KinoveaMainWindow(this);
@@ -144,6 +126,47 @@ namespace Kinovea.Root
         }
         #endregion
 
+        /// <summary>
+        /// Runs the batch export passed on the command line, without the user interface.
+        /// Returns the number of files that could not be exported, or BatchExporter.NoInput if there was nothing to export.
+        /// </summary>
+        public static int RunBatchExport(BatchExportSettings settings)
+        {
+            LoadModules();
+
+            // The export threads render the labels and the CSV headers, they must use the same language as the main thread.
+            CultureInfo culture = PreferencesManager.GeneralPreferences.GetSupportedCulture();
+            CultureInfo.DefaultThreadCurrentUICulture = culture;
+            Thread.CurrentThread.CurrentUICulture = culture;
+            BatchExporter exporter = new BatchExporter(settings);
+            return exporter.Run();
+        }
+
+        /// <summary>
+        /// Registers the video readers, camera managers and drawing tools.
+        /// </summary>
+        private static void LoadModules()
+        {
+            log.Debug("Loading video readers.");
+            List<Type> videoReaders = new List<Type>();
+            videoReaders.Add(typeof(Video.Bitmap.VideoReaderBitmap));
+            videoReaders.Add(typeof(Video.FFMpeg.VideoReaderFFMpeg));
+            videoReaders.Add(typeof(Video.SVG.VideoReaderSVG));
+            videoReaders.Add(typeof(Video.Synthetic.VideoReaderSynthetic));
+            VideoTypeManager.LoadVideoReaders(videoReaders);
+
+            log.Debug("Loading built-in camera managers.");
+            CameraTypeManager.LoadCameraManager(typeof(Camera.DirectShow.CameraManagerDirectShow));
+            CameraTypeManager.LoadCameraManager(typeof(Camera.HTTP.CameraManagerHTTP));
+            CameraTypeManager.LoadCameraManager(typeof(Camera.FrameGenerator.CameraManagerFrameGenerator));
+
+            log.Debug("Loading camera managers plugins.");
+            CameraTypeManager.LoadCameraManagersPlugins();
+
+            log.Debug("Loading tools.");
+            ToolManager.LoadTools();
+        }
+
         #region Prepare & Launch
         public void Prepare()
         {
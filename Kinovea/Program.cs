@@ -57,18 +57,27 @@ namespace Kinovea.Root
 
             Software.SanityCheckDirectories();
             PreferencesManager.Initialize();
-            bool firstInstance = Program.FirstInstance;
-            if (!firstInstance && !PreferencesManager.GeneralPreferences.AllowMultipleInstances)
-                return;
-
             var args = Environment.GetCommandLineArgs();
             if (args.Length > 1)
                 CommandLineArgumentManager.Instance.ParseArguments(args);
 
+            // A batch export can run alongside an interactive instance, it doesn't take the single instance mutex.
+            bool batchExport = LaunchSettingsManager.BatchExport != null;
+            bool firstInstance = batchExport || Program.FirstInstance;
+            if (!firstInstance && !PreferencesManager.GeneralPreferences.AllowMultipleInstances)
+                return;
+
             Software.ConfigureInstance();
             if (!string.IsNullOrEmpty(Software.InstanceName) && PreferencesManager.GeneralPreferences.InstancesOwnPreferences)
                 PreferencesManager.Initialize();
 
+            if (batchExport)
+            {
+                log.Debug("Running batch export.");
+                Environment.ExitCode = RootKernel.RunBatchExport(LaunchSettingsManager.BatchExport);
+                return;
+            }
+
             log.Debug("Application level initialisations.");
             Application.EnableVisualStyles();
             Application.SetCompatibleTextRenderingDefault(false);
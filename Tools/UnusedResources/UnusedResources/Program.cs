@@ -55,7 +55,6 @@ namespace UnusedResources
             directories.Add("Kinovea.Video");
             directories.Add("Kinovea.Video.Bitmap");
             directories.Add("Kinovea.Video.FFMpeg");
-            directories.Add("Kinovea.Video.GIF");
             directories.Add("Kinovea.Video.SVG");
             directories.Add("Kinovea.Video.Synthetic");
             directories.Add("Kinovea.Pipeline");
@@ -19,6 +19,7 @@ along with Kinovea. If not, see http://www.gnu.org/licenses/.
 */
 #endregion
 using System;
+using System.Diagnostics;
 using NUnit.Framework;
 using Kinovea.Video;
 
@@ -27,6 +28,109 @@ namespace Kinovea.Video.Tests
     [TestFixture]
     public class VideoFrameCacheTests
     {
-        // TODO
+        private const int seeks = 20000;
+        
+        [TestCase(1000, false)]
+        [TestCase(1000, true)]
+        [TestCase(100000, false)]
+        [TestCase(100000, true)]
+        public void MoveToTest(int _frames, bool _variable)
+        {
+            long[] timestamps = BuildTimestamps(_frames, _variable);
+            Cache cache = BuildCache(timestamps);
+            Random random = new Random(0);
+            
+            for(int i = 0; i < 1000; i++)
+            {
+                long target = timestamps[0] + (long)(random.NextDouble() * (timestamps[_frames - 1] - timestamps[0]));
+                Assert.IsTrue(cache.MoveTo(target));
+                
+                // The current frame must be the first frame at or after the target.
+                int expected = Array.BinarySearch(timestamps, target);
+                if(expected < 0)
+                    expected = ~expected;
+                
+                Assert.AreEqual(timestamps[expected], cache.CurrentFrame.Timestamp);
+            }
+            
+            cache.Dispose();
+        }
+        
+        [Test]
+        public void MoveToPrependedTest()
+        {
+            long[] timestamps = BuildTimestamps(100, false);
+            Cache cache = new Cache(delegate(VideoFrame _frame) {});
+            
+            for(int i = 50; i < 100; i++)
+                cache.Add(new VideoFrame(timestamps[i], null));
+            
+            cache.SetPrependBlock(true);
+            for(int i = 0; i < 50; i++)
+                cache.Add(new VideoFrame(timestamps[i], null));
+            cache.SetPrependBlock(false);
+            
+            for(int i = 0; i < 100; i++)
+            {
+                Assert.IsTrue(cache.MoveTo(timestamps[i]));
+                Assert.AreEqual(timestamps[i], cache.CurrentFrame.Timestamp);
+            }
+            
+            cache.Dispose();
+        }
+        
+        /// <summary>
+        /// Benchmark: average MoveTo cost for increasing cache sizes. 
+        /// The cost should stay flat (constant frame rate) or logarithmic (variable frame rate).
+        /// </summary>
+        [Test]
+        public void MoveToBenchmark()
+        {
+            int[] sizes = new int[] { 100, 1000, 10000, 100000 };
+            foreach(bool variable in new bool[] { false, true })
+            {
+                foreach(int size in sizes)
+                {
+                    long[] timestamps = BuildTimestamps(size, variable);
+                    Cache cache = BuildCache(timestamps);
+                    Random random = new Random(0);
+                    long range = timestamps[size - 1] - timestamps[0];
+                    
+                    Stopwatch stopwatch = Stopwatch.StartNew();
+                    for(int i = 0; i < seeks; i++)
+                        cache.MoveTo(timestamps[0] + (long)(random.NextDouble() * range));
+                    stopwatch.Stop();
+                    
+                    double nsPerSeek = stopwatch.Elapsed.TotalMilliseconds * 1000000.0 / seeks;
+                    Console.WriteLine("MoveTo, {0} frame rate, {1} frames: {2:0.0} ns/seek.", variable ? "variable" : "constant", size, nsPerSeek);
+                    
+                    cache.Dispose();
+                }
+            }
+        }
+        
+        private static long[] BuildTimestamps(int _frames, bool _variable)
+        {
+            // Timestamps in the style of a 90 kHz time base at 30 fps, with optional jitter.
+            long[] timestamps = new long[_frames];
+            Random random = new Random(_frames);
+            long timestamp = 3000;
+            for(int i = 0; i < _frames; i++)
+            {
+                timestamps[i] = timestamp;
+                timestamp += _variable ? 2000 + random.Next(2000) : 3000;
+            }
+            
+            return timestamps;
+        }
+        
+        private static Cache BuildCache(long[] _timestamps)
+        {
+            Cache cache = new Cache(delegate(VideoFrame _frame) {});
+            foreach(long timestamp in _timestamps)
+                cache.Add(new VideoFrame(timestamp, null));
+            
+            return cache;
+        }
     }
 }